@@ -71,7 +71,7 @@ btConvexHullShape *createConvexHullShapeFromMesh(Mesh *mesh) {
     if (mesh != NULL) {
         btConvexHullShape *initial_hull_shape = NULL;
         btShapeHull *hull_shape_optimizer = NULL;
-        unsigned short vertex_index;
+        unsigned int vertex_index;
 
         initial_hull_shape = new btConvexHullShape();
 
@@ -0,0 +1,138 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Host benchmarks for the CPU side of the renderer: transform update,
+ * frustum culling, state sorting, batch setup and picking, plus the
+ * frustum kernel, the custom shader draw setup, mesh uploads and
+ * occlusion culling on their own.
+ ***************************************************************************/
+
+#ifndef BENCHMARK_H_
+#define BENCHMARK_H_
+
+#include <string>
+#include <vector>
+
+#include "engine/renderer/gl_renderer.h"
+#include "glm/gtc/type_ptr.hpp"
+#include "objects/scene.h"
+#include "objects/scene_object.h"
+#include "shaders/shader_manager.h"
+
+namespace gvr {
+
+/*
+ * GLRenderer with the per-frame stages exposed one at a time, so each
+ * can be timed in isolation.
+ */
+class BenchmarkRenderer: public GLRenderer {
+public:
+    BenchmarkRenderer() : GLRenderer() {
+    }
+
+    void cullStage(Scene* scene, Camera* camera,
+            ShaderManager* shader_manager,
+            std::vector<SceneObject*>& scene_objects) {
+        cullFromCamera(scene, camera, shader_manager, scene_objects);
+    }
+
+    void sortStage() {
+        state_sort();
+    }
+
+    void batchStage() {
+        if (nullptr != batch_manager) {
+            batch_manager->batchSetup(render_data_vector);
+        }
+    }
+
+    void buildFrustum(Camera* camera, float frustum[6][4]) {
+        glm::mat4 vp_matrix = camera->getProjectionMatrix() * camera->getViewMatrix();
+        build_frustum(frustum, (const float*) glm::value_ptr(vp_matrix));
+    }
+
+    size_t renderDataCount() const {
+        return render_data_vector.size();
+    }
+};
+
+/*
+ * A synthetic scene. Objects share a small pool of meshes and materials
+ * the way instanced props do in real content, are spread through a cube
+ * around the camera and are either all parented to the root (flat) or
+ * arranged as a k-ary tree with spatially coherent children.
+ */
+struct BenchmarkScene {
+    std::string              name;
+    Scene*                   scene = nullptr;
+    SceneObject*             root = nullptr;
+    SceneObject*             camera_object = nullptr;
+    Camera*                  camera = nullptr;
+    std::vector<SceneObject*> objects;
+    std::vector<Mesh*>       meshes;
+    std::vector<Material*>   materials;
+    std::vector<RenderPass*> passes;
+    std::vector<Component*>  components;
+};
+
+BenchmarkScene* createBenchmarkScene(int object_count, int branching);
+void destroyBenchmarkScene(BenchmarkScene* bench);
+
+struct StageResult {
+    std::string stage;
+    double      ns_per_object;
+    double      ms_per_frame;
+    size_t      processed;
+};
+
+/*
+ * Runs every stage against the scene and appends one result per stage.
+ */
+void runStages(BenchmarkRenderer& renderer, ShaderManager& shader_manager,
+        BenchmarkScene& bench, int iterations, std::vector<StageResult>& results);
+
+/*
+ * Classifies every object's bounding box against the camera frustum,
+ * once through SceneObject::frustumCull, once through the scalar kernel
+ * and once through the kernel selected for this build.
+ */
+void runFrustumKernels(BenchmarkRenderer& renderer, BenchmarkScene& bench,
+        int iterations, std::vector<StageResult>& results);
+
+/*
+ * Issues one CustomShader::render per render data of the scene, with a
+ * shader binding a texture, uniforms the material has and uniforms it
+ * does not have yet. Reports the CPU time per draw.
+ */
+void runShaderDraws(ShaderManager& shader_manager, BenchmarkScene& bench,
+        int iterations, std::vector<StageResult>& results);
+
+/*
+ * Uploads a new mesh for a few programs through Mesh::getVAOId and
+ * reports the CPU time per vertex.
+ */
+void runMeshUploads(BenchmarkScene& bench, int iterations,
+        std::vector<StageResult>& results);
+
+/*
+ * Puts an occluder wall in front of the camera and times the cull with
+ * occlusion culling on. The count is what is left to render.
+ */
+void runOcclusion(BenchmarkRenderer& renderer, ShaderManager& shader_manager,
+        BenchmarkScene& bench, int iterations, std::vector<StageResult>& results);
+
+}
+#endif
@@ -0,0 +1,118 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Frustum test throughput: the per-object SceneObject::frustumCull path
+ * against the batched kernels in engine/renderer/frustum_kernel.h.
+ ***************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+
+#include "benchmark.h"
+#include "engine/renderer/frustum_kernel.h"
+#include "objects/bounding_volume.h"
+#include "objects/transform_store.h"
+
+namespace gvr {
+
+typedef std::chrono::steady_clock Clock;
+
+static double elapsedNs(Clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+static void addResult(std::vector<StageResult>& results, const std::string& stage,
+        std::vector<double>& samples, size_t object_count, size_t processed) {
+    std::sort(samples.begin(), samples.end());
+    double ns = samples[samples.size() / 2];
+    StageResult result;
+    result.stage = stage;
+    result.ns_per_object = ns / std::max<size_t>(object_count, 1);
+    result.ms_per_frame = ns / 1.0e6;
+    result.processed = processed;
+    results.push_back(result);
+}
+
+static size_t countVisible(const std::vector<unsigned char>& classes) {
+    size_t visible = 0;
+    for (size_t i = 0; i < classes.size(); ++i) {
+        if (FRUSTUM_OUTSIDE != classes[i]) {
+            ++visible;
+        }
+    }
+    return visible;
+}
+
+void runFrustumKernels(BenchmarkRenderer& renderer, BenchmarkScene& bench,
+        int iterations, std::vector<StageResult>& results) {
+    std::vector<SceneObject*>& objects = bench.objects;
+    size_t object_count = objects.size();
+    std::vector<double> samples;
+    size_t processed;
+
+    TransformStore::getInstance()->updateWorldMatrices();
+    float frustum[6][4];
+    renderer.buildFrustum(bench.camera, frustum);
+    FrustumPlanes planes;
+    planes.set(frustum);
+
+    // every path classifies the same boxes, taken up front so the
+    // bounding volume updates stay out of the timings
+    BoxArrays boxes;
+    boxes.resize(object_count);
+    for (size_t i = 0; i < object_count; ++i) {
+        BoundingVolume& bv = objects[i]->getBoundingVolume();
+        boxes.set(i, bv.min_corner(), bv.max_corner());
+    }
+    std::vector<unsigned char> classes(object_count);
+
+    // object: the per-object test the scene graph walk used to do
+    samples.clear();
+    processed = 0;
+    for (int i = 0; i < iterations; ++i) {
+        size_t visible = 0;
+        Clock::time_point start = Clock::now();
+        for (size_t j = 0; j < object_count; ++j) {
+            int plane_mask = 0;
+            if (0 != objects[j]->frustumCull(bench.camera_object->transform()->position(),
+                    frustum, plane_mask)) {
+                ++visible;
+            }
+        }
+        samples.push_back(elapsedNs(start));
+        processed = visible;
+    }
+    addResult(results, "fc-object", samples, object_count, processed);
+
+    samples.clear();
+    for (int i = 0; i < iterations; ++i) {
+        Clock::time_point start = Clock::now();
+        classifyBoxesScalar(planes, 0, boxes, 0, object_count, classes.data());
+        samples.push_back(elapsedNs(start));
+    }
+    addResult(results, "fc-scalar", samples, object_count, countVisible(classes));
+
+    samples.clear();
+    for (int i = 0; i < iterations; ++i) {
+        Clock::time_point start = Clock::now();
+        classifyBoxes(planes, 0, boxes, 0, object_count, classes.data());
+        samples.push_back(elapsedNs(start));
+    }
+    addResult(results, std::string("fc-") + frustumKernelName(), samples,
+            object_count, countVisible(classes));
+}
+
+}
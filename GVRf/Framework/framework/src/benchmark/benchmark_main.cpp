@@ -0,0 +1,103 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Entry point for the host benchmarks.
+ *
+ *   gvrf_benchmark [--quick] [--iterations N] [--workers N] [--objects N]...
+ ***************************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "benchmark.h"
+#include "engine/memory/gl_delete.h"
+#include "util/gvr_job_system.h"
+
+using namespace gvr;
+
+static void usage(const char* name) {
+    fprintf(stderr, "usage: %s [--quick] [--iterations N] [--workers N] [--objects N]...\n", name);
+}
+
+int main(int argc, char** argv) {
+    std::vector<int> sizes;
+    int iterations = 0;
+    int workers = -1;
+    bool quick = false;
+
+    for (int i = 1; i < argc; ++i) {
+        if (0 == strcmp(argv[i], "--quick")) {
+            quick = true;
+        } else if (0 == strcmp(argv[i], "--objects") && i + 1 < argc) {
+            sizes.push_back(atoi(argv[++i]));
+        } else if (0 == strcmp(argv[i], "--iterations") && i + 1 < argc) {
+            iterations = atoi(argv[++i]);
+        } else if (0 == strcmp(argv[i], "--workers") && i + 1 < argc) {
+            workers = atoi(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (sizes.empty()) {
+        if (quick) {
+            sizes = { 1000, 10000 };
+        } else {
+            sizes = { 1000, 10000, 50000, 200000 };
+        }
+    }
+    if (iterations <= 0) {
+        iterations = quick ? 5 : 21;
+    }
+
+    // the renderer and the GL wrappers expect to run on a thread with a deleter
+    GlDelete::createTlsKey();
+    new GlDelete();
+
+    if (workers >= 0) {
+        JobSystem::getInstance()->resize(workers);
+    }
+
+    BenchmarkRenderer* renderer = new BenchmarkRenderer();
+    gRenderer = renderer;
+    ShaderManager shader_manager;
+
+    printf("%-6s %8s %-10s %12s %12s %12s %10s\n",
+            "scene", "objects", "stage", "ns/object", "objects/ms", "ms/frame", "count");
+    const int topologies[] = { 0, 8 };
+    for (size_t s = 0; s < sizes.size(); ++s) {
+        for (size_t t = 0; t < sizeof(topologies) / sizeof(topologies[0]); ++t) {
+            BenchmarkScene* bench = createBenchmarkScene(sizes[s], topologies[t]);
+            std::vector<StageResult> results;
+            runStages(*renderer, shader_manager, *bench, iterations, results);
+            runFrustumKernels(*renderer, *bench, iterations, results);
+            runShaderDraws(shader_manager, *bench, iterations, results);
+            runMeshUploads(*bench, iterations, results);
+            runOcclusion(*renderer, shader_manager, *bench, iterations, results);
+            for (size_t r = 0; r < results.size(); ++r) {
+                double objects_per_ms = results[r].ns_per_object > 0.0 ?
+                        1.0e6 / results[r].ns_per_object : 0.0;
+                printf("%-6s %8d %-10s %12.1f %12.0f %12.3f %10zu\n",
+                        bench->name.c_str(), sizes[s], results[r].stage.c_str(),
+                        results[r].ns_per_object, objects_per_ms,
+                        results[r].ms_per_frame, results[r].processed);
+            }
+            destroyBenchmarkScene(bench);
+        }
+    }
+    return 0;
+}
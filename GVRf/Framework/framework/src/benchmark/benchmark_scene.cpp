@@ -0,0 +1,186 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Synthetic scenes for the host benchmarks.
+ ***************************************************************************/
+
+#include <random>
+
+#include "benchmark.h"
+#include "objects/material.h"
+#include "objects/mesh.h"
+#include "objects/render_pass.h"
+#include "objects/components/mesh_collider.h"
+#include "objects/components/perspective_camera.h"
+#include "objects/components/render_data.h"
+#include "objects/components/sphere_collider.h"
+
+namespace gvr {
+
+static const int MESH_POOL_SIZE = 4;
+static const int MATERIAL_POOL_SIZE = 8;
+static const float SCENE_EXTENT = 100.0f;
+static const float CHILD_EXTENT = 4.0f;
+static const int TREE_ROOTS = 64;
+
+/*
+ * Unit cube with texture coordinates, which is what the batcher expects
+ * every TEXTURE_SHADER mesh to carry.
+ */
+static Mesh* createCube(float size) {
+    Mesh* mesh = new Mesh();
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec2> uvs;
+    for (int i = 0; i < 8; ++i) {
+        glm::vec3 corner((i & 1) ? size : -size, (i & 2) ? size : -size,
+                (i & 4) ? size : -size);
+        vertices.push_back(corner);
+        normals.push_back(glm::normalize(corner));
+        uvs.push_back(glm::vec2((i & 1) ? 1.0f : 0.0f, (i & 2) ? 1.0f : 0.0f));
+    }
+    static const unsigned short faces[] = {
+        0, 2, 1, 1, 2, 3,  1, 3, 7, 1, 7, 5,  4, 5, 6, 5, 7, 6,
+        0, 6, 2, 0, 4, 6,  0, 1, 5, 0, 5, 4,  2, 7, 3, 2, 6, 7
+    };
+    std::vector<unsigned short> indices(faces, faces + sizeof(faces) / sizeof(faces[0]));
+    mesh->set_vertices(std::move(vertices));
+    mesh->set_normals(std::move(normals));
+    mesh->setVec2Vector("a_texcoord", uvs);
+    mesh->set_indices(std::move(indices));
+    return mesh;
+}
+
+BenchmarkScene* createBenchmarkScene(int object_count, int branching) {
+    BenchmarkScene* bench = new BenchmarkScene();
+    bench->name = (branching > 0) ? "tree" : "flat";
+    bench->scene = new Scene();
+    Scene::set_main_scene(bench->scene);
+    bench->scene->set_frustum_culling(true);
+
+    for (int i = 0; i < MESH_POOL_SIZE; ++i) {
+        bench->meshes.push_back(createCube(0.5f + 0.25f * i));
+    }
+    for (int i = 0; i < MATERIAL_POOL_SIZE; ++i) {
+        Material* material = new Material(Material::ShaderType::TEXTURE_SHADER);
+        material->setVec3("color", glm::vec3(i / float(MATERIAL_POOL_SIZE), 0.5f, 0.5f));
+        bench->materials.push_back(material);
+    }
+
+    // GVRScene always hangs content off a root object with a transform
+    bench->root = new SceneObject();
+    Transform* root_transform = new Transform();
+    bench->root->attachComponent(root_transform);
+    bench->components.push_back(root_transform);
+    bench->scene->addSceneObject(bench->root);
+
+    // camera at the origin looking down -z, as the head transform would be
+    bench->camera_object = new SceneObject();
+    Transform* camera_transform = new Transform();
+    PerspectiveCamera* camera = new PerspectiveCamera();
+    camera->set_far_clipping_distance(2.0f * SCENE_EXTENT);
+    bench->camera_object->attachComponent(camera_transform);
+    bench->camera_object->attachComponent(camera);
+    bench->components.push_back(camera_transform);
+    bench->components.push_back(camera);
+    bench->camera = camera;
+
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> scene_position(-SCENE_EXTENT, SCENE_EXTENT);
+    std::uniform_real_distribution<float> child_position(-CHILD_EXTENT, CHILD_EXTENT);
+
+    bench->objects.reserve(object_count);
+    for (int i = 0; i < object_count; ++i) {
+        SceneObject* object = new SceneObject();
+        Transform* transform = new Transform();
+        RenderData* render_data = new RenderData();
+        RenderPass* pass = new RenderPass();
+
+        SceneObject* parent = nullptr;
+        if (branching > 0 && i >= TREE_ROOTS) {
+            parent = bench->objects[(i - TREE_ROOTS) / branching];
+        }
+        // transforms only accept edits once they have an owner
+        object->attachComponent(transform);
+        if (nullptr != parent) {
+            transform->set_position(child_position(rng), child_position(rng),
+                    child_position(rng));
+        } else {
+            transform->set_position(scene_position(rng), scene_position(rng),
+                    scene_position(rng));
+        }
+
+        pass->set_material(bench->materials[i % MATERIAL_POOL_SIZE]);
+        render_data->add_pass(pass);
+        render_data->set_mesh(bench->meshes[i % MESH_POOL_SIZE]);
+        // a slice of the scene is transparent so the back-to-front path is exercised
+        if (0 == i % 16) {
+            render_data->set_rendering_order(RenderData::Transparent);
+        }
+        object->attachComponent(render_data);
+
+        Collider* collider = nullptr;
+        if (0 == i % 10) {
+            SphereCollider* sphere = new SphereCollider();
+            sphere->set_radius(1.0f);
+            collider = sphere;
+        } else if (5 == i % 10) {
+            collider = new MeshCollider(true);
+        }
+        if (nullptr != collider) {
+            object->attachComponent(collider);
+            bench->components.push_back(collider);
+        }
+
+        if (nullptr != parent) {
+            parent->addChildObject(parent, object);
+        } else {
+            bench->root->addChildObject(bench->root, object);
+        }
+        bench->objects.push_back(object);
+        bench->components.push_back(transform);
+        bench->components.push_back(render_data);
+        bench->passes.push_back(pass);
+    }
+    return bench;
+}
+
+void destroyBenchmarkScene(BenchmarkScene* bench) {
+    bench->scene->getRoot()->clear();
+    bench->root->clear();
+    for (auto it = bench->objects.begin(); it != bench->objects.end(); ++it) {
+        (*it)->clear();
+        delete *it;
+    }
+    delete bench->root;
+    delete bench->camera_object;
+    for (auto it = bench->components.begin(); it != bench->components.end(); ++it) {
+        delete *it;
+    }
+    for (auto it = bench->passes.begin(); it != bench->passes.end(); ++it) {
+        delete *it;
+    }
+    for (auto it = bench->materials.begin(); it != bench->materials.end(); ++it) {
+        delete *it;
+    }
+    for (auto it = bench->meshes.begin(); it != bench->meshes.end(); ++it) {
+        delete *it;
+    }
+    delete bench->scene;
+    delete bench;
+}
+
+}
@@ -0,0 +1,294 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Timing of the individual renderer stages.
+ ***************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+
+#include "benchmark.h"
+#include "engine/picker/picker.h"
+#include "objects/material.h"
+#include "objects/mesh.h"
+#include "objects/render_pass.h"
+#include "objects/transform_store.h"
+#include "objects/components/collider.h"
+#include "objects/components/render_data.h"
+#include "objects/components/transform.h"
+#include "shaders/material/custom_shader.h"
+
+namespace gvr {
+
+typedef std::chrono::steady_clock Clock;
+
+static double elapsedNs(Clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+static double median(std::vector<double>& samples) {
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+static void addResult(std::vector<StageResult>& results, const char* stage,
+        std::vector<double>& samples, size_t object_count, size_t processed) {
+    StageResult result;
+    double ns = median(samples);
+    result.stage = stage;
+    result.ns_per_object = ns / std::max<size_t>(object_count, 1);
+    result.ms_per_frame = ns / 1.0e6;
+    result.processed = processed;
+    results.push_back(result);
+}
+
+void runStages(BenchmarkRenderer& renderer, ShaderManager& shader_manager,
+        BenchmarkScene& bench, int iterations, std::vector<StageResult>& results) {
+    std::vector<SceneObject*>& objects = bench.objects;
+    std::vector<SceneObject*> visible;
+    std::vector<ColliderData> picks;
+    std::vector<double> samples;
+    size_t object_count = objects.size();
+    size_t processed = 0;
+
+    // transform: move a tenth of the scene, resolve the dirty world
+    // matrices the way Renderer::cull does, then pull every model matrix
+    samples.clear();
+    for (int i = 0; i < iterations; ++i) {
+        Clock::time_point start = Clock::now();
+        for (size_t j = i % 10; j < object_count; j += 10) {
+            Transform* t = objects[j]->transform();
+            t->set_position_x(t->position_x() + ((i & 1) ? 0.01f : -0.01f));
+        }
+        TransformStore::getInstance()->updateWorldMatrices();
+        for (size_t j = 0; j < object_count; ++j) {
+            objects[j]->transform()->getModelMatrix();
+        }
+        samples.push_back(elapsedNs(start));
+    }
+    addResult(results, "transform", samples, object_count, object_count);
+
+    // cull: hierarchical frustum cull plus render data collection
+    samples.clear();
+    for (int i = 0; i < iterations; ++i) {
+        Clock::time_point start = Clock::now();
+        renderer.cullStage(bench.scene, bench.camera, &shader_manager, visible);
+        samples.push_back(elapsedNs(start));
+    }
+    processed = renderer.renderDataCount();
+    addResult(results, "cull", samples, object_count, processed);
+
+    // sort: the cull output is re-collected untimed so every pass sorts the same input
+    samples.clear();
+    for (int i = 0; i < iterations; ++i) {
+        renderer.cullStage(bench.scene, bench.camera, &shader_manager, visible);
+        Clock::time_point start = Clock::now();
+        renderer.sortStage();
+        samples.push_back(elapsedNs(start));
+    }
+    addResult(results, "sort", samples, object_count, renderer.renderDataCount());
+
+    // batch: group the sorted render data into draw batches
+    samples.clear();
+    for (int i = 0; i < iterations; ++i) {
+        Clock::time_point start = Clock::now();
+        renderer.batchStage();
+        samples.push_back(elapsedNs(start));
+    }
+    addResult(results, "batch", samples, object_count, renderer.renderDataCount());
+
+    // pick: a ray down the view direction against every collider
+    samples.clear();
+    Transform* camera_transform = bench.camera_object->transform();
+    for (int i = 0; i < iterations; ++i) {
+        Clock::time_point start = Clock::now();
+        Picker::pickScene(bench.scene, picks, camera_transform,
+                0, 0, 0, 0, 0, -1);
+        samples.push_back(elapsedNs(start));
+    }
+    addResult(results, "pick", samples, object_count, picks.size());
+}
+
+namespace {
+
+class BenchmarkTexture: public Texture {
+public:
+    BenchmarkTexture() : Texture(new GLTexture(GL_TEXTURE_2D)) {
+    }
+
+    GLenum getTarget() const {
+        return GL_TEXTURE_2D;
+    }
+};
+
+}
+
+void runShaderDraws(ShaderManager& shader_manager, BenchmarkScene& bench,
+        int iterations, std::vector<StageResult>& results) {
+    static int shader_id = -1;
+    if (shader_id < 0) {
+        shader_id = shader_manager.addCustomShader(
+                "#version 300 es\nuniform mat4 u_mvp;\nin vec4 a_position;\n"
+                "void main() { gl_Position = u_mvp * a_position; }\n",
+                "#version 300 es\nprecision mediump float;\nuniform sampler2D u_texture;\n"
+                "uniform vec3 u_color;\nuniform float u_opacity;\nuniform vec4 u_tint;\n"
+                "uniform mat4 u_texture_matrix;\nout vec4 fragColor;\n"
+                "void main() { fragColor = vec4(u_color, u_opacity) * u_tint; }\n");
+        CustomShader* shader = shader_manager.getCustomShader(shader_id);
+        shader->addTextureKey("u_texture", "main_texture");
+        shader->addUniformVec3Key("u_color", "color");
+        shader->addUniformFloatKey("u_opacity", "opacity");
+        // not set on the material, the way keys look before the app sets them
+        shader->addUniformVec4Key("u_tint", "tint");
+        shader->addUniformMat4Key("u_texture_matrix", "texture_matrix");
+    }
+    CustomShader* shader = shader_manager.getCustomShader(shader_id);
+
+    BenchmarkTexture* texture = new BenchmarkTexture();
+    Material* material = new Material(Material::TEXTURE_SHADER);
+    material->setTexture("main_texture", texture);
+
+    RenderState rstate;
+    rstate.render_mask = 3;
+    rstate.viewportX = 0;
+    rstate.viewportY = 0;
+    rstate.viewportWidth = 1024;
+    rstate.viewportHeight = 1024;
+    rstate.scene = bench.scene;
+    rstate.material_override = nullptr;
+    rstate.shader_manager = &shader_manager;
+    rstate.shadow_map = false;
+
+    std::vector<RenderData*> render_data;
+    for (size_t i = 0; i < bench.objects.size(); ++i) {
+        RenderData* rd = bench.objects[i]->render_data();
+        if (nullptr != rd) {
+            render_data.push_back(rd);
+        }
+    }
+
+    std::vector<double> samples;
+    for (int i = 0; i < iterations; ++i) {
+        Clock::time_point start = Clock::now();
+        for (size_t j = 0; j < render_data.size(); ++j) {
+            shader->render(&rstate, render_data[j], material);
+        }
+        samples.push_back(elapsedNs(start));
+    }
+    addResult(results, "custom", samples, render_data.size(), render_data.size());
+
+    delete material;
+    delete texture;
+}
+
+void runMeshUploads(BenchmarkScene& bench, int iterations,
+        std::vector<StageResult>& results) {
+    // a lit, textured grid, the size of a typical imported prop
+    const int GRID = 96;
+    const int PROGRAMS = 4;
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec2> uvs;
+    std::vector<unsigned short> indices;
+    for (int y = 0; y <= GRID; ++y) {
+        for (int x = 0; x <= GRID; ++x) {
+            vertices.push_back(glm::vec3(x, y, 0.0f));
+            normals.push_back(glm::vec3(0.0f, 0.0f, 1.0f));
+            uvs.push_back(glm::vec2(float(x) / GRID, float(y) / GRID));
+        }
+    }
+    for (int y = 0; y < GRID; ++y) {
+        for (int x = 0; x < GRID; ++x) {
+            unsigned short i = y * (GRID + 1) + x;
+            unsigned short quad[] = { i, (unsigned short) (i + 1),
+                    (unsigned short) (i + GRID + 1), (unsigned short) (i + 1),
+                    (unsigned short) (i + GRID + 2), (unsigned short) (i + GRID + 1) };
+            indices.insert(indices.end(), quad, quad + 6);
+        }
+    }
+
+    // a new mesh per sample, drawn by a few programs the way a mesh
+    // shared by a lit and a shadow pass is
+    std::vector<double> samples;
+    for (int i = 0; i < iterations; ++i) {
+        Mesh* mesh = new Mesh();
+        mesh->set_vertices(vertices);
+        mesh->set_normals(normals);
+        mesh->setVec2Vector("a_texcoord", uvs);
+        mesh->set_indices(indices);
+        Clock::time_point start = Clock::now();
+        for (int program = 1; program <= PROGRAMS; ++program) {
+            mesh->getVAOId(program);
+        }
+        samples.push_back(elapsedNs(start));
+        delete mesh;
+    }
+    addResult(results, "vertex", samples, vertices.size(), vertices.size());
+}
+
+
+void runOcclusion(BenchmarkRenderer& renderer, ShaderManager& shader_manager,
+        BenchmarkScene& bench, int iterations, std::vector<StageResult>& results) {
+    // a wall 10 units down the view axis, hiding most of the view behind it
+    Mesh* mesh = new Mesh();
+    std::vector<glm::vec3> vertices = {
+        glm::vec3(-8.0f, -8.0f, 0.0f), glm::vec3(8.0f, -8.0f, 0.0f),
+        glm::vec3(-8.0f, 8.0f, 0.0f), glm::vec3(8.0f, 8.0f, 0.0f)
+    };
+    std::vector<glm::vec2> uvs = {
+        glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 0.0f),
+        glm::vec2(0.0f, 1.0f), glm::vec2(1.0f, 1.0f)
+    };
+    std::vector<unsigned short> indices = { 0, 1, 2, 1, 3, 2 };
+    mesh->set_vertices(std::move(vertices));
+    mesh->setVec2Vector("a_texcoord", uvs);
+    mesh->set_indices(std::move(indices));
+
+    SceneObject* wall = new SceneObject();
+    Transform* transform = new Transform();
+    RenderData* render_data = new RenderData();
+    RenderPass* pass = new RenderPass();
+    wall->attachComponent(transform);
+    transform->set_position(0.0f, 0.0f, -10.0f);
+    pass->set_material(bench.materials[0]);
+    render_data->add_pass(pass);
+    render_data->set_mesh(mesh);
+    render_data->set_occluder(true);
+    wall->attachComponent(render_data);
+    bench.root->addChildObject(bench.root, wall);
+    TransformStore::getInstance()->updateWorldMatrices();
+
+    std::vector<SceneObject*> visible;
+    std::vector<double> samples;
+    bench.scene->set_occlusion_culling(true);
+    for (int i = 0; i < iterations; ++i) {
+        Clock::time_point start = Clock::now();
+        renderer.cullStage(bench.scene, bench.camera, &shader_manager, visible);
+        samples.push_back(elapsedNs(start));
+    }
+    addResult(results, "occlude", samples, bench.objects.size(),
+            renderer.renderDataCount());
+    bench.scene->set_occlusion_culling(false);
+
+    bench.root->removeChildObject(wall);
+    delete wall;
+    delete render_data;
+    delete transform;
+    delete pass;
+    delete mesh;
+}
+
+}
@@ -0,0 +1,980 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * No-op OpenGL ES 3.0 / EGL implementation for the host benchmarks.
+ *
+ * Every entry point accepts its arguments and does nothing, except that
+ * object names are handed out from a counter, status queries report
+ * success, uniforms have locations and mapped buffers point at scratch
+ * memory, so the renderer takes the same code paths it takes on a device.
+ ***************************************************************************/
+
+#define __gl2_h_
+#include <GLES3/gl3.h>
+#include <EGL/egl.h>
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+namespace {
+
+// the texture loader calls in from its own thread
+GLuint nextName() {
+    static std::atomic<GLuint> name(0);
+    return ++name;
+}
+
+// every program declares the attributes of a textured, lit mesh
+struct StubAttribute {
+    const char* name;
+    GLenum type;
+};
+const StubAttribute stub_attributes[] = {
+    { "a_position", GL_FLOAT_VEC3 },
+    { "a_normal", GL_FLOAT_VEC3 },
+    { "a_texcoord", GL_FLOAT_VEC2 },
+};
+const GLuint STUB_ATTRIBUTE_COUNT = sizeof(stub_attributes) / sizeof(stub_attributes[0]);
+
+void* mapScratch(GLsizeiptr length) {
+    static thread_local std::vector<char> scratch;
+    if (scratch.size() < static_cast<size_t>(length)) {
+        scratch.resize(length);
+    }
+    return scratch.data();
+}
+
+}
+
+extern "C" {
+
+void GL_APIENTRY glActiveTexture(GLenum texture) {
+}
+
+void GL_APIENTRY glAttachShader(GLuint program, GLuint shader) {
+}
+
+void GL_APIENTRY glBindAttribLocation(GLuint program, GLuint index, const GLchar *name) {
+}
+
+void GL_APIENTRY glBindBuffer(GLenum target, GLuint buffer) {
+}
+
+void GL_APIENTRY glBindFramebuffer(GLenum target, GLuint framebuffer) {
+}
+
+void GL_APIENTRY glBindRenderbuffer(GLenum target, GLuint renderbuffer) {
+}
+
+void GL_APIENTRY glBindTexture(GLenum target, GLuint texture) {
+}
+
+void GL_APIENTRY glBlendColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha) {
+}
+
+void GL_APIENTRY glBlendEquation(GLenum mode) {
+}
+
+void GL_APIENTRY glBlendEquationSeparate(GLenum modeRGB, GLenum modeAlpha) {
+}
+
+void GL_APIENTRY glBlendFunc(GLenum sfactor, GLenum dfactor) {
+}
+
+void GL_APIENTRY glBlendFuncSeparate(GLenum sfactorRGB, GLenum dfactorRGB, GLenum sfactorAlpha, GLenum dfactorAlpha) {
+}
+
+void GL_APIENTRY glBufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usage) {
+}
+
+void GL_APIENTRY glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void *data) {
+}
+
+GLenum GL_APIENTRY glCheckFramebufferStatus(GLenum target) {
+    return GL_FRAMEBUFFER_COMPLETE;
+}
+
+void GL_APIENTRY glClear(GLbitfield mask) {
+}
+
+void GL_APIENTRY glClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha) {
+}
+
+void GL_APIENTRY glClearDepthf(GLfloat d) {
+}
+
+void GL_APIENTRY glClearStencil(GLint s) {
+}
+
+void GL_APIENTRY glColorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha) {
+}
+
+void GL_APIENTRY glCompileShader(GLuint shader) {
+}
+
+void GL_APIENTRY glCompressedTexImage2D(GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const void *data) {
+}
+
+void GL_APIENTRY glCompressedTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLsizei imageSize, const void *data) {
+}
+
+void GL_APIENTRY glCopyTexImage2D(GLenum target, GLint level, GLenum internalformat, GLint x, GLint y, GLsizei width, GLsizei height, GLint border) {
+}
+
+void GL_APIENTRY glCopyTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint x, GLint y, GLsizei width, GLsizei height) {
+}
+
+GLuint GL_APIENTRY glCreateProgram(void) {
+    return nextName();
+}
+
+GLuint GL_APIENTRY glCreateShader(GLenum type) {
+    return nextName();
+}
+
+void GL_APIENTRY glCullFace(GLenum mode) {
+}
+
+void GL_APIENTRY glDeleteBuffers(GLsizei n, const GLuint *buffers) {
+}
+
+void GL_APIENTRY glDeleteFramebuffers(GLsizei n, const GLuint *framebuffers) {
+}
+
+void GL_APIENTRY glDeleteProgram(GLuint program) {
+}
+
+void GL_APIENTRY glDeleteRenderbuffers(GLsizei n, const GLuint *renderbuffers) {
+}
+
+void GL_APIENTRY glDeleteShader(GLuint shader) {
+}
+
+void GL_APIENTRY glDeleteTextures(GLsizei n, const GLuint *textures) {
+}
+
+void GL_APIENTRY glDepthFunc(GLenum func) {
+}
+
+void GL_APIENTRY glDepthMask(GLboolean flag) {
+}
+
+void GL_APIENTRY glDepthRangef(GLfloat n, GLfloat f) {
+}
+
+void GL_APIENTRY glDetachShader(GLuint program, GLuint shader) {
+}
+
+void GL_APIENTRY glDisable(GLenum cap) {
+}
+
+void GL_APIENTRY glDisableVertexAttribArray(GLuint index) {
+}
+
+void GL_APIENTRY glDrawArrays(GLenum mode, GLint first, GLsizei count) {
+}
+
+void GL_APIENTRY glDrawElements(GLenum mode, GLsizei count, GLenum type, const void *indices) {
+}
+
+void GL_APIENTRY glEnable(GLenum cap) {
+}
+
+void GL_APIENTRY glEnableVertexAttribArray(GLuint index) {
+}
+
+void GL_APIENTRY glFinish(void) {
+}
+
+void GL_APIENTRY glFlush(void) {
+}
+
+void GL_APIENTRY glFramebufferRenderbuffer(GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer) {
+}
+
+void GL_APIENTRY glFramebufferTexture2D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level) {
+}
+
+void GL_APIENTRY glFrontFace(GLenum mode) {
+}
+
+void GL_APIENTRY glGenBuffers(GLsizei n, GLuint *buffers) {
+    for (GLsizei i = 0; i < n; ++i) {
+        buffers[i] = nextName();
+    }
+}
+
+void GL_APIENTRY glGenerateMipmap(GLenum target) {
+}
+
+void GL_APIENTRY glGenFramebuffers(GLsizei n, GLuint *framebuffers) {
+    for (GLsizei i = 0; i < n; ++i) {
+        framebuffers[i] = nextName();
+    }
+}
+
+void GL_APIENTRY glGenRenderbuffers(GLsizei n, GLuint *renderbuffers) {
+    for (GLsizei i = 0; i < n; ++i) {
+        renderbuffers[i] = nextName();
+    }
+}
+
+void GL_APIENTRY glGenTextures(GLsizei n, GLuint *textures) {
+    for (GLsizei i = 0; i < n; ++i) {
+        textures[i] = nextName();
+    }
+}
+
+void GL_APIENTRY glGetActiveAttrib(GLuint program, GLuint index, GLsizei bufSize, GLsizei *length, GLint *size, GLenum *type, GLchar *name) {
+    const char* attribute = index < STUB_ATTRIBUTE_COUNT ? stub_attributes[index].name : "";
+    if (length) {
+        *length = strlen(attribute);
+    }
+    if (bufSize > 0) {
+        strncpy(name, attribute, bufSize);
+        name[bufSize - 1] = 0;
+    }
+    *size = 1;
+    *type = index < STUB_ATTRIBUTE_COUNT ? stub_attributes[index].type : GL_FLOAT;
+}
+
+void GL_APIENTRY glGetActiveUniform(GLuint program, GLuint index, GLsizei bufSize, GLsizei *length, GLint *size, GLenum *type, GLchar *name) {
+    if (length) {
+        *length = 0;
+    }
+    if (bufSize > 0) {
+        name[0] = 0;
+    }
+    *size = 0;
+    *type = GL_FLOAT;
+}
+
+void GL_APIENTRY glGetAttachedShaders(GLuint program, GLsizei maxCount, GLsizei *count, GLuint *shaders) {
+}
+
+GLint GL_APIENTRY glGetAttribLocation(GLuint program, const GLchar *name) {
+    for (GLuint i = 0; i < STUB_ATTRIBUTE_COUNT; ++i) {
+        if (0 == strcmp(name, stub_attributes[i].name)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void GL_APIENTRY glGetBooleanv(GLenum pname, GLboolean *data) {
+    *data = GL_FALSE;
+}
+
+void GL_APIENTRY glGetBufferParameteriv(GLenum target, GLenum pname, GLint *params) {
+}
+
+GLenum GL_APIENTRY glGetError(void) {
+    return GL_NO_ERROR;
+}
+
+void GL_APIENTRY glGetFloatv(GLenum pname, GLfloat *data) {
+    *data = 0.0f;
+}
+
+void GL_APIENTRY glGetFramebufferAttachmentParameteriv(GLenum target, GLenum attachment, GLenum pname, GLint *params) {
+}
+
+void GL_APIENTRY glGetIntegerv(GLenum pname, GLint *data) {
+    *data = 0;
+}
+
+void GL_APIENTRY glGetProgramiv(GLuint program, GLenum pname, GLint *params) {
+    switch (pname) {
+    case GL_LINK_STATUS:
+        *params = GL_TRUE;
+        break;
+    case GL_ACTIVE_ATTRIBUTES:
+        *params = STUB_ATTRIBUTE_COUNT;
+        break;
+    default:
+        *params = 0;
+        break;
+    }
+}
+
+void GL_APIENTRY glGetProgramInfoLog(GLuint program, GLsizei bufSize, GLsizei *length, GLchar *infoLog) {
+    if (length) {
+        *length = 0;
+    }
+    if (bufSize > 0) {
+        infoLog[0] = 0;
+    }
+}
+
+void GL_APIENTRY glGetRenderbufferParameteriv(GLenum target, GLenum pname, GLint *params) {
+}
+
+void GL_APIENTRY glGetShaderiv(GLuint shader, GLenum pname, GLint *params) {
+    *params = (pname == GL_COMPILE_STATUS) ? GL_TRUE : 0;
+}
+
+void GL_APIENTRY glGetShaderInfoLog(GLuint shader, GLsizei bufSize, GLsizei *length, GLchar *infoLog) {
+    if (length) {
+        *length = 0;
+    }
+    if (bufSize > 0) {
+        infoLog[0] = 0;
+    }
+}
+
+void GL_APIENTRY glGetShaderPrecisionFormat(GLenum shadertype, GLenum precisiontype, GLint *range, GLint *precision) {
+}
+
+void GL_APIENTRY glGetShaderSource(GLuint shader, GLsizei bufSize, GLsizei *length, GLchar *source) {
+}
+
+const GLubyte * GL_APIENTRY glGetString(GLenum name) {
+    return reinterpret_cast<const GLubyte*>("host stub");
+}
+
+void GL_APIENTRY glGetTexParameterfv(GLenum target, GLenum pname, GLfloat *params) {
+}
+
+void GL_APIENTRY glGetTexParameteriv(GLenum target, GLenum pname, GLint *params) {
+}
+
+void GL_APIENTRY glGetUniformfv(GLuint program, GLint location, GLfloat *params) {
+}
+
+void GL_APIENTRY glGetUniformiv(GLuint program, GLint location, GLint *params) {
+}
+
+GLint GL_APIENTRY glGetUniformLocation(GLuint program, const GLchar *name) {
+    // every uniform is active; attributes stay inactive so the skinning
+    // and instancing paths are only taken where the renderer asks for them
+    GLint location = 0;
+    for (const GLchar* c = name; *c; ++c) {
+        location = (location * 31 + *c) & 0x3ff;
+    }
+    return location;
+}
+
+void GL_APIENTRY glGetVertexAttribfv(GLuint index, GLenum pname, GLfloat *params) {
+}
+
+void GL_APIENTRY glGetVertexAttribiv(GLuint index, GLenum pname, GLint *params) {
+}
+
+void GL_APIENTRY glGetVertexAttribPointerv(GLuint index, GLenum pname, void **pointer) {
+}
+
+void GL_APIENTRY glHint(GLenum target, GLenum mode) {
+}
+
+GLboolean GL_APIENTRY glIsBuffer(GLuint buffer) {
+    return GL_FALSE;
+}
+
+GLboolean GL_APIENTRY glIsEnabled(GLenum cap) {
+    return GL_FALSE;
+}
+
+GLboolean GL_APIENTRY glIsFramebuffer(GLuint framebuffer) {
+    return GL_FALSE;
+}
+
+GLboolean GL_APIENTRY glIsProgram(GLuint program) {
+    return GL_FALSE;
+}
+
+GLboolean GL_APIENTRY glIsRenderbuffer(GLuint renderbuffer) {
+    return GL_FALSE;
+}
+
+GLboolean GL_APIENTRY glIsShader(GLuint shader) {
+    return GL_FALSE;
+}
+
+GLboolean GL_APIENTRY glIsTexture(GLuint texture) {
+    return GL_FALSE;
+}
+
+void GL_APIENTRY glLineWidth(GLfloat width) {
+}
+
+void GL_APIENTRY glLinkProgram(GLuint program) {
+}
+
+void GL_APIENTRY glPixelStorei(GLenum pname, GLint param) {
+}
+
+void GL_APIENTRY glPolygonOffset(GLfloat factor, GLfloat units) {
+}
+
+void GL_APIENTRY glReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void *pixels) {
+}
+
+void GL_APIENTRY glReleaseShaderCompiler(void) {
+}
+
+void GL_APIENTRY glRenderbufferStorage(GLenum target, GLenum internalformat, GLsizei width, GLsizei height) {
+}
+
+void GL_APIENTRY glSampleCoverage(GLfloat value, GLboolean invert) {
+}
+
+void GL_APIENTRY glScissor(GLint x, GLint y, GLsizei width, GLsizei height) {
+}
+
+void GL_APIENTRY glShaderBinary(GLsizei count, const GLuint *shaders, GLenum binaryFormat, const void *binary, GLsizei length) {
+}
+
+void GL_APIENTRY glShaderSource(GLuint shader, GLsizei count, const GLchar *const*string, const GLint *length) {
+}
+
+void GL_APIENTRY glStencilFunc(GLenum func, GLint ref, GLuint mask) {
+}
+
+void GL_APIENTRY glStencilFuncSeparate(GLenum face, GLenum func, GLint ref, GLuint mask) {
+}
+
+void GL_APIENTRY glStencilMask(GLuint mask) {
+}
+
+void GL_APIENTRY glStencilMaskSeparate(GLenum face, GLuint mask) {
+}
+
+void GL_APIENTRY glStencilOp(GLenum fail, GLenum zfail, GLenum zpass) {
+}
+
+void GL_APIENTRY glStencilOpSeparate(GLenum face, GLenum sfail, GLenum dpfail, GLenum dppass) {
+}
+
+void GL_APIENTRY glTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void *pixels) {
+}
+
+void GL_APIENTRY glTexParameterf(GLenum target, GLenum pname, GLfloat param) {
+}
+
+void GL_APIENTRY glTexParameterfv(GLenum target, GLenum pname, const GLfloat *params) {
+}
+
+void GL_APIENTRY glTexParameteri(GLenum target, GLenum pname, GLint param) {
+}
+
+void GL_APIENTRY glTexParameteriv(GLenum target, GLenum pname, const GLint *params) {
+}
+
+void GL_APIENTRY glTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void *pixels) {
+}
+
+void GL_APIENTRY glUniform1f(GLint location, GLfloat v0) {
+}
+
+void GL_APIENTRY glUniform1fv(GLint location, GLsizei count, const GLfloat *value) {
+}
+
+void GL_APIENTRY glUniform1i(GLint location, GLint v0) {
+}
+
+void GL_APIENTRY glUniform1iv(GLint location, GLsizei count, const GLint *value) {
+}
+
+void GL_APIENTRY glUniform2f(GLint location, GLfloat v0, GLfloat v1) {
+}
+
+void GL_APIENTRY glUniform2fv(GLint location, GLsizei count, const GLfloat *value) {
+}
+
+void GL_APIENTRY glUniform2i(GLint location, GLint v0, GLint v1) {
+}
+
+void GL_APIENTRY glUniform2iv(GLint location, GLsizei count, const GLint *value) {
+}
+
+void GL_APIENTRY glUniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2) {
+}
+
+void GL_APIENTRY glUniform3fv(GLint location, GLsizei count, const GLfloat *value) {
+}
+
+void GL_APIENTRY glUniform3i(GLint location, GLint v0, GLint v1, GLint v2) {
+}
+
+void GL_APIENTRY glUniform3iv(GLint location, GLsizei count, const GLint *value) {
+}
+
+void GL_APIENTRY glUniform4f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3) {
+}
+
+void GL_APIENTRY glUniform4fv(GLint location, GLsizei count, const GLfloat *value) {
+}
+
+void GL_APIENTRY glUniform4i(GLint location, GLint v0, GLint v1, GLint v2, GLint v3) {
+}
+
+void GL_APIENTRY glUniform4iv(GLint location, GLsizei count, const GLint *value) {
+}
+
+void GL_APIENTRY glUniformMatrix2fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *value) {
+}
+
+void GL_APIENTRY glUniformMatrix3fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *value) {
+}
+
+void GL_APIENTRY glUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *value) {
+}
+
+void GL_APIENTRY glUseProgram(GLuint program) {
+}
+
+void GL_APIENTRY glValidateProgram(GLuint program) {
+}
+
+void GL_APIENTRY glVertexAttrib1f(GLuint index, GLfloat x) {
+}
+
+void GL_APIENTRY glVertexAttrib1fv(GLuint index, const GLfloat *v) {
+}
+
+void GL_APIENTRY glVertexAttrib2f(GLuint index, GLfloat x, GLfloat y) {
+}
+
+void GL_APIENTRY glVertexAttrib2fv(GLuint index, const GLfloat *v) {
+}
+
+void GL_APIENTRY glVertexAttrib3f(GLuint index, GLfloat x, GLfloat y, GLfloat z) {
+}
+
+void GL_APIENTRY glVertexAttrib3fv(GLuint index, const GLfloat *v) {
+}
+
+void GL_APIENTRY glVertexAttrib4f(GLuint index, GLfloat x, GLfloat y, GLfloat z, GLfloat w) {
+}
+
+void GL_APIENTRY glVertexAttrib4fv(GLuint index, const GLfloat *v) {
+}
+
+void GL_APIENTRY glVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void *pointer) {
+}
+
+void GL_APIENTRY glViewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+}
+
+void GL_APIENTRY glReadBuffer(GLenum src) {
+}
+
+void GL_APIENTRY glDrawRangeElements(GLenum mode, GLuint start, GLuint end, GLsizei count, GLenum type, const void *indices) {
+}
+
+void GL_APIENTRY glTexImage3D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLsizei depth, GLint border, GLenum format, GLenum type, const void *pixels) {
+}
+
+void GL_APIENTRY glTexSubImage3D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const void *pixels) {
+}
+
+void GL_APIENTRY glCopyTexSubImage3D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLint x, GLint y, GLsizei width, GLsizei height) {
+}
+
+void GL_APIENTRY glCompressedTexImage3D(GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLsizei depth, GLint border, GLsizei imageSize, const void *data) {
+}
+
+void GL_APIENTRY glCompressedTexSubImage3D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLsizei imageSize, const void *data) {
+}
+
+void GL_APIENTRY glGenQueries(GLsizei n, GLuint *ids) {
+    for (GLsizei i = 0; i < n; ++i) {
+        ids[i] = nextName();
+    }
+}
+
+void GL_APIENTRY glDeleteQueries(GLsizei n, const GLuint *ids) {
+}
+
+GLboolean GL_APIENTRY glIsQuery(GLuint id) {
+    return GL_FALSE;
+}
+
+void GL_APIENTRY glBeginQuery(GLenum target, GLuint id) {
+}
+
+void GL_APIENTRY glEndQuery(GLenum target) {
+}
+
+void GL_APIENTRY glGetQueryiv(GLenum target, GLenum pname, GLint *params) {
+}
+
+void GL_APIENTRY glGetQueryObjectuiv(GLuint id, GLenum pname, GLuint *params) {
+    *params = 0;
+}
+
+GLboolean GL_APIENTRY glUnmapBuffer(GLenum target) {
+    return GL_TRUE;
+}
+
+void GL_APIENTRY glGetBufferPointerv(GLenum target, GLenum pname, void **params) {
+}
+
+void GL_APIENTRY glDrawBuffers(GLsizei n, const GLenum *bufs) {
+}
+
+void GL_APIENTRY glUniformMatrix2x3fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *value) {
+}
+
+void GL_APIENTRY glUniformMatrix3x2fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *value) {
+}
+
+void GL_APIENTRY glUniformMatrix2x4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *value) {
+}
+
+void GL_APIENTRY glUniformMatrix4x2fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *value) {
+}
+
+void GL_APIENTRY glUniformMatrix3x4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *value) {
+}
+
+void GL_APIENTRY glUniformMatrix4x3fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *value) {
+}
+
+void GL_APIENTRY glBlitFramebuffer(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter) {
+}
+
+void GL_APIENTRY glRenderbufferStorageMultisample(GLenum target, GLsizei samples, GLenum internalformat, GLsizei width, GLsizei height) {
+}
+
+void GL_APIENTRY glFramebufferTextureLayer(GLenum target, GLenum attachment, GLuint texture, GLint level, GLint layer) {
+}
+
+void * GL_APIENTRY glMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+    return mapScratch(length);
+}
+
+void GL_APIENTRY glFlushMappedBufferRange(GLenum target, GLintptr offset, GLsizeiptr length) {
+}
+
+void GL_APIENTRY glBindVertexArray(GLuint array) {
+}
+
+void GL_APIENTRY glDeleteVertexArrays(GLsizei n, const GLuint *arrays) {
+}
+
+void GL_APIENTRY glGenVertexArrays(GLsizei n, GLuint *arrays) {
+    for (GLsizei i = 0; i < n; ++i) {
+        arrays[i] = nextName();
+    }
+}
+
+GLboolean GL_APIENTRY glIsVertexArray(GLuint array) {
+    return GL_FALSE;
+}
+
+void GL_APIENTRY glGetIntegeri_v(GLenum target, GLuint index, GLint *data) {
+}
+
+void GL_APIENTRY glBeginTransformFeedback(GLenum primitiveMode) {
+}
+
+void GL_APIENTRY glEndTransformFeedback(void) {
+}
+
+void GL_APIENTRY glBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+}
+
+void GL_APIENTRY glBindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+}
+
+void GL_APIENTRY glTransformFeedbackVaryings(GLuint program, GLsizei count, const GLchar *const*varyings, GLenum bufferMode) {
+}
+
+void GL_APIENTRY glGetTransformFeedbackVarying(GLuint program, GLuint index, GLsizei bufSize, GLsizei *length, GLsizei *size, GLenum *type, GLchar *name) {
+}
+
+void GL_APIENTRY glVertexAttribIPointer(GLuint index, GLint size, GLenum type, GLsizei stride, const void *pointer) {
+}
+
+void GL_APIENTRY glGetVertexAttribIiv(GLuint index, GLenum pname, GLint *params) {
+}
+
+void GL_APIENTRY glGetVertexAttribIuiv(GLuint index, GLenum pname, GLuint *params) {
+}
+
+void GL_APIENTRY glVertexAttribI4i(GLuint index, GLint x, GLint y, GLint z, GLint w) {
+}
+
+void GL_APIENTRY glVertexAttribI4ui(GLuint index, GLuint x, GLuint y, GLuint z, GLuint w) {
+}
+
+void GL_APIENTRY glVertexAttribI4iv(GLuint index, const GLint *v) {
+}
+
+void GL_APIENTRY glVertexAttribI4uiv(GLuint index, const GLuint *v) {
+}
+
+void GL_APIENTRY glGetUniformuiv(GLuint program, GLint location, GLuint *params) {
+}
+
+GLint GL_APIENTRY glGetFragDataLocation(GLuint program, const GLchar *name) {
+    return -1;
+}
+
+void GL_APIENTRY glUniform1ui(GLint location, GLuint v0) {
+}
+
+void GL_APIENTRY glUniform2ui(GLint location, GLuint v0, GLuint v1) {
+}
+
+void GL_APIENTRY glUniform3ui(GLint location, GLuint v0, GLuint v1, GLuint v2) {
+}
+
+void GL_APIENTRY glUniform4ui(GLint location, GLuint v0, GLuint v1, GLuint v2, GLuint v3) {
+}
+
+void GL_APIENTRY glUniform1uiv(GLint location, GLsizei count, const GLuint *value) {
+}
+
+void GL_APIENTRY glUniform2uiv(GLint location, GLsizei count, const GLuint *value) {
+}
+
+void GL_APIENTRY glUniform3uiv(GLint location, GLsizei count, const GLuint *value) {
+}
+
+void GL_APIENTRY glUniform4uiv(GLint location, GLsizei count, const GLuint *value) {
+}
+
+void GL_APIENTRY glClearBufferiv(GLenum buffer, GLint drawbuffer, const GLint *value) {
+}
+
+void GL_APIENTRY glClearBufferuiv(GLenum buffer, GLint drawbuffer, const GLuint *value) {
+}
+
+void GL_APIENTRY glClearBufferfv(GLenum buffer, GLint drawbuffer, const GLfloat *value) {
+}
+
+void GL_APIENTRY glClearBufferfi(GLenum buffer, GLint drawbuffer, GLfloat depth, GLint stencil) {
+}
+
+const GLubyte * GL_APIENTRY glGetStringi(GLenum name, GLuint index) {
+    return reinterpret_cast<const GLubyte*>("");
+}
+
+void GL_APIENTRY glCopyBufferSubData(GLenum readTarget, GLenum writeTarget, GLintptr readOffset, GLintptr writeOffset, GLsizeiptr size) {
+}
+
+void GL_APIENTRY glGetUniformIndices(GLuint program, GLsizei uniformCount, const GLchar *const*uniformNames, GLuint *uniformIndices) {
+}
+
+void GL_APIENTRY glGetActiveUniformsiv(GLuint program, GLsizei uniformCount, const GLuint *uniformIndices, GLenum pname, GLint *params) {
+}
+
+GLuint GL_APIENTRY glGetUniformBlockIndex(GLuint program, const GLchar *uniformBlockName) {
+    return GL_INVALID_INDEX;
+}
+
+void GL_APIENTRY glGetActiveUniformBlockiv(GLuint program, GLuint uniformBlockIndex, GLenum pname, GLint *params) {
+}
+
+void GL_APIENTRY glGetActiveUniformBlockName(GLuint program, GLuint uniformBlockIndex, GLsizei bufSize, GLsizei *length, GLchar *uniformBlockName) {
+}
+
+void GL_APIENTRY glUniformBlockBinding(GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding) {
+}
+
+void GL_APIENTRY glDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instancecount) {
+}
+
+void GL_APIENTRY glDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void *indices, GLsizei instancecount) {
+}
+
+GLsync GL_APIENTRY glFenceSync(GLenum condition, GLbitfield flags) {
+    return reinterpret_cast<GLsync>(static_cast<uintptr_t>(nextName()));
+}
+
+GLboolean GL_APIENTRY glIsSync(GLsync sync) {
+    return sync != nullptr;
+}
+
+void GL_APIENTRY glDeleteSync(GLsync sync) {
+}
+
+GLenum GL_APIENTRY glClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout) {
+    return GL_ALREADY_SIGNALED;
+}
+
+void GL_APIENTRY glWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout) {
+}
+
+void GL_APIENTRY glGetInteger64v(GLenum pname, GLint64 *data) {
+    *data = 0;
+}
+
+void GL_APIENTRY glGetSynciv(GLsync sync, GLenum pname, GLsizei count, GLsizei *length, GLint *values) {
+    if (count > 0) {
+        *values = (pname == GL_SYNC_STATUS) ? GL_SIGNALED : 0;
+    }
+    if (length) {
+        *length = 1;
+    }
+}
+
+void GL_APIENTRY glGetInteger64i_v(GLenum target, GLuint index, GLint64 *data) {
+}
+
+void GL_APIENTRY glGetBufferParameteri64v(GLenum target, GLenum pname, GLint64 *params) {
+}
+
+void GL_APIENTRY glGenSamplers(GLsizei count, GLuint *samplers) {
+    for (GLsizei i = 0; i < count; ++i) {
+        samplers[i] = nextName();
+    }
+}
+
+void GL_APIENTRY glDeleteSamplers(GLsizei count, const GLuint *samplers) {
+}
+
+GLboolean GL_APIENTRY glIsSampler(GLuint sampler) {
+    return GL_FALSE;
+}
+
+void GL_APIENTRY glBindSampler(GLuint unit, GLuint sampler) {
+}
+
+void GL_APIENTRY glSamplerParameteri(GLuint sampler, GLenum pname, GLint param) {
+}
+
+void GL_APIENTRY glSamplerParameteriv(GLuint sampler, GLenum pname, const GLint *param) {
+}
+
+void GL_APIENTRY glSamplerParameterf(GLuint sampler, GLenum pname, GLfloat param) {
+}
+
+void GL_APIENTRY glSamplerParameterfv(GLuint sampler, GLenum pname, const GLfloat *param) {
+}
+
+void GL_APIENTRY glGetSamplerParameteriv(GLuint sampler, GLenum pname, GLint *params) {
+}
+
+void GL_APIENTRY glGetSamplerParameterfv(GLuint sampler, GLenum pname, GLfloat *params) {
+}
+
+void GL_APIENTRY glVertexAttribDivisor(GLuint index, GLuint divisor) {
+}
+
+void GL_APIENTRY glBindTransformFeedback(GLenum target, GLuint id) {
+}
+
+void GL_APIENTRY glDeleteTransformFeedbacks(GLsizei n, const GLuint *ids) {
+}
+
+void GL_APIENTRY glGenTransformFeedbacks(GLsizei n, GLuint *ids) {
+    for (GLsizei i = 0; i < n; ++i) {
+        ids[i] = nextName();
+    }
+}
+
+GLboolean GL_APIENTRY glIsTransformFeedback(GLuint id) {
+    return GL_FALSE;
+}
+
+void GL_APIENTRY glPauseTransformFeedback(void) {
+}
+
+void GL_APIENTRY glResumeTransformFeedback(void) {
+}
+
+void GL_APIENTRY glGetProgramBinary(GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary) {
+}
+
+void GL_APIENTRY glProgramBinary(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length) {
+}
+
+void GL_APIENTRY glProgramParameteri(GLuint program, GLenum pname, GLint value) {
+}
+
+void GL_APIENTRY glInvalidateFramebuffer(GLenum target, GLsizei numAttachments, const GLenum *attachments) {
+}
+
+void GL_APIENTRY glInvalidateSubFramebuffer(GLenum target, GLsizei numAttachments, const GLenum *attachments, GLint x, GLint y, GLsizei width, GLsizei height) {
+}
+
+void GL_APIENTRY glTexStorage2D(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height) {
+}
+
+void GL_APIENTRY glTexStorage3D(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height, GLsizei depth) {
+}
+
+void GL_APIENTRY glGetInternalformativ(GLenum target, GLenum internalformat, GLenum pname, GLsizei count, GLint *params) {
+}
+
+__eglMustCastToProperFunctionPointerType EGLAPIENTRY eglGetProcAddress(const char *procname) {
+    return nullptr;
+}
+
+// one display and context that are always current, so shared contexts can be made
+static int stub_display;
+static int stub_context;
+
+EGLDisplay EGLAPIENTRY eglGetCurrentDisplay(void) {
+    return &stub_display;
+}
+
+EGLContext EGLAPIENTRY eglGetCurrentContext(void) {
+    return &stub_context;
+}
+
+EGLBoolean EGLAPIENTRY eglQueryContext(EGLDisplay dpy, EGLContext ctx, EGLint attribute, EGLint *value) {
+    *value = 1;
+    return EGL_TRUE;
+}
+
+EGLBoolean EGLAPIENTRY eglChooseConfig(EGLDisplay dpy, const EGLint *attrib_list, EGLConfig *configs, EGLint config_size, EGLint *num_config) {
+    if (configs && config_size > 0) {
+        configs[0] = &stub_display;
+    }
+    *num_config = 1;
+    return EGL_TRUE;
+}
+
+EGLContext EGLAPIENTRY eglCreateContext(EGLDisplay dpy, EGLConfig config, EGLContext share_context, const EGLint *attrib_list) {
+    return &stub_context;
+}
+
+EGLBoolean EGLAPIENTRY eglDestroyContext(EGLDisplay dpy, EGLContext ctx) {
+    return EGL_TRUE;
+}
+
+EGLSurface EGLAPIENTRY eglCreatePbufferSurface(EGLDisplay dpy, EGLConfig config, const EGLint *attrib_list) {
+    return &stub_display;
+}
+
+EGLBoolean EGLAPIENTRY eglDestroySurface(EGLDisplay dpy, EGLSurface surface) {
+    return EGL_TRUE;
+}
+
+EGLBoolean EGLAPIENTRY eglMakeCurrent(EGLDisplay dpy, EGLSurface draw, EGLSurface read, EGLContext ctx) {
+    return EGL_TRUE;
+}
+
+EGLBoolean EGLAPIENTRY eglReleaseThread(void) {
+    return EGL_TRUE;
+}
+
+const char * EGLAPIENTRY eglQueryString(EGLDisplay dpy, EGLint name) {
+    return "EGL_KHR_surfaceless_context";
+}
+
+EGLint EGLAPIENTRY eglGetError(void) {
+    return EGL_SUCCESS;
+}
+
+}
@@ -0,0 +1,127 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Host replacement for jni.h. The benchmark never calls into Java; these
+ * declarations exist only so that the native core compiles off-device.
+ ***************************************************************************/
+
+#ifndef HOST_JNI_H_
+#define HOST_JNI_H_
+
+#include <stdint.h>
+#include <stdarg.h>
+
+typedef uint8_t  jboolean;
+typedef int8_t   jbyte;
+typedef uint16_t jchar;
+typedef int16_t  jshort;
+typedef int32_t  jint;
+typedef int64_t  jlong;
+typedef float    jfloat;
+typedef double   jdouble;
+typedef jint     jsize;
+
+class _jobject {};
+typedef _jobject* jobject;
+typedef jobject   jclass;
+typedef jobject   jstring;
+typedef jobject   jthrowable;
+typedef jobject   jweak;
+typedef jobject   jarray;
+typedef jarray    jobjectArray;
+typedef jarray    jbooleanArray;
+typedef jarray    jbyteArray;
+typedef jarray    jcharArray;
+typedef jarray    jshortArray;
+typedef jarray    jintArray;
+typedef jarray    jlongArray;
+typedef jarray    jfloatArray;
+typedef jarray    jdoubleArray;
+
+struct _jfieldID;
+typedef struct _jfieldID* jfieldID;
+struct _jmethodID;
+typedef struct _jmethodID* jmethodID;
+
+typedef union jvalue {
+    jboolean z;
+    jbyte    b;
+    jchar    c;
+    jshort   s;
+    jint     i;
+    jlong    j;
+    jfloat   f;
+    jdouble  d;
+    jobject  l;
+} jvalue;
+
+#define JNIEXPORT
+#define JNICALL
+
+#define JNI_FALSE 0
+#define JNI_TRUE  1
+
+#define JNI_OK     0
+#define JNI_ERR    (-1)
+#define JNI_COMMIT 1
+#define JNI_ABORT  2
+
+#define JNI_VERSION_1_6 0x00010006
+
+struct JavaVM;
+
+struct JNIEnv {
+    jint GetJavaVM(JavaVM** vm) { *vm = nullptr; return JNI_OK; }
+    jclass FindClass(const char*) { return nullptr; }
+    jclass GetObjectClass(jobject) { return nullptr; }
+    jmethodID GetMethodID(jclass, const char*, const char*) { return nullptr; }
+    jmethodID GetStaticMethodID(jclass, const char*, const char*) { return nullptr; }
+    jfieldID GetFieldID(jclass, const char*, const char*) { return nullptr; }
+    jobject NewGlobalRef(jobject o) { return o; }
+    jobject NewLocalRef(jobject o) { return o; }
+    jweak NewWeakGlobalRef(jobject o) { return o; }
+    void DeleteGlobalRef(jobject) {}
+    void DeleteLocalRef(jobject) {}
+    void DeleteWeakGlobalRef(jweak) {}
+    jobject NewObject(jclass, jmethodID, ...) { return nullptr; }
+    void CallVoidMethod(jobject, jmethodID, ...) {}
+    jboolean CallBooleanMethod(jobject, jmethodID, ...) { return JNI_FALSE; }
+    jobject CallObjectMethod(jobject, jmethodID, ...) { return nullptr; }
+    void CallStaticVoidMethod(jclass, jmethodID, ...) {}
+    jobject CallStaticObjectMethod(jclass, jmethodID, ...) { return nullptr; }
+    jsize GetArrayLength(jarray) { return 0; }
+    jbyte* GetByteArrayElements(jbyteArray, jboolean*) { return nullptr; }
+    void ReleaseByteArrayElements(jbyteArray, jbyte*, jint) {}
+    void GetByteArrayRegion(jbyteArray, jsize, jsize, jbyte*) {}
+    jfloat* GetFloatArrayElements(jfloatArray, jboolean*) { return nullptr; }
+    void ReleaseFloatArrayElements(jfloatArray, jfloat*, jint) {}
+    jint* GetIntArrayElements(jintArray, jboolean*) { return nullptr; }
+    void ReleaseIntArrayElements(jintArray, jint*, jint) {}
+    const char* GetStringUTFChars(jstring, jboolean*) { return ""; }
+    void ReleaseStringUTFChars(jstring, const char*) {}
+    jstring NewStringUTF(const char*) { return nullptr; }
+    void* GetDirectBufferAddress(jobject) { return nullptr; }
+    jlong GetDirectBufferCapacity(jobject) { return 0; }
+    void FatalError(const char*) {}
+};
+
+struct JavaVM {
+    jint GetEnv(void** env, jint) { *env = nullptr; return JNI_OK; }
+    jint AttachCurrentThread(JNIEnv** env, void*) { *env = nullptr; return JNI_OK; }
+    jint DetachCurrentThread() { return JNI_OK; }
+};
+
+#endif
@@ -16,8 +16,10 @@
 package org.gearvrf;
 
 import android.content.Context;
+import android.content.res.AssetFileDescriptor;
 import android.content.res.Resources;
 import android.graphics.Bitmap;
+import android.os.ParcelFileDescriptor;
 import android.util.TypedValue;
 
 import org.gearvrf.asynchronous.CompressedTexture;
@@ -366,6 +368,42 @@ public class GVRAndroidResource {
         }
     }
 
+    /**
+     * Open the resource as a range of a file, for readers that map it
+     * instead of streaming it.
+     *
+     * Close the descriptor when done; a mapping made from it stays valid.
+     *
+     * @return The file, offset and length of the resource, or {@code null}
+     *         when it is not stored as a plain range of a file: streams,
+     *         network resources and compressed assets.
+     */
+    public AssetFileDescriptor openFileDescriptor() {
+        try {
+            switch (resourceType) {
+            case ANDROID_ASSETS:
+                return context.getResources().getAssets().openFd(assetPath);
+
+            case ANDROID_RESOURCE:
+                return context.getResources().openRawResourceFd(resourceId);
+
+            case LINUX_FILESYSTEM: {
+                File file = new File(filePath);
+                return new AssetFileDescriptor(ParcelFileDescriptor.open(file,
+                        ParcelFileDescriptor.MODE_READ_ONLY), 0, file.length());
+            }
+
+            default:
+                return null;
+            }
+        } catch (IOException e) {
+            // openFd() fails on compressed assets
+            return null;
+        } catch (Resources.NotFoundException e) {
+            return null;
+        }
+    }
+
     /**
      * Save the stream position, for later use with {@link #reset()}.
      * 
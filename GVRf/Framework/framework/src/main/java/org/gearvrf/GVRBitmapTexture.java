@@ -267,6 +267,8 @@ public class GVRBitmapTexture extends GVRTexture {
         GLUtils.texImage2D(GL_TEXTURE_2D, 0, bitmap, 0);
         glGenerateMipmap(GL_TEXTURE_2D);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);        
+        // counts against the texture budget, a third more for the mipmaps
+        NativeTexture.setByteSize(getNative(), bitmap.getByteCount() * 4L / 3);
         return (glGetError() == GL_NO_ERROR);
     }
 
@@ -2702,6 +2702,62 @@ public abstract class GVRContext implements IEventReceiver {
      */
     public abstract void captureScreen3D(GVRScreenshot3DCallback callback);
 
+    /**
+     * Sets how much GPU memory textures may take. Over the budget, the
+     * largest mipmap levels of the textures that have not been drawn for a
+     * while are dropped, and loaded again once those textures are drawn.
+     *
+     * Every texture counts against the budget, render textures included,
+     * but only textures that can be read again give levels back:
+     * compressed textures loaded from KTX files, assets or raw resources.
+     *
+     * @param bytes
+     *            The budget in bytes, or 0 for no budget, the default.
+     */
+    public void setTextureMemoryBudget(long bytes) {
+        NativeTextureResidency.setBudget(bytes);
+    }
+
+    /**
+     * @return The budget set with {@link #setTextureMemoryBudget(long)}
+     */
+    public long getTextureMemoryBudget() {
+        return NativeTextureResidency.getBudget();
+    }
+
+    /**
+     * @return The bytes the textures take on the GPU, see
+     *         {@link #setTextureMemoryBudget(long)}
+     */
+    public long getResidentTextureBytes() {
+        return NativeTextureResidency.getResidentBytes();
+    }
+
+    /**
+     * Limits how many GL objects the GL thread deletes each frame, after
+     * their Java objects have been collected. What is over the limit waits
+     * for the next frames, so dropping a big scene does not stall one
+     * frame. The default is 256 objects or 1 millisecond.
+     *
+     * @param objectsPerFrame
+     *            The most objects deleted in a frame, 0 for no limit.
+     * @param millisPerFrame
+     *            The most time spent on it in a frame, 0 for no limit.
+     */
+    public abstract void setDeletionBudget(int objectsPerFrame, float millisPerFrame);
+
+    /**
+     * @return The GL objects waiting to be deleted, see
+     *         {@link #setDeletionBudget(int, float)}
+     */
+    public abstract int getPendingDeletions();
+
+    /**
+     * @return The GPU memory held by the GL objects waiting to be deleted,
+     *         as far as it is known
+     */
+    public abstract long getPendingDeletionBytes();
+
     private Object mTag;
 
     /**
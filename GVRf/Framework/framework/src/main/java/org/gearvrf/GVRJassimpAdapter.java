@@ -5,7 +5,6 @@ import android.graphics.BitmapFactory;
 
 import java.io.ByteArrayInputStream;
 import java.io.IOException;
-import java.nio.CharBuffer;
 import java.nio.FloatBuffer;
 import java.nio.IntBuffer;
 import java.util.ArrayList;
@@ -57,6 +56,8 @@ class GVRJassimpAdapter {
     private AiScene mScene;
     private GVRContext mContext;
     private String mFileName;
+    private boolean mOptimizeVertexOrder;
+    private boolean mReduceOverdraw;
     private static final int MAX_TEX_COORDS = 8;
 
     public interface INodeFactory {
@@ -136,11 +137,9 @@ class GVRJassimpAdapter {
         // Triangles
         IntBuffer indexBuffer = aiMesh.getIndexBuffer();
         if (indexBuffer != null) {
-            CharBuffer triangles = CharBuffer.allocate(indexBuffer.capacity());
-            for (int i = 0; i < indexBuffer.capacity(); ++i) {
-                triangles.put((char)indexBuffer.get());
-            }
-            mesh.setIndices(triangles.array());
+            int[] triangles = new int[indexBuffer.capacity()];
+            indexBuffer.get(triangles);
+            mesh.setIndices(triangles);
         }
 
         // Bones
@@ -152,6 +151,9 @@ class GVRJassimpAdapter {
             mesh.setBones(bones);
         }
 
+        if (mOptimizeVertexOrder) {
+            mesh.optimize(mReduceOverdraw);
+        }
         return mesh;
     }
 
@@ -258,7 +260,15 @@ class GVRJassimpAdapter {
     public Set<AiPostProcessSteps> toJassimpSettings(EnumSet<GVRImportSettings> settings) {
         Set<AiPostProcessSteps> output = new HashSet<AiPostProcessSteps>();
 
+        // done by GVRMesh rather than assimp
+        mOptimizeVertexOrder = settings.contains(GVRImportSettings.OPTIMIZE_VERTEX_ORDER);
+        mReduceOverdraw = settings.contains(GVRImportSettings.REDUCE_OVERDRAW);
+
         for (GVRImportSettings setting : settings) {
+            if (setting == GVRImportSettings.OPTIMIZE_VERTEX_ORDER
+                    || setting == GVRImportSettings.REDUCE_OVERDRAW) {
+                continue;
+            }
             AiPostProcessSteps aiSetting = fromGVRSetting(setting);
             if (aiSetting != null) {
                 output.add(aiSetting);
@@ -36,6 +36,26 @@ import org.gearvrf.utility.Log;
 
     GVRMaterialShaderManager(GVRContext gvrContext) {
         super(gvrContext, NativeShaderManager.ctor());
+        NativeShaderManager.setProgramCacheDir(gvrContext.getContext()
+                .getCacheDir().getAbsolutePath());
+    }
+
+    /**
+     * Builds the shader programs the materials of a scene use ahead of
+     * their first draw, so a material appearing for the first time does
+     * not stall the frame on compiling its shader.
+     *
+     * The programs are built on the GL thread, a few per frame, starting
+     * with the next frame. Programs built before (in this or an earlier
+     * run) load from the program binary cache in the app's cache
+     * directory.
+     *
+     * @param scene
+     *            The scene whose materials to prepare; objects added later
+     *            need another call.
+     */
+    public void prewarm(GVRScene scene) {
+        NativeShaderManager.prewarm(getNative(), scene.getNative());
     }
 
     @Override
@@ -129,4 +149,8 @@ class NativeShaderManager {
             String fragmentShader);
 
     static native long getCustomShader(long shaderManager, int id);
+
+    static native void setProgramCacheDir(String directory);
+
+    static native void prewarm(long shaderManager, long scene);
 }
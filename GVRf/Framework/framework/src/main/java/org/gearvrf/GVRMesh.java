@@ -179,12 +179,24 @@ public class GVRMesh extends GVRHybridObject implements PrettyPrint {
      * Get the vertex indices of the mesh. The indices for each
      * vertex to be referenced.
      * 
-     * @return Array with the packed index data.
+     * @return Array with the packed index data, or {@code null} if the
+     *         mesh has indices which do not fit in 16 bits; use
+     *         {@link #getIntIndices()} for those.
      */
     public char[] getIndices() {
         return NativeMesh.getIndices(getNative());
     }
 
+    /**
+     * Get the vertex indices of the mesh as 32-bit values. Works for
+     * meshes of any size.
+     * 
+     * @return Array with the packed index data.
+     */
+    public int[] getIntIndices() {
+        return NativeMesh.getIntIndices(getNative());
+    }
+
     /**
      * Sets the vertex indices of the mesh. The indices for each
      * vertex.
@@ -196,6 +208,33 @@ public class GVRMesh extends GVRHybridObject implements PrettyPrint {
         NativeMesh.setIndices(getNative(), indices);
     }
 
+    /**
+     * Sets the vertex indices of the mesh from 32-bit values, for meshes
+     * with more than 65536 vertices. The mesh still draws with 16-bit
+     * indices when they all fit.
+     * 
+     * @param indices
+     *            Array containing the packed index data.
+     */
+    public void setIndices(int[] indices) {
+        NativeMesh.setIntIndices(getNative(), indices);
+    }
+
+    /**
+     * Reorders the triangles of the mesh for the post-transform vertex
+     * cache and renumbers its vertices in the order they are drawn. Bone
+     * weights refer to vertices, so skinned meshes keep their vertex
+     * order. Call it after the vertices, attributes, indices and bones
+     * are set.
+     * 
+     * @param reduceOverdraw
+     *            Also sort clusters of triangles so faces on the outside
+     *            of the mesh tend to draw first.
+     */
+    public void optimize(boolean reduceOverdraw) {
+        NativeMesh.optimize(getNative(), reduceOverdraw);
+    }
+
     /**
      * Get the array of {@code float} scalars bound to the shader attribute
      * {@code key}.
@@ -415,7 +454,7 @@ public class GVRMesh extends GVRHybridObject implements PrettyPrint {
     public void prettyPrint(StringBuffer sb, int indent) {
         sb.append(getVertices() == null ? 0 : Integer.toString(getVertices().length / 3));
         sb.append(" vertices, ");
-        sb.append(getIndices() == null ? 0 : Integer.toString(getIndices().length / 3));
+        sb.append(Integer.toString(getIntIndices().length / 3));
         sb.append(" triangles, ");
         sb.append(getTexCoords() == null ? 0 : Integer.toString(getTexCoords().length / 2));
         sb.append(" tex-coords, ");
@@ -499,6 +538,10 @@ class NativeMesh {
 
     static native void setIndices(long mesh, char[] indices);
 
+    static native int[] getIntIndices(long mesh);
+
+    static native void setIntIndices(long mesh, int[] indices);
+
     static native float[] getFloatVector(long mesh, String key);
 
     static native void setFloatVector(long mesh, String key, float[] floatVector);
@@ -522,4 +565,6 @@ class NativeMesh {
     static native void getSphereBound(long mesh, float[] sphere);
     
     static native boolean hasAttribute(long mesh, String key);
+
+    static native void optimize(long mesh, boolean reduceOverdraw);
 }
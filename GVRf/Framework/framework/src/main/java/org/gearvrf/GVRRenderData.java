@@ -905,6 +905,30 @@ public class GVRRenderData extends GVRComponent implements PrettyPrint {
     public void setCastShadows(boolean castShadows) {
         NativeRenderData.setCastShadows(getNative(), castShadows);
     }
+
+    /**
+     * Checks if the mesh of this object hides what is behind it from
+     * occlusion culling.
+     * @returns true if the object is an occluder.
+     * @see GVRRenderData.setOccluder
+     */
+    public boolean isOccluder() {
+        return NativeRenderData.isOccluder(getNative());
+    }
+
+    /**
+     * Marks the object as an occluder. When the scene has occlusion
+     * culling enabled, the meshes of the visible occluders are drawn into
+     * a small depth buffer on the CPU, and objects hidden behind them are
+     * not rendered. Large, simple, opaque meshes like walls and terrain
+     * make good occluders; the first few thousand triangles nearest the
+     * camera are used.
+     * @param occluder true to occlude other objects
+     * @see GVRScene.setOcclusionQuery
+     */
+    public void setOccluder(boolean occluder) {
+        NativeRenderData.setOccluder(getNative(), occluder);
+    }
     @Override
     public void prettyPrint(StringBuffer sb, int indent) {
         GVRMesh mesh = null;
@@ -1008,4 +1032,8 @@ class NativeRenderData {
     public static native void setCastShadows(long renderData, boolean castShadows);
 
     public static native boolean getCastShadows(long renderData);
+
+    public static native void setOccluder(long renderData, boolean occluder);
+
+    public static native boolean isOccluder(long renderData);
 }
@@ -130,6 +130,15 @@ public class GVRRenderTexture extends GVRTexture {
         return NativeRenderTexture.readRenderResult(getNative(), readbackBuffer);
     }
 
+    /**
+     * Whether the pixels read since the last {@link #readRenderResult(int[])}
+     * are in, so reading them does not wait for the GPU. Called on the GL
+     * thread.
+     */
+    boolean isReadBackDone() {
+        return NativeRenderTexture.isReadBackDone(getNative());
+    }
+
     /**
      * Bind the framebuffer for this GVRRenderTexture.
      *      
@@ -157,5 +166,7 @@ class NativeRenderTexture {
 
     static native boolean readRenderResult(long ptr, int[] readbackBuffer);
 
+    static native boolean isReadBackDone(long ptr);
+
     static native void bind(long ptr);
 }
@@ -286,7 +286,11 @@ public class GVRScene extends GVRHybridObject implements PrettyPrint, IScriptabl
     }
 
     /**
-     * Sets the occlusion query for the {@link GVRScene}.
+     * Enables occlusion culling for the {@link GVRScene}. Objects hidden
+     * behind the scene's occluders are not rendered. Occlusion is tested
+     * on the CPU in the same frame.
+     *
+     * @see GVRRenderData#setOccluder(boolean)
      */
     public void setOcclusionQuery(boolean flag) {
         NativeScene.setOcclusionQuery(getNative(), flag);
@@ -347,9 +351,15 @@ public class GVRScene extends GVRHybridObject implements PrettyPrint, IScriptabl
         if (mStatsEnabled) {
             int numberDrawCalls = NativeScene.getNumberDrawCalls(getNative());
             int numberTriangles = NativeScene.getNumberTriangles(getNative());
+            int numberInstances = NativeScene.getNumberInstances(getNative());
+            int numberStateChanges = NativeScene.getNumberStateChanges(getNative());
+            int numberSkippedStateChanges = NativeScene.getNumberSkippedStateChanges(getNative());
 
             mStatsConsole.writeLine("Draw Calls: %d", numberDrawCalls);
             mStatsConsole.writeLine("Triangles: %d", numberTriangles);
+            mStatsConsole.writeLine("Instances: %d", numberInstances);
+            mStatsConsole.writeLine("State Changes: %d (%d skipped)",
+                    numberStateChanges, numberSkippedStateChanges);
 
             if (mStatMessage.length() > 0) {
                 String lines[] = mStatMessage.toString().split(System.lineSeparator());
@@ -717,6 +727,12 @@ class NativeScene {
 
     public static native int getNumberTriangles(long scene);
 
+    public static native int getNumberInstances(long scene);
+
+    public static native int getNumberStateChanges(long scene);
+
+    public static native int getNumberSkippedStateChanges(long scene);
+
     public static native void exportToFile(long scene, String file_path);
 
     static native boolean addLight(long scene, long light);
@@ -290,4 +290,6 @@ class NativeTexture {
 
     static native void updateTextureParameters(long texture,
             int[] textureParametersValues);
+
+    static native void setByteSize(long texture, long bytes);
 }
@@ -42,6 +42,41 @@ public class GVRTextureCapturer extends GVRHybridObject {
 
     protected List<TextureCapturerListener> mListeners;
 
+    private final GVRDrawFrameListener mReadBackListener = new GVRDrawFrameListener() {
+        @Override
+        public void onDrawFrame(float frameTime) {
+            if (!captureTexture.isReadBackDone()) {
+                return;
+            }
+            getGVRContext().unregisterDrawFrameListener(this);
+
+            boolean readOk = captureTexture.readRenderResult(readBackBuffer);
+            if (!readOk) {
+                synchronized (processingLock) {
+                    processingCapturedTexture = false;
+                }
+                return;
+            }
+
+            Threads.spawn(new Runnable() {
+                @Override
+                public void run()
+                {
+                    Bitmap capturedBitmap = ImageUtils.generateBitmap(readBackBuffer,
+                                                                      width, height);
+                    // Wait for all listeners before processing another frame
+                    for (TextureCapturerListener l : mListeners) {
+                        l.onTextureCaptured(capturedBitmap);
+                    }
+
+                    synchronized (processingLock) {
+                        processingCapturedTexture = false;
+                    }
+                }
+            });
+        }
+    };
+
     /**
      * Constructs a texture capturer with a backing texture with width * height pixels.
      *
@@ -158,36 +193,8 @@ public class GVRTextureCapturer extends GVRHybridObject {
                     processingCapturedTexture = true;
                 }
 
-                getGVRContext().runOnGlThreadPostRender(1 /* delay 1 frame */, new Runnable() {
-                    @Override
-                    public void run()
-                    {
-                        boolean readOk = captureTexture.readRenderResult(readBackBuffer);
-                        if (!readOk) {
-                            synchronized (processingLock) {
-                                processingCapturedTexture = false;
-                            }
-                            return;
-                        }
-
-                        Threads.spawn(new Runnable() {
-                            @Override
-                            public void run()
-                            {
-                                Bitmap capturedBitmap = ImageUtils.generateBitmap(readBackBuffer,
-                                                                                  width, height);
-                                // Wait for all listeners before processing another frame
-                                for (TextureCapturerListener l : mListeners) {
-                                    l.onTextureCaptured(capturedBitmap);
-                                }
-
-                                synchronized (processingLock) {
-                                    processingCapturedTexture = false;
-                                }
-                            }
-                        });
-                    }
-                });
+                // looks for the pixels each frame, and reads them once the GPU is done
+                getGVRContext().registerDrawFrameListener(mReadBackListener);
                 break;
         }
     }
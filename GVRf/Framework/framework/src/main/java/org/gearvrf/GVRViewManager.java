@@ -65,6 +65,7 @@ abstract class GVRViewManager extends GVRContext {
 
     void onDestroy() {
         mInputManager.close();
+        NativeTextureLoader.stop();
     }
 
     public GVREventManager getEventManager() {
@@ -175,6 +176,10 @@ abstract class GVRViewManager extends GVRContext {
         // prevent non-GL thread from calling GL functions
         mGLThreadID = currentThread.getId();
         mGlDeleterPtr = NativeGLDelete.ctor();
+        if (mMaxDeletes >= 0) {
+            NativeGLDelete.setBudget(mGlDeleterPtr, mMaxDeletes, mMaxDeleteNanos);
+        }
+        NativeTextureLoader.start();
 
         // Evaluating anisotropic support on GL Thread
         String extensions = GLES20.glGetString(GLES20.GL_EXTENSIONS);
@@ -463,6 +468,25 @@ abstract class GVRViewManager extends GVRContext {
         }
     }
 
+    @Override
+    public void setDeletionBudget(int objectsPerFrame, float millisPerFrame) {
+        mMaxDeletes = objectsPerFrame;
+        mMaxDeleteNanos = (long) (millisPerFrame * 1000000.0f);
+        if (0 != mGlDeleterPtr) {
+            NativeGLDelete.setBudget(mGlDeleterPtr, mMaxDeletes, mMaxDeleteNanos);
+        }
+    }
+
+    @Override
+    public int getPendingDeletions() {
+        return 0 != mGlDeleterPtr ? NativeGLDelete.getPending(mGlDeleterPtr) : 0;
+    }
+
+    @Override
+    public long getPendingDeletionBytes() {
+        return 0 != mGlDeleterPtr ? NativeGLDelete.getPendingBytes(mGlDeleterPtr) : 0;
+    }
+
     @Override
     public void finalize() throws Throwable {
         try {
@@ -598,6 +622,9 @@ abstract class GVRViewManager extends GVRContext {
     protected GVRMain mMain;
 
     protected long mGlDeleterPtr;
+    // set before there is a deleter, -1 for the defaults
+    private int mMaxDeletes = -1;
+    private long mMaxDeleteNanos;
 
 
     protected native void renderCamera(long scene, long camera, long shaderManager,
@@ -5,4 +5,7 @@ class NativeGLDelete {
     static native void dtor(long ptr);
     static native void processQueues(long ptr);
     static native void createTlsKey();
+    static native void setBudget(long ptr, int maxDeletes, long maxNanos);
+    static native int getPending(long ptr);
+    static native long getPendingBytes(long ptr);
 }
@@ -0,0 +1,27 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package org.gearvrf;
+
+/**
+ * The native texture loader: a thread with a GL context shared with the
+ * GL thread's that uploads texture images in the background. Started on
+ * the GL thread once its context is current; without it textures upload
+ * on the GL thread at first use.
+ */
+class NativeTextureLoader {
+    static native boolean start();
+    static native void stop();
+}
@@ -0,0 +1,27 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package org.gearvrf;
+
+/**
+ * The native texture residency manager: keeps the textures within a GPU
+ * memory budget by evicting levels of the ones that can be reloaded, see
+ * {@link GVRContext#setTextureMemoryBudget(long)}.
+ */
+class NativeTextureResidency {
+    static native void setBudget(long bytes);
+    static native long getBudget();
+    static native long getResidentBytes();
+}
@@ -101,6 +101,12 @@ class AsyncCompressedTexture {
 
         @Override
         protected CompressedTexture loadResource() {
+            CompressedTexture mapped = MappedKtxTexture.map(resource);
+            if (mapped != null) {
+                Log.d("ASYNC", "mapped compressed texture %s", resource);
+                return mapped;
+            }
+
             GVRCompressedTextureLoader loader = resource.getCompressedLoader();
             CompressedTexture compressedTexture = null;
             try {
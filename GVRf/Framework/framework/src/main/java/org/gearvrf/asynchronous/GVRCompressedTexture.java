@@ -90,6 +90,30 @@ public class GVRCompressedTexture extends GVRTexture {
         updateMinification();
     }
 
+    // A mapped KTX file, see MappedKtxTexture; the native texture owns it
+    GVRCompressedTexture(GVRContext gvrContext, long ktxFile, int levels,
+            int quality, GVRTextureParameters textureParameters) {
+        super(gvrContext, NativeCompressedTexture.ktxConstructor(ktxFile,
+                withMinification(textureParameters.getCurrentValuesArray(),
+                        levels, GVRCompressedTexture.clamp(quality))));
+        mLevels = levels;
+        mQuality = GVRCompressedTexture.clamp(quality);
+    }
+
+    /*
+     * What updateMinification() sets, put into the parameters: the texture
+     * is still streaming, binding it here would wait for all of it.
+     */
+    private static int[] withMinification(int[] textureParameterValues,
+            int levels, int quality) {
+        if (levels > 1) {
+            textureParameterValues[0] = selectMipMapMinification(quality);
+        } else if (quality == QUALITY) {
+            textureParameterValues[0] = GL_LINEAR;
+        }
+        return textureParameterValues;
+    }
+
     private void updateMinification() {
         boolean rebound = true; // in 2 out of 3 branches ...
         if (mLevels > 1) {
@@ -167,4 +191,6 @@ class NativeCompressedTexture {
             int[] textureParameterValues);
 
     static native long mipmappedConstructor(int target);
+
+    static native long ktxConstructor(long ktxFile, int[] textureParameterValues);
 }
\ No newline at end of file
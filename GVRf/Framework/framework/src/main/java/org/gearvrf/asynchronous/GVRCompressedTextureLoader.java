@@ -209,6 +209,7 @@ public abstract class GVRCompressedTextureLoader {
         new AdaptiveScalableTextureCompression().register();
         new EricssonTextureCompression2().register();
         new KTX().register();
+        new KTX2().register();
     }
 
     /** Utility class for reading big- and little-endian numbers from a header */
@@ -0,0 +1,52 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package org.gearvrf.asynchronous;
+
+import org.gearvrf.utility.RuntimeAssertion;
+
+/**
+ * Recognizes KTX 2.0 files, so they are loaded as compressed textures.
+ * Only the native code reads them, from a mapped file: see
+ * {@link MappedKtxTexture}.
+ */
+class KTX2 extends GVRCompressedTextureLoader {
+
+    private static final int[] SIGNATURE = {
+            // '«', 'K', 'T', 'X', ' ', '2', '0', '»', '\r', '\n', '\x1A', '\n'
+            0xAB4B5458, 0x203230BB, 0x0D0A1A0A };
+
+    @Override
+    public int headerLength() {
+        return SIGNATURE.length * Reader.INTEGER_BYTES;
+    }
+
+    @Override
+    public boolean sniff(byte[] data, Reader reader) {
+        for (int chunk : SIGNATURE) {
+            if (chunk != reader.readBE(Reader.INTEGER_BYTES)) {
+                return false;
+            }
+        }
+        // else
+        return true;
+    }
+
+    @Override
+    public CompressedTexture parse(byte[] data, Reader reader) {
+        throw new RuntimeAssertion(
+                "KTX2 textures are only read from files, assets and resources");
+    }
+}
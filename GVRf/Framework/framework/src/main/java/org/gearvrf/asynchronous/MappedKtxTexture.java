@@ -0,0 +1,115 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package org.gearvrf.asynchronous;
+
+import java.io.IOException;
+import java.nio.ByteBuffer;
+
+import org.gearvrf.GVRAndroidResource;
+import org.gearvrf.GVRContext;
+import org.gearvrf.GVRTextureParameters;
+import org.gearvrf.utility.Log;
+
+import android.content.res.AssetFileDescriptor;
+
+/**
+ * A KTX or KTX2 file mapped by the native code instead of read into a byte
+ * array. Its levels are uploaded on the texture loader thread, smallest
+ * first, so the texture can be drawn before the big levels are in.
+ */
+class MappedKtxTexture extends CompressedTexture {
+
+    private static final String TAG = Log.tag(MappedKtxTexture.class);
+
+    private static final ByteBuffer NO_DATA = ByteBuffer.allocate(0);
+
+    // the native KtxFile, until a texture takes it over
+    private long mFile;
+
+    private MappedKtxTexture(long file, int[] info) {
+        super(info[0], info[1], info[2], -1, info[3], NO_DATA);
+        mFile = file;
+    }
+
+    /**
+     * Maps the resource if it is a KTX file stored as a range of a file.
+     *
+     * @return {@code null} when the resource cannot be mapped or is not a
+     *         file the native code reads; parse it as a stream then.
+     */
+    static MappedKtxTexture map(GVRAndroidResource resource) {
+        AssetFileDescriptor descriptor = resource.openFileDescriptor();
+        if (descriptor == null) {
+            return null;
+        }
+        try {
+            int[] info = new int[5];
+            long file = NativeKtxFile.open(
+                    descriptor.getParcelFileDescriptor().getFd(),
+                    descriptor.getStartOffset(), descriptor.getLength(), info);
+            if (file == 0) {
+                return null;
+            }
+            if (info[4] != 1) {
+                // cube maps go through the cubemap loaders
+                NativeKtxFile.delete(file);
+                return null;
+            }
+            Log.d(TAG, "mapped %s: internalformat = %x, %dx%d, %d levels",
+                    resource, info[0], info[1], info[2], info[3]);
+            return new MappedKtxTexture(file, info);
+        } finally {
+            try {
+                descriptor.close();
+            } catch (IOException e) {
+                e.printStackTrace();
+            }
+        }
+    }
+
+    @Override
+    GVRCompressedTexture toTexture(GVRContext gvrContext, int quality) {
+        return toTexture(gvrContext, quality,
+                gvrContext.DEFAULT_TEXTURE_PARAMETERS);
+    }
+
+    @Override
+    synchronized GVRCompressedTexture toTexture(GVRContext gvrContext,
+            int quality, GVRTextureParameters textureParameters) {
+        long file = mFile;
+        mFile = 0;
+        return new GVRCompressedTexture(gvrContext, file, levels, quality,
+                textureParameters);
+    }
+
+    @Override
+    protected synchronized void finalize() throws Throwable {
+        try {
+            if (mFile != 0) {
+                NativeKtxFile.delete(mFile);
+                mFile = 0;
+            }
+        } finally {
+            super.finalize();
+        }
+    }
+}
+
+class NativeKtxFile {
+    static native long open(int fd, long offset, long length, int[] info);
+
+    static native void delete(long file);
+}
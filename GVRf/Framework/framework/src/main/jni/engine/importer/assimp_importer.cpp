@@ -20,6 +20,7 @@
 #include "assimp_importer.h"
 
 #include "objects/mesh.h"
+#include "objects/mesh_optimizer.h"
 
 namespace gvr {
 Mesh* AssimpImporter::getMesh(int index) {
@@ -51,6 +52,21 @@ Mesh* AssimpImporter::getMesh(int index) {
         mesh->set_normals(std::move(normals));
     }
 
+    if (ai_mesh->HasTangentsAndBitangents()) {
+        std::vector<glm::vec3> tangents;
+        std::vector<glm::vec3> bitangents;
+        for (int i = 0; i < ai_mesh->mNumVertices; ++i) {
+            tangents.push_back(
+                    glm::vec3(ai_mesh->mTangents[i].x, ai_mesh->mTangents[i].y,
+                            ai_mesh->mTangents[i].z));
+            bitangents.push_back(
+                    glm::vec3(ai_mesh->mBitangents[i].x, ai_mesh->mBitangents[i].y,
+                            ai_mesh->mBitangents[i].z));
+        }
+        mesh->setVec3Vector("a_tangent", tangents);
+        mesh->setVec3Vector("a_bitangent", bitangents);
+    }
+
 
     if (ai_mesh->mTextureCoords[0] != 0) {
         std::vector<glm::vec2> tex_coords;
@@ -63,7 +79,7 @@ Mesh* AssimpImporter::getMesh(int index) {
         mesh->setVec2Vector(std::string("a_texcoord"),tex_coords);
     }
 
-    std::vector<unsigned short> triangles;
+    std::vector<unsigned int> triangles;
     for (int i = 0; i < ai_mesh->mNumFaces; ++i) {
         if (ai_mesh->mFaces[i].mNumIndices == 3) {
             triangles.push_back(ai_mesh->mFaces[i].mIndices[0]);
@@ -81,6 +97,22 @@ Mesh* AssimpImporter::getMesh(int index) {
     }
     mesh->set_triangles(std::move(triangles));
 
+    if (settings_ & OPTIMIZE_VERTEX_ORDER) {
+        MeshOptimizer::optimize(mesh, settings_ & REDUCE_OVERDRAW);
+    }
+
+    // compact vertex buffer, encoded here rather than on the GL thread;
+    // texture coordinates outside [0, 1] stay floats
+    mesh->setAttributeEncoding("a_position", Mesh::HALF);
+    mesh->setAttributeEncoding("a_normal", Mesh::SNORM_2_10_10_10);
+    mesh->setAttributeEncoding("a_tangent", Mesh::SNORM_2_10_10_10);
+    mesh->setAttributeEncoding("a_bitangent", Mesh::SNORM_2_10_10_10);
+    mesh->setAttributeEncoding("a_texcoord", Mesh::UNORM16);
+    mesh->encodeVertices();
+    LOGI("AssimpImporter: mesh %d, %d vertices, %d bytes of vertex buffer, %d as floats",
+            index, ai_mesh->mNumVertices, (int) mesh->vertexBufferSize(),
+            (int) mesh->floatVertexSize());
+
     return mesh;
 }
 }
@@ -50,8 +50,13 @@ class Mesh;
 
 class AssimpImporter: public HybridObject {
 public:
-    AssimpImporter(Assimp::Importer* assimp_importer) :
-            assimp_importer_(assimp_importer) {
+    // GVRImportSettings bits handled here, not by assimp
+    static const int OPTIMIZE_VERTEX_ORDER = 0x20000000;
+    static const int REDUCE_OVERDRAW = 0x40000000;
+    static const int GVR_SETTINGS = OPTIMIZE_VERTEX_ORDER | REDUCE_OVERDRAW;
+
+    AssimpImporter(Assimp::Importer* assimp_importer, int settings = 0) :
+            assimp_importer_(assimp_importer), settings_(settings & GVR_SETTINGS) {
     }
 
     ~AssimpImporter() {
@@ -74,6 +79,7 @@ public:
 
 private:
     Assimp::Importer* assimp_importer_;
+    int settings_;
 };
 }
 #endif
@@ -31,14 +31,15 @@ AssimpImporter* Importer::readFileFromAssets(char* buffer, long size,
             hint = hint + 1;
         }
     }
-    importer->ReadFileFromMemory(buffer, size, settings, hint);
+    importer->ReadFileFromMemory(buffer, size,
+            settings & ~AssimpImporter::GVR_SETTINGS, hint);
 
-    return new AssimpImporter(importer);
+    return new AssimpImporter(importer, settings);
 }
 
 AssimpImporter* Importer::readFileFromSDCard(const char * filename, int settings) {
     Assimp::Importer* importer = new Assimp::Importer();
-    importer->ReadFile(filename, settings);
-    return new AssimpImporter(importer);
+    importer->ReadFile(filename, settings & ~AssimpImporter::GVR_SETTINGS);
+    return new AssimpImporter(importer, settings);
 }
 }
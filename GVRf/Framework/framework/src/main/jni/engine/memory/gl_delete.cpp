@@ -16,6 +16,10 @@
 #include "util/gvr_log.h"
 #include "gl_delete.h"
 #include "util/gvr_cpp_stack_trace.h"
+#include "gl/gl_state_cache.h"
+#include "util/gvr_time.h"
+
+#include <climits>
 
 //#define VERBOSE_LOGGING
 
@@ -23,167 +27,279 @@ namespace gvr {
 
 pthread_key_t deleter_key;
 
+static const char* kind_names[GlDelete::KIND_COUNT] = {
+        "frame buffers", "vertex arrays", "textures", "render buffers",
+        "buffers", "programs", "shaders" };
+
+GlDelete::GlDelete() :
+        max_deletes_(DEFAULT_MAX_DELETES), max_nanos_(DEFAULT_MAX_NANOS),
+        deleted_last_frame_(0), peak_pending_(0), report_pending_(REPORT_PENDING) {
+    for (int kind = 0; kind < KIND_COUNT; ++kind) {
+        Queue& queue = queues_[kind];
+        queue.head.store(nullptr, std::memory_order_relaxed);
+        queue.pending.store(0, std::memory_order_relaxed);
+        queue.pending_bytes.store(0, std::memory_order_relaxed);
+        queue.backlog = nullptr;
+        queue.backlog_tail = nullptr;
+    }
+
+    int err = pthread_setspecific(deleter_key, this);
+    if (0 != err) {
+        LOGE("fatal error: pthread_setspecific failed with %d!", err);
+        std::terminate();
+    }
+
+    LOGV("GlDelete(): %p tid: %d", this, gettid());
+}
+
+GlDelete::~GlDelete() {
+    LOGV("~GlDelete(): %p tid: %d", this, gettid());
+    // the context goes with the deleter, and the objects with it
+    for (int kind = 0; kind < KIND_COUNT; ++kind) {
+        Queue& queue = queues_[kind];
+        takeQueued(queue);
+        while (nullptr != queue.backlog) {
+            Node* node = queue.backlog;
+            queue.backlog = node->next;
+            delete node;
+        }
+    }
+}
+
 void GlDelete::logInvalidParameter(const char *funcName) {
     LOGW("GlDelete::%s is called with an invalid parameter", funcName);
     printStackTrace();
 }
 
-void GlDelete::queueBuffer(GLuint buffer) {
-    if (buffer == GVR_INVALID) {
-        logInvalidParameter(__func__);
+void GlDelete::queue(Kind kind, GLuint handle, size_t bytes, const char* func) {
+    if (handle == GVR_INVALID) {
+        logInvalidParameter(func);
         return;
     }
 
-    lock();
-    buffers_.push_back(buffer);
+    Queue& queue = queues_[kind];
+    Node* node = new Node;
+    node->handle = handle;
+    node->bytes = bytes;
+    node->next = queue.head.load(std::memory_order_relaxed);
+    while (!queue.head.compare_exchange_weak(node->next, node,
+            std::memory_order_release, std::memory_order_relaxed)) {
+    }
+    queue.pending.fetch_add(1, std::memory_order_relaxed);
+    queue.pending_bytes.fetch_add(bytes, std::memory_order_relaxed);
 #ifdef VERBOSE_LOGGING
-    LOGD("queueBuffer(%d) buffers_.size() = %d", buffer, buffers_.size());
+    LOGD("%s(%d) pending %s = %d", func, handle, kind_names[kind],
+            queue.pending.load(std::memory_order_relaxed));
 #endif
-    dirty = true;
-    unlock();
 }
 
-void GlDelete::queueFrameBuffer(GLuint buffer) {
-    if (buffer == GVR_INVALID) {
-        logInvalidParameter(__func__);
-        return;
-    }
+void GlDelete::queueBuffer(GLuint buffer, size_t bytes) {
+    queue(BUFFERS, buffer, bytes, __func__);
+}
 
-    lock();
-    frame_buffers_.push_back(buffer);
-#ifdef VERBOSE_LOGGING
-    LOGD("queueFrameBuffer(%d) frame_buffers_.size() = %d", buffer,
-            frame_buffers_.size());
-#endif
-    dirty = true;
-    unlock();
+void GlDelete::queueFrameBuffer(GLuint buffer) {
+    queue(FRAME_BUFFERS, buffer, 0, __func__);
 }
 
 void GlDelete::queueProgram(GLuint program) {
-    if (program == GVR_INVALID) {
-        logInvalidParameter(__func__);
-        return;
-    }
-
-    lock();
-    programs_.push_back(program);
-#ifdef VERBOSE_LOGGING
-    LOGD("queueProgram(%d) programs_.size() = %d", program, programs_.size());
-#endif
-    dirty = true;
-    unlock();
+    queue(PROGRAMS, program, 0, __func__);
 }
 
-void GlDelete::queueRenderBuffer(GLuint buffer) {
-    if (buffer == GVR_INVALID) {
-        logInvalidParameter(__func__);
-        return;
-    }
-
-    lock();
-    render_buffers_.push_back(buffer);
-#ifdef VERBOSE_LOGGING
-    LOGD("queueRenderBuffer(%d) render_buffers_.size() = %d", buffer,
-            render_buffers_.size());
-#endif
-    dirty = true;
-    unlock();
+void GlDelete::queueRenderBuffer(GLuint buffer, size_t bytes) {
+    queue(RENDER_BUFFERS, buffer, bytes, __func__);
 }
 
 void GlDelete::queueShader(GLuint shader) {
-    if (shader == GVR_INVALID) {
-        logInvalidParameter(__func__);
-        return;
-    }
+    queue(SHADERS, shader, 0, __func__);
+}
 
-    lock();
-    shaders_.push_back(shader);
-#ifdef VERBOSE_LOGGING
-    LOGD("queueShader(%d) shaders_.size() = %d", shader, shaders_.size());
-#endif
-    dirty = true;
-    unlock();
+void GlDelete::queueTexture(GLuint texture, size_t bytes) {
+    queue(TEXTURES, texture, bytes, __func__);
 }
 
-void GlDelete::queueTexture(GLuint texture) {
-    if (texture == GVR_INVALID) {
-        logInvalidParameter(__func__);
-        return;
+void GlDelete::queueVertexArray(GLuint vertex_array) {
+    queue(VERTEX_ARRAYS, vertex_array, 0, __func__);
+}
+
+int GlDelete::pending() const {
+    int count = 0;
+    for (int kind = 0; kind < KIND_COUNT; ++kind) {
+        count += queues_[kind].pending.load(std::memory_order_relaxed);
     }
+    return count;
+}
 
-    lock();
-    textures_.push_back(texture);
-#ifdef VERBOSE_LOGGING
-    LOGD("queueTexture(%d) textures_.size() = %d", texture, textures_.size());
-#endif
-    dirty = true;
-    unlock();
+size_t GlDelete::pending_bytes() const {
+    size_t bytes = 0;
+    for (int kind = 0; kind < KIND_COUNT; ++kind) {
+        bytes += queues_[kind].pending_bytes.load(std::memory_order_relaxed);
+    }
+    return bytes;
 }
 
-void GlDelete::queueVertexArray(GLuint vertex_array) {
-    if (vertex_array == GVR_INVALID) {
-        logInvalidParameter(__func__);
+/*
+ * Moves what the other threads queued since to the end of the backlog,
+ * turned around so the oldest handle goes first.
+ */
+void GlDelete::takeQueued(Queue& queue) {
+    Node* node = queue.head.exchange(nullptr, std::memory_order_acquire);
+    if (nullptr == node) {
         return;
     }
+    Node* tail = node;
+    Node* taken = nullptr;
+    while (nullptr != node) {
+        Node* next = node->next;
+        node->next = taken;
+        taken = node;
+        node = next;
+    }
+    if (nullptr == queue.backlog) {
+        queue.backlog = taken;
+    } else {
+        queue.backlog_tail->next = taken;
+    }
+    queue.backlog_tail = tail;
+}
 
-    lock();
-    vertex_arrays_.push_back(vertex_array);
-#ifdef VERBOSE_LOGGING
-    LOGD("queueVertexArray(%d) vertex_arrays_.size() = %d", vertex_array,
-            vertex_arrays_.size());
-#endif
-    dirty = true;
-    unlock();
+void GlDelete::deleteHandles(Kind kind, const GLuint* handles, int count) {
+    switch (kind) {
+    case FRAME_BUFFERS:
+        glDeleteFramebuffers(count, handles);
+        break;
+    case VERTEX_ARRAYS:
+        glDeleteVertexArrays(count, handles);
+        break;
+    case TEXTURES:
+        glDeleteTextures(count, handles);
+        break;
+    case RENDER_BUFFERS:
+        glDeleteRenderbuffers(count, handles);
+        break;
+    case BUFFERS:
+        glDeleteBuffers(count, handles);
+        break;
+    case PROGRAMS:
+        for (int index = 0; index < count; ++index) {
+            glDeleteProgram(handles[index]);
+        }
+        break;
+    case SHADERS:
+        for (int index = 0; index < count; ++index) {
+            glDeleteShader(handles[index]);
+        }
+        break;
+    default:
+        break;
+    }
 }
 
-void GlDelete::processQueues() {
-    /*
-     * Do an unsynchronized check of the dirty flag, so that we don't have to
-     * call lock() on each and every frame. The consequences of 'just missing'
-     * a queue op and leaving a handle on a queue for an extra frame are quite
-     * minimal, but locking every frame is not free.
-     */
-    if (dirty) {
-        lock();
-#ifdef VERBOSE_LOGGING
-        LOGD("GlDelete::processQueues()");
-#endif
-        if (buffers_.size() > 0) {
-            glDeleteBuffers(buffers_.size(), buffers_.data());
-            buffers_.clear();
+/*
+ * Deletes from the front of the backlog of kind, a batch at a time, until
+ * it is empty, max_deletes are gone or it is past the deadline; a
+ * deadline of 0 is none. Returns the handles deleted.
+ */
+int GlDelete::deleteBacklog(Kind kind, int max_deletes, long long deadline) {
+    Queue& queue = queues_[kind];
+    GLuint handles[BATCH_SIZE];
+    int deleted = 0;
+
+    while (nullptr != queue.backlog && deleted < max_deletes) {
+        int count = 0;
+        size_t bytes = 0;
+        while (nullptr != queue.backlog && count < BATCH_SIZE
+                && deleted + count < max_deletes) {
+            Node* node = queue.backlog;
+            queue.backlog = node->next;
+            handles[count++] = node->handle;
+            bytes += node->bytes;
+            delete node;
         }
-        if (frame_buffers_.size() > 0) {
-            glDeleteFramebuffers(frame_buffers_.size(), frame_buffers_.data());
-            frame_buffers_.clear();
+        if (nullptr == queue.backlog) {
+            queue.backlog_tail = nullptr;
         }
-        if (programs_.size() > 0) {
-            for (int index = 0, size = programs_.size(); index < size;
-                    ++index) {
-                glDeleteProgram(programs_[index]);
-            }
-            programs_.clear();
+
+        deleteHandles(kind, handles, count);
+        deleted += count;
+        queue.pending.fetch_sub(count, std::memory_order_relaxed);
+        queue.pending_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+
+        if (0 != deadline && getNanoTime() >= deadline) {
+            break;
         }
-        if (render_buffers_.size() > 0) {
-            glDeleteRenderbuffers(render_buffers_.size(),
-                    render_buffers_.data());
-            render_buffers_.clear();
+    }
+    return deleted;
+}
+
+void GlDelete::processQueues() {
+    bool queued = false;
+    for (int kind = 0; kind < KIND_COUNT; ++kind) {
+        Queue& queue = queues_[kind];
+        /*
+         * The load keeps a frame that has nothing to delete from writing
+         * to the heads the other threads push onto.
+         */
+        if (nullptr != queue.head.load(std::memory_order_relaxed)) {
+            takeQueued(queue);
         }
-        if (shaders_.size() > 0) {
-            for (int index = 0, size = shaders_.size(); index < size; ++index) {
-                glDeleteShader(shaders_[index]);
+        queued = queued || nullptr != queue.backlog;
+    }
+    if (!queued) {
+        deleted_last_frame_.store(0, std::memory_order_relaxed);
+        return;
+    }
+
+    int pending_now = pending();
+    if (pending_now > peak_pending_.load(std::memory_order_relaxed)) {
+        peak_pending_.store(pending_now, std::memory_order_relaxed);
+    }
+    if (pending_now >= report_pending_) {
+        LOGW("GlDelete: %d handles, %zu bytes waiting to be deleted",
+                pending_now, pending_bytes());
+        for (int kind = 0; kind < KIND_COUNT; ++kind) {
+            if (0 != pending(static_cast<Kind>(kind))) {
+                LOGW("GlDelete:     %d %s", pending(static_cast<Kind>(kind)),
+                        kind_names[kind]);
             }
-            shaders_.clear();
-        }
-        if (textures_.size() > 0) {
-            glDeleteTextures(textures_.size(), textures_.data());
-            textures_.clear();
         }
-        if (vertex_arrays_.size() > 0) {
-            glDeleteVertexArrays(vertex_arrays_.size(), vertex_arrays_.data());
-            vertex_arrays_.clear();
+        report_pending_ *= 2;
+    } else if (pending_now < REPORT_PENDING / 2) {
+        report_pending_ = REPORT_PENDING;
+    }
+
+    int max_deletes = max_deletes_.load(std::memory_order_relaxed);
+    long long max_nanos = max_nanos_.load(std::memory_order_relaxed);
+    if (max_deletes <= 0) {
+        max_deletes = INT_MAX;
+    }
+    long long deadline = max_nanos > 0 ? getNanoTime() + max_nanos : 0;
+
+#ifdef VERBOSE_LOGGING
+    LOGD("GlDelete::processQueues() pending %d", pending_now);
+#endif
+    int deleted = 0;
+    for (int kind = 0; kind < KIND_COUNT && deleted < max_deletes; ++kind) {
+        deleted += deleteBacklog(static_cast<Kind>(kind), max_deletes - deleted, deadline);
+        if (0 != deadline && getNanoTime() >= deadline) {
+            break;
         }
-        dirty = false;
-        unlock();
+    }
+    deleted_last_frame_.store(deleted, std::memory_order_relaxed);
+
+    if (deleted > 0) {
+        // deleting bound objects unbinds them
+        GLStateCache::getInstance()->invalidate();
+    }
+}
+
+void GlDelete::flush() {
+    int deleted = 0;
+    for (int kind = 0; kind < KIND_COUNT; ++kind) {
+        takeQueued(queues_[kind]);
+        deleted += deleteBacklog(static_cast<Kind>(kind), INT_MAX, 0);
+    }
+    if (deleted > 0) {
+        GLStateCache::getInstance()->invalidate();
     }
 }
 
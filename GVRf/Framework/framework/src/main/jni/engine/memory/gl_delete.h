@@ -20,7 +20,7 @@
 #include "util/gvr_cpp_stack_trace.h"
 
 #include <atomic>
-#include <vector>
+#include <cstddef>
 #include <pthread.h>
 #include <unistd.h>
 #include "gl/gl_headers.h"
@@ -32,9 +32,40 @@ namespace gvr {
 
 extern pthread_key_t deleter_key;
 
+/*
+ * Deletes GL objects on the GL thread for whoever lets go of them, on any
+ * thread; the finalizers mostly.
+ *
+ * Each kind of object has its own queue, a list that the other threads
+ * push onto with a compare-and-swap. The GL thread takes the whole list
+ * with one exchange, never node by node, so there is no lock and no ABA.
+ * What it takes waits in its own backlog, oldest first, and every frame
+ * processQueues deletes from there only as many handles as the budget
+ * allows, so tearing down a big scene is spread over several frames.
+ */
 class GlDelete {
 
 public:
+    enum Kind {
+        FRAME_BUFFERS = 0,      // first, they hold on to textures and render buffers
+        VERTEX_ARRAYS,
+        TEXTURES,
+        RENDER_BUFFERS,
+        BUFFERS,
+        PROGRAMS,
+        SHADERS,
+        KIND_COUNT
+    };
+
+    static const int DEFAULT_MAX_DELETES = 256;
+    static const long long DEFAULT_MAX_NANOS = 1000000;
+
+    // handles given to one glDelete* call
+    static const int BATCH_SIZE = 32;
+
+    // the pending handles that get logged first, again each time they double
+    static const int REPORT_PENDING = 1024;
+
     /**
      * Before using this class this method must be called once
      * and only once per-process
@@ -49,61 +80,83 @@ public:
         }
     }
 
-    GlDelete() : dirty(false) {
-        int err = pthread_mutex_init(&mutex, nullptr);
-        if (0 != err) {
-            LOGE("fatal error: pthread_mutex_init failed with %d!", err);
-            std::terminate();
-        }
-        err = pthread_setspecific(deleter_key, this);
-        if (0 != err) {
-            LOGE("fatal error: pthread_setspecific failed with %d!", err);
-            std::terminate();
-        }
-
-        LOGV("GlDelete(): %p tid: %d", this, gettid());
-    }
-
-    ~GlDelete() {
-        LOGV("~GlDelete(): %p tid: %d", this, gettid());
-        int err = pthread_mutex_destroy(&mutex);
-        if (0 != err) {
-            LOGE("fatal error: pthread_mutex_destroy failed with %d!", err);
-            std::terminate();
-        }
-    }
+    GlDelete();
+    ~GlDelete();
 
-    void queueBuffer(GLuint buffer);
+    // any thread; bytes is what the object takes on the GPU, when known
+    void queueBuffer(GLuint buffer, size_t bytes = 0);
     void queueFrameBuffer(GLuint buffer);
     void queueProgram(GLuint program);
-    void queueRenderBuffer(GLuint buffer);
+    void queueRenderBuffer(GLuint buffer, size_t bytes = 0);
     void queueShader(GLuint shader);
-    void queueTexture(GLuint texture);
+    void queueTexture(GLuint texture, size_t bytes = 0);
     void queueVertexArray(GLuint vertex_array);
 
+    // GL thread, once per frame: deletes the oldest handles, up to the budget
     void processQueues();
 
-private:
+    // GL thread: deletes everything queued, whatever the budget
+    void flush();
+
+    /*
+     * Any thread. The handles deleted per frame and the time spent on it,
+     * checked after each batch; 0 for no limit. With neither limit every
+     * frame deletes all that is queued.
+     */
+    void setBudget(int max_deletes, long long max_nanos) {
+        max_deletes_.store(max_deletes, std::memory_order_relaxed);
+        max_nanos_.store(max_nanos, std::memory_order_relaxed);
+    }
 
-    pthread_mutex_t mutex;
-    std::atomic<bool> dirty;
+    // queued and not deleted yet, of one kind or of all
+    int pending(Kind kind) const {
+        return queues_[kind].pending.load(std::memory_order_relaxed);
+    }
+    int pending() const;
+    size_t pending_bytes() const;
 
-    void lock() {
-        pthread_mutex_lock(&mutex);
+    int deleted_last_frame() const {
+        return deleted_last_frame_.load(std::memory_order_relaxed);
     }
-    void unlock() {
-        pthread_mutex_unlock(&mutex);
+
+    // the most handles pending at the start of a frame
+    int peak_pending() const {
+        return peak_pending_.load(std::memory_order_relaxed);
     }
 
+private:
+    GlDelete(const GlDelete& deleter);
+    GlDelete(GlDelete&& deleter);
+    GlDelete& operator=(const GlDelete& deleter);
+    GlDelete& operator=(GlDelete&& deleter);
+
+    struct Node {
+        GLuint handle;
+        size_t bytes;
+        Node* next;
+    };
+
+    struct Queue {
+        std::atomic<Node*> head;        // newest first, pushed by any thread
+        std::atomic<int> pending;
+        std::atomic<size_t> pending_bytes;
+        Node* backlog;                  // oldest first, GL thread only
+        Node* backlog_tail;
+    };
+
+    void queue(Kind kind, GLuint handle, size_t bytes, const char* func);
+    void takeQueued(Queue& queue);
+    int deleteBacklog(Kind kind, int max_deletes, long long deadline);
+    void deleteHandles(Kind kind, const GLuint* handles, int count);
+
     void logInvalidParameter(const char *msg);
 
-    std::vector<GLuint> buffers_;
-    std::vector<GLuint> frame_buffers_;
-    std::vector<GLuint> programs_;
-    std::vector<GLuint> render_buffers_;
-    std::vector<GLuint> shaders_;
-    std::vector<GLuint> textures_;
-    std::vector<GLuint> vertex_arrays_;
+    Queue queues_[KIND_COUNT];
+    std::atomic<int> max_deletes_;
+    std::atomic<long long> max_nanos_;
+    std::atomic<int> deleted_last_frame_;
+    std::atomic<int> peak_pending_;
+    int report_pending_;
 };
 
 /**
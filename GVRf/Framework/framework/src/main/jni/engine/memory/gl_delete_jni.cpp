@@ -42,6 +42,25 @@ Java_org_gearvrf_NativeGLDelete_createTlsKey(JNIEnv * env, jobject obj) {
     GlDelete::createTlsKey();
 }
 
+JNIEXPORT void JNICALL
+Java_org_gearvrf_NativeGLDelete_setBudget(JNIEnv * env, jobject obj, jlong deleterPtr,
+        jint maxDeletes, jlong maxNanos) {
+    GlDelete* deleter = reinterpret_cast<GlDelete*>(deleterPtr);
+    deleter->setBudget(maxDeletes, maxNanos);
+}
+
+JNIEXPORT jint JNICALL
+Java_org_gearvrf_NativeGLDelete_getPending(JNIEnv * env, jobject obj, jlong deleterPtr) {
+    GlDelete* deleter = reinterpret_cast<GlDelete*>(deleterPtr);
+    return deleter->pending();
+}
+
+JNIEXPORT jlong JNICALL
+Java_org_gearvrf_NativeGLDelete_getPendingBytes(JNIEnv * env, jobject obj, jlong deleterPtr) {
+    GlDelete* deleter = reinterpret_cast<GlDelete*>(deleterPtr);
+    return deleter->pending_bytes();
+}
+
 }   //extern "C"
 
 }   //namespace gvr
@@ -13,86 +13,135 @@
  * limitations under the License.
  */
 #include "batch.h"
+#include "engine/memory/gl_delete.h"
 #include "objects/scene_object.h"
 #include "objects/components/camera.h"
 #include "objects/components/render_data.h"
 #include "objects/light.h"
 
-#define BATCH_SIZE 60
+#include "glm/gtc/type_ptr.hpp"
+#include "gl/gl_state_cache.h"
 
 namespace gvr {
 Batch::Batch(int no_vertices, int no_indices) :
-        draw_count_(0), vertex_count_(0), index_count_(0), vertex_limit_(no_vertices),
-        indices_limit_(no_indices), renderdata_(nullptr),mesh_init_(false),
-        index_offset_(0), not_batched_(false), batch_dirty_(false) {
-
-    vertices_.reserve(no_vertices);
-    indices_.reserve(no_indices);
-    normals_.reserve(no_vertices);
-    tex_coords_.reserve(no_vertices);
-    matrix_indices_.reserve(no_vertices);
+        batch_dirty_(false), renderdata_(nullptr), material_(nullptr),
+        vertex_end_(0), index_end_(0), live_indices_(0),
+        matrix_dirty_first_(MAX_MATRICES), matrix_dirty_last_(-1), upload_all_(false),
+        deleter_(nullptr), vertex_buffer_(0), index_buffer_(0), matrix_buffer_(0),
+        vertex_capacity_(0), index_capacity_(0), vertex_limit_(no_vertices),
+        indices_limit_(no_indices), not_batched_(false) {
 }
 
 Batch::~Batch() {
     clearData();
     delete renderdata_;
     renderdata_ = nullptr;
+    if (nullptr != deleter_) {
+        for (auto it = vaos_.begin(); it != vaos_.end(); ++it) {
+            deleter_->queueVertexArray(it->second);
+        }
+        deleter_->queueBuffer(vertex_buffer_,
+                vertex_capacity_ * VERTEX_FLOATS * sizeof(GLfloat));
+        deleter_->queueBuffer(index_buffer_, index_capacity_ * sizeof(GLuint));
+        deleter_->queueBuffer(matrix_buffer_, MAX_MATRICES * sizeof(glm::mat4));
+    }
 }
 
-bool Batch::updateMesh(Mesh* render_mesh){
-    const std::vector<unsigned short>& indices = render_mesh->indices();
-    const std::vector<glm::vec3>& vertices = render_mesh->vertices();
-    const std::vector<glm::vec3>& normals = render_mesh->normals();
-    const std::vector<glm::vec2>& tex_cords = render_mesh->getVec2Vector("a_texcoord");
-
-    int size = 0;
-    size = vertices.size();
+/*
+ * First fit from the free list, else from the end of the buffer.
+ */
+bool Batch::allocate(std::vector<Range>& free_list, unsigned int& end,
+        unsigned int count, Range& range) {
+    for (auto it = free_list.begin(); it != free_list.end(); ++it) {
+        if (it->count >= count) {
+            range.first = it->first;
+            range.count = count;
+            it->first += count;
+            it->count -= count;
+            if (0 == it->count) {
+                free_list.erase(it);
+            }
+            return true;
+        }
+    }
+    range.first = end;
+    range.count = count;
+    end += count;
+    return true;
+}
 
-    for(int i=0;i<size;i++){
-        vertices_.push_back(vertices[i]);
-        matrix_indices_.push_back(draw_count_);
-        tex_coords_.push_back(tex_cords[i]);
+/*
+ * Returns the range to the free list, which is kept sorted and merged
+ * with its neighbours.
+ */
+void Batch::release(std::vector<Range>& free_list, const Range& range) {
+    if (0 == range.count) {
+        return;
+    }
+    auto it = free_list.begin();
+    while (it != free_list.end() && it->first < range.first) {
+        ++it;
     }
-    // Check if models has normals
-    if(normals.size() > 0){
-        int normals_size = normals.size();
-        for(int i=0;i<normals_size;i++)
-            normals_.push_back(normals[i]);
+    it = free_list.insert(it, range);
+    auto next = it + 1;
+    if (next != free_list.end() && it->first + it->count == next->first) {
+        it->count += next->count;
+        free_list.erase(next);
     }
-    size = indices.size();
-    index_count_+=size;
-    for (int i = 0; i < size; i++) {
-        unsigned short index = indices[i];
-        index += index_offset_;
-        indices_.push_back(index);
+    if (it != free_list.begin()) {
+        auto previous = it - 1;
+        if (previous->first + previous->count == it->first) {
+            previous->count += it->count;
+            free_list.erase(it);
+        }
+    }
+}
+
+bool Batch::allocateMember(RenderData* render_data, Member& member) {
+    Mesh* mesh = render_data->mesh();
+    if (free_matrix_slots_.empty()) {
+        if (matrices_.size() >= MAX_MATRICES) {
+            return false;
+        }
+        member.matrix_slot = matrices_.size();
+        matrices_.push_back(glm::mat4());
+    } else {
+        member.matrix_slot = free_matrix_slots_.back();
+        free_matrix_slots_.pop_back();
+    }
+    allocate(free_vertices_, vertex_end_, mesh->vertices().size(), member.vertices);
+    allocate(free_indices_, index_end_, mesh->indices().size(), member.indices);
+    live_indices_ += member.indices.count;
+    return true;
+}
+
+void Batch::releaseMember(RenderData* render_data) {
+    auto it = members_.find(render_data);
+    if (it == members_.end()) {
+        return;
     }
-    // update all VBO data
-    vertex_count_ += vertices.size();
-    index_offset_ += vertices.size();
-    draw_count_++;
-    mesh_init_ = false;
+    Member& member = it->second;
+    release(free_vertices_, member.vertices);
+    release(free_indices_, member.indices);
+    free_matrix_slots_.push_back(member.matrix_slot);
+    live_indices_ -= member.indices.count;
+    // the stale indices would still draw the old triangles
+    pending_clears_.push_back(member.indices);
+    members_.erase(it);
 }
+
 /*
- * Add renderdata of scene object into mesh, add vertices, texcoords, normals, model matrices
+ * Add renderdata of scene object into the batch: reserve its slot and
+ * queue its vertices, indices and model matrix for upload
  */
 bool Batch::add(RenderData *render_data) {
     material_ = render_data->pass(0)->material();
     Mesh *render_mesh = render_data->mesh();
-    const std::vector<unsigned short>& indices = render_mesh->indices();
+    const std::vector<unsigned int>& indices = render_mesh->indices();
 
-    Transform* const t = render_data->owner_object()->transform();
-    glm::mat4 model_matrix;
-    if (t != NULL) {
-        model_matrix = glm::mat4(t->getModelMatrix());
-    }
-    render_data->getHashCode();
+    render_data->clearStateChanged();
     render_data->setDirty(false);
 
-    // Store the model matrix and its index into map for update
-    matrix_index_map_[render_data] = draw_count_;
-    matrices_.push_back(model_matrix);
-    render_data->owner_object()->setTransformUnDirty();
-
     if(!render_data->batching()){
         render_data_set_.insert(render_data);
         not_batched_ = true;
@@ -109,8 +158,9 @@ bool Batch::add(RenderData *render_data) {
         }
     }
     // if mesh is large, render in normal way
-    if (indices.size() == 0 || (indices.size() + index_count_ > indices_limit_)) {
-        if (draw_count_ > 0) {
+    if (indices.size() == 0 || (indices.size() + live_indices_ > static_cast<size_t>(indices_limit_))
+            || members_.size() >= MAX_MATRICES) {
+        if (members_.size() > 0) {
             return false;
         } else {
             render_data_set_.insert(render_data);
@@ -120,29 +170,99 @@ bool Batch::add(RenderData *render_data) {
         }
     }
     // Copy all renderData properties
-    if (draw_count_ == 0) {
+    if (members_.empty()) {
         if (!renderdata_) {
             renderdata_ = new RenderData(*render_data);
             renderdata_->set_batching(true);
        }
     }
+
+    Member member;
+    if (!allocateMember(render_data, member)) {
+        return false;
+    }
+    members_[render_data] = member;
     render_data_set_.insert(render_data); // store all the renderdata which are in batch
-    updateMesh(render_mesh);
+    pending_members_.push_back(render_data);
+
+    Transform* const t = render_data->owner_object()->transform();
+    UpdateModelMatrix(render_data, (t != NULL) ? t->getModelMatrix() : glm::mat4());
+    render_data->owner_object()->setTransformUnDirty();
+    return true;
+}
+
+bool Batch::updateRenderData(RenderData* render_data) {
+    auto it = members_.find(render_data);
+    if (it == members_.end() || render_data->pass(0)->material() != material_
+            || render_data->isStateChanged()) {
+        return false;
+    }
+    Mesh* mesh = render_data->mesh();
+    Member& member = it->second;
+    if (mesh->vertices().size() != member.vertices.count
+            || mesh->indices().size() != member.indices.count) {
+        // the mesh changed size, move it to a new slot of the right size
+        int matrix_slot = member.matrix_slot;
+        release(free_vertices_, member.vertices);
+        release(free_indices_, member.indices);
+        pending_clears_.push_back(member.indices);
+        live_indices_ -= member.indices.count;
+        if (mesh->indices().size() == 0
+                || mesh->indices().size() + live_indices_ > static_cast<size_t>(indices_limit_)) {
+            free_matrix_slots_.push_back(matrix_slot);
+            members_.erase(it);
+            return false;
+        }
+        allocate(free_vertices_, vertex_end_, mesh->vertices().size(), member.vertices);
+        allocate(free_indices_, index_end_, mesh->indices().size(), member.indices);
+        live_indices_ += member.indices.count;
+    }
+    pending_members_.push_back(render_data);
+    render_data->setDirty(false);
     return true;
 }
+
+void Batch::UpdateModelMatrix(RenderData* renderdata, const glm::mat4& model_matrix) {
+    auto it = members_.find(renderdata);
+    if (it == members_.end()) {
+        return;
+    }
+    int slot = it->second.matrix_slot;
+    matrices_[slot] = model_matrix;
+    matrix_dirty_first_ = std::min(matrix_dirty_first_, slot);
+    matrix_dirty_last_ = std::max(matrix_dirty_last_, slot);
+}
+
+void Batch::removeRenderData(RenderData* renderdata) {
+    renderdata->set_batching(false);
+    render_data_set_.erase(renderdata);
+    releaseMember(renderdata);
+    if (0 == render_data_set_.size())
+        resetBatch();
+}
+
+void Batch::detachRenderData(RenderData* renderdata) {
+    render_data_set_.erase(renderdata);
+    releaseMember(renderdata);
+    renderdata->setBatchNull();
+    if (0 == render_data_set_.size())
+        resetBatch();
+}
+
 void Batch::clearData(){
-    vertex_count_ = 0;
-    index_count_ = 0;
-    index_offset_ = 0;
-    draw_count_=0;
-    matrix_index_map_.clear();
-    matrix_indices_.clear();
+    vertex_end_ = 0;
+    index_end_ = 0;
+    live_indices_ = 0;
+    members_.clear();
+    free_vertices_.clear();
+    free_indices_.clear();
+    free_matrix_slots_.clear();
     matrices_.clear();
-    tex_coords_.clear();
-    vertices_.clear();
-    normals_.clear();
-    indices_.clear();
-    mesh_init_ = false;
+    matrix_dirty_first_ = MAX_MATRICES;
+    matrix_dirty_last_ = -1;
+    pending_members_.clear();
+    pending_clears_.clear();
+    upload_all_ = false;
     batch_dirty_ = false;
 }
 
@@ -152,6 +272,7 @@ bool Batch::isRenderModified(){
         if(!(*it)->enabled() || !(*it)->owner_object()->enabled()){
             (*it)->set_batching(false);
             (*it)->setBatchNull();
+            releaseMember(*it);
             render_data_set_.erase(it++);
             update_vbo = true;
         }
@@ -168,46 +289,197 @@ void Batch::resetBatch(){
     gRenderer->freeBatch(this);
 }
 
-void Batch::meshInit(){
-    mesh_init_ = true;
-    mesh_.set_vertices(vertices_);
-    mesh_.set_normals(normals_);
-    mesh_.setVec2Vector("a_texcoord",tex_coords_);
-    mesh_.set_indices(indices_);
-    mesh_.setFloatVector("a_matrix_index", matrix_indices_);
-    if (nullptr != renderdata_) {
-        renderdata_->set_mesh(&mesh_);
+/*
+ * Lays the members out back to back again, dropping the holes.
+ */
+void Batch::repack() {
+    vertex_end_ = 0;
+    index_end_ = 0;
+    free_vertices_.clear();
+    free_indices_.clear();
+    pending_clears_.clear();
+    pending_members_.clear();
+    for (auto it = members_.begin(); it != members_.end(); ++it) {
+        Member& member = it->second;
+        member.vertices.first = vertex_end_;
+        member.indices.first = index_end_;
+        vertex_end_ += member.vertices.count;
+        index_end_ += member.indices.count;
+    }
+    upload_all_ = true;
+}
+
+void Batch::writeMember(RenderData* render_data, const Member& member,
+        std::vector<GLfloat>& vertices, std::vector<GLuint>& indices) {
+    Mesh* mesh = render_data->mesh();
+    const std::vector<glm::vec3>& positions = mesh->vertices();
+    const std::vector<glm::vec3>& normals = mesh->normals();
+    const std::vector<glm::vec2>& tex_coords = mesh->getVec2Vector("a_texcoord");
+    const std::vector<unsigned int>& mesh_indices = mesh->indices();
+    const GLfloat matrix_index = member.matrix_slot;
+
+    vertices.resize(member.vertices.count * VERTEX_FLOATS);
+    GLfloat* out = vertices.data();
+    for (unsigned int i = 0; i < member.vertices.count; ++i) {
+        const glm::vec3& p = positions[i];
+        const glm::vec3 n = (i < normals.size()) ? normals[i] : glm::vec3();
+        const glm::vec2 uv = (i < tex_coords.size()) ? tex_coords[i] : glm::vec2();
+        *out++ = p.x; *out++ = p.y; *out++ = p.z;
+        *out++ = n.x; *out++ = n.y; *out++ = n.z;
+        *out++ = uv.x; *out++ = uv.y;
+        *out++ = matrix_index;
+    }
+    indices.resize(member.indices.count);
+    for (unsigned int i = 0; i < member.indices.count; ++i) {
+        indices[i] = mesh_indices[i] + member.vertices.first;
+    }
+}
+
+void Batch::createBuffers() {
+    if (0 != vertex_buffer_) {
+        return;
+    }
+    deleter_ = getDeleterForThisThread();
+    GLuint buffers[3];
+    glGenBuffers(3, buffers);
+    vertex_buffer_ = buffers[0];
+    index_buffer_ = buffers[1];
+    matrix_buffer_ = buffers[2];
+    GLStateCache::getInstance()->bindBuffer(GL_UNIFORM_BUFFER, matrix_buffer_);
+    glBufferData(GL_UNIFORM_BUFFER, MAX_MATRICES * sizeof(glm::mat4), nullptr,
+            GL_DYNAMIC_DRAW);
+    GLStateCache::getInstance()->bindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void Batch::upload() {
+    createBuffers();
+
+    // grow by doubling; a new store means uploading every member again
+    if (vertex_end_ > vertex_capacity_ || index_end_ > index_capacity_) {
+        while (vertex_capacity_ < vertex_end_) {
+            vertex_capacity_ = std::max(2 * vertex_capacity_, 1024u);
+        }
+        while (index_capacity_ < index_end_) {
+            index_capacity_ = std::max(2 * index_capacity_, 4096u);
+        }
+        GLStateCache::getInstance()->bindBuffer(GL_ARRAY_BUFFER, vertex_buffer_);
+        glBufferData(GL_ARRAY_BUFFER, vertex_capacity_ * VERTEX_FLOATS * sizeof(GLfloat),
+                nullptr, GL_DYNAMIC_DRAW);
+        GLStateCache::getInstance()->bindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer_);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_capacity_ * sizeof(GLuint),
+                nullptr, GL_DYNAMIC_DRAW);
+        upload_all_ = true;
+    }
+
+    if (upload_all_) {
+        pending_clears_.clear();
+        pending_members_.clear();
+        index_scratch_.assign(index_end_, 0);
+        vertex_scratch_.assign(vertex_end_ * VERTEX_FLOATS, 0.0f);
+        std::vector<GLfloat> vertices;
+        std::vector<GLuint> indices;
+        for (auto it = members_.begin(); it != members_.end(); ++it) {
+            const Member& member = it->second;
+            writeMember(it->first, member, vertices, indices);
+            std::copy(vertices.begin(), vertices.end(),
+                    vertex_scratch_.begin() + member.vertices.first * VERTEX_FLOATS);
+            std::copy(indices.begin(), indices.end(),
+                    index_scratch_.begin() + member.indices.first);
+        }
+        GLStateCache::getInstance()->bindBuffer(GL_ARRAY_BUFFER, vertex_buffer_);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, vertex_scratch_.size() * sizeof(GLfloat),
+                vertex_scratch_.data());
+        GLStateCache::getInstance()->bindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer_);
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, index_scratch_.size() * sizeof(GLuint),
+                index_scratch_.data());
+        matrix_dirty_first_ = 0;
+        matrix_dirty_last_ = matrices_.size() - 1;
+        upload_all_ = false;
+    }
+
+    // freed ranges first, their space may have been handed out again
+    GLStateCache::getInstance()->bindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer_);
+    for (auto it = pending_clears_.begin(); it != pending_clears_.end(); ++it) {
+        index_scratch_.assign(it->count, 0);
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, it->first * sizeof(GLuint),
+                it->count * sizeof(GLuint), index_scratch_.data());
+    }
+    pending_clears_.clear();
+
+    GLStateCache::getInstance()->bindBuffer(GL_ARRAY_BUFFER, vertex_buffer_);
+    for (auto it = pending_members_.begin(); it != pending_members_.end(); ++it) {
+        auto member = members_.find(*it);
+        if (member == members_.end()) {
+            continue;
+        }
+        const Member& m = member->second;
+        writeMember(*it, m, vertex_scratch_, index_scratch_);
+        glBufferSubData(GL_ARRAY_BUFFER, m.vertices.first * VERTEX_FLOATS * sizeof(GLfloat),
+                vertex_scratch_.size() * sizeof(GLfloat), vertex_scratch_.data());
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, m.indices.first * sizeof(GLuint),
+                index_scratch_.size() * sizeof(GLuint), index_scratch_.data());
+    }
+    pending_members_.clear();
+    GLStateCache::getInstance()->bindBuffer(GL_ARRAY_BUFFER, 0);
+    GLStateCache::getInstance()->bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    if (matrix_dirty_last_ >= matrix_dirty_first_) {
+        GLStateCache::getInstance()->bindBuffer(GL_UNIFORM_BUFFER, matrix_buffer_);
+        glBufferSubData(GL_UNIFORM_BUFFER, matrix_dirty_first_ * sizeof(glm::mat4),
+                (matrix_dirty_last_ - matrix_dirty_first_ + 1) * sizeof(glm::mat4),
+                glm::value_ptr(matrices_[matrix_dirty_first_]));
+        GLStateCache::getInstance()->bindBuffer(GL_UNIFORM_BUFFER, 0);
     }
+    matrix_dirty_first_ = MAX_MATRICES;
+    matrix_dirty_last_ = -1;
 }
+
 bool Batch::setupMesh(bool batch_dirty){
-    bool update_vbo = isRenderModified();
+    isRenderModified();
     // batch is empty, add it back to the pool
     if(0 == render_data_set_.size()){
         resetBatch();
         return false;
     }
-    if(batch_dirty || update_vbo)
-        regenerateMeshData();
+    if (2 * live_indices_ < index_end_) {
+        repack();
+    }
     batch_dirty_ = false;
-    if(!mesh_init_)
-        meshInit();
+    if (members_.empty()) {
+        return true;
+    }
+    upload();
     return true;
 }
-void Batch::regenerateMeshData(){
-    clearData();
-    for(auto it= render_data_set_.begin();it!=render_data_set_.end();++it){
-        RenderData* render_data = *it;
-        Mesh *render_mesh = render_data->mesh();
-        const std::vector<unsigned short>& indices = render_mesh->indices();
-        Transform* const t = render_data->owner_object()->transform();
-        glm::mat4 model_matrix;
-        if (t != NULL) {
-            model_matrix = glm::mat4(t->getModelMatrix());
+
+GLuint Batch::getVAOId(GLuint program_id) {
+    auto it = vaos_.find(program_id);
+    if (it != vaos_.end()) {
+        return it->second;
+    }
+
+    static const char* const names[] = {
+            "a_position", "a_normal", "a_texcoord", "a_matrix_index" };
+    static const int sizes[] = { 3, 3, 2, 1 };
+    GLuint vao;
+    glGenVertexArrays(1, &vao);
+    GLStateCache::getInstance()->bindVertexArray(vao);
+    GLStateCache::getInstance()->bindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer_);
+    GLStateCache::getInstance()->bindBuffer(GL_ARRAY_BUFFER, vertex_buffer_);
+    int offset = 0;
+    for (int i = 0; i < 4; ++i) {
+        GLint location = glGetAttribLocation(program_id, names[i]);
+        if (location >= 0) {
+            glVertexAttribPointer(location, sizes[i], GL_FLOAT, GL_FALSE,
+                    VERTEX_FLOATS * sizeof(GLfloat), (GLvoid*) (offset * sizeof(GLfloat)));
+            glEnableVertexAttribArray(location);
         }
-        // Store the model matrix and its index into map for update
-        matrix_index_map_[render_data] = draw_count_;
-        matrices_.push_back(model_matrix);
-        updateMesh(render_mesh);
+        offset += sizes[i];
     }
+    GLStateCache::getInstance()->bindVertexArray(0);
+    GLStateCache::getInstance()->bindBuffer(GL_ARRAY_BUFFER, 0);
+    GLStateCache::getInstance()->bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    vaos_[program_id] = vao;
+    return vao;
 }
 }
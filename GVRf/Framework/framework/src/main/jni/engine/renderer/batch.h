@@ -30,33 +30,53 @@ namespace gvr{
 class RenderData;
 class Material;
 class Mesh;
+class GlDelete;
+
+/*
+ * Meshes sharing a material and render state, drawn with one call.
+ *
+ * Every member owns a slot: a range of the batch's vertex buffer, a
+ * range of its 32-bit index buffer and an entry in its matrix buffer.
+ * Slots stay put while other members come and go, so adding or
+ * changing a member uploads only its own ranges, and moving it rewrites
+ * only its matrix. Freed ranges go on free lists for reuse and their
+ * indices are made degenerate; once more than half the indices are
+ * free the batch repacks and uploads everything once.
+ *
+ * Member changes only touch CPU state; the uploads happen in setupMesh
+ * on the GL thread.
+ */
 class Batch {
 public:
+    // vertex layout: position 3, normal 3, texcoord 2, matrix index 1
+    static const int VERTEX_FLOATS = 9;
+    // a std140 block of mat4 within the 16KB minimum GL_MAX_UNIFORM_BLOCK_SIZE
+    static const int MAX_MATRICES = 256;
+    static const GLuint MATRIX_BINDING = 0;
+
     Batch();
     Batch(int,int);
     ~Batch();
     bool add(RenderData *render_data);
     bool setupMesh(bool);
     void resetBatch();
-    void meshInit();
-    void regenerateMeshData();
-    void UpdateModelMatrix(RenderData* renderdata, glm::mat4 model_matrix){
-        if(renderdata){
-            matrices_[matrix_index_map_[renderdata]] = model_matrix;
-        }
-    }
-    void removeRenderData(RenderData* renderdata){
-        renderdata->set_batching(false);
-        render_data_set_.erase(renderdata);
-        batch_dirty_ = true;
-        if(0 == render_data_set_.size())
-            resetBatch();
-    }
+
+    /*
+     * Re-uploads a member whose mesh changed. Returns false when the
+     * render data has to leave the batch instead.
+     */
+    bool updateRenderData(RenderData* render_data);
+
+    void UpdateModelMatrix(RenderData* renderdata, const glm::mat4& model_matrix);
+    void removeRenderData(RenderData* renderdata);
+    // takes the render data out of the batch, leaving it free to batch again
+    void detachRenderData(RenderData* renderdata);
+
     const std::vector<glm::mat4>& get_matrices() {
         return matrices_;
     }
     int getNumberOfMeshes(){
-        return draw_count_;
+        return members_.size();
     }
     RenderData* get_renderdata() {
         return renderdata_;
@@ -82,31 +102,78 @@ public:
         return render_data_set_.size();
     }
     unsigned int getIndexCount(){
-        return index_count_;
+        return index_end_;
+    }
+
+    /*
+     * Vertex array for the program, bound to the batch's buffers.
+     * GL thread only.
+     */
+    GLuint getVAOId(GLuint program_id);
+
+    GLuint matrix_buffer() const {
+        return matrix_buffer_;
     }
+
 private:
-    bool updateMesh(Mesh* render_mesh);
+    struct Range {
+        unsigned int first;
+        unsigned int count;
+    };
+
+    struct Member {
+        Range vertices;
+        Range indices;
+        int   matrix_slot;
+    };
+
+    static bool allocate(std::vector<Range>& free_list, unsigned int& end,
+            unsigned int count, Range& range);
+    static void release(std::vector<Range>& free_list, const Range& range);
+
+    bool allocateMember(RenderData* render_data, Member& member);
+    void releaseMember(RenderData* render_data);
+    void repack();
+    void writeMember(RenderData* render_data, const Member& member,
+            std::vector<GLfloat>& vertices, std::vector<GLuint>& indices);
+    void createBuffers();
+    void upload();
     void clearData();
     bool isRenderModified();
+
     bool batch_dirty_;
-    std::unordered_map<RenderData*,int>matrix_index_map_;
+    std::unordered_map<RenderData*, Member> members_;
     std::unordered_set<RenderData*>render_data_set_;
-    Mesh mesh_;
     RenderData *renderdata_;
     Material *material_;
-    std::vector<glm::vec3> vertices_;
-    std::vector<glm::vec3> normals_;
-    std::vector<glm::vec2> tex_coords_;
-    std::vector<unsigned short> indices_;
+
+    std::vector<Range> free_vertices_;
+    std::vector<Range> free_indices_;
+    std::vector<int> free_matrix_slots_;
+    unsigned int vertex_end_;
+    unsigned int index_end_;
+    unsigned int live_indices_;
     std::vector<glm::mat4> matrices_;
-    std::vector<float> matrix_indices_;
+    int matrix_dirty_first_;
+    int matrix_dirty_last_;
+
+    // CPU changes waiting for setupMesh
+    std::vector<RenderData*> pending_members_;
+    std::vector<Range> pending_clears_;
+    bool upload_all_;
+
+    GlDelete* deleter_;
+    GLuint vertex_buffer_;
+    GLuint index_buffer_;
+    GLuint matrix_buffer_;
+    unsigned int vertex_capacity_;
+    unsigned int index_capacity_;
+    std::map<GLuint, GLuint> vaos_;
+    std::vector<GLfloat> vertex_scratch_;
+    std::vector<GLuint> index_scratch_;
+
     int vertex_limit_;
     int indices_limit_;
-    int draw_count_;
-    unsigned int index_offset_;
-    unsigned int vertex_count_;
-    unsigned int index_count_;
-    bool mesh_init_;
     bool not_batched_;
 };
 }
@@ -21,10 +21,10 @@
 #include "objects/scene.h"
 #include "objects/scene_object.h"
 #include "objects/components/camera.h"
-#define BATCH_SIZE 60
+#include <algorithm>
 namespace gvr {
 
-BatchManager::BatchManager(int batch_size, int max_indices){
+BatchManager::BatchManager(int batch_size, int max_indices) : next_instance_group_(0) {
     batch_size_ = batch_size;
     max_indices_ = max_indices;
 
@@ -67,20 +67,119 @@ void BatchManager::batchSetup(std::vector<RenderData*>& render_data_vector) {
     for (int i = 1; i < render_vector_size ; i++) {
         curr = render_data_vector[i];
         if(!(prev->batching() && prev->rendering_order() == curr->rendering_order() && isRenderPassEqual(prev,curr)
-            && !prev->getHashCode().compare(curr->getHashCode())) || !curr->batching()){
+            && prev->state_id() == curr->state_id()) || !curr->batching()){
             batch_indices_.push_back(i);
             prev = curr;
         }
     }
     batch_indices_.push_back(render_data_vector.size());
     clearBatchSet();
+    instance_groups_.clear();
+    instanced_.assign(render_vector_size, 0);
     for (int i = 1; i < batch_indices_.size(); i++) {
+        createInstanceGroups(batch_indices_[i - 1], batch_indices_[i] - 1, render_data_vector);
         createBatch(batch_indices_[i - 1], batch_indices_[i] - 1,render_data_vector);
     }
 }
+
+bool BatchManager::isInstanceable(RenderData* render_data) {
+    if (render_data->owner_object()->transform() == nullptr) {
+        return false;
+    }
+    for (int i = 0; i < render_data->pass_count(); i++) {
+        Material* material = render_data->pass(i)->material();
+        if (material == nullptr || (material->shader_type() != Material::ShaderType::TEXTURE_SHADER
+                && material->shader_type() < Material::ShaderType::BUILTIN_SHADER_SIZE)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Groups the render data of one batch run by mesh. Opaque render data
+ * are grouped across the run; transparent ones only with their
+ * neighbours, so the back to front order holds.
+ */
+void BatchManager::createInstanceGroups(int start, int end,
+        std::vector<RenderData*>& render_data_vector) {
+    if (end - start + 1 < MIN_INSTANCES) {
+        return;
+    }
+    bool transparent = render_data_vector[start]->rendering_order() >= RenderData::Transparent;
+    int first_group = instance_groups_.size();
+    int previous_group = -1;
+    Mesh* previous_mesh = nullptr;
+    instance_meshes_.clear();
+
+    for (int i = start; i <= end; ++i) {
+        RenderData* render_data = render_data_vector[i];
+        if (!isInstanceable(render_data)) {
+            previous_mesh = nullptr;
+            continue;
+        }
+        Mesh* mesh = render_data->mesh();
+        int group;
+        if (transparent) {
+            group = (mesh == previous_mesh) ? previous_group : -1;
+        } else {
+            auto it = instance_meshes_.find(mesh);
+            group = (it != instance_meshes_.end()) ? it->second : -1;
+        }
+        if (group < 0) {
+            group = instance_groups_.size();
+            instance_groups_.push_back(InstanceGroup());
+            instance_groups_.back().batch_index = batch_set_.size();
+            if (!transparent) {
+                instance_meshes_[mesh] = group;
+            }
+        }
+        instance_groups_[group].indices.push_back(i);
+        previous_group = group;
+        previous_mesh = mesh;
+    }
+
+    // keep the groups worth an instanced draw
+    int count = first_group;
+    int group_count = instance_groups_.size();
+    for (int g = first_group; g < group_count; ++g) {
+        InstanceGroup& group = instance_groups_[g];
+        if (static_cast<int>(group.indices.size()) < MIN_INSTANCES) {
+            continue;
+        }
+        for (auto it = group.indices.begin(); it != group.indices.end(); ++it) {
+            RenderData* render_data = render_data_vector[*it];
+            Batch* batch = render_data->getBatch();
+            if (batch != nullptr) {
+                batch->detachRenderData(render_data);
+            }
+            instanced_[*it] = 1;
+            group.render_data.push_back(render_data);
+        }
+        if (count != g) {
+            std::swap(instance_groups_[count], group);
+        }
+        ++count;
+    }
+    instance_groups_.resize(count);
+}
+
+void BatchManager::renderInstanceGroups(RenderState& rstate, int batch_index) {
+    rstate.material_override = nullptr;
+    int group_count = instance_groups_.size();
+    for (; next_instance_group_ < group_count
+            && instance_groups_[next_instance_group_].batch_index <= batch_index;
+            ++next_instance_group_) {
+        gRenderer->renderInstances(rstate, instance_groups_[next_instance_group_].render_data);
+    }
+}
+
 void BatchManager::renderBatches(RenderState& rstate) {
-    for (auto it = batch_set_.begin(); it != batch_set_.end(); ++it) {
-        Batch* batch = *it;
+    next_instance_group_ = 0;
+    int batch_count = batch_set_.size();
+    for (int i = 0; i < batch_count; ++i) {
+        renderInstanceGroups(rstate, i);
+        Batch* batch = batch_set_[i];
         rstate.material_override = batch->material(0);
         if(rstate.material_override == nullptr)
             continue;
@@ -119,25 +218,18 @@ void BatchManager::renderBatches(RenderState& rstate) {
 
         gRenderer->setRenderStates(renderdata, rstate);
 
-        if(use_multiview){
-           rstate.uniforms.u_view_[0] = rstate.scene->main_camera_rig()->left_camera()->getViewMatrix();
-           rstate.uniforms.u_view_[1] = rstate.scene->main_camera_rig()->right_camera()->getViewMatrix();
-        }
-
-        const std::vector<glm::mat4>& matrices = batch->get_matrices();
-
         for(int passIndex =0; passIndex< renderdata->pass_count(); passIndex++){
             gRenderer->set_face_culling(renderdata->pass(passIndex)->cull_face());
             rstate.material_override = batch->material(passIndex);
             if(rstate.material_override == nullptr)
                 continue;
 
-            rstate.shader_manager->getTextureShader()->render_batch(matrices,
-                        renderdata, rstate, batch->getIndexCount(),
-                        batch->getNumberOfMeshes());
+            rstate.shader_manager->getTextureShader()->render_batch(batch,
+                        renderdata, rstate);
         }
         gRenderer->restoreRenderStates(renderdata);
     }
+    renderInstanceGroups(rstate, batch_count);
 }
 
 void BatchManager::createBatch(int start, int end, std::vector<RenderData*>& render_data_vector) {
@@ -145,7 +237,7 @@ void BatchManager::createBatch(int start, int end, std::vector<RenderData*>& ren
      int size = batch_size_;
      // get batch with least no of meshes in it
      for (int i = start; i <= end; ++i) {
-         if (render_data_vector[i]->getBatch() != nullptr) {
+         if (!instanced_[i] && render_data_vector[i]->getBatch() != nullptr) {
              if (render_data_vector[i]->getBatch()->getNumberOfMeshes()
                      <= size) {
                  size = render_data_vector[i]->getBatch()->getNumberOfMeshes();
@@ -154,6 +246,9 @@ void BatchManager::createBatch(int start, int end, std::vector<RenderData*>& ren
          }
      }
      for (int i = start; i <= end; ++i) {
+         if (instanced_[i]) {
+             continue;
+         }
          RenderData* render_data = render_data_vector[i];
          Batch* current_batch = render_data->getBatch();
          if (nullptr == current_batch) {
@@ -183,10 +278,11 @@ void BatchManager::createBatch(int start, int end, std::vector<RenderData*>& ren
              batching for that renderData
 
              1. if any property of render-data is modified
-             2. if mesh is modified
+             2. if mesh is modified and can not be updated in place
              3. Material is modified
             ***/
-           if(render_data->batching() && (render_data->isDirty() || render_data->isHashCodeDirty())){
+           if(render_data->batching() && (render_data->isDirty() || render_data->isStateChanged())
+                   && !current_batch->updateRenderData(render_data)){
                   current_batch->removeRenderData(render_data);
                   current_batch = nullptr;
                   getNewBatch(render_data, &current_batch);
@@ -52,6 +52,9 @@ private:
     }
     void getNewBatch(RenderData* rdata, Batch** existing_batch);
     void createBatch(int start, int end, std::vector<RenderData*>& render_data_vector);
+    void createInstanceGroups(int start, int end, std::vector<RenderData*>& render_data_vector);
+    static bool isInstanceable(RenderData* render_data);
+    void renderInstanceGroups(RenderState& rstate, int batch_index);
 
     std::vector<Batch*>batch_pool_;
     /*
@@ -67,6 +70,23 @@ private:
 
     std::vector<int> batch_indices_;
 
+    /*
+     * Render data of a batch run that share their mesh are drawn with one
+     * instanced draw instead of being batched. A group is drawn right
+     * before batch_set_[batch_index], keeping the order of the runs.
+     */
+    static const int MIN_INSTANCES = 2;
+    struct InstanceGroup {
+        int batch_index;
+        std::vector<int> indices;
+        std::vector<RenderData*> render_data;
+    };
+    std::vector<InstanceGroup> instance_groups_;
+    std::unordered_map<Mesh*, int> instance_meshes_;
+    // per entry of the render data vector, set when it is drawn instanced
+    std::vector<char> instanced_;
+    int next_instance_group_;
+
 };
 }
 #endif // BATCH_MANAGER_H
\ No newline at end of file
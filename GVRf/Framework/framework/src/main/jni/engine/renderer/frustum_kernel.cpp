@@ -0,0 +1,216 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Batched box against frustum tests for culling.
+ ***************************************************************************/
+
+#include "frustum_kernel.h"
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define FRUSTUM_KERNEL_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define FRUSTUM_KERNEL_SSE2 1
+#endif
+
+namespace gvr {
+
+void FrustumPlanes::set(const float frustum[6][4]) {
+    for (int p = 0; p < 6; ++p) {
+        a[p] = frustum[p][0];
+        b[p] = frustum[p][1];
+        c[p] = frustum[p][2];
+        d[p] = frustum[p][3];
+    }
+}
+
+void BoxArrays::clear() {
+    resize(0);
+}
+
+void BoxArrays::resize(int count) {
+    min_x.resize(count);
+    min_y.resize(count);
+    min_z.resize(count);
+    max_x.resize(count);
+    max_y.resize(count);
+    max_z.resize(count);
+}
+
+void BoxArrays::set(int index, const glm::vec3& min_corner,
+        const glm::vec3& max_corner) {
+    min_x[index] = min_corner.x;
+    min_y[index] = min_corner.y;
+    min_z[index] = min_corner.z;
+    max_x[index] = max_corner.x;
+    max_y[index] = max_corner.y;
+    max_z[index] = max_corner.z;
+}
+
+void BoxArrays::swap(BoxArrays& other) {
+    min_x.swap(other.min_x);
+    min_y.swap(other.min_y);
+    min_z.swap(other.min_z);
+    max_x.swap(other.max_x);
+    max_y.swap(other.max_y);
+    max_z.swap(other.max_z);
+}
+
+/*
+ * For each plane only two corners matter: the one furthest along the
+ * normal (if it is behind the plane, the whole box is) and the one
+ * furthest against it (if that one is in front, the whole box is).
+ */
+int classifyBox(const FrustumPlanes& planes, const glm::vec3& min_corner,
+        const glm::vec3& max_corner, int& plane_mask) {
+    int result = FRUSTUM_INSIDE;
+    for (int p = 0; p < 6; ++p) {
+        if (plane_mask & (1 << p)) {
+            continue;
+        }
+        float a = planes.a[p], b = planes.b[p], c = planes.c[p], d = planes.d[p];
+        float far_distance = a * (a > 0.0f ? max_corner.x : min_corner.x)
+                + b * (b > 0.0f ? max_corner.y : min_corner.y)
+                + c * (c > 0.0f ? max_corner.z : min_corner.z) + d;
+        if (far_distance <= 0.0f) {
+            return FRUSTUM_OUTSIDE;
+        }
+        float near_distance = a * (a > 0.0f ? min_corner.x : max_corner.x)
+                + b * (b > 0.0f ? min_corner.y : max_corner.y)
+                + c * (c > 0.0f ? min_corner.z : max_corner.z) + d;
+        if (near_distance <= 0.0f) {
+            result = FRUSTUM_INTERSECT;
+        } else {
+            plane_mask |= 1 << p;
+        }
+    }
+    return result;
+}
+
+void classifyBoxesScalar(const FrustumPlanes& planes, int plane_mask,
+        const BoxArrays& boxes, int first, int count, unsigned char* results) {
+    for (int i = 0; i < count; ++i) {
+        int mask = plane_mask;
+        int n = first + i;
+        results[i] = classifyBox(planes,
+                glm::vec3(boxes.min_x[n], boxes.min_y[n], boxes.min_z[n]),
+                glm::vec3(boxes.max_x[n], boxes.max_y[n], boxes.max_z[n]), mask);
+    }
+}
+
+#if defined(FRUSTUM_KERNEL_NEON) || defined(FRUSTUM_KERNEL_SSE2)
+
+static inline unsigned char combine(bool outside, bool intersect) {
+    return outside ? FRUSTUM_OUTSIDE : (intersect ? FRUSTUM_INTERSECT : FRUSTUM_INSIDE);
+}
+
+void classifyBoxes(const FrustumPlanes& planes, int plane_mask,
+        const BoxArrays& boxes, int first, int count, unsigned char* results) {
+    const float* min_x = boxes.min_x.data() + first;
+    const float* min_y = boxes.min_y.data() + first;
+    const float* min_z = boxes.min_z.data() + first;
+    const float* max_x = boxes.max_x.data() + first;
+    const float* max_y = boxes.max_y.data() + first;
+    const float* max_z = boxes.max_z.data() + first;
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+#if defined(FRUSTUM_KERNEL_NEON)
+        uint32x4_t outside = vdupq_n_u32(0);
+        uint32x4_t intersect = vdupq_n_u32(0);
+        float32x4_t zero = vdupq_n_f32(0.0f);
+#else
+        __m128 outside = _mm_setzero_ps();
+        __m128 intersect = _mm_setzero_ps();
+        __m128 zero = _mm_setzero_ps();
+#endif
+        for (int p = 0; p < 6; ++p) {
+            if (plane_mask & (1 << p)) {
+                continue;
+            }
+            float a = planes.a[p], b = planes.b[p], c = planes.c[p];
+            // the plane is the same for all four boxes, so is the choice of corners
+            const float* far_x = (a > 0.0f ? max_x : min_x) + i;
+            const float* far_y = (b > 0.0f ? max_y : min_y) + i;
+            const float* far_z = (c > 0.0f ? max_z : min_z) + i;
+            const float* near_x = (a > 0.0f ? min_x : max_x) + i;
+            const float* near_y = (b > 0.0f ? min_y : max_y) + i;
+            const float* near_z = (c > 0.0f ? min_z : max_z) + i;
+#if defined(FRUSTUM_KERNEL_NEON)
+            float32x4_t va = vdupq_n_f32(a);
+            float32x4_t vb = vdupq_n_f32(b);
+            float32x4_t vc = vdupq_n_f32(c);
+            float32x4_t vd = vdupq_n_f32(planes.d[p]);
+            float32x4_t far_distance = vmlaq_f32(vmlaq_f32(vmlaq_f32(vd,
+                    va, vld1q_f32(far_x)), vb, vld1q_f32(far_y)), vc, vld1q_f32(far_z));
+            float32x4_t near_distance = vmlaq_f32(vmlaq_f32(vmlaq_f32(vd,
+                    va, vld1q_f32(near_x)), vb, vld1q_f32(near_y)), vc, vld1q_f32(near_z));
+            outside = vorrq_u32(outside, vcleq_f32(far_distance, zero));
+            intersect = vorrq_u32(intersect, vcleq_f32(near_distance, zero));
+#else
+            __m128 va = _mm_set1_ps(a);
+            __m128 vb = _mm_set1_ps(b);
+            __m128 vc = _mm_set1_ps(c);
+            __m128 vd = _mm_set1_ps(planes.d[p]);
+            __m128 far_distance = _mm_add_ps(_mm_add_ps(
+                    _mm_mul_ps(va, _mm_loadu_ps(far_x)), _mm_mul_ps(vb, _mm_loadu_ps(far_y))),
+                    _mm_add_ps(_mm_mul_ps(vc, _mm_loadu_ps(far_z)), vd));
+            __m128 near_distance = _mm_add_ps(_mm_add_ps(
+                    _mm_mul_ps(va, _mm_loadu_ps(near_x)), _mm_mul_ps(vb, _mm_loadu_ps(near_y))),
+                    _mm_add_ps(_mm_mul_ps(vc, _mm_loadu_ps(near_z)), vd));
+            outside = _mm_or_ps(outside, _mm_cmple_ps(far_distance, zero));
+            intersect = _mm_or_ps(intersect, _mm_cmple_ps(near_distance, zero));
+#endif
+        }
+#if defined(FRUSTUM_KERNEL_NEON)
+        results[i + 0] = combine(vgetq_lane_u32(outside, 0), vgetq_lane_u32(intersect, 0));
+        results[i + 1] = combine(vgetq_lane_u32(outside, 1), vgetq_lane_u32(intersect, 1));
+        results[i + 2] = combine(vgetq_lane_u32(outside, 2), vgetq_lane_u32(intersect, 2));
+        results[i + 3] = combine(vgetq_lane_u32(outside, 3), vgetq_lane_u32(intersect, 3));
+#else
+        int outside_bits = _mm_movemask_ps(outside);
+        int intersect_bits = _mm_movemask_ps(intersect);
+        for (int k = 0; k < 4; ++k) {
+            results[i + k] = combine((outside_bits >> k) & 1, (intersect_bits >> k) & 1);
+        }
+#endif
+    }
+    if (i < count) {
+        classifyBoxesScalar(planes, plane_mask, boxes, first + i, count - i, results + i);
+    }
+}
+
+#else
+
+void classifyBoxes(const FrustumPlanes& planes, int plane_mask,
+        const BoxArrays& boxes, int first, int count, unsigned char* results) {
+    classifyBoxesScalar(planes, plane_mask, boxes, first, count, results);
+}
+
+#endif
+
+const char* frustumKernelName() {
+#if defined(FRUSTUM_KERNEL_NEON)
+    return "neon";
+#elif defined(FRUSTUM_KERNEL_SSE2)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+}
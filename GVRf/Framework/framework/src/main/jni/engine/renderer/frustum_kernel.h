@@ -0,0 +1,92 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Batched box against frustum tests for culling.
+ ***************************************************************************/
+
+#ifndef FRUSTUM_KERNEL_H_
+#define FRUSTUM_KERNEL_H_
+
+#include <vector>
+
+#include "glm/glm.hpp"
+
+namespace gvr {
+
+enum FrustumResult {
+    FRUSTUM_OUTSIDE = 0,
+    FRUSTUM_INTERSECT = 1,
+    FRUSTUM_INSIDE = 2,
+};
+
+/*
+ * The six planes from Renderer::build_frustum, one array per coefficient
+ * so a plane can be broadcast across a vector of boxes.
+ */
+struct FrustumPlanes {
+    float a[6];
+    float b[6];
+    float c[6];
+    float d[6];
+
+    void set(const float frustum[6][4]);
+};
+
+/*
+ * Axis-aligned boxes as six coordinate arrays.
+ */
+struct BoxArrays {
+    std::vector<float> min_x, min_y, min_z;
+    std::vector<float> max_x, max_y, max_z;
+
+    int size() const {
+        return min_x.size();
+    }
+
+    void clear();
+    void resize(int count);
+    void set(int index, const glm::vec3& min_corner, const glm::vec3& max_corner);
+    void swap(BoxArrays& other);
+};
+
+/*
+ * Classifies one box. Planes whose bit is set in plane_mask are known to
+ * contain the box and are skipped; planes found to contain it entirely
+ * are added to the mask, so children of the box can skip them too.
+ */
+int classifyBox(const FrustumPlanes& planes, const glm::vec3& min_corner,
+        const glm::vec3& max_corner, int& plane_mask);
+
+/*
+ * Classifies boxes [first, first + count) into results, four at a time
+ * with NEON or SSE2 where available.
+ */
+void classifyBoxes(const FrustumPlanes& planes, int plane_mask,
+        const BoxArrays& boxes, int first, int count, unsigned char* results);
+
+/*
+ * Portable version of classifyBoxes, also used for the tail.
+ */
+void classifyBoxesScalar(const FrustumPlanes& planes, int plane_mask,
+        const BoxArrays& boxes, int first, int count, unsigned char* results);
+
+/*
+ * "neon", "sse2" or "scalar", whichever classifyBoxes was built with.
+ */
+const char* frustumKernelName();
+
+}
+#endif
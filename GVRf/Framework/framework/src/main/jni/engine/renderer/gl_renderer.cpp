@@ -37,6 +37,7 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <gvr_image_capture.h>
+#include "gl/gl_state_cache.h"
 
 namespace gvr {
 void GLRenderer::renderCamera(Scene* scene, Camera* camera, int framebufferId,
@@ -64,17 +65,21 @@ void GLRenderer::renderCamera(Scene* scene, Camera* camera, int framebufferId,
 
     std::vector<PostEffectData*> post_effects = camera->post_effect_data();
 
-    GL(glEnable (GL_DEPTH_TEST));
-    GL(glDepthFunc (GL_LEQUAL));
-    GL(glEnable (GL_CULL_FACE));
-    GL(glFrontFace (GL_CCW));
-    GL(glCullFace (GL_BACK));
-    GL(glEnable (GL_BLEND));
-    GL(glDisable(GL_SAMPLE_ALPHA_TO_COVERAGE));
-    GL(glBlendEquation (GL_FUNC_ADD));
-    GL(glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
-    GL(glDisable (GL_POLYGON_OFFSET_FILL));
-    GL(glLineWidth(1.0f));
+    // the VR runtime draws between the eyes
+    GLStateCache* gl_state = GLStateCache::getInstance();
+    gl_state->invalidate();
+    GL(gl_state->enable(GL_DEPTH_TEST));
+    GL(gl_state->depthFunc(GL_LEQUAL));
+    GL(gl_state->enable(GL_CULL_FACE));
+    GL(gl_state->frontFace(GL_CCW));
+    GL(gl_state->cullFace(GL_BACK));
+    GL(gl_state->enable(GL_BLEND));
+    GL(gl_state->disable(GL_SAMPLE_ALPHA_TO_COVERAGE));
+    GL(gl_state->blendEquation(GL_FUNC_ADD));
+    GL(gl_state->blendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
+    GL(gl_state->disable(GL_POLYGON_OFFSET_FILL));
+    GL(gl_state->lineWidth(1.0f));
+    uniform_blocks_.update(rstate, render_data_vector);
     if (post_effects.size() == 0) {
         GL(glBindFramebuffer(GL_FRAMEBUFFER, framebufferId));
         GL(glViewport(viewportX, viewportY, viewportWidth, viewportHeight));
@@ -102,8 +107,11 @@ void GLRenderer::renderCamera(Scene* scene, Camera* camera, int framebufferId,
             GL(renderRenderData(rstate, *it));
         }
 
-        GL(glDisable(GL_DEPTH_TEST));
-        GL(glDisable(GL_CULL_FACE));
+        GL(gl_state->disable(GL_DEPTH_TEST));
+        GL(gl_state->disable(GL_CULL_FACE));
+        GL(gl_state->enable(GL_BLEND));
+        GL(gl_state->disable(GL_SAMPLE_ALPHA_TO_COVERAGE));
+        GL(gl_state->disable(GL_POLYGON_OFFSET_FILL));
 
         for (int i = 0; i < post_effects.size() - 1; ++i) {
             if (i % 2 == 0) {
@@ -127,59 +135,49 @@ void GLRenderer::renderCamera(Scene* scene, Camera* camera, int framebufferId,
         renderPostEffectData(camera, texture_render_texture, post_effects.back(), post_effect_shader_manager);
     }
 
-    GL(glDisable(GL_DEPTH_TEST));
-    GL(glDisable(GL_CULL_FACE));
-    GL(glDisable(GL_BLEND));
+    GL(gl_state->disable(GL_DEPTH_TEST));
+    GL(gl_state->disable(GL_CULL_FACE));
+    GL(gl_state->disable(GL_BLEND));
+    GL(gl_state->disable(GL_SAMPLE_ALPHA_TO_COVERAGE));
+    GL(gl_state->disable(GL_POLYGON_OFFSET_FILL));
 }
 
 /**
- * Set the render states for render data
+ * Set the render states for render data. Every state is set, whatever
+ * the previous render data left, so nothing needs restoring in between
+ * and the state cache drops what did not change.
  */
 void GLRenderer::setRenderStates(RenderData* render_data, RenderState& rstate) {
 
     if (!(rstate.render_mask & render_data->render_mask()))
         return;
 
+    GLStateCache* gl_state = GLStateCache::getInstance();
     if (render_data->offset()) {
-        GL(glEnable (GL_POLYGON_OFFSET_FILL));
+        GL(gl_state->enable(GL_POLYGON_OFFSET_FILL));
         GL(
-                glPolygonOffset(render_data->offset_factor(),
+                gl_state->polygonOffset(render_data->offset_factor(),
                         render_data->offset_units()));
+    } else {
+        GL(gl_state->disable(GL_POLYGON_OFFSET_FILL));
     }
-    if (!render_data->depth_test()) {
-        GL(glDisable (GL_DEPTH_TEST));
-    }
-    if (!render_data->alpha_blend()) {
-        GL(glDisable (GL_BLEND));
-    }
+    GL(gl_state->setCapability(GL_DEPTH_TEST, render_data->depth_test()));
+    GL(gl_state->setCapability(GL_BLEND, render_data->alpha_blend()));
     if (render_data->alpha_to_coverage()) {
-        GL(glEnable(GL_SAMPLE_ALPHA_TO_COVERAGE));
+        GL(gl_state->enable(GL_SAMPLE_ALPHA_TO_COVERAGE));
         GL(
-                glSampleCoverage(render_data->sample_coverage(),
+                gl_state->sampleCoverage(render_data->sample_coverage(),
                         render_data->invert_coverage_mask()));
+    } else {
+        GL(gl_state->disable(GL_SAMPLE_ALPHA_TO_COVERAGE));
     }
 }
 /**
- * Restore the render states for render data
+ * Restore the render states for render data. The next setRenderStates
+ * sets everything again and the lists end with the defaults restored,
+ * so there is nothing to do per render data.
  */
 void GLRenderer::restoreRenderStates(RenderData* render_data) {
-    if (render_data->cull_face() != RenderData::CullBack) {
-        GL(glEnable (GL_CULL_FACE));
-        GL(glCullFace (GL_BACK));
-    }
-
-    if (render_data->offset()) {
-        GL(glDisable (GL_POLYGON_OFFSET_FILL));
-    }
-    if (!render_data->depth_test()) {
-        GL(glEnable (GL_DEPTH_TEST));
-    }
-    if (!render_data->alpha_blend()) {
-        GL(glEnable (GL_BLEND));
-    }
-    if (render_data->alpha_to_coverage()) {
-        GL(glDisable(GL_SAMPLE_ALPHA_TO_COVERAGE));
-    }
 }
 
 /**
@@ -191,12 +189,14 @@ void GLRenderer::restoreRenderStates(RenderData* render_data) {
 void GLRenderer::makeShadowMaps(Scene* scene, ShaderManager* shader_manager, int width, int height)
 {
     const std::vector<Light*> lights = scene->getLightList();
-    GL(glEnable (GL_DEPTH_TEST));
-    GL(glDepthFunc (GL_LEQUAL));
-    GL(glEnable (GL_CULL_FACE));
-    GL(glFrontFace (GL_CCW));
-    GL(glCullFace (GL_BACK));
-    GL(glDisable(GL_SAMPLE_ALPHA_TO_COVERAGE));
+    GLStateCache* gl_state = GLStateCache::getInstance();
+    gl_state->invalidate();
+    GL(gl_state->enable(GL_DEPTH_TEST));
+    GL(gl_state->depthFunc(GL_LEQUAL));
+    GL(gl_state->enable(GL_CULL_FACE));
+    GL(gl_state->frontFace(GL_CCW));
+    GL(gl_state->cullFace(GL_BACK));
+    GL(gl_state->disable(GL_SAMPLE_ALPHA_TO_COVERAGE));
 
     int texIndex = 0;
     std::vector<SceneObject*> scene_objects;
@@ -206,9 +206,11 @@ void GLRenderer::makeShadowMaps(Scene* scene, ShaderManager* shader_manager, int
      	    (*it)->makeShadowMap(scene, shader_manager, texIndex, scene_objects, width, height))
             ++texIndex;
     }
-    GL(glDisable(GL_DEPTH_TEST));
-    GL(glDisable(GL_CULL_FACE));
-
+    GL(gl_state->disable(GL_DEPTH_TEST));
+    GL(gl_state->disable(GL_CULL_FACE));
+    GL(gl_state->enable(GL_BLEND));
+    GL(gl_state->disable(GL_SAMPLE_ALPHA_TO_COVERAGE));
+    GL(gl_state->disable(GL_POLYGON_OFFSET_FILL));
 }
 
 /**
@@ -234,6 +236,7 @@ void GLRenderer::renderShadowMap(RenderState& rstate, Camera* camera, GLuint fra
     glClearColor(0,0,0,1);
     GL(glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT));
     rstate.shadow_map = true;
+    uniform_blocks_.update(rstate, render_data_vector);
     for (auto it = render_data_vector.begin();
          it != render_data_vector.end(); ++it) {
         RenderData* rdata = *it;
@@ -289,18 +292,18 @@ void GLRenderer::renderCamera(Scene* scene, Camera* camera, int viewportX,
 void GLRenderer::set_face_culling(int cull_face) {
     switch (cull_face) {
     case RenderData::CullFront:
-        glEnable (GL_CULL_FACE);
-        glCullFace (GL_FRONT);
+        GLStateCache::getInstance()->enable(GL_CULL_FACE);
+        GLStateCache::getInstance()->cullFace(GL_FRONT);
         break;
 
     case RenderData::CullNone:
-        glDisable(GL_CULL_FACE);
+        GLStateCache::getInstance()->disable(GL_CULL_FACE);
         break;
 
         // CullBack as Default
     default:
-        glEnable(GL_CULL_FACE);
-        glCullFace (GL_BACK);
+        GLStateCache::getInstance()->enable(GL_CULL_FACE);
+        GLStateCache::getInstance()->cullFace(GL_BACK);
         break;
     }
 }
@@ -326,77 +329,8 @@ void GLRenderer::occlusion_cull(Scene* scene,
     if(!occlusion_cull_init(scene, scene_objects))
         return;
 
-    for (auto it = scene_objects.begin(); it != scene_objects.end(); ++it) {
-        SceneObject *scene_object = (*it);
-        RenderData* render_data = scene_object->render_data();
-        if (render_data == 0 || render_data->material(0) == 0) {
-            continue;
-        }
-
-        //If a query was issued on an earlier or same frame and if results are
-        //available, then update the same. If results are unavailable, do nothing
-        if (!scene_object->is_query_issued()) {
-            continue;
-        }
-
-        //If a previous query is active, do not issue a new query.
-        //This avoids overloading the GPU with too many queries
-        //Queries may span multiple frames
-
-        bool is_query_issued = scene_object->is_query_issued();
-        if (!is_query_issued) {
-            //Setup basic bounding box and material
-            RenderData* bounding_box_render_data(new RenderData());
-            Mesh* bounding_box_mesh = render_data->mesh()->createBoundingBox();
-            Material *bbox_material = new Material(
-                    Material::BOUNDING_BOX_SHADER);
-            RenderPass *pass = new RenderPass();
-            pass->set_material(bbox_material);
-            bounding_box_render_data->set_mesh(bounding_box_mesh);
-            bounding_box_render_data->add_pass(pass);
-
-            GLuint *query = scene_object->get_occlusion_array();
-
-            glDepthFunc (GL_LEQUAL);
-            glEnable (GL_DEPTH_TEST);
-            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
-
-            glm::mat4 model_matrix_tmp(
-                    scene_object->transform()->getModelMatrix());
-            glm::mat4 mvp_matrix_tmp(vp_matrix * model_matrix_tmp);
-
-            //Issue the query only with a bounding box
-            glBeginQuery(GL_ANY_SAMPLES_PASSED, query[0]);
-            shader_manager->getBoundingBoxShader()->render(mvp_matrix_tmp,
-                    bounding_box_render_data,
-                    bounding_box_render_data->material(0));
-            glEndQuery (GL_ANY_SAMPLES_PASSED);
-            scene_object->set_query_issued(true);
-
-            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-
-            //Delete the generated bounding box mesh
-            bounding_box_mesh->cleanUp();
-            delete bbox_material;
-            delete pass;
-            delete bounding_box_render_data;
-        }
-
-        GLuint query_result = GL_FALSE;
-        GLuint *query = (*it)->get_occlusion_array();
-        glGetQueryObjectuiv(query[0], GL_QUERY_RESULT_AVAILABLE, &query_result);
-
-        if (query_result) {
-            GLuint pixel_count;
-            glGetQueryObjectuiv(query[0], GL_QUERY_RESULT, &pixel_count);
-            bool visibility = ((pixel_count & GL_TRUE) == GL_TRUE);
-
-            (*it)->set_visible(visibility);
-            (*it)->set_query_issued(false);
-            addRenderData((*it)->render_data());
-            scene->pick(scene_object);
-        }
-    }
+    // BVH::cull already dropped what the OcclusionCuller found hidden
+    collectRenderData(scene, scene_objects);
     scene->unlockColliders();
 }
 
@@ -418,6 +352,120 @@ void GLRenderer::renderMesh(RenderState& rstate, RenderData* render_data) {
     }
 }
 
+/*
+ * One draw per pass for all the render data, which share mesh, passes
+ * and render state. The model matrices go to a_instance_matrix and the
+ * shader sees the identity as u_model. Shaders that can not draw
+ * instanced fall back to a draw per render data.
+ */
+void GLRenderer::renderInstances(RenderState& rstate,
+        const std::vector<RenderData*>& render_data) {
+    RenderData* first = render_data[0];
+    if (!(rstate.render_mask & first->render_mask()))
+        return;
+
+    // the shared mesh may store its positions encoded
+    Mesh* mesh = first->mesh();
+    glm::mat4 dequant = mesh->hasPositionDequant() ? mesh->positionDequant() : glm::mat4();
+    int count = render_data.size();
+    instance_matrices_.resize(count);
+    for (int i = 0; i < count; ++i) {
+        instance_matrices_[i] = render_data[i]->owner_object()->transform()->getModelMatrix() * dequant;
+    }
+
+    setRenderStates(first, rstate);
+    for (int curr_pass = 0; curr_pass < first->pass_count(); ++curr_pass) {
+        set_face_culling(first->pass(curr_pass)->cull_face());
+        Material* curr_material = rstate.material_override;
+
+        if (curr_material == nullptr)
+            curr_material = first->pass(curr_pass)->material();
+        if (curr_material == nullptr)
+            continue;
+        // nothing is drawn until the shader and the texture are there, nor counted
+        if (Material::ShaderType::BEING_GENERATED == curr_material->shader_type()
+                || !checkTextureReady(curr_material))
+            continue;
+        if (renderInstancedMaterialShader(rstate, first, curr_material)) {
+            numberTriangles += first->mesh()->getNumTriangles() * render_data.size();
+            numberDrawCalls++;
+            numberInstances += render_data.size();
+            continue;
+        }
+        for (auto it = render_data.begin(); it != render_data.end(); ++it) {
+            numberTriangles += (*it)->mesh()->getNumTriangles();
+            numberDrawCalls++;
+            GL(renderMaterialShader(rstate, *it, curr_material));
+        }
+    }
+    restoreRenderStates(first);
+}
+
+bool GLRenderer::renderInstancedMaterialShader(RenderState& rstate, RenderData* render_data,
+        Material *curr_material) {
+    int shader_type = curr_material->shader_type();
+    if (Material::ShaderType::BEING_GENERATED == shader_type
+            || !checkTextureReady(curr_material)) {
+        return false;
+    }
+
+    ShaderBase* shader = nullptr;
+    try {
+        if (Material::ShaderType::TEXTURE_SHADER == shader_type) {
+            shader = rstate.shader_manager->getTextureShader();
+        } else if (shader_type >= Material::ShaderType::BUILTIN_SHADER_SIZE) {
+            shader = rstate.shader_manager->getCustomShader(shader_type);
+        } else {
+            return false;
+        }
+        uniform_blocks_.bindIdentity(rstate);
+        if (!shader->renderInstanced(&rstate, render_data, curr_material)) {
+            return false;
+        }
+    } catch (const std::string &error) {
+        LOGE("Error detected in Renderer::renderInstances; error : %s", error.c_str());
+        return false;
+    }
+
+    GLuint programId = shader->getProgramId();
+    GLint location = glGetAttribLocation(programId, "a_instance_matrix");
+    if (location < 0) {
+        return false;
+    }
+    Mesh* mesh = render_data->mesh();
+    int instance_count = instance_matrices_.size();
+    GLStateCache::getInstance()->bindVertexArray(mesh->getVAOId(programId));
+    if (0 == instance_buffer_) {
+        glGenBuffers(1, &instance_buffer_);
+    }
+    GLStateCache::getInstance()->bindBuffer(GL_ARRAY_BUFFER, instance_buffer_);
+    // orphan the previous store, the GPU may still read it
+    glBufferData(GL_ARRAY_BUFFER, instance_count * sizeof(glm::mat4),
+            glm::value_ptr(instance_matrices_[0]), GL_STREAM_DRAW);
+    for (int i = 0; i < 4; ++i) {
+        glVertexAttribPointer(location + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                (GLvoid*) (i * sizeof(glm::vec4)));
+        glEnableVertexAttribArray(location + i);
+        glVertexAttribDivisor(location + i, 1);
+    }
+    if (mesh->indices().size() > 0) {
+        glDrawElementsInstanced(render_data->draw_mode(), mesh->indices().size(),
+                mesh->indexType(), 0, instance_count);
+    } else {
+        glDrawArraysInstanced(render_data->draw_mode(), 0, mesh->vertices().size(),
+                instance_count);
+    }
+    // the vertex array is shared with single draws of the same program
+    for (int i = 0; i < 4; ++i) {
+        glVertexAttribDivisor(location + i, 0);
+        glDisableVertexAttribArray(location + i);
+    }
+    GLStateCache::getInstance()->bindVertexArray(0);
+    GLStateCache::getInstance()->bindBuffer(GL_ARRAY_BUFFER, 0);
+    checkGlError("GLRenderer::renderInstancedMaterialShader");
+    return true;
+}
+
 void GLRenderer::renderMaterialShader(RenderState& rstate, RenderData* render_data, Material *curr_material) {
 
     if (Material::ShaderType::BEING_GENERATED == curr_material->shader_type()) {
@@ -433,23 +481,7 @@ void GLRenderer::renderMaterialShader(RenderState& rstate, RenderData* render_da
     if (t == nullptr)
         return;
 
-    rstate.uniforms.u_model = t->getModelMatrix();
-	rstate.uniforms.u_mv = rstate.uniforms.u_view * rstate.uniforms.u_model;
-	rstate.uniforms.u_mv_it = glm::inverseTranspose(rstate.uniforms.u_mv);
-	rstate.uniforms.u_mvp = rstate.uniforms.u_proj * rstate.uniforms.u_mv;
-    rstate.uniforms.u_right = rstate.render_mask & RenderData::RenderMaskBit::Right;
-
-
-    if(use_multiview && !rstate.shadow_map){
-        rstate.uniforms.u_view_[0] = rstate.scene->main_camera_rig()->left_camera()->getViewMatrix();
-        rstate.uniforms.u_view_[1] = rstate.scene->main_camera_rig()->right_camera()->getViewMatrix();
-        rstate.uniforms.u_mv_[0] = rstate.uniforms.u_view_[0] * rstate.uniforms.u_model;
-        rstate.uniforms.u_mv_[1] = rstate.uniforms.u_view_[1] * rstate.uniforms.u_model;
-        rstate.uniforms.u_mv_it_[0] = glm::inverseTranspose(rstate.uniforms.u_mv_[0]);
-        rstate.uniforms.u_mv_it_[1] = glm::inverseTranspose(rstate.uniforms.u_mv_[1]);
-        rstate.uniforms.u_mvp_[0] = rstate.uniforms.u_proj * rstate.uniforms.u_mv_[0];
-        rstate.uniforms.u_mvp_[1] = rstate.uniforms.u_proj * rstate.uniforms.u_mv_[1];
-    }
+    uniform_blocks_.bindObject(rstate, render_data);
     Mesh* mesh = render_data->mesh();
 
     GLuint programId = -1;
@@ -479,12 +511,6 @@ void GLRenderer::renderMaterialShader(RenderState& rstate, RenderData* render_da
                 shader = shader_manager->getCubemapShader();
                 break;
             case Material::ShaderType::CUBEMAP_REFLECTION_SHADER:
-                if(use_multiview){
-                    rstate.uniforms.u_view_inv_[0] = glm::inverse(rstate.uniforms.u_view_[0]);
-                    rstate.uniforms.u_view_inv_[1] = glm::inverse(rstate.uniforms.u_view_[1]);
-                }
-                else
-                    rstate.uniforms.u_view_inv = glm::inverse(rstate.uniforms.u_view);
                 shader = shader_manager->getCubemapReflectionShader();
                 break;
             case Material::ShaderType::TEXTURE_SHADER:
@@ -514,12 +540,13 @@ void GLRenderer::renderMaterialShader(RenderState& rstate, RenderData* render_da
          if ((render_data->draw_mode() == GL_LINE_STRIP) ||
              (render_data->draw_mode() == GL_LINES) ||
              (render_data->draw_mode() == GL_LINE_LOOP)) {
-             if (curr_material->hasUniform("line_width")) {
-                 float lineWidth = curr_material->getFloat("line_width");
-                 glLineWidth(lineWidth);
+             static const int line_width_slot = Material::declare("line_width", MaterialLayout::FLOAT);
+             const float* lineWidth = curr_material->getFloatNoError(line_width_slot);
+             if (NULL != lineWidth) {
+                 GLStateCache::getInstance()->lineWidth(*lineWidth);
              }
              else {
-                 glLineWidth(1.0f);
+                 GLStateCache::getInstance()->lineWidth(1.0f);
              }
          }
          shader->render(&rstate, render_data, curr_material);
@@ -534,14 +561,14 @@ void GLRenderer::renderMaterialShader(RenderState& rstate, RenderData* render_da
     programId = shader->getProgramId();
     //there is no program associated with EXTERNAL_RENDERER_SHADER
     if (-1 != programId) {
-        glBindVertexArray(mesh->getVAOId(programId));
+        GLStateCache::getInstance()->bindVertexArray(mesh->getVAOId(programId));
         if (mesh->indices().size() > 0) {
-            glDrawElements(render_data->draw_mode(), mesh->indices().size(), GL_UNSIGNED_SHORT, 0);
+            glDrawElements(render_data->draw_mode(), mesh->indices().size(), mesh->indexType(), 0);
 
         } else {
             glDrawArrays(render_data->draw_mode(), 0, mesh->vertices().size());
         }
-        glBindVertexArray(0);
+        GLStateCache::getInstance()->bindVertexArray(0);
     }
     checkGlError("renderMesh::renderMaterialShader");
 }
@@ -40,6 +40,7 @@
 #include "gl/gl_program.h"
 #include <unordered_map>
 #include "renderer.h"
+#include "uniform_blocks.h"
 
 typedef unsigned long Long;
 namespace gvr {
@@ -56,7 +57,7 @@ class Light;
 class GLRenderer: public Renderer {
     friend class Renderer;
 protected:
-    GLRenderer(){}
+    GLRenderer() : instance_buffer_(0) {}
     virtual ~GLRenderer(){}
 public:
     // pure virtual
@@ -93,6 +94,7 @@ public:
             RenderTexture* post_effect_render_texture_b);
 
      void set_face_culling(int cull_face);
+     void renderInstances(RenderState& rstate, const std::vector<RenderData*>& render_data);
 
 private:
     // this is specific to GL
@@ -101,10 +103,16 @@ private:
     // Pure Virtual
     virtual void renderMesh(RenderState& rstate, RenderData* render_data);
     virtual void renderMaterialShader(RenderState& rstate, RenderData* render_data, Material *material) ;
+    // false when the shader can not draw instanced
+    bool renderInstancedMaterialShader(RenderState& rstate, RenderData* render_data,
+            Material *material);
     void occlusion_cull(Scene* scene,
                     std::vector<SceneObject*>& scene_objects,
                     ShaderManager *shader_manager, glm::mat4 vp_matrix);
 
+    UniformBlocks uniform_blocks_;
+    GLuint instance_buffer_;
+    std::vector<glm::mat4> instance_matrices_;
 };
 }
 #endif
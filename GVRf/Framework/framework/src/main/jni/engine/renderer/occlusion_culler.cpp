@@ -0,0 +1,630 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Occlusion culling against a software depth buffer.
+ ***************************************************************************/
+
+#include "occlusion_culler.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "objects/mesh.h"
+#include "objects/scene_object.h"
+#include "objects/components/render_data.h"
+#include "objects/components/transform.h"
+#include "util/gvr_job_system.h"
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define OCCLUSION_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define OCCLUSION_SSE2 1
+#endif
+
+namespace gvr {
+
+namespace {
+
+const int COVERAGE_BITS = HiZBuffer::COVERAGE_SAMPLES * HiZBuffer::COVERAGE_SAMPLES;
+const int SAMPLE_VECTORS = (COVERAGE_BITS + 3) / 4;
+
+/*
+ * Sample offsets from the pixel center in subpixels, row by row, in the
+ * order of the coverage bits. The padding lanes fall outside the mask.
+ */
+struct SampleOffsets {
+    float x[SAMPLE_VECTORS * 4];
+    float y[SAMPLE_VECTORS * 4];
+
+    SampleOffsets() {
+        const float step = (float) HiZBuffer::SUBPIXEL / (HiZBuffer::COVERAGE_SAMPLES - 1);
+        for (int k = 0; k < SAMPLE_VECTORS * 4; ++k) {
+            int sx = k % HiZBuffer::COVERAGE_SAMPLES;
+            int sy = k / HiZBuffer::COVERAGE_SAMPLES;
+            x[k] = k < COVERAGE_BITS ? sx * step - HiZBuffer::SUBPIXEL / 2 : 0.0f;
+            y[k] = k < COVERAGE_BITS ? sy * step - HiZBuffer::SUBPIXEL / 2 : 0.0f;
+        }
+    }
+};
+
+const SampleOffsets sample_offsets;
+
+/*
+ * Bit k set when sample k is inside the edge a * x + b * y + c >= 0,
+ * c taken at the pixel center.
+ */
+inline unsigned int edgeSamples(float a, float b, float c) {
+    unsigned int mask = 0;
+#if defined(OCCLUSION_NEON)
+    static const uint32_t weights[4] = { 1, 2, 4, 8 };
+    float32x4_t va = vdupq_n_f32(a);
+    float32x4_t vb = vdupq_n_f32(b);
+    float32x4_t vc = vdupq_n_f32(c);
+    float32x4_t zero = vdupq_n_f32(0.0f);
+    uint32x4_t vweights = vld1q_u32(weights);
+    for (int v = 0; v < SAMPLE_VECTORS; ++v) {
+        float32x4_t d = vmlaq_f32(vmlaq_f32(vc, va, vld1q_f32(sample_offsets.x + v * 4)),
+                vb, vld1q_f32(sample_offsets.y + v * 4));
+        uint32x4_t bits = vandq_u32(vcgeq_f32(d, zero), vweights);
+        uint32x2_t sum = vpadd_u32(vget_low_u32(bits), vget_high_u32(bits));
+        sum = vpadd_u32(sum, sum);
+        mask |= vget_lane_u32(sum, 0) << (v * 4);
+    }
+#elif defined(OCCLUSION_SSE2)
+    __m128 va = _mm_set1_ps(a);
+    __m128 vb = _mm_set1_ps(b);
+    __m128 vc = _mm_set1_ps(c);
+    __m128 zero = _mm_setzero_ps();
+    for (int v = 0; v < SAMPLE_VECTORS; ++v) {
+        __m128 d = _mm_add_ps(_mm_add_ps(vc, _mm_mul_ps(va, _mm_loadu_ps(sample_offsets.x + v * 4))),
+                _mm_mul_ps(vb, _mm_loadu_ps(sample_offsets.y + v * 4)));
+        mask |= (unsigned int) _mm_movemask_ps(_mm_cmpge_ps(d, zero)) << (v * 4);
+    }
+#else
+    for (int k = 0; k < COVERAGE_BITS; ++k) {
+        mask |= (unsigned int) (c + a * sample_offsets.x[k] + b * sample_offsets.y[k] >= 0.0f)
+                << k;
+    }
+#endif
+    return mask;
+}
+
+/*
+ * Pixels [x0, x1] of the row take the nearer of their depth and the
+ * triangle's, the plane at the far corner clamped to the farthest vertex.
+ */
+inline void fillSpan(const HiZBuffer::Triangle& t, float ez, float* row, int x0, int x1) {
+    const int S = HiZBuffer::SUBPIXEL;
+    int x = x0;
+#if defined(OCCLUSION_NEON)
+    static const float lanes[4] = { 0.0f, S, 2.0f * S, 3.0f * S };
+    float32x4_t vlanes = vld1q_f32(lanes);
+    float32x4_t va = vdupq_n_f32(t.depth_a);
+    float32x4_t vez = vdupq_n_f32(ez);
+    float32x4_t vmax = vdupq_n_f32(t.depth_max);
+    for (; x + 3 <= x1; x += 4) {
+        float32x4_t xc = vaddq_f32(vdupq_n_f32((float) (x * S + S / 2)), vlanes);
+        float32x4_t depth = vminq_f32(vmlaq_f32(vez, va, xc), vmax);
+        vst1q_f32(row + x, vminq_f32(vld1q_f32(row + x), depth));
+    }
+#elif defined(OCCLUSION_SSE2)
+    __m128 vlanes = _mm_set_ps(3.0f * S, 2.0f * S, S, 0.0f);
+    __m128 va = _mm_set1_ps(t.depth_a);
+    __m128 vez = _mm_set1_ps(ez);
+    __m128 vmax = _mm_set1_ps(t.depth_max);
+    for (; x + 3 <= x1; x += 4) {
+        __m128 xc = _mm_add_ps(_mm_set1_ps((float) (x * S + S / 2)), vlanes);
+        __m128 depth = _mm_min_ps(_mm_add_ps(_mm_mul_ps(va, xc), vez), vmax);
+        _mm_storeu_ps(row + x, _mm_min_ps(_mm_loadu_ps(row + x), depth));
+    }
+#endif
+    for (; x <= x1; ++x) {
+        float xc = x * S + S / 2;
+        row[x] = std::min(row[x], std::min(t.depth_a * xc + ez, t.depth_max));
+    }
+}
+
+/*
+ * dst[x] is the farthest of the 2x2 source texels under it, the source
+ * rows 2 * size wide.
+ */
+inline void reduceRow(const float* row0, const float* row1, float* dst, int size) {
+    int x = 0;
+#if defined(OCCLUSION_NEON)
+    for (; x + 4 <= size; x += 4) {
+        float32x4x2_t r0 = vld2q_f32(row0 + x * 2);
+        float32x4x2_t r1 = vld2q_f32(row1 + x * 2);
+        vst1q_f32(dst + x, vmaxq_f32(vmaxq_f32(r0.val[0], r0.val[1]),
+                vmaxq_f32(r1.val[0], r1.val[1])));
+    }
+#elif defined(OCCLUSION_SSE2)
+    for (; x + 4 <= size; x += 4) {
+        __m128 a0 = _mm_loadu_ps(row0 + x * 2);
+        __m128 a1 = _mm_loadu_ps(row0 + x * 2 + 4);
+        __m128 b0 = _mm_loadu_ps(row1 + x * 2);
+        __m128 b1 = _mm_loadu_ps(row1 + x * 2 + 4);
+        __m128 a = _mm_max_ps(_mm_shuffle_ps(a0, a1, _MM_SHUFFLE(2, 0, 2, 0)),
+                _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(3, 1, 3, 1)));
+        __m128 b = _mm_max_ps(_mm_shuffle_ps(b0, b1, _MM_SHUFFLE(2, 0, 2, 0)),
+                _mm_shuffle_ps(b0, b1, _MM_SHUFFLE(3, 1, 3, 1)));
+        _mm_storeu_ps(dst + x, _mm_max_ps(a, b));
+    }
+#endif
+    for (; x < size; ++x) {
+        dst[x] = std::max(std::max(row0[x * 2], row0[x * 2 + 1]),
+                std::max(row1[x * 2], row1[x * 2 + 1]));
+    }
+}
+
+}
+
+HiZBuffer::HiZBuffer() {
+    int offset = 0;
+    for (int n = 0; n <= LEVELS; ++n) {
+        level_offset_[n] = offset;
+        int size = SIZE >> n;
+        offset += size * size;
+    }
+    levels_.resize(offset);
+    coverage_.resize(SIZE * SIZE);
+    partial_depth_.resize(SIZE * SIZE);
+    clear();
+}
+
+void HiZBuffer::clear() {
+    std::fill(levels_.begin(), levels_.end(), 1.0f);
+    std::fill(coverage_.begin(), coverage_.end(), 0u);
+    std::fill(partial_depth_.begin(), partial_depth_.end(), 0.0f);
+    triangles_.clear();
+}
+
+/*
+ * Sutherland-Hodgman in clip space against the near and the four side
+ * planes, so what reaches the rasterizer has w > 0 and stays on screen.
+ * Most triangles are entirely inside or outside one plane and skip it.
+ */
+void HiZBuffer::setupTriangle(const glm::vec3& p0, const glm::vec3& p1,
+        const glm::vec3& p2) {
+    static const glm::vec4 planes[5] = {
+        glm::vec4(0.0f, 0.0f, 1.0f, 1.0f),
+        glm::vec4(1.0f, 0.0f, 0.0f, 1.0f),
+        glm::vec4(-1.0f, 0.0f, 0.0f, 1.0f),
+        glm::vec4(0.0f, 1.0f, 0.0f, 1.0f),
+        glm::vec4(0.0f, -1.0f, 0.0f, 1.0f),
+    };
+    glm::vec4 polygon[2][8];
+    int count = 3;
+    polygon[0][0] = vp_ * glm::vec4(p0, 1.0f);
+    polygon[0][1] = vp_ * glm::vec4(p1, 1.0f);
+    polygon[0][2] = vp_ * glm::vec4(p2, 1.0f);
+
+    int crossed = 0;
+    for (int p = 0; p < 5; ++p) {
+        int outside = 0;
+        for (int i = 0; i < 3; ++i) {
+            outside += glm::dot(planes[p], polygon[0][i]) < 0.0f;
+        }
+        if (3 == outside) {
+            return;
+        }
+        if (outside > 0) {
+            crossed |= 1 << p;
+        }
+    }
+    if (0 == crossed) {
+        addTriangle(polygon[0][0], polygon[0][1], polygon[0][2]);
+        return;
+    }
+
+    int in = 0;
+    for (int p = 0; p < 5 && count >= 3; ++p) {
+        if (0 == (crossed & (1 << p))) {
+            continue;
+        }
+        const glm::vec4* src = polygon[in];
+        glm::vec4* dst = polygon[in ^ 1];
+        int out_count = 0;
+        for (int i = 0; i < count; ++i) {
+            const glm::vec4& a = src[i];
+            const glm::vec4& b = src[(i + 1) % count];
+            float da = glm::dot(planes[p], a);
+            float db = glm::dot(planes[p], b);
+            if (da >= 0.0f) {
+                dst[out_count++] = a;
+            }
+            if ((da >= 0.0f) != (db >= 0.0f)) {
+                dst[out_count++] = a + (b - a) * (da / (da - db));
+            }
+        }
+        count = out_count;
+        in ^= 1;
+    }
+    for (int i = 2; i < count; ++i) {
+        addTriangle(polygon[in][0], polygon[in][i - 1], polygon[in][i]);
+    }
+}
+
+/*
+ * Vertices are snapped to 1/SUBPIXEL of a pixel, which keeps the edge
+ * functions exact integers in float. An edge shared by two triangles
+ * runs opposite ways in each, and only the one where it is a left edge
+ * (or a bottom edge, if horizontal) covers the samples on it, so a
+ * closed occluder has no seams.
+ */
+void HiZBuffer::addTriangle(const glm::vec4& c0, const glm::vec4& c1,
+        const glm::vec4& c2) {
+    const glm::vec4* clip[3] = { &c0, &c1, &c2 };
+    float x[3], y[3], z[3];
+    for (int i = 0; i < 3; ++i) {
+        float inv_w = 1.0f / clip[i]->w;
+        x[i] = std::floor((clip[i]->x * inv_w * 0.5f + 0.5f) * (SIZE * SUBPIXEL) + 0.5f);
+        y[i] = std::floor((clip[i]->y * inv_w * 0.5f + 0.5f) * (SIZE * SUBPIXEL) + 0.5f);
+        z[i] = clip[i]->z * inv_w * 0.5f + 0.5f;
+    }
+    float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+    if (0.0f == area) {
+        return;
+    }
+    if (area < 0.0f) {
+        // both windings occlude, make the inside positive
+        std::swap(x[1], x[2]);
+        std::swap(y[1], y[2]);
+        std::swap(z[1], z[2]);
+        area = -area;
+    }
+
+    // every pixel the bounding box touches, pixel n spans [n, n + 1) * SUBPIXEL
+    Triangle t;
+    int min_x = (int) std::floor(std::min(x[0], std::min(x[1], x[2])) / SUBPIXEL);
+    int max_x = (int) std::floor(std::max(x[0], std::max(x[1], x[2])) / SUBPIXEL);
+    int min_y = (int) std::floor(std::min(y[0], std::min(y[1], y[2])) / SUBPIXEL);
+    int max_y = (int) std::floor(std::max(y[0], std::max(y[1], y[2])) / SUBPIXEL);
+    t.min_x = std::max(min_x, 0);
+    t.max_x = std::min(max_x, SIZE - 1);
+    t.min_y = std::max(min_y, 0);
+    t.max_y = std::min(max_y, SIZE - 1);
+    if (t.min_x > t.max_x || t.min_y > t.max_y) {
+        return;
+    }
+
+    // edge i is opposite vertex i, >= 0 inside
+    for (int i = 0; i < 3; ++i) {
+        int a = (i + 1) % 3;
+        int b = (i + 2) % 3;
+        t.edge_a[i] = y[a] - y[b];
+        t.edge_b[i] = x[b] - x[a];
+        t.edge_c[i] = x[a] * y[b] - y[a] * x[b];
+        bool owned = t.edge_a[i] > 0.0f || (0.0f == t.edge_a[i] && t.edge_b[i] < 0.0f);
+        if (!owned) {
+            t.edge_c[i] -= 1.0f;
+        }
+        // an edge function changes by this much from a pixel center to its corners
+        t.edge_reach[i] = (std::abs(t.edge_a[i]) + std::abs(t.edge_b[i])) * (SUBPIXEL / 2);
+    }
+    float inv_area = 1.0f / area;
+    t.depth_a = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) * inv_area;
+    t.depth_b = ((z[2] - z[0]) * (x[1] - x[0]) - (z[1] - z[0]) * (x[2] - x[0])) * inv_area;
+    t.depth_c = z[0] - t.depth_a * x[0] - t.depth_b * y[0];
+    // farthest depth over a pixel: the plane at the far corner, but never past the triangle
+    t.depth_reach = (std::abs(t.depth_a) + std::abs(t.depth_b)) * (SUBPIXEL / 2);
+    t.depth_max = std::max(z[0], std::max(z[1], z[2]));
+    triangles_.push_back(t);
+}
+
+/*
+ * Conservative: a pixel only takes a depth once occluders cover all of
+ * it, and then takes the farthest depth they have over it. Coverage is
+ * kept as a mask of COVERAGE_SAMPLES x COVERAGE_SAMPLES samples running
+ * from corner to corner, so a pixel one triangle covers alone is covered
+ * exactly, and the triangles meeting inside a pixel add up their masks.
+ *
+ * The span of pixels inside all three edges corner to corner, the bulk
+ * of a large occluder, is found per row and written without samples.
+ */
+void HiZBuffer::rasterizeRow(const Triangle& t, int y) {
+    float yc = y * SUBPIXEL + SUBPIXEL / 2;
+    float e[3];
+    for (int i = 0; i < 3; ++i) {
+        e[i] = t.edge_b[i] * yc + t.edge_c[i];
+    }
+    float ez = t.depth_b * yc + t.depth_c + t.depth_reach;
+    float* row = &levels_[y * SIZE];
+
+    // edge i covers the whole pixel x when edge_a[i] * SUBPIXEL * x + base >= 0,
+    // and some of it when that holds with 2 * edge_reach[i] added to base
+    int full_min = t.min_x;
+    int full_max = t.max_x;
+    int touch_min = t.min_x;
+    int touch_max = t.max_x;
+    for (int i = 0; i < 3; ++i) {
+        float slope = t.edge_a[i] * SUBPIXEL;
+        float base = t.edge_a[i] * (SUBPIXEL / 2) + e[i] - t.edge_reach[i];
+        float touch_base = base + 2.0f * t.edge_reach[i];
+        if (0.0f == slope) {
+            if (base < 0.0f) {
+                full_max = full_min - 1;
+            }
+            if (touch_base < 0.0f) {
+                return;
+            }
+            continue;
+        }
+        float full_bound = std::min(std::max(-base / slope, t.min_x - 1.0f), t.max_x + 1.0f);
+        float touch_bound = std::min(std::max(-touch_base / slope, t.min_x - 1.0f),
+                t.max_x + 1.0f);
+        if (slope > 0.0f) {
+            full_min = std::max(full_min, (int) std::ceil(full_bound));
+            touch_min = std::max(touch_min, (int) std::floor(touch_bound));
+        } else {
+            full_max = std::min(full_max, (int) std::floor(full_bound));
+            touch_max = std::min(touch_max, (int) std::ceil(touch_bound));
+        }
+    }
+    // the span ends were rounded in float, the exact test has the last word
+    while (full_min <= full_max && !coversPixel(t, e, full_min)) {
+        ++full_min;
+    }
+    while (full_min <= full_max && !coversPixel(t, e, full_max)) {
+        --full_max;
+    }
+
+    if (full_min > full_max) {
+        for (int x = touch_min; x <= touch_max; ++x) {
+            coverPart(t, e, ez, x, y);
+        }
+        return;
+    }
+    for (int x = touch_min; x < full_min; ++x) {
+        coverPart(t, e, ez, x, y);
+    }
+    fillSpan(t, ez, row, full_min, full_max);
+    for (int x = full_max + 1; x <= touch_max; ++x) {
+        coverPart(t, e, ez, x, y);
+    }
+}
+
+bool HiZBuffer::coversPixel(const Triangle& t, const float e[3], int x) const {
+    float xc = x * SUBPIXEL + SUBPIXEL / 2;
+    for (int i = 0; i < 3; ++i) {
+        if (t.edge_a[i] * xc + e[i] < t.edge_reach[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Adds the samples of pixel x the triangle covers, and writes the depth
+ * once the samples of all the triangles so far cover the whole pixel.
+ */
+void HiZBuffer::coverPart(const Triangle& t, const float e[3], float ez, int x, int y) {
+    const unsigned int full = (1u << (COVERAGE_SAMPLES * COVERAGE_SAMPLES)) - 1;
+    float xc = x * SUBPIXEL + SUBPIXEL / 2;
+    float c[3];
+    for (int i = 0; i < 3; ++i) {
+        c[i] = t.edge_a[i] * xc + e[i];
+        if (c[i] < -t.edge_reach[i]) {
+            return; // outside the edge over the whole pixel
+        }
+    }
+
+    // only the edges crossing the pixel take samples away
+    unsigned int mask = full;
+    for (int i = 0; i < 3; ++i) {
+        if (c[i] < t.edge_reach[i]) {
+            mask &= edgeSamples(t.edge_a[i], t.edge_b[i], c[i]);
+        }
+    }
+    if (0 == mask) {
+        return;
+    }
+    int index = y * SIZE + x;
+    float depth = std::min(t.depth_a * xc + ez, t.depth_max);
+    coverage_[index] |= mask;
+    partial_depth_[index] = std::max(partial_depth_[index], depth);
+    if (full == coverage_[index]) {
+        levels_[index] = std::min(levels_[index], partial_depth_[index]);
+        coverage_[index] = 0;
+        partial_depth_[index] = 0.0f;
+    }
+}
+
+void HiZBuffer::rasterize(int first_row, int last_row) {
+    for (auto it = triangles_.begin(); it != triangles_.end(); ++it) {
+        const Triangle& t = *it;
+        int y0 = std::max(t.min_y, first_row);
+        int y1 = std::min(t.max_y, last_row - 1);
+        for (int y = y0; y <= y1; ++y) {
+            rasterizeRow(t, y);
+        }
+    }
+}
+
+void HiZBuffer::buildMips() {
+    for (int n = 1; n <= LEVELS; ++n) {
+        int size = SIZE >> n;
+        const float* src = &levels_[level_offset_[n - 1]];
+        float* dst = &levels_[level_offset_[n]];
+        for (int y = 0; y < size; ++y) {
+            const float* row0 = src + (y * 2) * size * 2;
+            reduceRow(row0, row0 + size * 2, dst + y * size, size);
+        }
+    }
+}
+
+/*
+ * The nearest corner bounds the depth of the whole box and the corners'
+ * screen rectangle bounds its footprint. The rectangle is looked up on
+ * the level where it spans at most 2x2 texels.
+ */
+bool HiZBuffer::isOccluded(const glm::vec3& min_corner,
+        const glm::vec3& max_corner) const {
+    float min_x = SIZE, max_x = 0.0f;
+    float min_y = SIZE, max_y = 0.0f;
+    float min_depth = 1.0f;
+    // corners are the min corner plus the box edges, transformed once
+    glm::vec3 extent = max_corner - min_corner;
+    glm::vec4 origin = vp_ * glm::vec4(min_corner, 1.0f);
+    glm::vec4 edges[3] = { vp_[0] * extent.x, vp_[1] * extent.y, vp_[2] * extent.z };
+    for (int i = 0; i < 8; ++i) {
+        glm::vec4 clip = origin;
+        if (i & 1) {
+            clip += edges[0];
+        }
+        if (i & 2) {
+            clip += edges[1];
+        }
+        if (i & 4) {
+            clip += edges[2];
+        }
+        if (clip.w <= 0.0f || clip.z < -clip.w) {
+            return false;
+        }
+        float inv_w = 1.0f / clip.w;
+        float x = (clip.x * inv_w * 0.5f + 0.5f) * SIZE;
+        float y = (clip.y * inv_w * 0.5f + 0.5f) * SIZE;
+        min_x = std::min(min_x, x);
+        max_x = std::max(max_x, x);
+        min_y = std::min(min_y, y);
+        max_y = std::max(max_y, y);
+        min_depth = std::min(min_depth, clip.z * inv_w * 0.5f + 0.5f);
+    }
+    if (max_x < 0.0f || min_x >= SIZE || max_y < 0.0f || min_y >= SIZE) {
+        return true; // off screen, the frustum test has it
+    }
+
+    int x0 = std::max((int) min_x, 0);
+    int x1 = std::min((int) max_x, SIZE - 1);
+    int y0 = std::max((int) min_y, 0);
+    int y1 = std::min((int) max_y, SIZE - 1);
+    int n = 0;
+    while ((x1 >> n) - (x0 >> n) > 1 || (y1 >> n) - (y0 >> n) > 1) {
+        ++n;
+    }
+    int size = SIZE >> n;
+    const float* texels = level(n);
+    float max_depth = 0.0f;
+    for (int y = y0 >> n; y <= (y1 >> n); ++y) {
+        for (int x = x0 >> n; x <= (x1 >> n); ++x) {
+            max_depth = std::max(max_depth, texels[y * size + x]);
+        }
+    }
+    return min_depth > max_depth;
+}
+
+OcclusionCuller::OcclusionCuller() :
+        view_count_(0), occluder_count_(0), occluder_triangles_(0) {
+}
+
+void OcclusionCuller::setViews(const glm::mat4* vp, int view_count) {
+    view_count_ = std::min(view_count, (int) MAX_VIEWS);
+    for (int v = 0; v < view_count_; ++v) {
+        views_[v].setViewProjection(vp[v]);
+    }
+}
+
+bool OcclusionCuller::rasterize(const std::vector<SceneObject*>& objects) {
+    occluders_.clear();
+    for (auto it = objects.begin(); it != objects.end(); ++it) {
+        RenderData* rdata = (*it)->render_data();
+        if (nullptr != rdata && rdata->is_occluder() && nullptr != rdata->mesh()
+                && GL_TRIANGLES == rdata->draw_mode()) {
+            occluders_.push_back(*it);
+        }
+    }
+    occluder_count_ = 0;
+    occluder_triangles_ = 0;
+    if (occluders_.empty() || 0 == view_count_) {
+        return false;
+    }
+    std::stable_sort(occluders_.begin(), occluders_.end(),
+            [](SceneObject* a, SceneObject* b) {
+                return a->render_data()->camera_distance() < b->render_data()->camera_distance();
+            });
+
+    world_triangles_.clear();
+    for (auto it = occluders_.begin(); it != occluders_.end(); ++it) {
+        const Mesh* mesh = (*it)->render_data()->mesh();
+        const std::vector<glm::vec3>& vertices = mesh->vertices();
+        const std::vector<unsigned int>& indices = mesh->indices();
+        int triangles = indices.empty() ? vertices.size() / 3 : indices.size() / 3;
+        if (0 == triangles) {
+            continue;
+        }
+        if (occluder_triangles_ + triangles > MAX_OCCLUDER_TRIANGLES) {
+            break;
+        }
+
+        glm::mat4 model = (*it)->transform()->getModelMatrix();
+        world_vertices_.resize(vertices.size());
+        for (size_t i = 0; i < vertices.size(); ++i) {
+            world_vertices_[i] = glm::vec3(model * glm::vec4(vertices[i], 1.0f));
+        }
+        if (indices.empty()) {
+            world_triangles_.insert(world_triangles_.end(), world_vertices_.begin(),
+                    world_vertices_.begin() + triangles * 3);
+        } else {
+            for (int i = 0; i < triangles * 3; ++i) {
+                world_triangles_.push_back(world_vertices_[indices[i]]);
+            }
+        }
+        ++occluder_count_;
+        occluder_triangles_ += triangles;
+    }
+    if (0 == occluder_triangles_) {
+        return false;
+    }
+
+    JobSystem* jobs = JobSystem::getInstance();
+    jobs->parallelFor(view_count_, 1, [this](int begin, int end) {
+        for (int v = begin; v < end; ++v) {
+            HiZBuffer& view = views_[v];
+            view.clear();
+            for (int t = 0; t < occluder_triangles_; ++t) {
+                view.setupTriangle(world_triangles_[t * 3], world_triangles_[t * 3 + 1],
+                        world_triangles_[t * 3 + 2]);
+            }
+        }
+    });
+
+    // one job per band of rows of each view, no two share a pixel
+    const int bands = HiZBuffer::SIZE / BAND_ROWS;
+    jobs->parallelFor(view_count_ * bands, 1,
+            [this, bands](int begin, int end) {
+                for (int job = begin; job < end; ++job) {
+                    int band = job % bands;
+                    views_[job / bands].rasterize(band * BAND_ROWS, (band + 1) * BAND_ROWS);
+                }
+            });
+    for (int v = 0; v < view_count_; ++v) {
+        views_[v].buildMips();
+    }
+    return true;
+}
+
+bool OcclusionCuller::isOccluded(const glm::vec3& min_corner,
+        const glm::vec3& max_corner) const {
+    for (int v = 0; v < view_count_; ++v) {
+        if (!views_[v].isOccluded(min_corner, max_corner)) {
+            return false;
+        }
+    }
+    return view_count_ > 0;
+}
+
+}
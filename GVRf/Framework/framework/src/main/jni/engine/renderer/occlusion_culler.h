@@ -0,0 +1,170 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Occlusion culling against a software depth buffer.
+ ***************************************************************************/
+
+#ifndef OCCLUSION_CULLER_H_
+#define OCCLUSION_CULLER_H_
+
+#include <vector>
+
+#include "glm/glm.hpp"
+
+namespace gvr {
+class SceneObject;
+
+/*
+ * A small depth buffer with a max-depth mip chain over it. Depth is
+ * window z in [0, 1], cleared to the far plane; a texel of level 0
+ * holds the farthest occluder depth over the whole texel, and one of
+ * level n the farthest of the 2x2 texels below it, so one texel read
+ * bounds the occluders over its whole footprint.
+ */
+class HiZBuffer {
+public:
+    static const int SIZE = 128;
+    static const int LEVELS = 8;    // SIZE down to 1
+    static const int SUBPIXEL = 8;  // vertex precision, steps per pixel
+    static const int COVERAGE_SAMPLES = 5;  // per side of a pixel, corners included
+
+    struct Triangle {
+        float edge_a[3], edge_b[3], edge_c[3];   // >= 0 inside, in subpixels
+        float edge_reach[3];                     // edge change from pixel center to corner
+        float depth_a, depth_b, depth_c;         // window z plane over subpixels
+        float depth_reach, depth_max;            // plane change to a corner, farthest vertex
+        int min_x, max_x, min_y, max_y;          // pixel bounds
+    };
+
+    HiZBuffer();
+
+    void setViewProjection(const glm::mat4& vp) {
+        vp_ = vp;
+    }
+
+    const glm::mat4& viewProjection() const {
+        return vp_;
+    }
+
+    void clear();
+
+    /*
+     * Clips the triangle, given in world space, to the frustum and adds
+     * the pieces to the triangle list.
+     */
+    void setupTriangle(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2);
+
+    int triangle_count() const {
+        return triangles_.size();
+    }
+
+    /*
+     * Rasterizes the triangle list into rows [first_row, last_row).
+     * Disjoint row ranges can be filled from different threads.
+     */
+    void rasterize(int first_row, int last_row);
+
+    void buildMips();
+
+    /*
+     * True when every point of the box lies behind the depth buffer.
+     * Boxes crossing the near plane are never occluded.
+     */
+    bool isOccluded(const glm::vec3& min_corner, const glm::vec3& max_corner) const;
+
+    const float* level(int n) const {
+        return &levels_[level_offset_[n]];
+    }
+
+private:
+    void addTriangle(const glm::vec4& c0, const glm::vec4& c1, const glm::vec4& c2);
+    void rasterizeRow(const Triangle& t, int y);
+    bool coversPixel(const Triangle& t, const float e[3], int x) const;
+    void coverPart(const Triangle& t, const float e[3], float ez, int x, int y);
+
+private:
+    glm::mat4 vp_;
+    std::vector<float> levels_;
+    int level_offset_[LEVELS + 1];
+    // level 0 pixels covered in part so far, and the farthest depth over those parts
+    std::vector<unsigned int> coverage_;
+    std::vector<float> partial_depth_;
+    std::vector<Triangle> triangles_;
+};
+
+/*
+ * Rasterizes the occluders among the frustum-culled objects, those
+ * whose RenderData is marked as occluder, into one HiZBuffer per view.
+ * The nearest occluders go first until the triangle budget is spent.
+ * Each view clips and sets up its triangles on a JobSystem worker, then
+ * the rows are split into bands that are filled in parallel.
+ *
+ * For the camera rig both eyes get a view, and an object only counts as
+ * occluded when it is hidden from both; the center camera alone would
+ * cull objects one eye can see around an edge.
+ */
+class OcclusionCuller {
+public:
+    static const int MAX_VIEWS = 2;
+    static const int MAX_OCCLUDER_TRIANGLES = 8192;
+    static const int BAND_ROWS = 16;
+
+    OcclusionCuller();
+
+    void setViews(const glm::mat4* vp, int view_count);
+
+    /*
+     * Fills the depth buffers from the occluders in objects. Returns
+     * false when there was nothing to draw, so nothing can be occluded.
+     */
+    bool rasterize(const std::vector<SceneObject*>& objects);
+
+    bool isOccluded(const glm::vec3& min_corner, const glm::vec3& max_corner) const;
+
+    const HiZBuffer& view(int index) const {
+        return views_[index];
+    }
+
+    int view_count() const {
+        return view_count_;
+    }
+
+    int occluder_count() const {
+        return occluder_count_;
+    }
+
+    int occluder_triangle_count() const {
+        return occluder_triangles_;
+    }
+
+private:
+    OcclusionCuller(const OcclusionCuller& culler);
+    OcclusionCuller(OcclusionCuller&& culler);
+    OcclusionCuller& operator=(const OcclusionCuller& culler);
+    OcclusionCuller& operator=(OcclusionCuller&& culler);
+
+private:
+    HiZBuffer views_[MAX_VIEWS];
+    int view_count_;
+    int occluder_count_;
+    int occluder_triangles_;
+    std::vector<SceneObject*> occluders_;
+    std::vector<glm::vec3> world_vertices_;
+    std::vector<glm::vec3> world_triangles_;     // world space, three per triangle
+};
+
+}
+#endif
@@ -0,0 +1,109 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "render_sort.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "objects/material.h"
+#include "objects/components/render_data.h"
+
+namespace gvr {
+
+static inline uint64_t clampBits(int value, int bits) {
+    const int max_value = (1 << bits) - 1;
+    if (value < 0) {
+        return 0;
+    }
+    return value > max_value ? max_value : value;
+}
+
+static inline uint32_t distanceBits(float distance) {
+    if (!(distance > 0.0f)) {
+        return 0;
+    }
+    uint32_t bits;
+    memcpy(&bits, &distance, sizeof(bits));
+    return bits;
+}
+
+uint64_t makeRenderSortKey(RenderData* render_data) {
+    const int order = render_data->rendering_order();
+    const Material* material = render_data->material(0);
+    uint64_t key = clampBits(order + 0x8000, 16) << 48;
+    // BEING_GENERATED is -1
+    key |= clampBits(material->shader_type() + 1, 12) << 36;
+
+    // the distance bits without the sign, exp:8 mantissa:23
+    uint32_t depth = distanceBits(render_data->camera_distance());
+    uint64_t material_id = material->sort_id() & 0xFFF;
+    if (order >= RenderData::Transparent && order < RenderData::Overlay) {
+        // back to front
+        key |= (uint64_t) (~(depth >> 7) & 0xFFFFFF) << 12;
+        key |= material_id;
+    } else {
+        uint64_t state = (render_data->state_id() & 0x7F) << 1
+                | (render_data->cull_face(0) ? 1 : 0);
+        key |= material_id << 24;
+        key |= state << 16;
+        key |= (depth >> 15) & 0xFFFF;
+    }
+    return key;
+}
+
+void radixSort(std::vector<RenderSortItem>& items,
+        std::vector<RenderSortItem>& scratch) {
+    const size_t count = items.size();
+    if (count < 2) {
+        return;
+    }
+    scratch.resize(count);
+
+    // one histogram per byte, all filled in a single read of the keys
+    uint32_t histograms[8][256];
+    memset(histograms, 0, sizeof(histograms));
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t key = items[i].key;
+        for (int b = 0; b < 8; ++b) {
+            ++histograms[b][(key >> (b * 8)) & 0xFF];
+        }
+    }
+
+    RenderSortItem* source = items.data();
+    RenderSortItem* target = scratch.data();
+    for (int b = 0; b < 8; ++b) {
+        uint32_t* histogram = histograms[b];
+        const int shift = b * 8;
+        if (histogram[(source[0].key >> shift) & 0xFF] == count) {
+            continue;
+        }
+        uint32_t offset = 0;
+        for (int digit = 0; digit < 256; ++digit) {
+            uint32_t digit_count = histogram[digit];
+            histogram[digit] = offset;
+            offset += digit_count;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            target[histogram[(source[i].key >> shift) & 0xFF]++] = source[i];
+        }
+        std::swap(source, target);
+    }
+    if (source != items.data()) {
+        memcpy(items.data(), source, count * sizeof(RenderSortItem));
+    }
+}
+
+}
@@ -0,0 +1,58 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Packed render sort keys and the radix sort used by Renderer::state_sort.
+ ***************************************************************************/
+
+#ifndef RENDER_SORT_H_
+#define RENDER_SORT_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace gvr {
+class RenderData;
+
+struct RenderSortItem {
+    uint64_t    key;
+    RenderData* render_data;
+};
+
+/*
+ * Packs everything the render list is ordered by into one integer, most
+ * significant first:
+ *
+ *   opaque:       order:16 shader:12 material:12 state:8 depth:16
+ *   transparent:  order:16 shader:12 depth:24 (inverted) material:12
+ *
+ * where transparent means Transparent <= order < Overlay. The depth is
+ * the top bits of the non-negative float camera distance, whose bit
+ * pattern orders like the value. Material and state are short ids;
+ * when two of them share an id the objects merely interleave, which
+ * costs batching but never correctness.
+ */
+uint64_t makeRenderSortKey(RenderData* render_data);
+
+/*
+ * Stable LSD radix sort on the key, a byte per pass. Passes over bytes
+ * that are the same in every key are skipped. scratch is resized as
+ * needed and can be reused between calls.
+ */
+void radixSort(std::vector<RenderSortItem>& items,
+        std::vector<RenderSortItem>& scratch);
+
+}
+#endif
@@ -19,6 +19,8 @@
 
 #include "renderer.h"
 #include "gl/gl_program.h"
+#include "gl/gl_readback.h"
+#include "gl/gl_state_cache.h"
 #include "glm/gtc/matrix_inverse.hpp"
 
 #include "eglextension/tiledrendering/tiled_rendering_enhancer.h"
@@ -26,22 +28,29 @@
 #include "objects/post_effect_data.h"
 #include "objects/scene.h"
 #include "objects/scene_object.h"
+#include "objects/transform_store.h"
 #include "objects/components/camera.h"
+#include "objects/components/camera_rig.h"
+#include "objects/components/perspective_camera.h"
+#include "objects/components/collider.h"
 #include "objects/components/render_data.h"
 #include "objects/textures/render_texture.h"
+#include "objects/textures/texture_residency.h"
 #include "shaders/shader_manager.h"
 #include "shaders/post_effect_shader_manager.h"
 #include "util/gvr_gl.h"
+#include "util/gvr_job_system.h"
 #include "util/gvr_log.h"
 #include "batch_manager.h"
 
+#include <cstring>
 #include <unordered_map>
 #include <unordered_set>
 
 #include "gl_renderer.h"
 #include "vulkan_renderer.h"
-#define MAX_INDICES 500
-#define BATCH_SIZE 60
+#define MAX_INDICES 65536
+#define BATCH_SIZE 256
 bool do_batching = true;
 
 namespace gvr {
@@ -68,79 +77,29 @@ Renderer* Renderer::getInstance(const char* type){
     }
     return instance;
 }
-Renderer::Renderer():numberDrawCalls(0), numberTriangles(0), batch_manager(nullptr) {
+Renderer::Renderer():batch_manager(nullptr), numberDrawCalls(0), numberTriangles(0),
+        numberInstances(0) {
     if(do_batching && !gRenderer->isVulkanInstace()) {
         batch_manager = new BatchManager(BATCH_SIZE, MAX_INDICES);
     }
 }
-void Renderer::frustum_cull(glm::vec3 camera_position, SceneObject *object,
-        float frustum[6][4], std::vector<SceneObject*>& scene_objects,
-        bool need_cull, int planeMask) {
-
-    // frustumCull() return 3 possible values:
-    // 0 when the HBV of the object is completely outside the frustum: cull itself and all its children out
-    // 1 when the HBV of the object is intersecting the frustum but the object itself is not: cull it out and continue culling test with its children
-    // 2 when the HBV of the object is intersecting the frustum and the mesh BV of the object are intersecting (inside) the frustum: render itself and continue culling test with its children
-    // 3 when the HBV of the object is completely inside the frustum: render itself and all its children without further culling test
-    int cullVal;
-
-    if (!object->enabled()) {
-        return;
-    }
-
-    //allows for on demand calculation of the camera distance; usually matters
-    //when transparent objects are in play
-    RenderData* renderData = object->render_data();
-    if (nullptr != renderData) {
-        renderData->setCameraDistanceLambda([object, camera_position]() {
-            // Transform the bounding volume
-            BoundingVolume bounding_volume_ = object->getBoundingVolume();
-            glm::vec4 transformed_sphere_center(bounding_volume_.center(), 1.0f);
-
-            // Calculate distance from camera
-            glm::vec4 position(camera_position, 1.0f);
-            glm::vec4 difference = transformed_sphere_center - position;
-            float distance = glm::dot(difference, difference);
-
-            // this distance will be used when sorting transparent objects
-            return distance;
-        });
-    }
-
-    if (need_cull) {
-        cullVal = object->frustumCull(camera_position, frustum, planeMask);
-        if (cullVal == 0) {
-            object->setCullStatus(true);
-            return;
-        }
-
-        if (cullVal >= 2) {
-            object->setCullStatus(false);
-            scene_objects.push_back(object);
-        }
-
-        if (cullVal == 3) {
-            object->setCullStatus(false);
-            need_cull = false;
-        }
-    } else {
-        object->setCullStatus(false);
-        scene_objects.push_back(object);
-    }
-
-    const std::vector<SceneObject*> children = object->children();
-    for (auto it = children.begin(); it != children.end(); ++it) {
-        frustum_cull(camera_position, *it, frustum, scene_objects, need_cull, planeMask);
-    }
-}
-
 void Renderer::state_sort() {
     // The current implementation of sorting is based on
     // 1. rendering order first to maintain specified order
     // 2. shader type second to minimize the gl cost of switching shader
     // 3. camera distance last to minimize overdraw
-    std::sort(render_data_vector.begin(), render_data_vector.end(),
-            compareRenderDataByOrderShaderDistance);
+    // all packed into one key per render data, see makeRenderSortKey
+    size_t count = render_data_vector.size();
+    sort_items_.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        RenderData* render_data = render_data_vector[i];
+        sort_items_[i].key = makeRenderSortKey(render_data);
+        sort_items_[i].render_data = render_data;
+    }
+    radixSort(sort_items_, sort_scratch_);
+    for (size_t i = 0; i < count; ++i) {
+        render_data_vector[i] = sort_items_[i].render_data;
+    }
 
     if (DEBUG_RENDERER) {
         LOGD("SORTING: After sorting");
@@ -178,6 +137,14 @@ bool isRenderPassEqual(RenderData* rdata1, RenderData* rdata2){
     return true;
 }
 
+int Renderer::getNumberStateChanges() {
+    return isVulkan_ ? 0 : GLStateCache::getInstance()->issuedCalls();
+}
+
+int Renderer::getNumberSkippedStateChanges() {
+    return isVulkan_ ? 0 : GLStateCache::getInstance()->skippedCalls();
+}
+
 void Renderer::cull(Scene *scene, Camera *camera,
         ShaderManager* shader_manager) {
 
@@ -188,6 +155,18 @@ void Renderer::cull(Scene *scene, Camera *camera,
     std::vector<SceneObject*> scene_objects;
     scene_objects.reserve(1024);
 
+    if (!isVulkan_) {
+        GLStateCache::getInstance()->beginFrame();
+        TextureResidency::getInstance()->beginFrame();
+        // pixels read back in earlier frames that the GPU is done with
+        GLReadback::getInstance()->poll();
+        // programs queued by ShaderManager::prewarm, a few per frame
+        shader_manager->prewarmStep(PREWARM_PROGRAMS_PER_FRAME);
+    }
+
+    // resolve all world matrices moved since the last frame in one pass
+    TransformStore::getInstance()->updateWorldMatrices();
+
     cullFromCamera(scene, camera, shader_manager, scene_objects);
 
     // Note: this needs to be scaled to sort on N states
@@ -198,6 +177,46 @@ void Renderer::cull(Scene *scene, Camera *camera,
     }
 }
 
+/*
+ * The union of both eye frusta of the scene's main camera rig, when
+ * culling from its center camera. The rig keeps the eyes side by side
+ * with the same orientation and projection, so the union is the left
+ * eye's frustum with the right plane taken from the right eye: the eye
+ * offset lies in the other four planes. Unlike the center camera's own
+ * frustum this does not pull in the far plane.
+ */
+bool Renderer::build_stereo_frustum(Scene* scene, Camera* camera,
+        float frustum[6][4], glm::vec3& camera_position, glm::mat4 eye_vp[2]) {
+    const CameraRig* camera_rig = scene->main_camera_rig();
+    if (nullptr == camera_rig || camera_rig->center_camera() != camera) {
+        return false;
+    }
+    Camera* left_camera = camera_rig->left_camera();
+    Camera* right_camera = camera_rig->right_camera();
+    if (nullptr == left_camera || nullptr == right_camera
+            || nullptr == left_camera->owner_object()
+            || nullptr == right_camera->owner_object()
+            || nullptr == left_camera->owner_object()->transform()
+            || nullptr == right_camera->owner_object()->transform()) {
+        return false;
+    }
+
+    glm::mat4 left_vp = left_camera->getProjectionMatrix() * left_camera->getViewMatrix();
+    glm::mat4 right_vp = right_camera->getProjectionMatrix() * right_camera->getViewMatrix();
+    float right_frustum[6][4];
+    build_frustum(frustum, (const float*) glm::value_ptr(left_vp));
+    build_frustum(right_frustum, (const float*) glm::value_ptr(right_vp));
+    // plane 0 is the RIGHT plane
+    memcpy(frustum[0], right_frustum[0], sizeof(right_frustum[0]));
+
+    glm::vec3 left_position(left_camera->owner_object()->transform()->getModelMatrix()[3]);
+    glm::vec3 right_position(right_camera->owner_object()->transform()->getModelMatrix()[3]);
+    camera_position = (left_position + right_position) * 0.5f;
+    eye_vp[0] = left_vp;
+    eye_vp[1] = right_vp;
+    return true;
+}
+
 /*
  * Perform view frustum culling from a specific camera viewpoint
  */
@@ -211,21 +230,40 @@ void Renderer::cullFromCamera(Scene *scene, Camera* camera,
     glm::mat4 projection_matrix = camera->getProjectionMatrix();
     glm::mat4 vp_matrix = glm::mat4(projection_matrix * view_matrix);
 
-    // Travese all scene objects in the scene as a tree and do frustum culling at the same time if enabled
-    // 1. Build the view frustum
+    // 1. Build the view frustum, covering both eyes when culling for the camera rig
     float frustum[6][4];
-    build_frustum(frustum, (const float*) glm::value_ptr(vp_matrix));
+    glm::vec3 camera_position;
+    glm::mat4 eye_vp[2];
+    int view_count = 2;
+    if (!build_stereo_frustum(scene, camera, frustum, camera_position, eye_vp)) {
+        build_frustum(frustum, (const float*) glm::value_ptr(vp_matrix));
+        camera_position = glm::vec3(camera->owner_object()->transform()->getModelMatrix()[3]);
+        eye_vp[0] = vp_matrix;
+        view_count = 1;
+    }
 
-    // 2. Iteratively execute frustum culling for each root object (as well as its children objects recursively)
-    SceneObject *object = scene->getRoot();
+    // 2. Collect the objects inside it from the scene's bounding volume hierarchy,
+    //    dropping those hidden behind its occluders if occlusion culling is on
     if (DEBUG_RENDERER) {
-        LOGD("FRUSTUM: start frustum culling for root %s\n", object->name().c_str());
+        LOGD("FRUSTUM: start frustum culling for scene\n");
     }
-    frustum_cull(camera->owner_object()->transform()->position(), object, frustum, scene_objects, scene->get_frustum_culling(), 0);
+    OcclusionCuller* occlusion_culler = nullptr;
+    if (scene->get_occlusion_culling()) {
+        occlusion_culler_.setViews(eye_vp, view_count);
+        occlusion_culler = &occlusion_culler_;
+    }
+    scene->bvh().cull(frustum, scene->get_frustum_culling(),
+            camera_position, scene_objects, occlusion_culler);
     if (DEBUG_RENDERER) {
-        LOGD("FRUSTUM: end frustum culling for root %s\n", object->name().c_str());
+        LOGD("FRUSTUM: end frustum culling for scene, %d visible\n",
+                (int) scene_objects.size());
+        if (nullptr != occlusion_culler) {
+            LOGD("OCCLUSION: %d occluders, %d triangles\n",
+                    occlusion_culler->occluder_count(),
+                    occlusion_culler->occluder_triangle_count());
+        }
     }
-    // 3. do occlusion culling, if enabled
+    // 3. turn the visible objects into render data
     occlusion_cull(scene, scene_objects, shader_manager, vp_matrix);
 }
 
@@ -242,21 +280,71 @@ void Renderer::renderRenderDataVector(RenderState &rstate) {
     }
 }
 
-void Renderer::addRenderData(RenderData *render_data) {
+bool Renderer::isRenderable(RenderData *render_data) {
     if (render_data == 0 || render_data->material(0) == 0 || !render_data->enabled()) {
-        return;
+        return false;
     }
 
     if (render_data->mesh() == NULL) {
-        return;
+        return false;
     }
 
     if (render_data->render_mask() == 0) {
-        return;
+        return false;
     }
+    return true;
+}
 
-    render_data_vector.push_back(render_data);
-    return;
+void Renderer::addRenderData(RenderData *render_data) {
+    if (isRenderable(render_data)) {
+        render_data_vector.push_back(render_data);
+    }
+}
+
+/*
+ * Filters the visible objects into render data and visible colliders on
+ * the JobSystem. Each chunk fills its own lists and the lists are joined
+ * in chunk order, so the output matches a serial walk.
+ */
+void Renderer::collectRenderData(Scene* scene, std::vector<SceneObject*>& scene_objects) {
+    int object_count = scene_objects.size();
+    int chunk_count = (object_count + COLLECT_GRAIN - 1) / COLLECT_GRAIN;
+    if (static_cast<int>(chunk_render_data_.size()) < chunk_count) {
+        chunk_render_data_.resize(chunk_count);
+        chunk_colliders_.resize(chunk_count);
+    }
+    bool pick_visible = scene->getPickVisible();
+    long long collider_type = Collider::getComponentType();
+
+    JobSystem::getInstance()->parallelFor(chunk_count, 1,
+            [this, &scene_objects, object_count, pick_visible, collider_type](int begin, int end) {
+                for (int c = begin; c < end; ++c) {
+                    std::vector<RenderData*>& render_data = chunk_render_data_[c];
+                    std::vector<Component*>& colliders = chunk_colliders_[c];
+                    render_data.clear();
+                    colliders.clear();
+                    int last = std::min(object_count, (c + 1) * COLLECT_GRAIN);
+                    for (int i = c * COLLECT_GRAIN; i < last; ++i) {
+                        SceneObject* scene_object = scene_objects[i];
+                        RenderData* rdata = scene_object->render_data();
+                        if (isRenderable(rdata)) {
+                            render_data.push_back(rdata);
+                        }
+                        if (pick_visible) {
+                            Component* collider = scene_object->getComponent(collider_type);
+                            if (collider) {
+                                colliders.push_back(collider);
+                            }
+                        }
+                    }
+                }
+            });
+
+    for (int c = 0; c < chunk_count; ++c) {
+        render_data_vector.insert(render_data_vector.end(),
+                chunk_render_data_[c].begin(), chunk_render_data_[c].end());
+        scene->addVisibleColliders(chunk_colliders_[c]);
+    }
 }
 
 bool Renderer::occlusion_cull_init(Scene* scene, std::vector<SceneObject*>& scene_objects){
@@ -265,12 +353,7 @@ bool Renderer::occlusion_cull_init(Scene* scene, std::vector<SceneObject*>& scen
     scene->clearVisibleColliders();
     bool do_culling = scene->get_occlusion_culling();
     if (!do_culling) {
-        for (auto it = scene_objects.begin(); it != scene_objects.end(); ++it) {
-            SceneObject *scene_object = (*it);
-            RenderData* render_data = scene_object->render_data();
-            addRenderData(render_data);
-            scene->pick(scene_object);
-        }
+        collectRenderData(scene, scene_objects);
         scene->unlockColliders();
         return false;
     }
@@ -424,11 +507,16 @@ void Renderer::renderRenderData(RenderState& rstate, RenderData* render_data) {
         GL(renderMesh(rstate, render_data));
     }
     // Restoring to Default.
-    // TODO: There's a lot of redundant state changes. If on every render face culling is being set there's no need to
-    // restore defaults. Possibly later we could add a OpenGL state wrapper to avoid redundant api calls.
     restoreRenderStates(render_data);
 }
 
+void Renderer::renderInstances(RenderState& rstate,
+        const std::vector<RenderData*>& render_data) {
+    for (auto it = render_data.begin(); it != render_data.end(); ++it) {
+        renderRenderData(rstate, *it);
+    }
+}
+
 void Renderer::renderPostEffectData(Camera* camera,
         RenderTexture* render_texture, PostEffectData* post_effect_data,
         PostEffectShaderManager* post_effect_shader_manager) {
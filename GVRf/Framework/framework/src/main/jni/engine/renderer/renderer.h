@@ -33,11 +33,14 @@
 #include "gl/gl_program.h"
 #include <unordered_map>
 #include "batch_manager.h"
+#include "occlusion_culler.h"
+#include "render_sort.h"
 
 typedef unsigned long Long;
 namespace gvr {
 extern bool use_multiview;
 class Camera;
+class Component;
 class Scene;
 class SceneObject;
 class PostEffectData;
@@ -86,6 +89,7 @@ public:
     void resetStats() {
         numberDrawCalls = 0;
         numberTriangles = 0;
+        numberInstances = 0;
     }
     bool isVulkanInstace(){
         return isVulkan_;
@@ -100,6 +104,13 @@ public:
      int getNumberTriangles() {
         return numberTriangles;
      }
+     // objects drawn by instanced draw calls, each of which counts once in getNumberDrawCalls
+     int getNumberInstances() {
+        return numberInstances;
+     }
+     // GL state calls issued and dropped as redundant during the last frame
+     int getNumberStateChanges();
+     int getNumberSkippedStateChanges();
      int incrementTriangles(int number=1){
         return numberTriangles += number;
      }
@@ -113,9 +124,20 @@ public:
      virtual void initializeStats();
      virtual void set_face_culling(int cull_face) = 0;
      virtual void renderRenderDataVector(RenderState &rstate);
+     /*
+      * Culls, sorts and batches once per frame; every renderCamera call
+      * of the frame draws the same list. Given the center camera of the
+      * scene's main camera rig, the cull covers both eyes.
+      */
      virtual void cull(Scene *scene, Camera *camera,
             ShaderManager* shader_manager);
      virtual void renderRenderData(RenderState& rstate, RenderData* render_data);
+     /*
+      * Draws render data sharing a mesh, passes and render state. The
+      * default draws them one by one.
+      */
+     virtual void renderInstances(RenderState& rstate,
+             const std::vector<RenderData*>& render_data);
 
 
      virtual void renderCamera(Scene* scene, Camera* camera,
@@ -151,12 +173,6 @@ public:
 
 private:
     static bool isVulkan_;
-    virtual void build_frustum(float frustum[6][4], const float *vp_matrix);
-    virtual void frustum_cull(glm::vec3 camera_position, SceneObject *object,
-            float frustum[6][4], std::vector<SceneObject*>& scene_objects,
-            bool continue_cull, int planeMask);
-
-    virtual void state_sort();
     virtual bool isShader3d(const Material* curr_material);
     virtual bool isDefaultPosition3d(const Material* curr_material);
 
@@ -164,11 +180,15 @@ private:
     Renderer(Renderer&& render_engine);
     Renderer& operator=(const Renderer& render_engine);
     Renderer& operator=(Renderer&& render_engine);
-    BatchManager* batch_manager;
     static Renderer* instance;
     
 protected:
     Renderer();
+    virtual void build_frustum(float frustum[6][4], const float *vp_matrix);
+    bool build_stereo_frustum(Scene* scene, Camera* camera, float frustum[6][4],
+            glm::vec3& camera_position, glm::mat4 eye_vp[2]);
+    virtual void state_sort();
+    BatchManager* batch_manager;
     virtual ~Renderer(){
         delete batch_manager;
     }
@@ -177,7 +197,9 @@ protected:
     virtual void occlusion_cull(Scene* scene,
                 std::vector<SceneObject*>& scene_objects,
                 ShaderManager *shader_manager, glm::mat4 vp_matrix) = 0;
+    static bool isRenderable(RenderData *render_data);
     void addRenderData(RenderData *render_data);
+    void collectRenderData(Scene* scene, std::vector<SceneObject*>& scene_objects);
     virtual bool occlusion_cull_init(Scene* scene, std::vector<SceneObject*>& scene_objects);
     virtual void cullFromCamera(Scene *scene, Camera *camera,
             ShaderManager* shader_manager,
@@ -189,8 +211,21 @@ protected:
             PostEffectShaderManager* post_effect_shader_manager);
 
     std::vector<RenderData*> render_data_vector;
+    // scratch for state_sort
+    std::vector<RenderSortItem> sort_items_;
+    std::vector<RenderSortItem> sort_scratch_;
+    // objects per collectRenderData chunk
+    static const int COLLECT_GRAIN = 1024;
+    // programs ShaderManager::prewarmStep may build per frame
+    static const int PREWARM_PROGRAMS_PER_FRAME = 2;
+    // scratch lists for collectRenderData, one per chunk
+    std::vector<std::vector<RenderData*> > chunk_render_data_;
+    std::vector<std::vector<Component*> > chunk_colliders_;
+    // depth buffers for scenes with occlusion culling
+    OcclusionCuller occlusion_culler_;
     int numberDrawCalls;
     int numberTriangles;
+    int numberInstances;
 
 public:
     //to be used only on the gl thread
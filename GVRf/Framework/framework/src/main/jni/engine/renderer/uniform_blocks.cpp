@@ -0,0 +1,330 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Uniform buffers holding the camera and per object matrices.
+ ***************************************************************************/
+
+#include "uniform_blocks.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "glm/gtc/matrix_inverse.hpp"
+#include "engine/memory/gl_delete.h"
+#include "engine/renderer/renderer.h"
+#include "gl/gl_state_cache.h"
+#include "objects/mesh.h"
+#include "objects/scene.h"
+#include "objects/scene_object.h"
+#include "objects/components/camera.h"
+#include "objects/components/camera_rig.h"
+#include "objects/components/render_data.h"
+#include "objects/components/transform.h"
+#include "util/gvr_job_system.h"
+#include "util/gvr_log.h"
+
+namespace gvr {
+
+const char UniformBlocks::FRAME_BLOCK[] =
+        "layout(std140) uniform FrameUniforms {\n"
+        "    mat4 u_view;\n"
+        "    mat4 u_proj;\n"
+        "    mat4 u_view_inv;\n"
+        "    mat4 u_view_[2];\n"
+        "    mat4 u_view_inv_[2];\n"
+        "    highp int u_right;\n"
+        "};\n";
+
+const char UniformBlocks::OBJECT_BLOCK[] =
+        "layout(std140) uniform ObjectUniforms {\n"
+        "    mat4 u_model;\n"
+        "    mat4 u_mv;\n"
+        "    mat4 u_mvp;\n"
+        "    mat4 u_mv_it;\n"
+        "    mat4 u_mv_[2];\n"
+        "    mat4 u_mvp_[2];\n"
+        "    mat4 u_mv_it_[2];\n"
+        "};\n";
+
+// the matrices a mono object slot holds
+static const int MONO_OBJECT_SIZE = 4 * sizeof(glm::mat4);
+
+// how long to wait on a region between warnings once the ring cannot grow
+static const GLuint64 FENCE_TIMEOUT = 100000000;
+
+UniformBlocks::UniformBlocks() :
+        buffer_(0), region_count_(MIN_REGIONS), region_(-1), region_size_(0),
+        capacity_(0), count_(0), spare_slot_(0), stride_(0), frame_size_(0),
+        alignment_(0), eyes_(false), stereo_(false), deleter_(nullptr) {
+}
+
+UniformBlocks::~UniformBlocks() {
+    // the fences go with the context
+    if (nullptr != deleter_) {
+        deleter_->queueBuffer(buffer_, region_count_ * region_size_);
+    }
+}
+
+void UniformBlocks::bindProgram(GLuint program_id) {
+    GLuint frame_index = glGetUniformBlockIndex(program_id, "FrameUniforms");
+    if (GL_INVALID_INDEX != frame_index) {
+        glUniformBlockBinding(program_id, frame_index, FRAME_BINDING);
+    }
+    GLuint object_index = glGetUniformBlockIndex(program_id, "ObjectUniforms");
+    if (GL_INVALID_INDEX != object_index) {
+        glUniformBlockBinding(program_id, object_index, OBJECT_BINDING);
+    }
+}
+
+/*
+ * Grows the regions to hold slot_count object slots plus the spare one.
+ * Reallocating orphans the old store, so the fences are dropped.
+ */
+void UniformBlocks::reserve(int slot_count) {
+    if (0 == alignment_) {
+        GLint alignment = 0;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        alignment_ = alignment > 0 ? alignment : 256;
+        frame_size_ = (sizeof(FrameUniforms) + alignment_ - 1) / alignment_ * alignment_;
+    }
+    // a mono slot holds the first four matrices, its range runs into the
+    // next slot where the eye arrays would be
+    int object_size = eyes_ ? sizeof(ObjectUniforms) : MONO_OBJECT_SIZE;
+    int stride = (object_size + alignment_ - 1) / alignment_ * alignment_;
+    if (slot_count <= capacity_ && stride == stride_) {
+        return;
+    }
+    int capacity = capacity_ > 0 ? capacity_ : OBJECT_GRAIN;
+    while (capacity < slot_count) {
+        capacity *= 2;
+    }
+    capacity_ = capacity;
+    spare_slot_ = capacity;
+    stride_ = stride;
+    int size = frame_size_ + (capacity_ + 1) * stride_ + sizeof(ObjectUniforms);
+    region_size_ = (size + alignment_ - 1) / alignment_ * alignment_;
+    staging_.resize(region_size_);
+    owners_.assign(capacity_ + 1, nullptr);
+    count_ = 0;
+    allocate();
+}
+
+/*
+ * (Re)allocates the ring. The GPU keeps reading the orphaned store, so
+ * every region of the new one is free.
+ */
+void UniformBlocks::allocate() {
+    if (0 == buffer_) {
+        glGenBuffers(1, &buffer_);
+        deleter_ = getDeleterForThisThread();
+    }
+    GLStateCache::getInstance()->bindBuffer(GL_UNIFORM_BUFFER, buffer_);
+    glBufferData(GL_UNIFORM_BUFFER, region_count_ * region_size_, nullptr, GL_DYNAMIC_DRAW);
+    for (auto it = fences_.begin(); it != fences_.end(); ++it) {
+        if (0 != *it) {
+            glDeleteSync(*it);
+        }
+    }
+    fences_.assign(region_count_, 0);
+    region_ = -1;
+}
+
+/*
+ * Fences the pass of the current region and returns the next free one.
+ * A busy region means more passes are in flight than the ring holds:
+ * it doubles, and only once it cannot does this wait, for as long as it
+ * takes.
+ */
+int UniformBlocks::nextRegion() {
+    if (region_ >= 0) {
+        fences_[region_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+    int region = (region_ + 1) % region_count_;
+    if (0 == fences_[region]) {
+        return region;
+    }
+    GLenum status = glClientWaitSync(fences_[region], GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    while (GL_TIMEOUT_EXPIRED == status) {
+        if (region_count_ < MAX_REGIONS) {
+            region_count_ = std::min(region_count_ * 2, int(MAX_REGIONS));
+            allocate();
+            return 0;
+        }
+        status = glClientWaitSync(fences_[region], GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT);
+        if (GL_TIMEOUT_EXPIRED == status) {
+            LOGW("UniformBlocks: region %d still in use", region);
+        }
+    }
+    glDeleteSync(fences_[region]);
+    fences_[region] = 0;
+    return region;
+}
+
+/*
+ * Fills everything but u_model, which the caller has set. A mesh with
+ * encoded positions gets its dequantization folded into the position
+ * matrices; the normal matrices leave it out.
+ */
+void UniformBlocks::computeObject(ObjectUniforms& object, const Mesh* mesh) const {
+    bool dequant = nullptr != mesh && mesh->hasPositionDequant();
+    glm::mat4 model = object.u_model;
+    object.u_mv = frame_.u_view * model;
+    object.u_mv_it = glm::inverseTranspose(object.u_mv);
+    if (dequant) {
+        object.u_model = object.u_model * mesh->positionDequant();
+        object.u_mv = object.u_mv * mesh->positionDequant();
+    }
+    object.u_mvp = frame_.u_proj * object.u_mv;
+    if (!eyes_) {
+        return;
+    }
+    if (stereo_) {
+        for (int eye = 0; eye < 2; ++eye) {
+            object.u_mv_[eye] = frame_.u_view_[eye] * model;
+            object.u_mv_it_[eye] = glm::inverseTranspose(object.u_mv_[eye]);
+            if (dequant) {
+                object.u_mv_[eye] = object.u_mv_[eye] * mesh->positionDequant();
+            }
+            object.u_mvp_[eye] = frame_.u_proj * object.u_mv_[eye];
+        }
+    } else {
+        for (int eye = 0; eye < 2; ++eye) {
+            object.u_mv_[eye] = object.u_mv;
+            object.u_mv_it_[eye] = object.u_mv_it;
+            object.u_mvp_[eye] = object.u_mvp;
+        }
+    }
+}
+
+void UniformBlocks::update(RenderState& rstate, const std::vector<RenderData*>& render_data) {
+    eyes_ = use_multiview;
+    stereo_ = use_multiview && !rstate.shadow_map;
+
+    frame_.u_view = rstate.uniforms.u_view;
+    frame_.u_proj = rstate.uniforms.u_proj;
+    frame_.u_view_inv = glm::inverse(frame_.u_view);
+    if (stereo_) {
+        const CameraRig* camera_rig = rstate.scene->main_camera_rig();
+        frame_.u_view_[0] = camera_rig->left_camera()->getViewMatrix();
+        frame_.u_view_[1] = camera_rig->right_camera()->getViewMatrix();
+        frame_.u_view_inv_[0] = glm::inverse(frame_.u_view_[0]);
+        frame_.u_view_inv_[1] = glm::inverse(frame_.u_view_[1]);
+    } else {
+        for (int eye = 0; eye < 2; ++eye) {
+            frame_.u_view_[eye] = frame_.u_view;
+            frame_.u_view_inv_[eye] = frame_.u_view_inv;
+        }
+    }
+    frame_.u_right = glm::ivec4(rstate.uniforms.u_right ? 1 : 0);
+    rstate.uniforms.u_view_inv = frame_.u_view_inv;
+    for (int eye = 0; eye < 2; ++eye) {
+        rstate.uniforms.u_view_[eye] = frame_.u_view_[eye];
+        rstate.uniforms.u_view_inv_[eye] = frame_.u_view_inv_[eye];
+    }
+
+    int count = render_data.size() + 1;
+    reserve(count);
+    memcpy(&staging_[0], &frame_, sizeof(FrameUniforms));
+
+    // the model matrices load here, resolving anything moved since the
+    // cull, so the workers below only read them
+    object(0).u_model = glm::mat4();
+    owners_[0] = nullptr;
+    for (int i = 1; i < count; ++i) {
+        RenderData* rdata = render_data[i - 1];
+        Transform* transform = rdata->owner_object()->transform();
+        object(i).u_model = (nullptr != transform) ? transform->getModelMatrix() : glm::mat4();
+        owners_[i] = rdata;
+        rdata->set_uniform_slot(i);
+    }
+    JobSystem::getInstance()->parallelFor(count, OBJECT_GRAIN, [this](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            computeObject(object(i), (nullptr != owners_[i]) ? owners_[i]->mesh() : nullptr);
+        }
+    });
+    count_ = count;
+
+    GLStateCache* gl_state = GLStateCache::getInstance();
+    region_ = nextRegion();
+
+    GLintptr offset = region_ * region_size_;
+    GLsizeiptr size = frame_size_ + (count - 1) * stride_ + sizeof(ObjectUniforms);
+    gl_state->bindBuffer(GL_UNIFORM_BUFFER, buffer_);
+    void* region = glMapBufferRange(GL_UNIFORM_BUFFER, offset, size,
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (nullptr != region) {
+        memcpy(region, &staging_[0], size);
+        glUnmapBuffer(GL_UNIFORM_BUFFER);
+    } else {
+        glBufferSubData(GL_UNIFORM_BUFFER, offset, size, &staging_[0]);
+    }
+    gl_state->bindBufferRange(GL_UNIFORM_BUFFER, FRAME_BINDING, buffer_, offset,
+            sizeof(FrameUniforms));
+}
+
+void UniformBlocks::bindObject(RenderState& rstate, RenderData* render_data) {
+    if (region_ < 0) {
+        std::vector<RenderData*> none;
+        update(rstate, none);
+    }
+    int slot = render_data->uniform_slot();
+    if (slot <= 0 || (slot >= count_ && slot != spare_slot_)
+            || owners_[slot] != render_data) {
+        // drawn outside the list of the update; GL orders the write
+        // after the draws that read the previous spare object
+        slot = spare_slot_;
+        ObjectUniforms& spare = object(slot);
+        Transform* transform = render_data->owner_object()->transform();
+        spare.u_model = (nullptr != transform) ? transform->getModelMatrix() : glm::mat4();
+        computeObject(spare, render_data->mesh());
+        owners_[slot] = render_data;
+        render_data->set_uniform_slot(slot);
+
+        GLStateCache::getInstance()->bindBuffer(GL_UNIFORM_BUFFER, buffer_);
+        glBufferSubData(GL_UNIFORM_BUFFER, region_ * region_size_ + frame_size_ + slot * stride_,
+                eyes_ ? sizeof(ObjectUniforms) : MONO_OBJECT_SIZE, &spare);
+    }
+    bindSlot(rstate, slot);
+}
+
+void UniformBlocks::bindIdentity(RenderState& rstate) {
+    if (region_ < 0) {
+        std::vector<RenderData*> none;
+        update(rstate, none);
+    }
+    bindSlot(rstate, 0);
+}
+
+void UniformBlocks::bindSlot(RenderState& rstate, int slot) {
+    GLStateCache::getInstance()->bindBufferRange(GL_UNIFORM_BUFFER, OBJECT_BINDING, buffer_,
+            region_ * region_size_ + frame_size_ + slot * stride_, sizeof(ObjectUniforms));
+
+    const ObjectUniforms& source = object(slot);
+    ShaderUniformsPerObject& uniforms = rstate.uniforms;
+    uniforms.u_model = source.u_model;
+    uniforms.u_mv = source.u_mv;
+    uniforms.u_mvp = source.u_mvp;
+    uniforms.u_mv_it = source.u_mv_it;
+    if (eyes_) {
+        for (int eye = 0; eye < 2; ++eye) {
+            uniforms.u_mv_[eye] = source.u_mv_[eye];
+            uniforms.u_mvp_[eye] = source.u_mvp_[eye];
+            uniforms.u_mv_it_[eye] = source.u_mv_it_[eye];
+        }
+    }
+}
+
+}
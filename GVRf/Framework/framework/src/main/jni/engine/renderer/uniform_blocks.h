@@ -0,0 +1,149 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Uniform buffers holding the camera and per object matrices.
+ ***************************************************************************/
+
+#ifndef UNIFORM_BLOCKS_H_
+#define UNIFORM_BLOCKS_H_
+
+#include <vector>
+
+#include "gl/gl_headers.h"
+#include "glm/glm.hpp"
+
+namespace gvr {
+class GlDelete;
+class Mesh;
+class RenderData;
+struct RenderState;
+
+/*
+ * std140 image of the FrameUniforms block, the camera of a pass.
+ */
+struct FrameUniforms {
+    glm::mat4  u_view;
+    glm::mat4  u_proj;
+    glm::mat4  u_view_inv;
+    glm::mat4  u_view_[2];
+    glm::mat4  u_view_inv_[2];
+    glm::ivec4 u_right;     // x only
+};
+
+/*
+ * std140 image of the ObjectUniforms block. The eye arrays are only
+ * written when rendering multiview.
+ */
+struct ObjectUniforms {
+    glm::mat4 u_model;
+    glm::mat4 u_mv;
+    glm::mat4 u_mvp;
+    glm::mat4 u_mv_it;
+    glm::mat4 u_mv_[2];
+    glm::mat4 u_mvp_[2];
+    glm::mat4 u_mv_it_[2];
+};
+
+/*
+ * Replaces the per draw glUniformMatrix4fv calls for the matrices.
+ *
+ * update() runs once per pass, after culling: it computes the frame
+ * block and the object blocks of every render data in the list (in
+ * parallel) and uploads them with one write into the next region of a
+ * ring buffer. Each draw then only binds its object slot with
+ * glBindBufferRange. A region is reused once the fence inserted after
+ * its pass has signaled; when it has not, the ring doubles instead, so
+ * it grows to the passes in flight, the eyes and the shadow maps of the
+ * frames the GPU is behind, and a region is never written while the GPU
+ * may still read it.
+ *
+ * Shaders opt in by declaring the blocks (FRAME_BLOCK, OBJECT_BLOCK);
+ * bindProgram() assigns their binding points. The matrices are also
+ * copied to RenderState::uniforms for shaders that still use plain
+ * uniforms.
+ */
+class UniformBlocks {
+public:
+    // Batch::MATRIX_BINDING is 0
+    static const int FRAME_BINDING = 1;
+    static const int OBJECT_BINDING = 2;
+
+    // GLSL declarations of the blocks, #version 300 es
+    static const char FRAME_BLOCK[];
+    static const char OBJECT_BLOCK[];
+
+    UniformBlocks();
+    ~UniformBlocks();
+
+    // binds the blocks the program declares to their binding points
+    static void bindProgram(GLuint program_id);
+
+    // fills and uploads the blocks for a pass, binds the frame block
+    void update(RenderState& rstate, const std::vector<RenderData*>& render_data);
+
+    /*
+     * Binds the object block of the render data and copies its
+     * matrices to rstate.uniforms. Render data not in the list of the
+     * last update go to the spare slot of the region.
+     */
+    void bindObject(RenderState& rstate, RenderData* render_data);
+
+    // binds the identity model, for instanced draws
+    void bindIdentity(RenderState& rstate);
+
+private:
+    UniformBlocks(const UniformBlocks& uniform_blocks);
+    UniformBlocks(UniformBlocks&& uniform_blocks);
+    UniformBlocks& operator=(const UniformBlocks& uniform_blocks);
+    UniformBlocks& operator=(UniformBlocks&& uniform_blocks);
+
+    // two eyes of three frames to start with, shadow map passes grow it
+    static const int MIN_REGIONS = 6;
+    static const int MAX_REGIONS = 64;
+    static const int OBJECT_GRAIN = 256;
+
+    void reserve(int slot_count);
+    void allocate();
+    int nextRegion();
+    void computeObject(ObjectUniforms& object, const Mesh* mesh) const;
+    ObjectUniforms& object(int slot) {
+        return *reinterpret_cast<ObjectUniforms*>(&staging_[frame_size_ + slot * stride_]);
+    }
+    void bindSlot(RenderState& rstate, int slot);
+
+    GLuint buffer_;
+    std::vector<GLsync> fences_;
+    int region_count_;
+    int region_;        // -1 before the first update
+    int region_size_;
+    int capacity_;      // object slots per region, not counting the spare one
+    int count_;         // slots written by the last update
+    int spare_slot_;
+    int stride_;        // object slot size, rounded to the offset alignment
+    int frame_size_;
+    int alignment_;
+    bool eyes_;         // write the eye arrays
+    bool stereo_;       // the eyes see different views
+    FrameUniforms frame_;
+    // region image, the frame block then the object slots; slot 0 holds
+    // the identity model
+    std::vector<char> staging_;
+    std::vector<RenderData*> owners_;
+    GlDelete* deleter_;
+};
+
+}
+#endif
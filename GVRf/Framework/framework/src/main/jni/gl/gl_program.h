@@ -20,7 +20,11 @@
 #ifndef GL_PROGRAM_H_
 #define GL_PROGRAM_H_
 
+#include <cstring>
+#include <string>
+
 #include "gl/gl_headers.h"
+#include "gl/gl_program_cache.h"
 
 #include "engine/memory/gl_delete.h"
 
@@ -101,6 +105,20 @@ public:
             const GLint* pVertexSourceStringLengths,
             const char** pFragmentSourceStrings,
             const GLint* pFragmentSourceStringLengths) {
+        // a binary of the same sources skips compiling and linking
+        ProgramCache* cache = ProgramCache::getInstance();
+        bool use_cache = cache->enabled();
+        uint64_t key = 0;
+        if (use_cache) {
+            key = ProgramCache::hashSources(strLength, pVertexSourceStrings,
+                    pVertexSourceStringLengths, pFragmentSourceStrings,
+                    pFragmentSourceStringLengths);
+            GLuint program = cache->loadProgram(key);
+            if (program) {
+                return program;
+            }
+        }
+
         GLuint vertexShader = loadShader(GL_VERTEX_SHADER, strLength,
                 pVertexSourceStrings, pVertexSourceStringLengths);
         if (!vertexShader) {
@@ -128,6 +146,9 @@ public:
             glAttachShader(program, pixelShader);
             checkGlError("glAttachShader");
 
+            if (use_cache) {
+                glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+            }
             glLinkProgram(program);
             GLint linkStatus = GL_FALSE;
             glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
@@ -144,6 +165,8 @@ public:
                 }
                 deleter_->queueProgram(program);
                 program = 0;
+            } else if (use_cache) {
+                cache->storeProgram(key, program);
             }
         }
         return program;
@@ -0,0 +1,285 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * On-disk cache of linked program binaries.
+ ***************************************************************************/
+
+#include "gl_program_cache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "util/gvr_log.h"
+
+namespace gvr {
+
+static const uint32_t FILE_MAGIC = 0x50525647;     // "GVRP"
+static const uint32_t FILE_VERSION = 1;
+static const uint32_t MAX_BINARY_LENGTH = 16 * 1024 * 1024;
+
+// 64-bit FNV-1a
+static const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+static const uint64_t FNV_PRIME = 1099511628211ULL;
+
+static uint64_t hashBytes(uint64_t hash, const char* bytes, size_t length) {
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= static_cast<unsigned char>(bytes[i]);
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+static uint64_t hashStrings(uint64_t hash, int count, const char** strings,
+        const GLint* lengths) {
+    for (int i = 0; i < count; ++i) {
+        size_t length = (nullptr != lengths && lengths[i] >= 0) ?
+                lengths[i] : strlen(strings[i]);
+        hash = hashBytes(hash, strings[i], length);
+    }
+    return hash;
+}
+
+ProgramCache* ProgramCache::instance_ = new ProgramCache();
+
+ProgramCache* ProgramCache::getInstance() {
+    return instance_;
+}
+
+ProgramCache::ProgramCache() :
+        scanned_(false), state_(0), driver_(0), hits_(0), misses_(0) {
+}
+
+void ProgramCache::setDirectory(const std::string& directory) {
+    std::lock_guard < std::mutex > lock(mutex_);
+    if (!directory_.empty()) {
+        return;
+    }
+    directory_ = directory + "/gvrf_programs";
+    mkdir(directory_.c_str(), 0700);
+    // lives as long as the process, like the cache
+    std::thread(&ProgramCache::ioLoop, this).detach();
+}
+
+uint64_t ProgramCache::hashSources(int count,
+        const char** vertex_strings, const GLint* vertex_lengths,
+        const char** fragment_strings, const GLint* fragment_lengths) {
+    uint64_t hash = hashStrings(FNV_OFFSET, count, vertex_strings, vertex_lengths);
+    // keep "ab" + "c" apart from "a" + "bc"
+    hash = hashBytes(hash, "\0", 1);
+    return hashStrings(hash, count, fragment_strings, fragment_lengths);
+}
+
+bool ProgramCache::enabled() {
+    if (0 == state_) {
+        {
+            std::lock_guard < std::mutex > lock(mutex_);
+            if (directory_.empty()) {
+                return false;
+            }
+        }
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        if (formats <= 0) {
+            LOGI("ProgramCache: no program binary formats, cache off");
+            state_ = -1;
+        } else {
+            const GLenum names[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+            uint64_t hash = FNV_OFFSET;
+            for (int i = 0; i < 3; ++i) {
+                const char* name = reinterpret_cast<const char*>(glGetString(names[i]));
+                if (nullptr != name) {
+                    hash = hashBytes(hash, name, strlen(name));
+                }
+            }
+            driver_ = hash;
+            state_ = 1;
+        }
+    }
+    return state_ > 0;
+}
+
+GLuint ProgramCache::loadProgram(uint64_t key) {
+    if (!enabled()) {
+        return 0;
+    }
+    std::unique_lock < std::mutex > lock(mutex_);
+    auto it = binaries_.find(key);
+    if (it == binaries_.end() && !scanned_) {
+        // the background read has not got to it yet
+        std::string file = path(key);
+        lock.unlock();
+        Binary binary;
+        uint64_t file_key = 0;
+        bool found = readFile(file, file_key, binary) && file_key == key;
+        lock.lock();
+        if (found) {
+            it = binaries_.insert(std::make_pair(key, std::move(binary))).first;
+        } else {
+            it = binaries_.find(key);
+        }
+    }
+    if (it == binaries_.end()) {
+        ++misses_;
+        return 0;
+    }
+    if (it->second.driver != driver_) {
+        LOGI("ProgramCache: dropping %016llx, built by another driver",
+                static_cast<unsigned long long>(key));
+        binaries_.erase(it);
+        ++misses_;
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, it->second.format, it->second.data.data(),
+            it->second.data.size());
+    GLint status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (GL_TRUE != status) {
+        LOGI("ProgramCache: binary %016llx rejected, relinking",
+                static_cast<unsigned long long>(key));
+        glDeleteProgram(program);
+        binaries_.erase(it);
+        ++misses_;
+        return 0;
+    }
+    ++hits_;
+    return program;
+}
+
+void ProgramCache::storeProgram(uint64_t key, GLuint program) {
+    if (!enabled()) {
+        return;
+    }
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0 || static_cast<uint32_t>(length) > MAX_BINARY_LENGTH) {
+        return;
+    }
+    Binary binary;
+    binary.driver = driver_;
+    binary.format = 0;
+    binary.data.resize(length);
+    GLsizei written = 0;
+    glGetProgramBinary(program, length, &written, &binary.format, binary.data.data());
+    if (written <= 0) {
+        return;
+    }
+    binary.data.resize(written);
+
+    std::lock_guard < std::mutex > lock(mutex_);
+    writes_.push_back(std::make_pair(key, binary));
+    binaries_[key] = std::move(binary);
+    wake_.notify_one();
+}
+
+std::string ProgramCache::path(uint64_t key) const {
+    char name[32];
+    snprintf(name, sizeof(name), "/%016llx.bin", static_cast<unsigned long long>(key));
+    return directory_ + name;
+}
+
+bool ProgramCache::readFile(const std::string& path, uint64_t& key, Binary& binary) const {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (nullptr == file) {
+        return false;
+    }
+    FileHeader header;
+    bool valid = 1 == fread(&header, sizeof(header), 1, file)
+            && FILE_MAGIC == header.magic && FILE_VERSION == header.version
+            && header.length > 0 && header.length <= MAX_BINARY_LENGTH;
+    if (valid) {
+        binary.data.resize(header.length);
+        valid = 1 == fread(binary.data.data(), header.length, 1, file);
+    }
+    fclose(file);
+    if (valid) {
+        key = header.key;
+        binary.driver = header.driver;
+        binary.format = header.format;
+    }
+    return valid;
+}
+
+// written under a temporary name first so a crash never leaves half a file
+void ProgramCache::writeFile(uint64_t key, const Binary& binary) const {
+    std::string final_path = path(key);
+    std::string temp_path = final_path + ".tmp";
+    FILE* file = fopen(temp_path.c_str(), "wb");
+    if (nullptr == file) {
+        LOGE("ProgramCache: can not write %s", temp_path.c_str());
+        return;
+    }
+    FileHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = FILE_MAGIC;
+    header.version = FILE_VERSION;
+    header.key = key;
+    header.driver = binary.driver;
+    header.format = binary.format;
+    header.length = binary.data.size();
+    bool written = 1 == fwrite(&header, sizeof(header), 1, file)
+            && 1 == fwrite(binary.data.data(), binary.data.size(), 1, file);
+    written = (0 == fclose(file)) && written;
+    if (!written || 0 != rename(temp_path.c_str(), final_path.c_str())) {
+        remove(temp_path.c_str());
+    }
+}
+
+void ProgramCache::ioLoop() {
+    std::string directory;
+    {
+        std::lock_guard < std::mutex > lock(mutex_);
+        directory = directory_;
+    }
+    DIR* dir = opendir(directory.c_str());
+    if (nullptr != dir) {
+        int count = 0;
+        for (struct dirent* entry = readdir(dir); nullptr != entry; entry = readdir(dir)) {
+            size_t length = strlen(entry->d_name);
+            if (length < 4 || 0 != strcmp(entry->d_name + length - 4, ".bin")) {
+                continue;
+            }
+            Binary binary;
+            uint64_t key = 0;
+            if (readFile(directory + "/" + entry->d_name, key, binary)) {
+                std::lock_guard < std::mutex > lock(mutex_);
+                binaries_.insert(std::make_pair(key, std::move(binary)));
+                ++count;
+            }
+        }
+        closedir(dir);
+        LOGI("ProgramCache: read %d program binaries", count);
+    }
+    scanned_ = true;
+
+    for (;;) {
+        std::pair<uint64_t, Binary> write;
+        {
+            std::unique_lock < std::mutex > lock(mutex_);
+            while (writes_.empty()) {
+                wake_.wait(lock);
+            }
+            write = std::move(writes_.front());
+            writes_.pop_front();
+        }
+        writeFile(write.first, write.second);
+    }
+}
+
+}
@@ -0,0 +1,123 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * On-disk cache of linked program binaries.
+ ***************************************************************************/
+
+#ifndef GL_PROGRAM_CACHE_H_
+#define GL_PROGRAM_CACHE_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "gl/gl_headers.h"
+
+namespace gvr {
+
+/*
+ * Keeps the binaries of linked programs, keyed by a hash of their source
+ * strings, in memory and as one file per program under the app's cache
+ * directory. The feature defines of a shader permutation are part of its
+ * source, so every permutation has its own entry. GLProgram asks the
+ * cache before compiling and stores every program it had to compile.
+ *
+ * Entries carry a hash of GL_VENDOR, GL_RENDERER and GL_VERSION; one
+ * written by another driver is dropped and rebuilt. Reading the
+ * directory and writing new files happen on a background thread.
+ *
+ * The cache stays off until setDirectory is called, and on drivers
+ * without program binary formats.
+ */
+class ProgramCache {
+public:
+    static ProgramCache* getInstance();
+
+    // turns the cache on and starts reading the directory in the background
+    void setDirectory(const std::string& directory);
+
+    static uint64_t hashSources(int count,
+            const char** vertex_strings, const GLint* vertex_lengths,
+            const char** fragment_strings, const GLint* fragment_lengths);
+
+    // GL thread: a program linked from the cached binary, or 0
+    GLuint loadProgram(uint64_t key);
+
+    // GL thread: keeps the binary of a program linked from source
+    void storeProgram(uint64_t key, GLuint program);
+
+    // GL thread: true when programs should be linked retrievable
+    bool enabled();
+
+    int hits() const {
+        return hits_;
+    }
+    int misses() const {
+        return misses_;
+    }
+
+private:
+    ProgramCache();
+    ProgramCache(const ProgramCache& cache);
+    ProgramCache(ProgramCache&& cache);
+    ProgramCache& operator=(const ProgramCache& cache);
+    ProgramCache& operator=(ProgramCache&& cache);
+
+    struct Binary {
+        uint64_t driver;
+        GLenum format;
+        std::vector<char> data;
+    };
+
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t key;
+        uint64_t driver;
+        uint32_t format;
+        uint32_t length;
+    };
+
+    std::string path(uint64_t key) const;
+    bool readFile(const std::string& path, uint64_t& key, Binary& binary) const;
+    void writeFile(uint64_t key, const Binary& binary) const;
+    void ioLoop();
+
+private:
+    static ProgramCache* instance_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::string directory_;
+    std::unordered_map<uint64_t, Binary> binaries_;
+    std::deque<std::pair<uint64_t, Binary> > writes_;
+    std::atomic<bool> scanned_;    // the directory has been read
+
+    // GL thread only
+    int state_;                     // 0 unknown, 1 on, -1 off
+    uint64_t driver_;
+    int hits_;
+    int misses_;
+};
+
+}
+#endif
@@ -0,0 +1,152 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Reads pixels back from the GPU without waiting for it.
+ ***************************************************************************/
+
+#include "gl_readback.h"
+
+#include <pthread.h>
+
+#include "gl/gl_state_cache.h"
+#include "util/gvr_log.h"
+
+namespace gvr {
+
+static pthread_key_t readback_key;
+static pthread_once_t readback_once = PTHREAD_ONCE_INIT;
+
+static void deleteReadback(void* readback) {
+    delete static_cast<GLReadback*>(readback);
+}
+
+static void createReadbackKey() {
+    int err = pthread_key_create(&readback_key, deleteReadback);
+    if (0 != err) {
+        LOGE("fatal error: pthread_key_create failed with %d!", err);
+        std::terminate();
+    }
+}
+
+GLReadback* GLReadback::getInstance() {
+    pthread_once(&readback_once, createReadbackKey);
+    GLReadback* readback = static_cast<GLReadback*>(pthread_getspecific(readback_key));
+    if (nullptr == readback) {
+        readback = new GLReadback();
+        pthread_setspecific(readback_key, readback);
+    }
+    return readback;
+}
+
+GLReadback::GLReadback() :
+        first_(0), count_(0) {
+    for (int i = 0; i < RING_SIZE; ++i) {
+        slots_[i].buffer = 0;
+        slots_[i].capacity = 0;
+        slots_[i].fence = 0;
+        slots_[i].width = 0;
+        slots_[i].height = 0;
+    }
+}
+
+GLReadback::~GLReadback() {
+    // the thread is going, and its context with the buffers
+}
+
+bool GLReadback::read(int x, int y, int width, int height, const Callback& done) {
+    if (full()) {
+        return false;
+    }
+    Slot& slot = slots_[(first_ + count_) % RING_SIZE];
+    GLsizeiptr size = static_cast<GLsizeiptr>(width) * height * 4;
+
+    GLStateCache* cache = GLStateCache::getInstance();
+    if (0 == slot.buffer) {
+        glGenBuffers(1, &slot.buffer);
+    }
+    cache->bindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    if (slot.capacity < size) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+        slot.capacity = size;
+    }
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    cache->bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.width = width;
+    slot.height = height;
+    slot.done = done;
+    ++count_;
+    return true;
+}
+
+void GLReadback::poll() {
+    while (count_ > 0) {
+        Slot& slot = slots_[first_];
+        // the frame's flush gets the fence to the GPU, do not force one
+        GLenum status = glClientWaitSync(slot.fence, 0, 0);
+        if (GL_ALREADY_SIGNALED != status && GL_CONDITION_SATISFIED != status) {
+            return;
+        }
+        complete(slot);
+    }
+}
+
+void GLReadback::finish() {
+    while (count_ > 0) {
+        Slot& slot = slots_[first_];
+        GLenum status;
+        do {
+            status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                    1000000000ull);
+        } while (GL_TIMEOUT_EXPIRED == status);
+        if (GL_WAIT_FAILED == status) {
+            LOGE("GLReadback: waiting for a read failed");
+        }
+        complete(slot);
+    }
+}
+
+void GLReadback::complete(Slot& slot) {
+    glDeleteSync(slot.fence);
+    slot.fence = 0;
+
+    GLStateCache* cache = GLStateCache::getInstance();
+    cache->bindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    GLsizeiptr size = static_cast<GLsizeiptr>(slot.width) * slot.height * 4;
+    const GLubyte* pixels = static_cast<const GLubyte*>(
+            glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT));
+    if (nullptr == pixels) {
+        LOGE("GLReadback: cannot map the pixels of a %dx%d read", slot.width, slot.height);
+    }
+
+    // the slot stays taken until the callback is done with its buffer
+    Callback done;
+    done.swap(slot.done);
+    if (done) {
+        done(pixels, slot.width, slot.height);
+    }
+    if (nullptr != pixels) {
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    cache->bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    first_ = (first_ + 1) % RING_SIZE;
+    --count_;
+}
+
+}
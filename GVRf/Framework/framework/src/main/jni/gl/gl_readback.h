@@ -0,0 +1,97 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Reads pixels back from the GPU without waiting for it.
+ ***************************************************************************/
+
+#ifndef GL_READBACK_H_
+#define GL_READBACK_H_
+
+#include <functional>
+
+#include "gl/gl_headers.h"
+
+namespace gvr {
+
+/*
+ * One per GL thread: a ring of RING_SIZE pixel pack buffers that
+ * glReadPixels copies into on the GPU. A fence follows each read, and
+ * poll(), once per frame, maps the buffers whose fence has signalled by
+ * then, so nothing waits for the GPU to catch up with the read.
+ *
+ * Reads complete in the order they were made. The callback gets the
+ * mapped pixels, RGBA8, bottom row first; they are only valid during the
+ * call, so whatever is kept has to be copied. Callbacks run on the GL
+ * thread and must not read again.
+ */
+class GLReadback {
+public:
+    static const int RING_SIZE = 3;
+
+    // null pixels when the buffer could not be mapped
+    typedef std::function<void(const GLubyte* pixels, int width, int height)> Callback;
+
+    static GLReadback* getInstance();
+
+    /*
+     * Reads the rectangle of the bound read framebuffer into the next
+     * buffer of the ring. Returns false, reading nothing, while every
+     * buffer is in flight.
+     */
+    bool read(int x, int y, int width, int height, const Callback& done);
+
+    // completes the reads whose fence has signalled, oldest first
+    void poll();
+
+    // completes every read, waiting for the GPU
+    void finish();
+
+    bool full() const {
+        return RING_SIZE == count_;
+    }
+
+    int pending() const {
+        return count_;
+    }
+
+    ~GLReadback();
+
+private:
+    GLReadback();
+    GLReadback(const GLReadback& readback);
+    GLReadback(GLReadback&& readback);
+    GLReadback& operator=(const GLReadback& readback);
+    GLReadback& operator=(GLReadback&& readback);
+
+    struct Slot {
+        GLuint buffer;
+        GLsizeiptr capacity;
+        GLsync fence;
+        int width;
+        int height;
+        Callback done;
+    };
+
+    void complete(Slot& slot);
+
+private:
+    Slot slots_[RING_SIZE];
+    int first_;         // the oldest read in flight
+    int count_;
+};
+
+}
+#endif
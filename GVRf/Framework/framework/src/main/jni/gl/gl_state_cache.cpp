@@ -0,0 +1,220 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Shadow copy of the GL state, dropping redundant state changes.
+ ***************************************************************************/
+
+#include "gl_state_cache.h"
+
+#include <pthread.h>
+
+#include "util/gvr_log.h"
+
+namespace gvr {
+
+static pthread_key_t state_cache_key;
+static pthread_once_t state_cache_once = PTHREAD_ONCE_INIT;
+
+static void deleteStateCache(void* cache) {
+    delete static_cast<GLStateCache*>(cache);
+}
+
+static void createStateCacheKey() {
+    int err = pthread_key_create(&state_cache_key, deleteStateCache);
+    if (0 != err) {
+        LOGE("fatal error: pthread_key_create failed with %d!", err);
+        std::terminate();
+    }
+}
+
+GLStateCache* GLStateCache::getInstance() {
+    pthread_once(&state_cache_once, createStateCacheKey);
+    GLStateCache* cache = static_cast<GLStateCache*>(pthread_getspecific(state_cache_key));
+    if (nullptr == cache) {
+        cache = new GLStateCache();
+        pthread_setspecific(state_cache_key, cache);
+    }
+    return cache;
+}
+
+GLStateCache::GLStateCache() :
+        issued_(0), skipped_(0), last_issued_(0), last_skipped_(0) {
+}
+
+void GLStateCache::invalidate() {
+    for (int i = 0; i < CAPABILITY_COUNT; ++i) {
+        capabilities_[i].known = false;
+    }
+    cull_face_.known = false;
+    front_face_.known = false;
+    depth_func_.known = false;
+    depth_mask_.known = false;
+    color_mask_.known = false;
+    blend_func_.known = false;
+    blend_equation_.known = false;
+    polygon_offset_.known = false;
+    sample_coverage_.known = false;
+    line_width_.known = false;
+    program_.known = false;
+    vertex_array_.known = false;
+    for (int i = 0; i < BUFFER_TARGETS; ++i) {
+        buffers_[i].known = false;
+    }
+    for (int i = 0; i < UNIFORM_BUFFER_BINDINGS; ++i) {
+        uniform_buffers_[i].known = false;
+    }
+    active_texture_.known = false;
+    for (int unit = 0; unit < TEXTURE_UNITS; ++unit) {
+        for (int target = 0; target < TEXTURE_TARGETS; ++target) {
+            textures_[unit][target].known = false;
+        }
+    }
+}
+
+void GLStateCache::beginFrame() {
+    last_issued_ = issued_;
+    last_skipped_ = skipped_;
+    issued_ = 0;
+    skipped_ = 0;
+}
+
+int GLStateCache::capabilityIndex(GLenum cap) {
+    switch (cap) {
+    case GL_BLEND:
+        return 0;
+    case GL_CULL_FACE:
+        return 1;
+    case GL_DEPTH_TEST:
+        return 2;
+    case GL_POLYGON_OFFSET_FILL:
+        return 3;
+    case GL_SAMPLE_ALPHA_TO_COVERAGE:
+        return 4;
+    case GL_SAMPLE_COVERAGE:
+        return 5;
+    case GL_SCISSOR_TEST:
+        return 6;
+    case GL_STENCIL_TEST:
+        return 7;
+    default:
+        return -1;
+    }
+}
+
+int GLStateCache::textureTargetIndex(GLenum target) {
+    switch (target) {
+    case GL_TEXTURE_2D:
+        return 0;
+    case GL_TEXTURE_CUBE_MAP:
+        return 1;
+    case GL_TEXTURE_EXTERNAL_OES:
+        return 2;
+    case GL_TEXTURE_2D_ARRAY:
+        return 3;
+    case GL_TEXTURE_3D:
+        return 4;
+    default:
+        return -1;
+    }
+}
+
+int GLStateCache::bufferTargetIndex(GLenum target) {
+    switch (target) {
+    case GL_ARRAY_BUFFER:
+        return 0;
+    case GL_UNIFORM_BUFFER:
+        return 1;
+    case GL_PIXEL_PACK_BUFFER:
+        return 2;
+    case GL_PIXEL_UNPACK_BUFFER:
+        return 3;
+    default:
+        return -1;
+    }
+}
+
+void GLStateCache::setCapability(GLenum cap, bool enabled) {
+    int index = capabilityIndex(cap);
+    if (index < 0 || changed(capabilities_[index], enabled)) {
+        if (index < 0) {
+            ++issued_;
+        }
+        if (enabled) {
+            glEnable(cap);
+        } else {
+            glDisable(cap);
+        }
+    }
+}
+
+void GLStateCache::bindBuffer(GLenum target, GLuint buffer) {
+    int index = bufferTargetIndex(target);
+    if (index < 0) {
+        ++issued_;
+        glBindBuffer(target, buffer);
+    } else if (changed(buffers_[index], buffer)) {
+        glBindBuffer(target, buffer);
+    }
+}
+
+void GLStateCache::bindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+    if (GL_UNIFORM_BUFFER != target || index >= UNIFORM_BUFFER_BINDINGS) {
+        ++issued_;
+        glBindBufferBase(target, index, buffer);
+        return;
+    }
+    if (changed(uniform_buffers_[index], BufferRange(buffer, 0, -1))) {
+        glBindBufferBase(target, index, buffer);
+        // also binds the generic binding point
+        buffers_[bufferTargetIndex(target)].set(buffer);
+    }
+}
+
+void GLStateCache::bindBufferRange(GLenum target, GLuint index, GLuint buffer,
+        GLintptr offset, GLsizeiptr size) {
+    if (GL_UNIFORM_BUFFER != target || index >= UNIFORM_BUFFER_BINDINGS) {
+        ++issued_;
+        glBindBufferRange(target, index, buffer, offset, size);
+        return;
+    }
+    if (changed(uniform_buffers_[index], BufferRange(buffer, offset, size))) {
+        glBindBufferRange(target, index, buffer, offset, size);
+        buffers_[bufferTargetIndex(target)].set(buffer);
+    }
+}
+
+void GLStateCache::bindTexture(GLenum target, GLuint texture) {
+    int index = textureTargetIndex(target);
+    int unit = active_texture_.value - GL_TEXTURE0;
+    if (index < 0 || !active_texture_.known || unit < 0 || unit >= TEXTURE_UNITS) {
+        ++issued_;
+        glBindTexture(target, texture);
+    } else if (changed(textures_[unit][index], texture)) {
+        glBindTexture(target, texture);
+    }
+}
+
+void GLStateCache::forgetTexture(GLuint texture) {
+    for (int unit = 0; unit < TEXTURE_UNITS; ++unit) {
+        for (int target = 0; target < TEXTURE_TARGETS; ++target) {
+            if (textures_[unit][target].value == texture) {
+                textures_[unit][target].known = false;
+            }
+        }
+    }
+}
+
+}
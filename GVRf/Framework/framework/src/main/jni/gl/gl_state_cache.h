@@ -0,0 +1,224 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Shadow copy of the GL state, dropping redundant state changes.
+ ***************************************************************************/
+
+#ifndef GL_STATE_CACHE_H_
+#define GL_STATE_CACHE_H_
+
+#include <utility>
+
+#include "gl/gl_headers.h"
+
+namespace gvr {
+
+/*
+ * One cache per GL thread, remembering the capabilities, fixed function
+ * state, program, vertex array, buffer and texture bindings set through
+ * it. A call that would not change the state is skipped.
+ *
+ * The cache only knows what went through it. Code that changes the
+ * state behind its back (the VR runtime, external renderers, deletes of
+ * bound objects) must be followed by invalidate(), after which every
+ * call is issued again once.
+ *
+ * The element array buffer binding belongs to the vertex array and is
+ * passed straight through.
+ */
+class GLStateCache {
+public:
+    static GLStateCache* getInstance();
+
+    // forgets the state; the next call of every kind is issued
+    void invalidate();
+
+    // closes the frame's counters, see issuedCalls and skippedCalls
+    void beginFrame();
+
+    // calls issued and skipped during the last frame
+    int issuedCalls() const {
+        return last_issued_;
+    }
+    int skippedCalls() const {
+        return last_skipped_;
+    }
+
+    void enable(GLenum cap) {
+        setCapability(cap, true);
+    }
+    void disable(GLenum cap) {
+        setCapability(cap, false);
+    }
+    void setCapability(GLenum cap, bool enabled);
+
+    void cullFace(GLenum mode) {
+        if (changed(cull_face_, mode)) {
+            glCullFace(mode);
+        }
+    }
+    void frontFace(GLenum mode) {
+        if (changed(front_face_, mode)) {
+            glFrontFace(mode);
+        }
+    }
+    void depthFunc(GLenum func) {
+        if (changed(depth_func_, func)) {
+            glDepthFunc(func);
+        }
+    }
+    void depthMask(GLboolean flag) {
+        if (changed(depth_mask_, flag)) {
+            glDepthMask(flag);
+        }
+    }
+    void colorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha) {
+        GLuint mask = red | (green << 1) | (blue << 2) | (alpha << 3);
+        if (changed(color_mask_, mask)) {
+            glColorMask(red, green, blue, alpha);
+        }
+    }
+    void blendFunc(GLenum sfactor, GLenum dfactor) {
+        if (changed(blend_func_, std::make_pair(sfactor, dfactor))) {
+            glBlendFunc(sfactor, dfactor);
+        }
+    }
+    void blendEquation(GLenum mode) {
+        if (changed(blend_equation_, mode)) {
+            glBlendEquation(mode);
+        }
+    }
+    void polygonOffset(GLfloat factor, GLfloat units) {
+        if (changed(polygon_offset_, std::make_pair(factor, units))) {
+            glPolygonOffset(factor, units);
+        }
+    }
+    void sampleCoverage(GLfloat value, GLboolean invert) {
+        if (changed(sample_coverage_, std::make_pair(value, invert))) {
+            glSampleCoverage(value, invert);
+        }
+    }
+    void lineWidth(GLfloat width) {
+        if (changed(line_width_, width)) {
+            glLineWidth(width);
+        }
+    }
+
+    void useProgram(GLuint program) {
+        if (changed(program_, program)) {
+            glUseProgram(program);
+        }
+    }
+    void bindVertexArray(GLuint vertex_array) {
+        if (changed(vertex_array_, vertex_array)) {
+            glBindVertexArray(vertex_array);
+        }
+    }
+    void bindBuffer(GLenum target, GLuint buffer);
+    void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+    void bindBufferRange(GLenum target, GLuint index, GLuint buffer,
+            GLintptr offset, GLsizeiptr size);
+
+    void activeTexture(GLenum unit) {
+        if (changed(active_texture_, unit)) {
+            glActiveTexture(unit);
+        }
+    }
+    void bindTexture(GLenum target, GLuint texture);
+
+    /*
+     * The next bind of texture is issued even where it is bound already;
+     * a texture changed in another context is only seen after a rebind.
+     */
+    void forgetTexture(GLuint texture);
+
+private:
+    template <class T> struct Shadow {
+        Shadow() : value(), known(false) {
+        }
+        void set(T v) {
+            value = v;
+            known = true;
+        }
+        T value;
+        bool known;
+    };
+
+    // an indexed uniform buffer binding, size -1 for the whole buffer
+    struct BufferRange {
+        BufferRange() : buffer(0), offset(0), size(0) {
+        }
+        BufferRange(GLuint b, GLintptr o, GLsizeiptr s) :
+                buffer(b), offset(o), size(s) {
+        }
+        bool operator==(const BufferRange& other) const {
+            return buffer == other.buffer && offset == other.offset
+                    && size == other.size;
+        }
+        GLuint buffer;
+        GLintptr offset;
+        GLsizeiptr size;
+    };
+
+    GLStateCache();
+
+    // records the new value, returns true when the call has to be issued
+    template <class T> bool changed(Shadow<T>& shadow, T value) {
+        if (shadow.known && shadow.value == value) {
+            ++skipped_;
+            return false;
+        }
+        shadow.set(value);
+        ++issued_;
+        return true;
+    }
+
+    static const int CAPABILITY_COUNT = 8;
+    static const int TEXTURE_UNITS = 16;
+    static const int TEXTURE_TARGETS = 5;
+    static const int BUFFER_TARGETS = 4;
+    static const int UNIFORM_BUFFER_BINDINGS = 16;
+
+    static int capabilityIndex(GLenum cap);
+    static int textureTargetIndex(GLenum target);
+    static int bufferTargetIndex(GLenum target);
+
+    Shadow<bool> capabilities_[CAPABILITY_COUNT];
+    Shadow<GLenum> cull_face_;
+    Shadow<GLenum> front_face_;
+    Shadow<GLenum> depth_func_;
+    Shadow<GLboolean> depth_mask_;
+    Shadow<GLuint> color_mask_;
+    Shadow<std::pair<GLenum, GLenum> > blend_func_;
+    Shadow<GLenum> blend_equation_;
+    Shadow<std::pair<GLfloat, GLfloat> > polygon_offset_;
+    Shadow<std::pair<GLfloat, GLboolean> > sample_coverage_;
+    Shadow<GLfloat> line_width_;
+    Shadow<GLuint> program_;
+    Shadow<GLuint> vertex_array_;
+    Shadow<GLuint> buffers_[BUFFER_TARGETS];
+    Shadow<BufferRange> uniform_buffers_[UNIFORM_BUFFER_BINDINGS];
+    Shadow<GLenum> active_texture_;
+    Shadow<GLuint> textures_[TEXTURE_UNITS][TEXTURE_TARGETS];
+
+    int issued_;
+    int skipped_;
+    int last_issued_;
+    int last_skipped_;
+};
+
+}
+#endif
@@ -30,9 +30,13 @@
 
 #include "util/gvr_log.h"
 #include <cstdlib>
+#include <cstring>
 
 #include "engine/memory/gl_delete.h"
 #include "objects/gl_pending_task.h"
+#include "objects/textures/texture_loader.h"
+#include "objects/textures/texture_residency.h"
+#include "gl/gl_state_cache.h"
 
 #define MAX_TEXTURE_PARAM_NUM 10
 
@@ -56,16 +60,111 @@ public:
     }
 
     virtual ~GLTexture() {
+        if (resident_) {
+            TextureResidency::getInstance()->remove(this);
+        }
+        if (upload_) {
+            // deleted by the loader if it is still working on it
+            GLuint id = upload_->abandon();
+            if (0 != id && deleter_) {
+                deleter_->queueTexture(id, upload_->byteSize());
+            }
+            if (GL_TASK_LOAD == pending_gl_task_) {
+                id_ = 0;    // a streamed texture, borrowed from the loader
+            }
+        }
         if (0 != id_ && deleter_) {
-            deleter_->queueTexture(id_);
+            deleter_->queueTexture(id_, bytes_);
         }
     }
 
+    // from the shaders' bind paths, for TextureResidency
+    void markUsed() {
+        last_used_frame_ = TextureResidency::getInstance()->frame();
+    }
+
+    /*
+     * GL thread: the bytes of images defined outside an upload, such as a
+     * render target's or a bitmap's from Java, for the texture budget.
+     */
+    void setByteSize(size_t bytes) {
+        bytes_ = bytes;
+        TextureResidency::getInstance()->addFixed(this, bytes);
+        resident_ = true;
+    }
+
+    // 0 while the texture is being loaded
     GLuint id() {
         runPendingGL();
         return id_;
     }
 
+    /*
+     * Fills the texture with the images in upload. Called where the
+     * texture is constructed, on any thread: a running TextureLoader
+     * starts on it right away, otherwise the images are uploaded on the
+     * GL thread at first use.
+     */
+    void setUpload(const std::shared_ptr<TextureUpload>& upload) {
+        upload_ = upload;
+        TextureLoader* loader = TextureLoader::getInstance();
+        if (loader->submit(upload)) {
+            deleter_ = loader->deleter();
+            pending_gl_task_ = GL_TASK_LOAD;
+        } else {
+            pending_gl_task_ = GL_TASK_INIT_UPLOAD;
+        }
+    }
+
+    // false until the loader's fence has signalled for the first stage
+    bool isLoaded() {
+        runPendingGL();
+        return GL_TASK_LOAD != pending_gl_task_ || 0 != id_;
+    }
+
+    // blocks until the loader is done with the texture
+    void waitUntilLoaded() {
+        if (GL_TASK_LOAD == pending_gl_task_) {
+            TextureLoader::getInstance()->wait(*upload_);
+        }
+        runPendingGL();
+    }
+
+    // sets the parameters of the bound texture, the defaults without any
+    static void setParameters(GLenum target, const int* texture_parameters) {
+        if (nullptr == texture_parameters) {
+            glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(target, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+            glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            return;
+        }
+
+        // Sets the new MIN FILTER
+        GLenum min_filter_type_ = texture_parameters[0];
+
+        // Sets the MAG FILTER
+        GLenum mag_filter_type_ = texture_parameters[1];
+
+        // Sets the wrap parameter for texture coordinate S
+        GLenum wrap_s_type_ = texture_parameters[3];
+
+        // Sets the wrap parameter for texture coordinate S
+        GLenum wrap_t_type_ = texture_parameters[4];
+
+        // Sets the anisotropic filtering if the value provided is greater than 1 because 1 is the default value
+        if (texture_parameters[2] > 1.0f) {
+            glTexParameterf(target, GL_TEXTURE_MAX_ANISOTROPY_EXT,
+                    (float) texture_parameters[2]);
+        }
+
+        glTexParameteri(target, GL_TEXTURE_WRAP_S, wrap_s_type_);
+        glTexParameteri(target, GL_TEXTURE_WRAP_T, wrap_t_type_);
+        glTexParameteri(target, GL_TEXTURE_MIN_FILTER, min_filter_type_);
+        glTexParameteri(target, GL_TEXTURE_MAG_FILTER, mag_filter_type_);
+    }
+
     GLenum target() const {
         return target_;
     }
@@ -80,45 +179,60 @@ public:
             deleter_= getDeleterForThisThread();
 
             glGenTextures(1, &id_);
-            glBindTexture(target_, id_);
-            glTexParameteri(target_, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-            glTexParameteri(target_, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-            glTexParameteri(target_, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-            glTexParameteri(target_, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            glTexParameteri(target_, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            glBindTexture(target_, 0);
+            GLStateCache::getInstance()->bindTexture(target_, id_);
+            setParameters(target_, nullptr);
+            GLStateCache::getInstance()->bindTexture(target_, 0);
             break;
         }
 
         case GL_TASK_INIT_WITH_PARAM: {
             deleter_= getDeleterForThisThread();
 
-            // Sets the new MIN FILTER
-            GLenum min_filter_type_ = texture_parameters_[0];
-
-            // Sets the MAG FILTER
-            GLenum mag_filter_type_ = texture_parameters_[1];
+            glGenTextures(1, &id_);
+            GLStateCache::getInstance()->bindTexture(target_, id_);
+            setParameters(target_, texture_parameters_);
+            GLStateCache::getInstance()->bindTexture(target_, 0);
+            break;
+        }
 
-            // Sets the wrap parameter for texture coordinate S
-            GLenum wrap_s_type_ = texture_parameters_[3];
+        case GL_TASK_LOAD: {
+            int state = upload_->state();
+            if (TextureUpload::DONE == state) {
+                id_ = upload_->takeId();
+                // filled in another context, bind it again to see it
+                GLStateCache::getInstance()->forgetTexture(id_);
+                track();
+                break;
+            }
+            if (TextureUpload::STREAMING == state) {
+                int landed = upload_->landed_stages();
+                if (landed != landed_stages_) {
+                    landed_stages_ = landed;
+                    id_ = upload_->id();
+                    GLStateCache::getInstance()->forgetTexture(id_);
+                }
+                return; // still streaming
+            }
+            if (TextureUpload::FAILED != state) {
+                return; // still loading
+            }
+            LOGW("GLTexture: loader failed, uploading on the GL thread");
+            id_ = 0;
+        }
+        // fall through
 
-            // Sets the wrap parameter for texture coordinate S
-            GLenum wrap_t_type_ = texture_parameters_[4];
+        case GL_TASK_INIT_UPLOAD: {
+            deleter_= getDeleterForThisThread();
 
             glGenTextures(1, &id_);
-            glBindTexture(target_, id_);
-
-            // Sets the anisotropic filtering if the value provided is greater than 1 because 1 is the default value
-            if (texture_parameters_[2] > 1.0f) {
-                glTexParameterf(target_, GL_TEXTURE_MAX_ANISOTROPY_EXT,
-                        (float) texture_parameters_[2]);
+            GLStateCache::getInstance()->bindTexture(target_, id_);
+            setParameters(target_, upload_->texture_parameters());
+            upload_->allocate();
+            for (int stage = 0; stage < upload_->stage_count(); ++stage) {
+                upload_->issueStage(stage, false);
             }
-
-            glTexParameteri(target_, GL_TEXTURE_WRAP_S, wrap_s_type_);
-            glTexParameteri(target_, GL_TEXTURE_WRAP_T, wrap_t_type_);
-            glTexParameteri(target_, GL_TEXTURE_MIN_FILTER, min_filter_type_);
-            glTexParameteri(target_, GL_TEXTURE_MAG_FILTER, mag_filter_type_);
-            glBindTexture(target_, 0);
+            GLStateCache::getInstance()->bindTexture(target_, 0);
+            track();
             break;
         }
 
@@ -128,6 +242,21 @@ public:
     }
 
 private:
+    // hands the texture over to TextureResidency, to evict if it can be reloaded
+    void track() {
+        if (upload_->reloadable()) {
+            bytes_ = upload_->byteSize();
+            TextureResidency::getInstance()->add(this, upload_);
+            resident_ = true;
+        } else {
+            setByteSize(upload_->byteSize());
+        }
+        upload_.reset();
+    }
+
+private:
+    friend class TextureResidency;
+
     GLTexture(const GLTexture& gl_texture);
     GLTexture(GLTexture&& gl_texture);
     GLTexture& operator=(const GLTexture& gl_texture);
@@ -144,9 +273,20 @@ private:
         GL_TASK_NONE = 0,
         GL_TASK_INIT_NO_PARAM,
         GL_TASK_INIT_WITH_PARAM,
+        GL_TASK_INIT_UPLOAD,
+        GL_TASK_LOAD,
     };
     int pending_gl_task_;
 
+    // For GL_TASK_INIT_UPLOAD and GL_TASK_LOAD
+    std::shared_ptr<TextureUpload> upload_;
+    int landed_stages_ = 0;
+    size_t bytes_ = 0;      // of the images, for the deleter
+
+    // for TextureResidency
+    bool resident_ = false;
+    unsigned int last_used_frame_ = 0;
+
     int texture_parameters_[MAX_TEXTURE_PARAM_NUM];
 };
 
@@ -198,6 +198,7 @@ bool BoundingVolume::intersect(glm::vec3& hitPoint, const glm::vec3& rayStart, c
 	}
 	t = tmin; // Store length of ray until intersection in t
 	hitPoint = rayStart + direction * t; // intersection point
+	return true;
 }
 
 } // namespace
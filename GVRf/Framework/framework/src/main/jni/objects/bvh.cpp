@@ -0,0 +1,602 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Bounding volume hierarchy over the renderable objects of a scene.
+ ***************************************************************************/
+
+#include "bvh.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+
+#include "engine/renderer/occlusion_culler.h"
+#include "objects/mesh.h"
+#include "objects/render_pass.h"
+#include "objects/scene_object.h"
+#include "objects/components/render_data.h"
+#include "util/gvr_job_system.h"
+
+namespace gvr {
+
+static float boxArea(const glm::vec3& min_corner, const glm::vec3& max_corner) {
+    glm::vec3 size = max_corner - min_corner;
+    return size.x * size.y + size.y * size.z + size.z * size.x;
+}
+
+BVH::BVH() :
+        rebuild_needed_(false), built_area_(0.0f), cull_frame_(0) {
+}
+
+BVH::~BVH() {
+    clear();
+}
+
+void BVH::collect(SceneObject* object, std::vector<SceneObject*>& objects) {
+    objects.push_back(object);
+    object->getDescendants(objects);
+}
+
+void BVH::insert(SceneObject* object) {
+    // gather outside mutex_, getDescendants takes the children locks
+    std::vector<SceneObject*> objects;
+    collect(object, objects);
+
+    std::lock_guard < std::mutex > lock(mutex_);
+    for (auto it = objects.begin(); it != objects.end(); ++it) {
+        SceneObject* o = *it;
+        if (this == o->bvh_) {
+            continue;
+        }
+        o->bvh_ = this;
+        o->bvh_index_ = objects_.size();
+        o->bvh_leaf_ = -1;
+        o->bvh_dirty_ = false;
+        o->bvh_visible_frame_ = 0;
+        // culled until a cull() finds it visible
+        o->setCullStatus(true);
+        objects_.push_back(o);
+    }
+    rebuild_needed_ = true;
+}
+
+void BVH::remove(SceneObject* object) {
+    std::vector<SceneObject*> objects;
+    collect(object, objects);
+
+    std::lock_guard < std::mutex > lock(mutex_);
+    bool was_visible = false;
+    for (auto it = objects.begin(); it != objects.end(); ++it) {
+        SceneObject* o = *it;
+        if (this != o->bvh_) {
+            continue;
+        }
+        was_visible |= cull_frame_ == o->bvh_visible_frame_;
+        SceneObject* last = objects_.back();
+        objects_[o->bvh_index_] = last;
+        last->bvh_index_ = o->bvh_index_;
+        objects_.pop_back();
+        if (o->bvh_dirty_) {
+            dirty_.erase(std::remove(dirty_.begin(), dirty_.end(), o), dirty_.end());
+        }
+        o->bvh_ = nullptr;
+        o->bvh_index_ = -1;
+        o->bvh_leaf_ = -1;
+        o->bvh_dirty_ = false;
+    }
+    if (was_visible) {
+        // the object may be on its way out, the last visible list must not keep it
+        visible_.erase(std::remove_if(visible_.begin(), visible_.end(),
+                [this](SceneObject* o) {
+                    return this != o->bvh_;
+                }), visible_.end());
+    }
+    rebuild_needed_ = true;
+}
+
+void BVH::clear() {
+    std::lock_guard < std::mutex > lock(mutex_);
+    for (auto it = objects_.begin(); it != objects_.end(); ++it) {
+        SceneObject* o = *it;
+        o->bvh_ = nullptr;
+        o->bvh_index_ = -1;
+        o->bvh_leaf_ = -1;
+        o->bvh_dirty_ = false;
+    }
+    objects_.clear();
+    dirty_.clear();
+    nodes_.clear();
+    leaf_objects_.clear();
+    leaf_boxes_.clear();
+    leaf_center_.clear();
+    leaf_node_.clear();
+    visible_.clear();
+    rebuild_needed_ = false;
+}
+
+void BVH::markDirty(SceneObject* object) {
+    std::lock_guard < std::mutex > lock(mutex_);
+    if (this != object->bvh_ || object->bvh_dirty_) {
+        return;
+    }
+    object->bvh_dirty_ = true;
+    dirty_.push_back(object);
+}
+
+bool BVH::leafBounds(SceneObject* object, glm::vec3& min_corner,
+        glm::vec3& max_corner) {
+    RenderData* rdata = object->render_data();
+    if (nullptr == rdata || nullptr == rdata->mesh()) {
+        return false;
+    }
+    const BoundingVolume& bounds = rdata->mesh()->getBoundingVolume();
+    if (bounds.radius() <= 0.0f) {
+        return false;
+    }
+
+    glm::vec3 center = (bounds.min_corner() + bounds.max_corner()) * 0.5f;
+    glm::vec3 extent = (bounds.max_corner() - bounds.min_corner()) * 0.5f;
+    Transform* t = object->transform();
+    if (nullptr != t) {
+        glm::mat4 model = t->getModelMatrix();
+        center = glm::vec3(model * glm::vec4(center, 1.0f));
+        extent = glm::abs(glm::vec3(model[0])) * extent.x
+                + glm::abs(glm::vec3(model[1])) * extent.y
+                + glm::abs(glm::vec3(model[2])) * extent.z;
+    }
+    min_corner = center - extent;
+    max_corner = center + extent;
+    return true;
+}
+
+void BVH::rebuild() {
+    leaf_objects_.clear();
+    leaf_center_.clear();
+    nodes_.clear();
+    dirty_.clear();
+    rebuild_needed_ = false;
+
+    std::vector<glm::vec3> mins, maxs;
+    glm::vec3 min_corner, max_corner;
+    for (auto it = objects_.begin(); it != objects_.end(); ++it) {
+        SceneObject* o = *it;
+        o->bvh_leaf_ = -1;
+        o->bvh_dirty_ = false;
+        if (leafBounds(o, min_corner, max_corner)) {
+            leaf_objects_.push_back(o);
+            mins.push_back(min_corner);
+            maxs.push_back(max_corner);
+            leaf_center_.push_back((min_corner + max_corner) * 0.5f);
+        }
+    }
+    int leaf_count = leaf_objects_.size();
+    leaf_node_.assign(leaf_count, -1);
+    leaf_boxes_.resize(leaf_count);
+    if (0 == leaf_count) {
+        built_area_ = 0.0f;
+        return;
+    }
+
+    // leaves are partitioned through a permutation and reordered at the end
+    std::vector<int> order(leaf_count);
+    for (int i = 0; i < leaf_count; ++i) {
+        order[i] = i;
+    }
+
+    build_stack_.clear();
+    BuildTask root = { -1, 0, leaf_count, 0 };
+    build_stack_.push_back(root);
+    while (!build_stack_.empty()) {
+        BuildTask task = build_stack_.back();
+        build_stack_.pop_back();
+
+        int index = nodes_.size();
+        nodes_.push_back(Node());
+        Node& node = nodes_.back();
+        node.first = task.first;
+        node.count = task.count;
+        node.right = -1;
+        node.parent = task.parent;
+        node.depth = task.depth;
+        if (task.parent >= 0 && index != task.parent + 1) {
+            nodes_[task.parent].right = index;
+        }
+
+        glm::vec3 centers_min(FLT_MAX), centers_max(-FLT_MAX);
+        node.min_corner = glm::vec3(FLT_MAX);
+        node.max_corner = glm::vec3(-FLT_MAX);
+        for (int i = task.first; i < task.first + task.count; ++i) {
+            int leaf = order[i];
+            node.min_corner = glm::min(node.min_corner, mins[leaf]);
+            node.max_corner = glm::max(node.max_corner, maxs[leaf]);
+            centers_min = glm::min(centers_min, leaf_center_[leaf]);
+            centers_max = glm::max(centers_max, leaf_center_[leaf]);
+        }
+
+        if (task.count <= LEAF_SIZE || task.depth + 1 >= MAX_DEPTH) {
+            for (int i = task.first; i < task.first + task.count; ++i) {
+                leaf_node_[i] = index;
+            }
+            continue;
+        }
+
+        // median split along the widest spread of centers
+        glm::vec3 spread = centers_max - centers_min;
+        int axis = (spread.x >= spread.y && spread.x >= spread.z) ? 0 :
+                   (spread.y >= spread.z) ? 1 : 2;
+        int half = task.count / 2;
+        const std::vector<glm::vec3>& centers = leaf_center_;
+        std::nth_element(order.begin() + task.first,
+                order.begin() + task.first + half,
+                order.begin() + task.first + task.count,
+                [&centers, axis](int a, int b) {
+                    return centers[a][axis] < centers[b][axis];
+                });
+
+        // right pushed first so the left child comes next in depth first order
+        BuildTask right = { index, task.first + half, task.count - half, task.depth + 1 };
+        BuildTask left = { index, task.first, half, task.depth + 1 };
+        build_stack_.push_back(right);
+        build_stack_.push_back(left);
+    }
+
+    for (int i = nodes_.size() - 1; i >= 0; --i) {
+        Node& node = nodes_[i];
+        node.skip = (node.right < 0) ? i + 1 : nodes_[node.right].skip;
+    }
+
+    std::vector<SceneObject*> objects(leaf_count);
+    std::vector<glm::vec3> centers(leaf_count);
+    for (int i = 0; i < leaf_count; ++i) {
+        int leaf = order[i];
+        objects[i] = leaf_objects_[leaf];
+        centers[i] = leaf_center_[leaf];
+        leaf_boxes_.set(i, mins[leaf], maxs[leaf]);
+        objects[i]->bvh_leaf_ = i;
+    }
+    leaf_objects_.swap(objects);
+    leaf_center_.swap(centers);
+    built_area_ = surfaceArea();
+}
+
+void BVH::refitNode(int index) {
+    Node& node = nodes_[index];
+    if (node.right < 0) {
+        node.min_corner = glm::vec3(FLT_MAX);
+        node.max_corner = glm::vec3(-FLT_MAX);
+        const BoxArrays& boxes = leaf_boxes_;
+        for (int i = node.first; i < node.first + node.count; ++i) {
+            node.min_corner = glm::min(node.min_corner,
+                    glm::vec3(boxes.min_x[i], boxes.min_y[i], boxes.min_z[i]));
+            node.max_corner = glm::max(node.max_corner,
+                    glm::vec3(boxes.max_x[i], boxes.max_y[i], boxes.max_z[i]));
+        }
+    } else {
+        const Node& left = nodes_[index + 1];
+        const Node& right = nodes_[node.right];
+        node.min_corner = glm::min(left.min_corner, right.min_corner);
+        node.max_corner = glm::max(left.max_corner, right.max_corner);
+    }
+}
+
+float BVH::surfaceArea() const {
+    float area = 0.0f;
+    for (auto it = nodes_.begin(); it != nodes_.end(); ++it) {
+        area += boxArea(it->min_corner, it->max_corner);
+    }
+    return area;
+}
+
+/*
+ * Updates the boxes of the queued leaves. Returns false when a leaf
+ * appeared or disappeared, which needs a rebuild.
+ */
+bool BVH::refit() {
+    glm::vec3 min_corner, max_corner;
+    for (auto it = dirty_.begin(); it != dirty_.end(); ++it) {
+        SceneObject* o = *it;
+        // cleared first so a move racing with the refit queues it again
+        o->bvh_dirty_ = false;
+        bool has_bounds = leafBounds(o, min_corner, max_corner);
+        int leaf = o->bvh_leaf_;
+        if (has_bounds != (leaf >= 0)) {
+            // the object gained or lost its leaf
+            rebuild_needed_ = true;
+            return false;
+        }
+        if (!has_bounds) {
+            continue;
+        }
+        leaf_boxes_.set(leaf, min_corner, max_corner);
+        leaf_center_[leaf] = (min_corner + max_corner) * 0.5f;
+    }
+
+    if (dirty_.size() * 8 > leaf_objects_.size()) {
+        // children follow their parent, so one backwards sweep refits all
+        for (int i = nodes_.size() - 1; i >= 0; --i) {
+            refitNode(i);
+        }
+    } else {
+        for (auto it = dirty_.begin(); it != dirty_.end(); ++it) {
+            int leaf = (*it)->bvh_leaf_;
+            if (leaf < 0) {
+                continue;
+            }
+            for (int node = leaf_node_[leaf]; node >= 0; node = nodes_[node].parent) {
+                refitNode(node);
+            }
+        }
+    }
+    return true;
+}
+
+void BVH::update() {
+    if (!rebuild_needed_ && !dirty_.empty()) {
+        // refitting keeps the topology, rebuild once the boxes got too loose
+        if (!refit() || surfaceArea() > 1.5f * built_area_) {
+            rebuild_needed_ = true;
+        }
+        dirty_.clear();
+    }
+    if (rebuild_needed_) {
+        rebuild();
+    }
+}
+
+void BVH::emit(int leaf, const glm::vec3& camera_position,
+        std::vector<SceneObject*>& scene_objects) {
+    SceneObject* object = leaf_objects_[leaf];
+    for (SceneObject* o = object; nullptr != o; o = o->parent()) {
+        if (!o->enabled() || !o->visible()) {
+            return;
+        }
+    }
+    RenderData* rdata = object->render_data();
+    const RenderPass* pass = rdata->pass(0);
+    if (nullptr == pass || nullptr == pass->material()) {
+        return;
+    }
+
+    glm::vec3 difference = leaf_center_[leaf] - camera_position;
+    float distance = glm::dot(difference, difference);
+    if (SceneObject::using_lod()) {
+        if (!object->inLODRange(distance)) {
+            return;
+        }
+        for (SceneObject* o = object->parent(); nullptr != o; o = o->parent()) {
+            if (nullptr != o->render_data()) {
+                glm::vec3 d = o->getBoundingVolume().center() - camera_position;
+                if (!o->inLODRange(glm::dot(d, d))) {
+                    return;
+                }
+            }
+        }
+    }
+
+    // this distance will be used when sorting transparent objects
+    rdata->set_camera_distance(distance);
+    scene_objects.push_back(object);
+}
+
+void BVH::cullSubtree(const FrustumPlanes& planes, bool need_cull,
+        const CullTask& task, const glm::vec3& camera_position,
+        std::vector<SceneObject*>& scene_objects) {
+    // plane_masks[d] holds the planes already known to contain the parent of a node at depth d
+    int plane_masks[MAX_DEPTH + 1];
+    unsigned char results[LEAF_SIZE];
+
+    const Node* nodes = nodes_.data();
+    int i = task.node;
+    int end = nodes[i].skip;
+    plane_masks[nodes[i].depth] = task.plane_mask;
+    while (i < end) {
+        const Node& node = nodes[i];
+        int plane_mask = plane_masks[node.depth];
+        int result = need_cull ?
+                classifyBox(planes, node.min_corner, node.max_corner, plane_mask) :
+                FRUSTUM_INSIDE;
+        if (FRUSTUM_OUTSIDE == result) {
+            i = node.skip;
+            continue;
+        }
+        if (FRUSTUM_INSIDE == result) {
+            for (int leaf = node.first; leaf < node.first + node.count; ++leaf) {
+                emit(leaf, camera_position, scene_objects);
+            }
+            i = node.skip;
+            continue;
+        }
+        if (node.right < 0) {
+            classifyBoxes(planes, plane_mask, leaf_boxes_, node.first, node.count, results);
+            for (int k = 0; k < node.count; ++k) {
+                if (FRUSTUM_OUTSIDE != results[k]) {
+                    emit(node.first + k, camera_position, scene_objects);
+                }
+            }
+            i = node.skip;
+            continue;
+        }
+        plane_masks[node.depth + 1] = plane_mask;
+        ++i;
+    }
+}
+
+/*
+ * Splits the top of the tree into subtrees, in depth first order, for
+ * the workers. Subtrees outside the frustum are dropped here already.
+ */
+void BVH::splitTasks(const FrustumPlanes& planes, bool need_cull,
+        int split_depth) {
+    int plane_masks[MAX_DEPTH + 1];
+    plane_masks[0] = 0;
+    tasks_.clear();
+
+    const Node* nodes = nodes_.data();
+    int node_count = nodes_.size();
+    int i = 0;
+    while (i < node_count) {
+        const Node& node = nodes[i];
+        int plane_mask = plane_masks[node.depth];
+        if (node.depth >= split_depth || node.right < 0) {
+            CullTask task = { i, plane_mask };
+            tasks_.push_back(task);
+            i = node.skip;
+            continue;
+        }
+        int result = need_cull ?
+                classifyBox(planes, node.min_corner, node.max_corner, plane_mask) :
+                FRUSTUM_INSIDE;
+        if (FRUSTUM_OUTSIDE == result) {
+            i = node.skip;
+            continue;
+        }
+        plane_masks[node.depth + 1] = plane_mask;
+        ++i;
+    }
+}
+
+/*
+ * Walks the tree again below the nodes inside the frustum. Leaves are
+ * flagged by range, since the leaves of a subtree are contiguous.
+ */
+void BVH::occlusionCull(const FrustumPlanes& planes, bool need_cull,
+        const OcclusionCuller& occlusion_culler,
+        std::vector<SceneObject*>& scene_objects, size_t first) {
+    int plane_masks[MAX_DEPTH + 1];
+    plane_masks[0] = 0;
+    leaf_occluded_.assign(leaf_objects_.size(), 0);
+
+    const Node* nodes = nodes_.data();
+    int node_count = nodes_.size();
+    int i = 0;
+    while (i < node_count) {
+        const Node& node = nodes[i];
+        int plane_mask = plane_masks[node.depth];
+        if (need_cull && FRUSTUM_OUTSIDE ==
+                classifyBox(planes, node.min_corner, node.max_corner, plane_mask)) {
+            i = node.skip;
+            continue;
+        }
+        if (occlusion_culler.isOccluded(node.min_corner, node.max_corner)) {
+            memset(&leaf_occluded_[node.first], 1, node.count);
+            i = node.skip;
+            continue;
+        }
+        if (node.right < 0) {
+            for (int leaf = node.first; leaf < node.first + node.count; ++leaf) {
+                glm::vec3 min_corner(leaf_boxes_.min_x[leaf], leaf_boxes_.min_y[leaf],
+                        leaf_boxes_.min_z[leaf]);
+                glm::vec3 max_corner(leaf_boxes_.max_x[leaf], leaf_boxes_.max_y[leaf],
+                        leaf_boxes_.max_z[leaf]);
+                leaf_occluded_[leaf] = occlusion_culler.isOccluded(min_corner, max_corner);
+            }
+            i = node.skip;
+            continue;
+        }
+        plane_masks[node.depth + 1] = plane_mask;
+        ++i;
+    }
+
+    auto end = std::remove_if(scene_objects.begin() + first, scene_objects.end(),
+            [this](SceneObject* object) {
+                return 0 != leaf_occluded_[object->bvh_leaf_];
+            });
+    scene_objects.erase(end, scene_objects.end());
+}
+
+void BVH::cull(const float frustum[6][4], bool need_cull,
+        const glm::vec3& camera_position,
+        std::vector<SceneObject*>& scene_objects,
+        OcclusionCuller* occlusion_culler) {
+    std::lock_guard < std::mutex > lock(mutex_);
+    update();
+    size_t first = scene_objects.size();
+    if (!nodes_.empty()) {
+        FrustumPlanes planes;
+        planes.set(frustum);
+        frustumCull(planes, need_cull, camera_position, scene_objects);
+
+        if (nullptr != occlusion_culler && scene_objects.size() > first
+                && occlusion_culler->rasterize(scene_objects)) {
+            occlusionCull(planes, need_cull, *occlusion_culler, scene_objects, first);
+        }
+    }
+    updateCullStatus(scene_objects, first);
+}
+
+/*
+ * Objects start out culled when inserted, so only those that appeared
+ * or disappeared since the last cull() change their flag.
+ */
+void BVH::updateCullStatus(const std::vector<SceneObject*>& scene_objects,
+        size_t first) {
+    ++cull_frame_;
+    for (auto it = scene_objects.begin() + first; it != scene_objects.end(); ++it) {
+        SceneObject* o = *it;
+        o->bvh_visible_frame_ = cull_frame_;
+        if (o->isCulled()) {
+            o->setCullStatus(false);
+        }
+    }
+    for (auto it = visible_.begin(); it != visible_.end(); ++it) {
+        if (cull_frame_ != (*it)->bvh_visible_frame_) {
+            (*it)->setCullStatus(true);
+        }
+    }
+    visible_.assign(scene_objects.begin() + first, scene_objects.end());
+}
+
+void BVH::frustumCull(const FrustumPlanes& planes, bool need_cull,
+        const glm::vec3& camera_position,
+        std::vector<SceneObject*>& scene_objects) {
+    // the LOD test computes hierarchical bounding volumes on demand, so it stays serial
+    JobSystem* jobs = JobSystem::getInstance();
+    int thread_count = jobs->worker_count() + 1;
+    if (thread_count < 2 || leaf_objects_.size() < PARALLEL_LEAVES
+            || SceneObject::using_lod()) {
+        CullTask root = { 0, 0 };
+        cullSubtree(planes, need_cull, root, camera_position, scene_objects);
+        return;
+    }
+
+    // a few subtrees per thread so stealing can even out uneven ones
+    int split_depth = 0;
+    while ((1 << split_depth) < TASKS_PER_THREAD * thread_count) {
+        ++split_depth;
+    }
+    splitTasks(planes, need_cull, split_depth);
+
+    int task_count = tasks_.size();
+    if (task_results_.size() < tasks_.size()) {
+        task_results_.resize(tasks_.size());
+    }
+    jobs->parallelFor(task_count, 1,
+            [this, &planes, need_cull, &camera_position](int begin, int end) {
+                for (int t = begin; t < end; ++t) {
+                    task_results_[t].clear();
+                    cullSubtree(planes, need_cull, tasks_[t], camera_position,
+                            task_results_[t]);
+                }
+            });
+
+    // merged in task order, which is the order of the serial walk
+    for (int t = 0; t < task_count; ++t) {
+        scene_objects.insert(scene_objects.end(), task_results_[t].begin(),
+                task_results_[t].end());
+    }
+}
+
+}
@@ -0,0 +1,182 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Bounding volume hierarchy over the renderable objects of a scene.
+ ***************************************************************************/
+
+#ifndef BVH_H_
+#define BVH_H_
+
+#include <mutex>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "engine/renderer/frustum_kernel.h"
+
+namespace gvr {
+class OcclusionCuller;
+class SceneObject;
+
+/*
+ * The leaves are the scene objects with a mesh, bounded by their own
+ * world-space mesh box, so the tree depends only on where things are and
+ * not on how the application parented them.
+ *
+ * Membership follows the scene graph: the Scene inserts its root, and
+ * SceneObject keeps children in the hierarchy of their parent. Moving an
+ * object or changing its mesh (dirtyHierarchicalBoundingVolume, which the
+ * Mesh calls for its RenderData owners) queues its leaf, and the queue
+ * is applied at the start of cull() either by refitting the boxes on the
+ * path to the root or, when leaves came or went or the refitted tree got
+ * too loose, by rebuilding.
+ *
+ * Nodes are stored depth first with an escape index, so cull() walks the
+ * tree without recursion, an explicit stack or allocation. Planes that
+ * contain a node are not tested again below it, and the leaf boxes are
+ * kept as coordinate arrays for the batched kernel in frustum_kernel.h.
+ */
+class BVH {
+public:
+    BVH();
+    ~BVH();
+
+    /*
+     * Adds the object and all its descendants.
+     */
+    void insert(SceneObject* object);
+
+    /*
+     * Removes the object and all its descendants.
+     */
+    void remove(SceneObject* object);
+
+    /*
+     * Removes every object.
+     */
+    void clear();
+
+    /*
+     * Queues the object's leaf for a refit. Cheap if already queued.
+     */
+    void markDirty(SceneObject* object);
+
+    /*
+     * Appends the objects to render, in tree order, and sets their camera
+     * distance. The objects returned are the ones not culled; the cull
+     * status changes only for those that came or went since the last call. With need_cull false every enabled object is returned.
+     * Large trees are split into subtrees culled on the JobSystem; the
+     * per-subtree lists are merged in tree order, so the result does
+     * not depend on the number of threads.
+     *
+     * With an occlusion culler, the occluders among the objects found
+     * are rasterized and the tree is walked again, dropping every
+     * subtree whose box is hidden behind them.
+     */
+    void cull(const float frustum[6][4], bool need_cull,
+            const glm::vec3& camera_position,
+            std::vector<SceneObject*>& scene_objects,
+            OcclusionCuller* occlusion_culler = nullptr);
+
+    int leaf_count() const {
+        return leaf_objects_.size();
+    }
+
+    int node_count() const {
+        return nodes_.size();
+    }
+
+private:
+    BVH(const BVH& bvh);
+    BVH(BVH&& bvh);
+    BVH& operator=(const BVH& bvh);
+    BVH& operator=(BVH&& bvh);
+
+    struct Node {
+        glm::vec3 min_corner;
+        int       first;     // first leaf of the subtree
+        glm::vec3 max_corner;
+        int       count;     // number of leaves in the subtree
+        int       right;     // right child, the left one follows directly; -1 for leaves
+        int       skip;      // next node once this subtree is done
+        int       parent;
+        int       depth;
+    };
+
+    struct CullTask {
+        int node;
+        int plane_mask;     // planes containing the node's parent
+    };
+
+    struct BuildTask {
+        int parent;
+        int first;
+        int count;
+        int depth;
+    };
+
+    static const int LEAF_SIZE = 8;
+    // median splits keep the depth at log2 of the leaf count
+    static const int MAX_DEPTH = 64;
+    // below this many leaves a single thread is faster than handing out work
+    static const size_t PARALLEL_LEAVES = 2048;
+    static const int TASKS_PER_THREAD = 4;
+
+    void collect(SceneObject* object, std::vector<SceneObject*>& objects);
+    void update();
+    void rebuild();
+    bool refit();
+    void refitNode(int node);
+    float surfaceArea() const;
+    bool leafBounds(SceneObject* object, glm::vec3& min_corner,
+            glm::vec3& max_corner);
+    void splitTasks(const FrustumPlanes& planes, bool need_cull, int split_depth);
+    void cullSubtree(const FrustumPlanes& planes, bool need_cull,
+            const CullTask& task, const glm::vec3& camera_position,
+            std::vector<SceneObject*>& scene_objects);
+    void emit(int leaf, const glm::vec3& camera_position,
+            std::vector<SceneObject*>& scene_objects);
+    void frustumCull(const FrustumPlanes& planes, bool need_cull,
+            const glm::vec3& camera_position,
+            std::vector<SceneObject*>& scene_objects);
+    void occlusionCull(const FrustumPlanes& planes, bool need_cull,
+            const OcclusionCuller& occlusion_culler,
+            std::vector<SceneObject*>& scene_objects, size_t first);
+    void updateCullStatus(const std::vector<SceneObject*>& scene_objects, size_t first);
+
+private:
+    std::mutex                mutex_;
+    std::vector<SceneObject*> objects_;
+    std::vector<SceneObject*> dirty_;
+    bool                      rebuild_needed_;
+    float                     built_area_;
+
+    std::vector<Node>         nodes_;
+    std::vector<SceneObject*> leaf_objects_;
+    BoxArrays                 leaf_boxes_;
+    std::vector<glm::vec3>    leaf_center_;
+    std::vector<int>          leaf_node_;
+    std::vector<BuildTask>    build_stack_;
+    std::vector<CullTask>     tasks_;
+    std::vector<std::vector<SceneObject*> > task_results_;
+    std::vector<unsigned char> leaf_occluded_;
+    // what the last cull() returned, stamped with its number
+    std::vector<SceneObject*> visible_;
+    unsigned int              cull_frame_;
+};
+
+}
+#endif
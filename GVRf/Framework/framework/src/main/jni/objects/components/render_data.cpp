@@ -16,10 +16,13 @@
 
 #include "objects/hybrid_object.h"
 #include "objects/components/render_data.h"
+#include "objects/render_data_state.h"
+#include "objects/scene_object.h"
 
 namespace gvr {
 
 RenderData::~RenderData() {
+    *mesh_listener_ = nullptr;
 }
 
 void RenderData::add_pass(RenderPass* render_pass) {
@@ -36,9 +39,25 @@ const RenderPass* RenderData::pass(int pass) const {
 }
 
 void RenderData::set_mesh(Mesh* mesh) {
-    mesh_ = mesh;
+    if (mesh_ != mesh) {
+        // the previous mesh drops the old listener the next time its bounds change
+        *mesh_listener_ = nullptr;
+        mesh_ = mesh;
+        listenToMesh();
+    }
     mesh->add_dirty_flag(dirty_flag_);
     *dirty_flag_ = true;
+    // a mesh set once the object is in a scene gives it a new leaf box
+    if (nullptr != owner_object()) {
+        owner_object()->dirtyHierarchicalBoundingVolume();
+    }
+}
+
+void RenderData::listenToMesh() {
+    mesh_listener_ = std::make_shared<RenderData*>(this);
+    if (nullptr != mesh_) {
+        mesh_->add_bounds_listener(mesh_listener_);
+    }
 }
 
 void RenderData::setDirty(bool dirty){
@@ -49,7 +68,7 @@ bool RenderData::cull_face(int pass) const {
     if (pass >= 0 && pass < render_pass_list_.size()) {
         return render_pass_list_[pass]->cull_face();
     }
-    return nullptr;
+    return false;
 }
 
 Material* RenderData::material(int pass) const {
@@ -59,48 +78,26 @@ Material* RenderData::material(int pass) const {
     return nullptr;
 }
 
+void RenderData::updateStateId() {
+    RenderDataState state;
+    state.light = light_;
+    state.offset_factor = offset_factor_;
+    state.offset_units = offset_units_;
+    state.sample_coverage = sample_coverage_;
+    state.draw_mode = draw_mode_;
+    state.render_mask = render_mask_;
+    state.use_light = use_light_;
+    state.use_lightmap = use_lightmap_;
+    state.offset = offset_;
+    state.depth_test = depth_test_;
+    state.alpha_blend = alpha_blend_;
+    state.alpha_to_coverage = alpha_to_coverage_;
+    state.invert_coverage_mask = invert_coverage_mask_;
+    state_id_ = RenderDataStateTable::getInstance()->intern(state);
+}
+
 void RenderData::setCameraDistanceLambda(std::function<float()> func) {
     cameraDistanceLambda_ = func;
 }
 
-bool compareRenderDataByOrderShaderDistance(RenderData *i, RenderData *j) {
-    //1. rendering order needs to be sorted first to guarantee specified correct order
-    if (i->rendering_order() == j->rendering_order()) {
-
-        if (i->material(0)->shader_type() == j->material(0)->shader_type()) {
-
-            // if it is a transparent object, sort by camera distance from back to front
-            if (i->rendering_order() >= RenderData::Transparent
-                && i->rendering_order() < RenderData::Overlay) {
-                return i->camera_distance() > j->camera_distance();
-            }
-
-            int no_passes1 = i->pass_count();
-            int no_passes2 = j->pass_count();
-
-            if (no_passes1 == no_passes2) {
-
-                //@todo what about the other passes
-
-                //this is pointer comparison; assumes batching is on; if the materials are not
-                //the same then comparing the pointers further is an arbitrary decision; hence
-                //falling back to camera distance.
-                if (i->material(0) == j->material(0)) {
-                    if (i->cull_face(0) == j->cull_face(0)) {
-                        if (i->getHashCode().compare(j->getHashCode()) == 0) {
-                            // otherwise sort from front to back
-                            return i->camera_distance() < j->camera_distance();
-                        }
-                        return i->getHashCode() < j->getHashCode();
-                    }
-                    return i->cull_face(0) < j->cull_face(0);
-                }
-                return i->material(0) < j->material(0);
-            }
-            return no_passes1 < no_passes2;
-        }
-        return i->material(0)->shader_type() < j->material(0)->shader_type();
-    }
-    return i->rendering_order() < j->rendering_order();
-}
 }
\ No newline at end of file
@@ -21,6 +21,7 @@
 #define RENDER_DATA_H_
 
 #include <memory>
+#include <functional>
 #include <vector>
 
 #include "gl/gl_program.h"
@@ -39,17 +40,6 @@ class Batch;
 class TextureCapturer;
 class RenderPass;
 
-template<typename T> std::string to_string(T value) {
-    //create an output string stream
-    std::ostringstream os;
-
-    //throw the value into the string stream
-    os << value;
-
-    //convert the string stream into a string and return
-    return os.str();
-}
-
 class RenderData: public Component {
 public:
     enum Queue {
@@ -65,19 +55,21 @@ public:
     };
 
     RenderData() :
-            Component(RenderData::getComponentType()), mesh_(0), light_(0),
-                    use_light_(false), use_lightmap_(false), batching_(true),
-                    render_mask_(DEFAULT_RENDER_MASK), batch_(nullptr),
-                    rendering_order_(DEFAULT_RENDERING_ORDER), hash_code_dirty_(true),
+            Component(RenderData::getComponentType()), mesh_(0), batch_(nullptr),
+                    uniform_slot_(-1), state_id_(-1), state_changed_(true), light_(0),
+                    dirty_flag_(std::make_shared<bool>(true)),
+                    mesh_listener_(std::make_shared<RenderData*>(this)), use_light_(false),
+                    batching_(true), use_lightmap_(false), render_mask_(DEFAULT_RENDER_MASK),
+                    rendering_order_(DEFAULT_RENDERING_ORDER),
                     offset_(false), offset_factor_(0.0f), offset_units_(0.0f),
                     depth_test_(true), alpha_blend_(true), alpha_to_coverage_(false),
-                    sample_coverage_(1.0f), invert_coverage_mask_(GL_FALSE), draw_mode_(GL_TRIANGLES),
-                    texture_capturer(0), cast_shadows_(true), dirty_flag_(std::make_shared<bool>(true)) {
+                    cast_shadows_(true), occluder_(false), sample_coverage_(1.0f),
+                    invert_coverage_mask_(GL_FALSE), draw_mode_(GL_TRIANGLES), texture_capturer(0) {
     }
 
     void copy(const RenderData& rdata) {
         Component(rdata.getComponentType());
-        hash_code = rdata.hash_code;
+        state_id_ = rdata.state_id_;
         mesh_ = rdata.mesh_;
         light_ = rdata.light_;
         use_light_ = rdata.use_light_;
@@ -85,12 +77,13 @@ public:
         batching_ = rdata.batching_;
         render_mask_ = rdata.render_mask_;
         cast_shadows_ = rdata.cast_shadows_;
+        occluder_ = rdata.occluder_;
         batch_ = rdata.batch_;
         for(int i=0;i<rdata.render_pass_list_.size();i++) {
             render_pass_list_.push_back((rdata.render_pass_list_)[i]);
         }
         rendering_order_ = rdata.rendering_order_;
-        hash_code_dirty_ = rdata.hash_code_dirty_;
+        state_changed_ = rdata.state_changed_;
         offset_ = rdata.offset_;
         offset_factor_ = rdata.offset_factor_;
         offset_units_ = rdata.offset_units_;
@@ -102,6 +95,7 @@ public:
         draw_mode_ = rdata.draw_mode_;
         texture_capturer = rdata.texture_capturer;
         dirty_flag_ = rdata.dirty_flag_;
+        listenToMesh();
     }
 
     RenderData(const RenderData& rdata) {
@@ -142,17 +136,17 @@ public:
     void set_light(Light* light) {
         light_ = light;
         use_light_ = true;
-        hash_code_dirty_ = true;
+        markStateDirty();
     }
 
     void enable_light() {
         use_light_ = true;
-        hash_code_dirty_ = true;
+        markStateDirty();
     }
 
     void disable_light() {
         use_light_ = false;
-        hash_code_dirty_ = true;
+        markStateDirty();
     }
 
     bool light_enabled() {
@@ -161,12 +155,12 @@ public:
 
     void enable_lightmap() {
         use_lightmap_ = true;
-        hash_code_dirty_ = true;
+        markStateDirty();
     }
 
     void disable_lightmap() {
         use_lightmap_ = false;
-        hash_code_dirty_ = true;
+        markStateDirty();
     }
 
     int render_mask() const {
@@ -175,7 +169,7 @@ public:
 
     void set_render_mask(int render_mask) {
         render_mask_ = render_mask;
-        hash_code_dirty_ = true;
+        markStateDirty();
     }
 
     int rendering_order() const {
@@ -194,6 +188,15 @@ public:
         cast_shadows_ = cast_shadows;
     }
 
+    // rasterized for occlusion culling when the scene has it enabled
+    bool is_occluder() const {
+        return occluder_;
+    }
+
+    void set_occluder(bool occluder) {
+        occluder_ = occluder;
+    }
+
     Batch* getBatch() {
         return batch_;
     }
@@ -214,6 +217,15 @@ public:
         batch_ = nullptr;
     }
 
+    // slot of the per object uniforms, see UniformBlocks
+    int uniform_slot() const {
+        return uniform_slot_;
+    }
+
+    void set_uniform_slot(int slot) {
+        uniform_slot_ = slot;
+    }
+
     bool cull_face(int pass=0) const ;
 
     bool offset() const {
@@ -222,7 +234,7 @@ public:
 
     void set_offset(bool offset) {
         offset_ = offset;
-        hash_code_dirty_ = true;
+        markStateDirty();
     }
 
     float offset_factor() const {
@@ -231,7 +243,7 @@ public:
 
     void set_offset_factor(float offset_factor) {
         offset_factor_ = offset_factor;
-        hash_code_dirty_ = true;
+        markStateDirty();
     }
 
     float offset_units() const {
@@ -240,7 +252,7 @@ public:
 
     void set_offset_units(float offset_units) {
         offset_units_ = offset_units;
-        hash_code_dirty_ = true;
+        markStateDirty();
     }
 
     bool depth_test() const {
@@ -249,7 +261,7 @@ public:
 
     void set_depth_test(bool depth_test) {
         depth_test_ = depth_test;
-        hash_code_dirty_ = true;
+        markStateDirty();
     }
 
     bool alpha_blend() const {
@@ -258,7 +270,7 @@ public:
 
     void set_alpha_blend(bool alpha_blend) {
         alpha_blend_ = alpha_blend;
-        hash_code_dirty_ = true;
+        markStateDirty();
     }
 
     bool alpha_to_coverage() const {
@@ -267,12 +279,12 @@ public:
 
     void set_alpha_to_coverage(bool alpha_to_coverage) {
         alpha_to_coverage_ = alpha_to_coverage;
-        hash_code_dirty_ = true;
+        markStateDirty();
     }
 
     void set_sample_coverage(float sample_coverage) {
         sample_coverage_ = sample_coverage;
-        hash_code_dirty_ = true;
+        markStateDirty();
     }
    
     float sample_coverage() const {
@@ -281,7 +293,7 @@ public:
 
     void set_invert_coverage_mask(GLboolean invert_coverage_mask) {
         invert_coverage_mask_ = invert_coverage_mask;
-        hash_code_dirty_ = true;
+        markStateDirty();
     }
 
     GLboolean invert_coverage_mask() const {
@@ -300,51 +312,59 @@ public:
         return camera_distance_;
     }
 
+    void set_camera_distance(float distance) {
+        camera_distance_ = distance;
+        cameraDistanceLambda_ = nullptr;
+    }
+
     void set_draw_mode(GLenum draw_mode) {
         draw_mode_ = draw_mode;
-        hash_code_dirty_ = true;
+        markStateDirty();
+    }
+
+    /*
+     * True when a state setter ran since clearStateChanged, e.g. since
+     * the render data was added to its batch.
+     */
+    bool isStateChanged() const {
+        return state_changed_;
     }
 
-    bool isHashCodeDirty()  {
-        return hash_code_dirty_;
+    void clearStateChanged() {
+        state_changed_ = false;
     }
 
     void set_texture_capturer(TextureCapturer *capturer) {
         texture_capturer = capturer;
     }
-    // TODO: need to consider texture_capturer in hash_code ?
+    // TODO: need to consider texture_capturer in the render state ?
     TextureCapturer *get_texture_capturer() {
         return texture_capturer;
     }
 
-    std::string getHashCode() {
-        if (hash_code_dirty_) {
-            std::string render_data_string;
-            render_data_string.append(to_string(use_light_));
-            render_data_string.append(to_string(light_));
-            render_data_string.append(to_string(getComponentType()));
-            render_data_string.append(to_string(use_lightmap_));
-            render_data_string.append(to_string(render_mask_));
-            render_data_string.append(to_string(offset_));
-            render_data_string.append(to_string(offset_factor_));
-            render_data_string.append(to_string(offset_units_));
-            render_data_string.append(to_string(depth_test_));
-            render_data_string.append(to_string(alpha_blend_));
-            render_data_string.append(to_string(alpha_to_coverage_));
-            render_data_string.append(to_string(sample_coverage_));
-            render_data_string.append(to_string(invert_coverage_mask_));
-            render_data_string.append(to_string(draw_mode_));
-
-            hash_code = render_data_string;
-            hash_code_dirty_ = false;
-
+    /*
+     * Id of the GL state this render data draws with, interned in the
+     * RenderDataStateTable: equal ids mean equal state. Recomputed on
+     * the first call after a setter changed the state.
+     */
+    int state_id() {
+        if (state_id_ < 0) {
+            updateStateId();
         }
-        return hash_code;
+        return state_id_;
     }
 
     void setCameraDistanceLambda(std::function<float()> func);
 
 private:
+    void markStateDirty() {
+        state_id_ = -1;
+        state_changed_ = true;
+    }
+
+    void updateStateId();
+    void listenToMesh();
+
     //  RenderData(const RenderData& render_data);
     RenderData(RenderData&& render_data);
     RenderData& operator=(const RenderData& render_data);
@@ -355,11 +375,14 @@ private:
     static const int DEFAULT_RENDERING_ORDER = Geometry;
     Mesh* mesh_;
     Batch* batch_;
-    bool hash_code_dirty_;
-    std::string hash_code;
+    int uniform_slot_;
+    int state_id_;
+    bool state_changed_;
     std::vector<RenderPass*> render_pass_list_;
     Light* light_;
     std::shared_ptr<bool> dirty_flag_;
+    // points back here while mesh_ keeps it, see Mesh::add_bounds_listener
+    std::shared_ptr<RenderData*> mesh_listener_;
     bool use_light_;
     bool batching_;
     bool use_lightmap_;
@@ -372,6 +395,7 @@ private:
     bool alpha_blend_;
     bool alpha_to_coverage_;
     bool cast_shadows_;
+    bool occluder_;
     float sample_coverage_;
     GLboolean invert_coverage_mask_;
     GLenum draw_mode_;
@@ -380,7 +404,5 @@ private:
 
     std::function<float()> cameraDistanceLambda_ = nullptr;
 };
-
-bool compareRenderDataByOrderShaderDistance(RenderData* i, RenderData* j);
 }
 #endif
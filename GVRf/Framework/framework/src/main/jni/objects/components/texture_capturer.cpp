@@ -13,6 +13,8 @@
 #include "objects/mesh.h"
 #include "util/gvr_log.h"
 #include "util/gvr_time.h"
+#include "gl/gl_readback.h"
+#include "gl/gl_state_cache.h"
 
 #define TOL 1e-8
 
@@ -74,6 +76,11 @@ bool TextureCapturer::getAndClearPendingCapture() {
         }
     }
 
+    // with every readback buffer in flight, capture in a later frame rather than wait
+    if (mPendingCapture && GLReadback::getInstance()->full()) {
+        return false;
+    }
+
     bool rv = mPendingCapture;
     mPendingCapture = false;
     return rv;
@@ -91,11 +98,11 @@ void TextureCapturer::beginCapture() {
     // Setup FBO
     glBindFramebuffer(GL_DRAW_FRAMEBUFFER, mRenderTexture->getFrameBufferId());
 
-    glDisable(GL_CULL_FACE);
-    glEnable (GL_BLEND);
-    glBlendEquation (GL_FUNC_ADD);
-    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
-    glDisable (GL_POLYGON_OFFSET_FILL);
+    GLStateCache::getInstance()->disable(GL_CULL_FACE);
+    GLStateCache::getInstance()->enable(GL_BLEND);
+    GLStateCache::getInstance()->blendEquation(GL_FUNC_ADD);
+    GLStateCache::getInstance()->blendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    GLStateCache::getInstance()->disable(GL_POLYGON_OFFSET_FILL);
 
     // Setup viewport
     glViewport(0, 0, mRenderTexture->width(), mRenderTexture->height());
@@ -118,19 +125,19 @@ void TextureCapturer::endCapture() {
               mSavedScissor[2], mSavedScissor[3]);
 
     if (mIsCullFace)
-        glEnable(GL_CULL_FACE);
+        GLStateCache::getInstance()->enable(GL_CULL_FACE);
     else
-        glDisable(GL_CULL_FACE);
+        GLStateCache::getInstance()->disable(GL_CULL_FACE);
 
     if (mIsBlend)
-        glEnable(GL_BLEND);
+        GLStateCache::getInstance()->enable(GL_BLEND);
     else
-        glDisable(GL_BLEND);
+        GLStateCache::getInstance()->disable(GL_BLEND);
 
     if (mIsPolygonOffsetFill)
-        glEnable(GL_POLYGON_OFFSET_FILL);
+        GLStateCache::getInstance()->enable(GL_POLYGON_OFFSET_FILL);
     else
-        glDisable(GL_POLYGON_OFFSET_FILL);
+        GLStateCache::getInstance()->disable(GL_POLYGON_OFFSET_FILL);
 }
 
 void TextureCapturer::render(RenderState* rstate, RenderData* render_data) {
@@ -26,27 +26,43 @@
 namespace gvr {
 
 Transform::Transform() :
-        Component(Transform::getComponentType()), position_(glm::vec3(0.0f, 0.0f, 0.0f)), rotation_(
-                glm::quat(1.0f, 0.0f, 0.0f, 0.0f)), scale_(
-                glm::vec3(1.0f, 1.0f, 1.0f)), model_matrix_(
-                Lazy<glm::mat4>(glm::mat4())) {
+        Component(Transform::getComponentType()),
+        slot_(TransformStore::getInstance()->allocate(this)),
+        position_(TransformStore::getInstance()->position(slot_)),
+        rotation_(TransformStore::getInstance()->rotation(slot_)),
+        scale_(TransformStore::getInstance()->scale(slot_)) {
 }
 
 Transform::~Transform() {
+    TransformStore::getInstance()->release(slot_);
 }
 
-void Transform::invalidate(bool rotationUpdated) {
-    owner_object()->setTransformDirty();
-    if (model_matrix_.isValid()) {
-        model_matrix_.invalidate();
-        std::vector<SceneObject*> childrenCopy = owner_object()->children();
-        for (auto it = childrenCopy.begin(); it != childrenCopy.end(); ++it) {
-            Transform* const t = (*it)->transform();
-            if (nullptr != t) {
-                t->invalidate(false);
-            }
+void Transform::set_owner_object(SceneObject* owner_object) {
+    TransformStore* store = TransformStore::getInstance();
+    Component::set_owner_object(owner_object);
+    if (nullptr == owner_object) {
+        store->detachChildren(slot_);
+        store->setParent(slot_, TransformStore::NO_SLOT);
+        return;
+    }
+
+    SceneObject* parent = owner_object->parent();
+    set_parent((nullptr != parent) ? parent->transform() : nullptr);
+    std::vector<SceneObject*> children = owner_object->children();
+    for (auto it = children.begin(); it != children.end(); ++it) {
+        Transform* const t = (*it)->transform();
+        if (nullptr != t) {
+            t->set_parent(this);
         }
     }
+}
+
+void Transform::set_parent(Transform* parent) {
+    TransformStore::getInstance()->setParent(slot_,
+            (nullptr != parent) ? parent->slot_ : TransformStore::NO_SLOT);
+}
+
+void Transform::invalidate(bool rotationUpdated) {
     if (rotationUpdated) {
         // scale rotation_ if needed to avoid overflow
         static const float threshold = sqrt(FLT_MAX) / 2.0f;
@@ -59,41 +75,15 @@ void Transform::invalidate(bool rotationUpdated) {
             rotation_.z *= scale_factor;
         }
     }
-
-    if(owner_object()) {
-        owner_object()->dirtyHierarchicalBoundingVolume();
-    }
+    TransformStore::getInstance()->invalidate(slot_);
 }
 
 glm::mat4 Transform::getModelMatrix() {
-    if (!model_matrix_.isValid()) {
-        glm::mat4 translation_matrix = glm::translate(glm::mat4(), position_);
-        glm::mat4 rotation_matrix = glm::mat4_cast(rotation_);
-        glm::mat4 scale_matrix = glm::scale(glm::mat4(), scale_);
-
-        glm::mat4 trs_matrix = translation_matrix * rotation_matrix
-                * scale_matrix;
-        if (owner_object()->parent() != 0) {
-            Transform* const t = owner_object()->parent()->transform();
-            if (nullptr != t) {
-                glm::mat4 model_matrix = t->getModelMatrix() * trs_matrix;
-                model_matrix_.validate(model_matrix);
-            }
-        } else {
-            model_matrix_.validate(trs_matrix);
-        }
-
-    }
-    return model_matrix_.element();
+    return TransformStore::getInstance()->worldMatrix(slot_);
 }
 
 glm::mat4 Transform::getLocalModelMatrix() {
-    glm::mat4 translation_matrix = glm::translate(glm::mat4(), position_);
-    glm::mat4 rotation_matrix = glm::mat4_cast(rotation_);
-    glm::mat4 scale_matrix = glm::scale(glm::mat4(), scale_);
-    glm::mat4 trs_matrix = translation_matrix * rotation_matrix
-            * scale_matrix;
-    return trs_matrix;
+    return TransformStore::getInstance()->localMatrix(slot_);
 }
 
 void Transform::setModelMatrix(glm::mat4 matrix) {
@@ -27,15 +27,32 @@
 #include "glm/gtx/quaternion.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 
-#include "objects/lazy.h"
+#include "objects/transform_store.h"
 #include "objects/components/component.h"
 
 namespace gvr {
+/*
+ * A handle to one slot of the TransformStore. The local position,
+ * rotation and scale are references into the store; the world matrix is
+ * resolved there, either per frame for the whole scene or lazily here.
+ */
 class Transform: public Component {
 public:
     Transform();
     virtual ~Transform();
 
+    virtual void set_owner_object(SceneObject* owner_object);
+
+    int slot() const {
+        return slot_;
+    }
+
+    /*
+     * Follows the owner's parent scene object: re-links this slot under
+     * the parent's transform, or makes it a root for nullptr.
+     */
+    void set_parent(Transform* parent);
+
     static long long getComponentType() {
         return COMPONENT_TYPE_TRANSFORM;
     }
@@ -175,7 +192,7 @@ public:
     }
 
     bool isModelMatrixValid() {
-        return model_matrix_.isValid();
+        return TransformStore::getInstance()->isWorldMatrixValid(slot_);
     }
 
     void invalidate(bool rotationUpdated);
@@ -198,11 +215,10 @@ private:
     Transform& operator=(Transform&& transform);
 
 private:
-    glm::vec3 position_;
-    glm::quat rotation_;
-    glm::vec3 scale_;
-
-    Lazy<glm::mat4> model_matrix_;
+    int slot_;
+    glm::vec3& position_;
+    glm::quat& rotation_;
+    glm::vec3& scale_;
 };
 
 }
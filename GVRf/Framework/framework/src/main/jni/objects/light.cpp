@@ -21,6 +21,7 @@
 #include "gl/gl_frame_buffer.h"
 #include "glm/gtc/type_ptr.hpp"
 #include "glm/gtc/matrix_access.hpp"
+#include "gl/gl_state_cache.h"
 
 namespace gvr {
 const int Light::SHADOW_MAP_SIZE = 1024;
@@ -163,9 +164,8 @@ void Light::render(int program, int texIndex) {
  * bind the shadow map texture to the shader and
  * set the shadow_map_index with the index of the map.
  */
-void Light::bindShadowMap(int program, int texIndex) {
+void Light::bindShadowMap(int loc, int texIndex) {
     GLTexture* shadowmap = depth_texture_;
-    int loc = glGetUniformLocation(program, "u_shadow_maps");
 
     if ((loc >= 0) && depth_texture_) {
         //LOGD("LIGHT: found shadow map in shader %d\n", loc);
@@ -174,8 +174,8 @@ void Light::bindShadowMap(int program, int texIndex) {
             throw error;
         }
         else {
-            glActiveTexture(GL_TEXTURE0 + texIndex);
-            glBindTexture(GL_TEXTURE_2D_ARRAY, depth_texture_->id());
+            GLStateCache::getInstance()->activeTexture(GL_TEXTURE0 + texIndex);
+            GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D_ARRAY, depth_texture_->id());
             glPixelStorei(GL_PACK_ALIGNMENT, 1);
         }
         glUniform1i(loc, texIndex);
@@ -222,13 +222,13 @@ bool Light::generateFBO() {
 
 void Light::createDepthTexture(int width, int height, int depth) {
     depth_texture_ = new GLTexture(GL_TEXTURE_2D_ARRAY);
-    glBindTexture(GL_TEXTURE_2D_ARRAY, depth_texture_->id());
+    GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D_ARRAY, depth_texture_->id());
     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
  //   glTexImage3D(GL_TEXTURE_2D_ARRAY,0,GL_RGB8, width,height,depth,0,GL_RGB, GL_UNSIGNED_BYTE,NULL);
  //   glTexImage3D(GL_TEXTURE_2D_ARRAY,0,GL_R16F, width,height,depth,0,GL_RED, GL_HALF_FLOAT,NULL);  // it does not for S6 edge
  //   glTexImage3D(GL_TEXTURE_2D_ARRAY,0,GL_RGB10_A2, width,height,depth,0,GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV,NULL);
     glTexImage3D(GL_TEXTURE_2D_ARRAY,0,GL_RGBA8, width,height,depth,0,GL_RGBA, GL_UNSIGNED_BYTE,NULL);
-    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D_ARRAY, 0);
     checkGlError("Light::createDepthTexture");
 #ifdef DEBUG_LIGHT
     LOGD("LIGHT: create shadow map depth texture %d", depth_texture_->id());
@@ -244,6 +244,7 @@ void Light::deleteDepthTexture()
         LOGD("LIGHT: delete shadow map depth texture %d", id);
 #endif
         glDeleteTextures(1,&id);
+        GLStateCache::getInstance()->invalidate();
         delete depth_texture_;
         depth_texture_ = nullptr;
     }
@@ -167,8 +167,9 @@ public:
     /**
      * Internal function called during rendering to bind the shadow map
      * framebuffer to the texture for this light.
+     * @param location  location of u_shadow_maps in the shader program
      */
-    static void bindShadowMap(int program, int texIndex);
+    static void bindShadowMap(int location, int texIndex);
 
     /***
      * Creates the storage for shadow maps
@@ -20,14 +20,18 @@
 #ifndef MATERIAL_H_
 #define MATERIAL_H_
 
+#include <atomic>
+#include <cstring>
 #include <map>
 #include <memory>
 #include <unordered_set>
 #include <string>
+#include <vector>
 
 #include "glm/glm.hpp"
 
 #include "objects/hybrid_object.h"
+#include "objects/material_layout.h"
 #include "objects/textures/texture.h"
 #include "objects/components/render_data.h"
 #include "objects/helpers.h"
@@ -61,16 +65,15 @@ public:
     explicit Material(ShaderType shader_type) :
             shader_type_(shader_type),
             textures_(),
-            floats_(),
-            vec2s_(),
-            vec3s_(),
-            vec4s_(),
-            shader_feature_set_(0)
+            block_(nullptr),
+            shader_feature_set_(0),
+            sort_id_(nextSortId())
     {
+        setLayout(layoutFor(shader_type));
         switch (shader_type) {
         default:
-            vec3s_["color"] = glm::vec3(1.0f, 1.0f, 1.0f);
-            floats_["opacity"] = 1.0f;
+            setVec3(colorSlot(), glm::vec3(1.0f, 1.0f, 1.0f));
+            setFloat(opacitySlot(), 1.0f);
             break;
         }
     }
@@ -82,7 +85,18 @@ public:
         return shader_type_;
     }
 
+    /*
+     * Small id that groups render data sharing this material in the
+     * render sort key; see makeRenderSortKey.
+     */
+    unsigned int sort_id() const {
+        return sort_id_;
+    }
+
     void set_shader_type(ShaderType shader_type) {
+        if (shader_type != shader_type_) {
+            setLayout(layoutFor(shader_type));
+        }
         shader_type_ = shader_type;
         dirty();
     }
@@ -120,97 +134,159 @@ public:
         dirty();
     }
 
-    float getFloat(const std::string& key) {
-        auto it = floats_.find(key);
-        if (it != floats_.end()) {
-            return it->second;
-        } else {
-            std::string error = "Material::getFloat() : " + key + " not found";
-            throw error;
-        }
+    /*
+     * Parameters by name, for the Java side and setup code. The name is
+     * looked up in the MaterialLayout without a lock; getters throw if the
+     * material does not have the parameter.
+     */
+    float getFloat(const std::string& key) const {
+        return getParam<float>(find(key, MaterialLayout::FLOAT), "getFloat", key);
     }
     void setFloat(const std::string& key, float value) {
-        floats_[key] = value;
-        dirty();
+        setParam(declare(key, MaterialLayout::FLOAT), value);
     }
 
-    glm::vec2 getVec2(const std::string& key) {
-        auto it = vec2s_.find(key);
-        if (it != vec2s_.end()) {
-            return it->second;
-        } else {
-            std::string error = "Material::getVec2() : " + key + " not found";
-            throw error;
-        }
+    glm::vec2 getVec2(const std::string& key) const {
+        return getParam<glm::vec2>(find(key, MaterialLayout::VEC2), "getVec2", key);
     }
-
     void setVec2(const std::string& key, glm::vec2 vector) {
-        vec2s_[key] = vector;
-        dirty();
+        setParam(declare(key, MaterialLayout::VEC2), vector);
     }
 
-    glm::vec3 getVec3(const std::string& key) {
-        auto it = vec3s_.find(key);
-        if (it != vec3s_.end()) {
-            return it->second;
-        } else {
-            std::string error = "Material::getVec3() : " + key + " not found";
-            throw error;
-        }
+    glm::vec3 getVec3(const std::string& key) const {
+        return getParam<glm::vec3>(find(key, MaterialLayout::VEC3), "getVec3", key);
     }
-
     void setVec3(const std::string& key, glm::vec3 vector) {
-        vec3s_[key] = vector;
-        dirty();
+        setParam(declare(key, MaterialLayout::VEC3), vector);
     }
 
-    glm::vec4 getVec4(const std::string& key) {
-        auto it = vec4s_.find(key);
-        if (it != vec4s_.end()) {
-            return it->second;
-        } else {
-            std::string error = "Material::getVec4() : " + key + " not found";
-            throw error;
-        }
+    glm::vec4 getVec4(const std::string& key) const {
+        return getParam<glm::vec4>(find(key, MaterialLayout::VEC4), "getVec4", key);
     }
-
     void setVec4(const std::string& key, glm::vec4 vector) {
-        vec4s_[key] = vector;
-        dirty();
+        setParam(declare(key, MaterialLayout::VEC4), vector);
     }
 
-    glm::mat4 getMat4(const std::string& key) {
-        auto it = mat4s_.find(key);
-        if (it != mat4s_.end()) {
-            return it->second;
-        } else {
-            std::string error = "Material::getMat4() : " + key + " not found";
-            throw error;
-        }
+    glm::mat4 getMat4(const std::string& key) const {
+        return getParam<glm::mat4>(find(key, MaterialLayout::MAT4), "getMat4", key);
+    }
+    void setMat4(const std::string& key, glm::mat4 matrix) {
+        setParam(declare(key, MaterialLayout::MAT4), matrix);
+    }
+
+    /*
+     * Lookups for the draw path: NULL when the material does not have
+     * the key (yet), instead of throwing like the getters above.
+     */
+    const float* getFloatNoError(const std::string& key) const {
+        return findParam<float>(find(key, MaterialLayout::FLOAT));
+    }
+    const glm::vec2* getVec2NoError(const std::string& key) const {
+        return findParam<glm::vec2>(find(key, MaterialLayout::VEC2));
+    }
+    const glm::vec3* getVec3NoError(const std::string& key) const {
+        return findParam<glm::vec3>(find(key, MaterialLayout::VEC3));
+    }
+    const glm::vec4* getVec4NoError(const std::string& key) const {
+        return findParam<glm::vec4>(find(key, MaterialLayout::VEC4));
+    }
+    const glm::mat4* getMat4NoError(const std::string& key) const {
+        return findParam<glm::mat4>(find(key, MaterialLayout::MAT4));
+    }
+
+    /*
+     * Parameters by slot, see MaterialLayout::declare. Shaders resolve
+     * their slots once and use these while drawing.
+     */
+    float getFloat(int slot) const {
+        return getParam<float>(slot, "getFloat");
+    }
+    glm::vec2 getVec2(int slot) const {
+        return getParam<glm::vec2>(slot, "getVec2");
+    }
+    glm::vec3 getVec3(int slot) const {
+        return getParam<glm::vec3>(slot, "getVec3");
+    }
+    glm::vec4 getVec4(int slot) const {
+        return getParam<glm::vec4>(slot, "getVec4");
+    }
+    glm::mat4 getMat4(int slot) const {
+        return getParam<glm::mat4>(slot, "getMat4");
+    }
+
+    const float* getFloatNoError(int slot) const {
+        return findParam<float>(slot);
+    }
+    const glm::vec2* getVec2NoError(int slot) const {
+        return findParam<glm::vec2>(slot);
+    }
+    const glm::vec3* getVec3NoError(int slot) const {
+        return findParam<glm::vec3>(slot);
+    }
+    const glm::vec4* getVec4NoError(int slot) const {
+        return findParam<glm::vec4>(slot);
+    }
+    const glm::mat4* getMat4NoError(int slot) const {
+        return findParam<glm::mat4>(slot);
+    }
+
+    void setFloat(int slot, float value) {
+        setParam(slot, value);
+    }
+    void setVec2(int slot, glm::vec2 vector) {
+        setParam(slot, vector);
+    }
+    void setVec3(int slot, glm::vec3 vector) {
+        setParam(slot, vector);
+    }
+    void setVec4(int slot, glm::vec4 vector) {
+        setParam(slot, vector);
+    }
+    void setMat4(int slot, glm::mat4 matrix) {
+        setParam(slot, matrix);
+    }
+
+    bool hasParam(int slot) const {
+        return nullptr != findParam<char>(slot);
     }
 
     bool hasUniform(const std::string& key) const {
-        if (vec3s_.find(key) != vec3s_.end()) {
-            return true;
-        }
-        if (vec2s_.find(key) != vec2s_.end()) {
-            return true;
+        int slots[MaterialLayout::PARAM_TYPE_COUNT];
+        if (!MaterialLayout::findAll(key, slots)) {
+            return false;
         }
-        if (vec4s_.find(key) != vec4s_.end()) {
-            return true;
-        }
-        if (mat4s_.find(key) != mat4s_.end()) {
-            return true;
-        }
-        if (floats_.find(key) != floats_.end()) {
-            return true;
+        for (int i = 0; i < MaterialLayout::PARAM_TYPE_COUNT; ++i) {
+            if (hasParam(slots[i])) {
+                return true;
+            }
         }
         return false;
     }
 
-    void setMat4(const std::string& key, glm::mat4 matrix) {
-        mat4s_[key] = matrix;
-        dirty();
+    // slots of the parameters every material has
+    static int colorSlot() {
+        static const int slot = declare("color", MaterialLayout::VEC3);
+        return slot;
+    }
+    static int opacitySlot() {
+        static const int slot = declare("opacity", MaterialLayout::FLOAT);
+        return slot;
+    }
+
+    static int declare(const std::string& key, MaterialLayout::ParamType type) {
+        return MaterialLayout::declare(key, type);
+    }
+
+    /*
+     * The std140 image of the parameters, laid out by the MaterialLayout
+     * of the shader type; parameters the material was not given are zero.
+     * Valid as long as the material.
+     */
+    const void* paramBlock() const {
+        return block_.load(std::memory_order_acquire)->data.data();
+    }
+    int paramBlockSize() const {
+        return block_.load(std::memory_order_acquire)->size;
     }
 
     int get_shader_feature_set() {
@@ -224,6 +300,11 @@ public:
         return (main_texture != NULL) && main_texture->isReady();
     }
 
+    // "main_texture" without the lookup, NULL if not set
+    Texture* getMainTexture() const {
+        return main_texture;
+    }
+
     void add_dirty_flag(const std::shared_ptr<bool>& dirty_flag) {
         dirty_flags_.insert(dirty_flag);
     }
@@ -237,6 +318,133 @@ public:
     }
 
     private:
+    static int find(const std::string& key, MaterialLayout::ParamType type) {
+        return MaterialLayout::find(key, type);
+    }
+
+    /*
+     * The values of one layout. The storage is allocated once and never
+     * resized: when the layout outgrows it or the shader type changes, a
+     * new block replaces it and the old one stays until the material goes,
+     * so a pointer from findParam stays valid.
+     */
+    struct ParamBlock {
+        ParamBlock(MaterialLayout* layout) :
+                layout(layout),
+                count(layout->count()),
+                size(layout->blockSize()),
+                data(size / sizeof(glm::vec4)),
+                set(count, 0) {
+        }
+        MaterialLayout* layout;
+        int count;      // parameters of the layout the block has room for
+        int size;       // bytes, a multiple of 16
+        std::vector<glm::vec4> data;
+        std::vector<unsigned char> set;     // by layout index
+    };
+
+    // every material has color and opacity, so they lead each layout
+    static MaterialLayout* layoutFor(ShaderType shader_type) {
+        MaterialLayout* layout = MaterialLayout::forShader(shader_type);
+        layout->add(colorSlot());
+        layout->add(opacitySlot());
+        return layout;
+    }
+
+    static char* paramAddress(ParamBlock* block, int slot) {
+        return reinterpret_cast<char*>(block->data.data())
+                + block->layout->offset(slot);
+    }
+
+    // copies what the current block has into a new one for the layout
+    void setLayout(MaterialLayout* layout) {
+        ParamBlock* old_block = block_.load(std::memory_order_relaxed);
+        if (nullptr != old_block) {
+            MaterialLayout* old_layout = old_block->layout;
+            for (int i = 0; i < old_block->count; ++i) {
+                if (old_block->set[i]) {
+                    layout->add(old_layout->slotAt(i));
+                }
+            }
+        }
+        std::unique_ptr<ParamBlock> block(new ParamBlock(layout));
+        if (nullptr != old_block) {
+            for (int i = 0; i < old_block->count; ++i) {
+                if (old_block->set[i]) {
+                    int slot = old_block->layout->slotAt(i);
+                    memcpy(paramAddress(block.get(), slot),
+                            paramAddress(old_block, slot),
+                            MaterialLayout::paramSize(MaterialLayout::type(slot)));
+                    block->set[layout->index(slot)] = 1;
+                }
+            }
+        }
+        block_.store(block.get(), std::memory_order_release);
+        blocks_.push_back(std::move(block));
+    }
+
+    // lock free, for the draw path
+    template <class T> const T* findParam(int slot) const {
+        if (slot < 0) {
+            return NULL;
+        }
+        ParamBlock* block = block_.load(std::memory_order_acquire);
+        int index = block->layout->index(slot);
+        if (index < 0 || index >= block->count || !block->set[index]) {
+            return NULL;
+        }
+        return reinterpret_cast<const T*>(paramAddress(block, slot));
+    }
+
+    template <class T> T getParam(int slot, const char* getter) const {
+        const T* value = findParam<T>(slot);
+        if (NULL == value) {
+            std::string error = std::string("Material::") + getter + "() : "
+                    + (slot >= 0 ? MaterialLayout::name(slot) : "slot")
+                    + " not found";
+            throw error;
+        }
+        return *value;
+    }
+
+    template <class T> T getParam(int slot, const char* getter, const std::string& key) const {
+        const T* value = findParam<T>(slot);
+        if (NULL == value) {
+            std::string error = std::string("Material::") + getter + "() : " + key
+                    + " not found";
+            throw error;
+        }
+        return *value;
+    }
+
+    // setting a parameter to the value it has is not a change
+    template <class T> void setParam(int slot, const T& value) {
+        if (slot < 0) {
+            std::string error = "Material::setParam() : invalid slot";
+            throw error;
+        }
+        ParamBlock* block = block_.load(std::memory_order_relaxed);
+        MaterialLayout* layout = block->layout;
+        layout->add(slot);
+        if (layout->index(slot) >= block->count) {
+            setLayout(layout);
+            block = block_.load(std::memory_order_relaxed);
+        }
+        int index = layout->index(slot);
+        char* dest = paramAddress(block, slot);
+        if (block->set[index] && 0 == memcmp(dest, &value, sizeof(T))) {
+            return;
+        }
+        memcpy(dest, &value, sizeof(T));
+        block->set[index] = 1;
+        dirty();
+    }
+
+    static unsigned int nextSortId() {
+        static std::atomic<unsigned int> next_sort_id(0);
+        return next_sort_id++;
+    }
+
     Material(const Material& material);
     Material(Material&& material);
     Material& operator=(const Material& material);
@@ -246,14 +454,13 @@ private:
     ShaderType shader_type_;
     std::map<std::string, Texture*> textures_;
     Texture* main_texture = NULL;
-    std::map<std::string, float> floats_;
-    std::map<std::string, glm::vec2> vec2s_;
-    std::map<std::string, glm::vec3> vec3s_;
-    std::map<std::string, glm::vec4> vec4s_;
-    std::map<std::string, glm::mat4> mat4s_;
+    std::atomic<ParamBlock*> block_;
+    // every block the material had, the current one last
+    std::vector<std::unique_ptr<ParamBlock>> blocks_;
     std::unordered_set<std::shared_ptr<bool>> dirty_flags_;
 
     unsigned int shader_feature_set_;
+    unsigned int sort_id_;
 };
 
 }
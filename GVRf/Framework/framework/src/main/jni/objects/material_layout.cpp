@@ -0,0 +1,144 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "material_layout.h"
+
+#include "util/gvr_log.h"
+
+namespace gvr {
+
+std::mutex MaterialLayout::names_mutex_;
+std::atomic<const MaterialLayout::Names*> MaterialLayout::names_(new MaterialLayout::Names());
+std::vector<const MaterialLayout::Names*> MaterialLayout::old_names_;
+MaterialLayout::Param MaterialLayout::params_[MaterialLayout::MAX_PARAMS];
+int MaterialLayout::param_count_ = 0;
+
+std::mutex MaterialLayout::layouts_mutex_;
+std::map<int, MaterialLayout*> MaterialLayout::layouts_;
+
+MaterialLayout::MaterialLayout() :
+        count_(0), end_(0), block_size_(0) {
+    for (int i = 0; i < MAX_PARAMS; ++i) {
+        offsets_[i].store(-1, std::memory_order_relaxed);
+    }
+}
+
+int MaterialLayout::paramSize(ParamType type) {
+    switch (type) {
+    case FLOAT:
+        return 4;
+    case VEC2:
+        return 8;
+    case VEC3:
+        return 12;
+    case VEC4:
+        return 16;
+    default:
+        return 64;
+    }
+}
+
+// std140: scalars on 4, vec2 on 8, vec3, vec4 and the columns of a mat4 on 16
+int MaterialLayout::paramAlignment(ParamType type) {
+    switch (type) {
+    case FLOAT:
+        return 4;
+    case VEC2:
+        return 8;
+    default:
+        return 16;
+    }
+}
+
+int MaterialLayout::declare(const std::string& name, ParamType type) {
+    int slot = find(name, type);
+    if (slot >= 0) {
+        return slot;
+    }
+    std::lock_guard < std::mutex > lock(names_mutex_);
+    const Names* names = names_.load(std::memory_order_acquire);
+    auto it = names->find(name);
+    if (it != names->end() && it->second.slot[type] >= 0) {
+        return it->second.slot[type];
+    }
+    if (param_count_ >= MAX_PARAMS) {
+        LOGE("MaterialLayout: no slot left for %s", name.c_str());
+        std::string error = "MaterialLayout::declare() : no slot left for " + name;
+        throw error;
+    }
+    slot = param_count_++;
+    Param& param = params_[slot];
+    param.name = name;
+    param.type = type;
+
+    // readers may still be walking the old map, so it is kept
+    Names* declared = new Names(*names);
+    (*declared)[name].slot[type] = slot;
+    old_names_.push_back(names);
+    names_.store(declared, std::memory_order_release);
+    return slot;
+}
+
+int MaterialLayout::find(const std::string& name, ParamType type) {
+    const Names* names = names_.load(std::memory_order_acquire);
+    auto it = names->find(name);
+    return (it != names->end()) ? it->second.slot[type] : -1;
+}
+
+bool MaterialLayout::findAll(const std::string& name, int slots[PARAM_TYPE_COUNT]) {
+    const Names* names = names_.load(std::memory_order_acquire);
+    auto it = names->find(name);
+    if (it == names->end()) {
+        return false;
+    }
+    for (int i = 0; i < PARAM_TYPE_COUNT; ++i) {
+        slots[i] = it->second.slot[i];
+    }
+    return true;
+}
+
+MaterialLayout* MaterialLayout::forShader(int shader_type) {
+    std::lock_guard < std::mutex > lock(layouts_mutex_);
+    MaterialLayout*& layout = layouts_[shader_type];
+    if (nullptr == layout) {
+        layout = new MaterialLayout();
+    }
+    return layout;
+}
+
+int MaterialLayout::add(int slot) {
+    int offset = this->offset(slot);
+    if (offset >= 0) {
+        return offset;
+    }
+    std::lock_guard < std::mutex > lock(mutex_);
+    offset = offsets_[slot].load(std::memory_order_relaxed);
+    if (offset >= 0) {
+        return offset;
+    }
+    ParamType type = params_[slot].type;
+    int alignment = paramAlignment(type);
+    int index = count_.load(std::memory_order_relaxed);
+    offset = (end_ + alignment - 1) & ~(alignment - 1);
+    end_ = offset + paramSize(type);
+    indices_[slot] = index;
+    slots_[index] = slot;
+    block_size_.store((end_ + 15) & ~15, std::memory_order_release);
+    count_.store(index + 1, std::memory_order_release);
+    offsets_[slot].store(offset, std::memory_order_release);
+    return offset;
+}
+
+}
@@ -0,0 +1,155 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Slots and std140 offsets of the material parameters.
+ ***************************************************************************/
+
+#ifndef MATERIAL_LAYOUT_H_
+#define MATERIAL_LAYOUT_H_
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace gvr {
+
+/*
+ * Hands out one slot per parameter name and type, starting at 0, for the
+ * whole app. Shaders declare their parameters once and keep the slots.
+ *
+ * Each shader type also has a layout of its own that places the slots its
+ * materials use in a std140 block, after the ones added before them. A
+ * Material keeps its values in an image of that block, so the image can be
+ * copied into a uniform buffer as is, and names only used with other
+ * shaders cost it nothing.
+ *
+ * Slots and offsets are never released or moved. Looking up a name, the
+ * offset of a slot or the block size takes no lock; only declaring a new
+ * name or adding a slot to a layout does.
+ */
+class MaterialLayout {
+public:
+    enum ParamType {
+        FLOAT,
+        VEC2,
+        VEC3,
+        VEC4,
+        MAT4,
+        PARAM_TYPE_COUNT
+    };
+
+    static const int MAX_PARAMS = 1024;
+
+    // slot of the parameter, declaring it if needed; throws once full
+    static int declare(const std::string& name, ParamType type);
+
+    // slot of the parameter or -1, never declares
+    static int find(const std::string& name, ParamType type);
+
+    // true if the name is declared with any type; fills slots, -1 per missing type
+    static bool findAll(const std::string& name, int slots[PARAM_TYPE_COUNT]);
+
+    static ParamType type(int slot) {
+        return params_[slot].type;
+    }
+    static const std::string& name(int slot) {
+        return params_[slot].name;
+    }
+
+    static int paramSize(ParamType type);
+
+    // the layout of the materials of a shader type, created on first use
+    static MaterialLayout* forShader(int shader_type);
+
+    // offset of the slot in the block, adding it at the end if needed
+    int add(int slot);
+
+    // offset of the slot in the block or -1
+    int offset(int slot) const {
+        return offsets_[slot].load(std::memory_order_acquire);
+    }
+
+    // position of the slot in the order of add() or -1
+    int index(int slot) const {
+        return (offset(slot) >= 0) ? indices_[slot] : -1;
+    }
+
+    // slot added at the index, for index < count()
+    int slotAt(int index) const {
+        return slots_[index];
+    }
+
+    int count() const {
+        return count_.load(std::memory_order_acquire);
+    }
+
+    // bytes of the block so far, a multiple of 16
+    int blockSize() const {
+        return block_size_.load(std::memory_order_acquire);
+    }
+
+private:
+    MaterialLayout();
+    MaterialLayout(const MaterialLayout& layout);
+    MaterialLayout(MaterialLayout&& layout);
+    MaterialLayout& operator=(const MaterialLayout& layout);
+    MaterialLayout& operator=(MaterialLayout&& layout);
+
+    static int paramAlignment(ParamType type);
+
+    struct Param {
+        std::string name;
+        ParamType type;
+    };
+
+    struct Slots {
+        Slots() {
+            for (int i = 0; i < PARAM_TYPE_COUNT; ++i) {
+                slot[i] = -1;
+            }
+        }
+        int slot[PARAM_TYPE_COUNT];
+    };
+
+    typedef std::unordered_map<std::string, Slots> Names;
+
+private:
+    static std::mutex names_mutex_;
+    // replaced, never changed, by declare(); replaced maps are kept
+    static std::atomic<const Names*> names_;
+    static std::vector<const Names*> old_names_;
+    // written once per slot, before the slot is handed out
+    static Param params_[MAX_PARAMS];
+    static int param_count_;
+
+    static std::mutex layouts_mutex_;
+    static std::map<int, MaterialLayout*> layouts_;
+
+    std::mutex mutex_;
+    std::atomic<int> offsets_[MAX_PARAMS];
+    // written once per slot, before its offset
+    int indices_[MAX_PARAMS];
+    int slots_[MAX_PARAMS];
+    std::atomic<int> count_;
+    int end_;
+    std::atomic<int> block_size_;
+};
+
+}
+#endif
@@ -19,9 +19,17 @@
 
 #include "mesh.h"
 
+#include <algorithm>
+
 #include "assimp/Importer.hpp"
 #include "glm/gtc/matrix_inverse.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/packing.hpp"
+#include "glm/gtc/type_ptr.hpp"
 #include "objects/helpers.h"
+#include "objects/scene_object.h"
+#include "objects/components/render_data.h"
+#include "gl/gl_state_cache.h"
 
 namespace gvr {
 
@@ -173,171 +181,220 @@ void Mesh::getTransformedBoundingBoxInfo(glm::mat4 *Mat,
     }
 }
 
-void Mesh::createAttributeMapping(int programId,
-        int& totalStride, int& attrLen)
-{
-    totalStride = attrLen = 0;
-    if (programId == -1)
-    {
-        // If program id has not been set, return.
+void Mesh::updateDequant() {
+    has_dequant_ = encodingOf("a_position") == HALF && vertices_.size() > 0 && !hasBones();
+    if (!has_dequant_) {
+        dequant_ = glm::mat4();
+        quant_bias_ = glm::vec3();
+        quant_scale_ = 1.0f;
         return;
     }
-    GLint numActiveAtributes;
-    glGetProgramiv(programId, GL_ACTIVE_ATTRIBUTES, &numActiveAtributes);
-    GLchar attrName[512];
-    GLAttributeMapping attrData;
+    getBoundingVolume();
+    glm::vec3 min_corner = bounding_volume.min_corner();
+    glm::vec3 max_corner = bounding_volume.max_corner();
+    glm::vec3 extent = 0.5f * (max_corner - min_corner);
+    // one scale for all axes, so the normal matrix needs no correction
+    float scale = std::max(extent.x, std::max(extent.y, extent.z));
+    if (scale <= 0.0f) {
+        scale = 1.0f;
+    }
+    quant_bias_ = 0.5f * (max_corner + min_corner);
+    quant_scale_ = 1.0f / scale;
+    dequant_ = glm::translate(glm::mat4(), quant_bias_) * glm::scale(glm::mat4(), glm::vec3(scale));
+}
 
-    for (int i = 0; i < numActiveAtributes; i++)
-    {
-        GLsizei length;
-        GLint size;
-        GLenum type;
-        glGetActiveAttrib(programId, i, 512, &length, &size, &type, attrName);
-        if (std::find(dynamicAttribute_Names_.begin(), dynamicAttribute_Names_.end(), attrName) != dynamicAttribute_Names_.end())
-        {
-            // Skip dynamic attributes. Currently only bones are dynamic attributes which changes each frame.
-            // They are handled seperately.
+/*
+ * Collects every per vertex attribute of the mesh into vertex_format_,
+ * with where to read it from. Attributes with a different number of
+ * entries than the positions are left out.
+ */
+void Mesh::buildVertexFormat(std::vector<VertexSource>& sources) {
+    VertexFormat format;
+    sources.clear();
+    int vertex_count = vertices_.size() > 0 ? vertices_.size() : normals_.size();
+
+    auto add = [&](const std::string& name, const float* data, size_t length, GLint components) {
+        if (length == 0 || format.find(name.c_str()) != nullptr) {
+            return;
         }
-        else
-        {
-            attrData.type = GL_FLOAT;
-            int loc = glGetAttribLocation(programId, attrName);
-            attrData.index = loc;
-            attrData.data = NULL;
-            attrData.offset = totalStride;
-            bool addData = true;
-            int len = 0;
-
-            // Two things to note --
-            // 1. The 3 builtin buffers are still seperate from the maps used for the other attributes
-            // 2. The attribute index *has* to be 0, 1 and 2 for position, tex_coords and normal. The
-            // index from querying via glGetActiveAttrib cannot be used. Needs analysis.
-            if (strcmp(attrName, "a_position") == 0)
-            {
-                attrData.size = 3;
-                len = vertices_.size();
-                attrData.data = vertices_.data();
-            }
-            else if (strcmp(attrName, "a_normal") == 0)
-            {
-                attrData.size = 3;
-                len = normals_.size();
-                attrData.data = normals_.data();
-            }
-            else
-            {
-
-                switch (type)
-                {
-                    case GL_FLOAT:
-                        attrData.size = 1;
-                        {
-                            const std::vector<float>& curr = getFloatVector(attrName);
-                            len = curr.size();
-                            attrData.data = curr.data();
-                        }
-                        break;
-                    case GL_FLOAT_VEC2:
-                        attrData.size = 2;
-                        {
-                            const std::vector<glm::vec2>& curr = getVec2Vector(attrName);
-                            len = curr.size();
-                            attrData.data = curr.data();
-                        }
-                        break;
-                    case GL_FLOAT_VEC3:
-                        attrData.size = 3;
-                        {
-                            const std::vector<glm::vec3>& curr = getVec3Vector(attrName);
-                            len = curr.size();
-                            attrData.data = curr.data();
-                        }
-                        break;
-                    case GL_FLOAT_VEC4:
-                        attrData.size = 4;
-                        {
-                            const std::vector<glm::vec4>& curr = getVec4Vector(attrName);
-                            len = curr.size();
-                            attrData.data = curr.data();
-                        }
-                        break;
-                    default:
-                        addData = false;
-                        LOGE("Looking up %s failed ", attrName);
-                            break;
-                }
-            }
-            if (addData)
-            {
-                totalStride += attrData.size;
-                attrMapping.push_back(attrData);
-                if (attrLen == 0)
-                    attrLen = len;
-                else
-                {
-                    if (len != attrLen)
-                        LOGE(" $$$$*** Attib length does not match %d vs %d", len, attrLen);
+        if (length != static_cast<size_t>(vertex_count)) {
+            LOGE("mesh: %s has %d entries for %d vertices, left out", name.c_str(),
+                    (int) length, vertex_count);
+            return;
+        }
+        VertexEncoding encoding = encodingOf(name);
+        if (SNORM_2_10_10_10 == encoding && 3 != components) {
+            encoding = FLOAT;
+        } else if (UNORM16 == encoding) {
+            for (size_t i = 0; i < length * components; ++i) {
+                if (data[i] < 0.0f || data[i] > 1.0f) {
+                    LOGW("mesh: %s is outside [0, 1], stored as floats", name.c_str());
+                    encoding = FLOAT;
+                    break;
                 }
             }
         }
+        switch (encoding) {
+        case HALF:
+            format.add(name, components, GL_HALF_FLOAT);
+            break;
+        case SNORM_2_10_10_10:
+            format.add(name, 4, GL_INT_2_10_10_10_REV, GL_TRUE);
+            break;
+        case UNORM16:
+            format.add(name, components, GL_UNSIGNED_SHORT, GL_TRUE);
+            break;
+        default:
+            format.add(name, components);
+            break;
+        }
+        VertexSource source;
+        source.data = reinterpret_cast<const char*>(data);
+        source.components = components;
+        source.offset = format.attributes().back().offset;
+        source.encoding = encoding;
+        sources.push_back(source);
+    };
+
+    add("a_position", glm::value_ptr(vertices_[0]), vertices_.size(), 3);
+    if (normals_.size() > 0) {
+        add("a_normal", glm::value_ptr(normals_[0]), normals_.size(), 3);
+    }
+    for (auto it = float_vectors_.begin(); it != float_vectors_.end(); ++it) {
+        add(it->first, it->second.data(), it->second.size(), 1);
+    }
+    for (auto it = vec2_vectors_.begin(); it != vec2_vectors_.end(); ++it) {
+        add(it->first, reinterpret_cast<const float*>(it->second.data()), it->second.size(), 2);
+    }
+    for (auto it = vec3_vectors_.begin(); it != vec3_vectors_.end(); ++it) {
+        add(it->first, reinterpret_cast<const float*>(it->second.data()), it->second.size(), 3);
+    }
+    for (auto it = vec4_vectors_.begin(); it != vec4_vectors_.end(); ++it) {
+        add(it->first, reinterpret_cast<const float*>(it->second.data()), it->second.size(), 4);
+    }
+
+    vertex_count_ = vertex_count;
+    if (format != vertex_format_) {
+        vertex_format_ = format;
+        ++format_version_;
     }
 }
 
-void Mesh::createBuffer(std::vector<GLfloat>& buffer, int attrLength)
-{
-    for (int i = 0; i < attrLength; i++)
-    {
-        for (auto it = attrMapping.begin(); it != attrMapping.end(); ++it)
-        {
-            GLAttributeMapping currAttr = *it;
-            const float* ptr = (float*) currAttr.data;
-            for (int k = 0; k < currAttr.size; k++)
-            {
-                buffer.push_back(ptr[i * currAttr.size + k]);
+// vertex by vertex, so a write combined mapping is filled in order
+void Mesh::writeVertices(char* dest, const std::vector<VertexSource>& sources) const {
+    GLsizei stride = vertex_format_.stride();
+    for (int i = 0; i < vertex_count_; ++i) {
+        for (auto it = sources.begin(); it != sources.end(); ++it) {
+            const float* src = reinterpret_cast<const float*>(it->data) + i * it->components;
+            char* attribute = dest + it->offset;
+            switch (it->encoding) {
+            case HALF: {
+                uint16_t* half = reinterpret_cast<uint16_t*>(attribute);
+                if (has_dequant_ && it->data == reinterpret_cast<const char*>(vertices_.data())) {
+                    for (int k = 0; k < 3; ++k) {
+                        half[k] = glm::packHalf1x16((src[k] - quant_bias_[k]) * quant_scale_);
+                    }
+                } else {
+                    for (int k = 0; k < it->components; ++k) {
+                        half[k] = glm::packHalf1x16(src[k]);
+                    }
+                }
+                break;
+            }
+            case SNORM_2_10_10_10: {
+                uint32_t packed = glm::packSnorm3x10_1x2(glm::vec4(src[0], src[1], src[2], 0.0f));
+                memcpy(attribute, &packed, sizeof(packed));
+                break;
+            }
+            case UNORM16: {
+                uint16_t* unorm = reinterpret_cast<uint16_t*>(attribute);
+                for (int k = 0; k < it->components; ++k) {
+                    unorm[k] = glm::packUnorm1x16(src[k]);
+                }
+                break;
+            }
+            default:
+                memcpy(attribute, src, it->components * sizeof(float));
+                break;
             }
         }
+        dest += stride;
     }
 }
 
-
-const GLuint Mesh::getVAOId(int programId) {
-    if (programId == -1)
-    {
-        LOGI("!! %p Prog Id -- %d ", this, programId);
-        return 0;
+size_t Mesh::floatVertexSize() const {
+    size_t floats = (vertices_.size() + normals_.size()) * 3;
+    for (auto it = float_vectors_.begin(); it != float_vectors_.end(); ++it) {
+        floats += it->second.size();
     }
-    if (vao_dirty_)
-    {
-        generateVAO(programId);
+    for (auto it = vec2_vectors_.begin(); it != vec2_vectors_.end(); ++it) {
+        floats += it->second.size() * 2;
     }
-    auto it = program_ids_.find(programId);
-    if (it != program_ids_.end())
-    {
-        GLVaoVboId id = it->second;
-        return id.vaoID;
+    for (auto it = vec3_vectors_.begin(); it != vec3_vectors_.end(); ++it) {
+        floats += it->second.size() * 3;
     }
-    vao_dirty_ = true;
-    generateVAO(programId);
-    it = program_ids_.find(programId);
-    if (it != program_ids_.end())
-    {
-        GLVaoVboId id = it->second;
-        return id.vaoID;
+    for (auto it = vec4_vectors_.begin(); it != vec4_vectors_.end(); ++it) {
+        floats += it->second.size() * 4;
     }
-    LOGI("!! %p Error in creating VAO  for Prog Id -- %d", this, programId);
-    return 0;
+    return floats * sizeof(float);
 }
 
-// generate vertex array object
-void Mesh::generateVAO(int programId) {
-    GLuint tmpID;
+void Mesh::encodeVertices() {
+    if (vertices_.size() == 0) {
+        return;
+    }
+    std::vector<VertexSource> sources;
+    buildVertexFormat(sources);
+    vertex_blob_.resize(vertexBufferSize());
+    writeVertices(vertex_blob_.data(), sources);
+}
 
-    if (!vao_dirty_) {
-         return;
+template <class T>
+static void remapArray(std::vector<T>& data, const std::vector<unsigned int>& remap) {
+    if (data.size() != remap.size()) {
+        return;
     }
-    obtainDeleter();
+    std::vector<T> remapped(data.size());
+    for (size_t i = 0; i < data.size(); ++i) {
+        remapped[remap[i]] = data[i];
+    }
+    data.swap(remapped);
+}
+
+template <class T>
+static void remapArrays(std::map<std::string, std::vector<T>>& arrays,
+        const std::vector<unsigned int>& remap) {
+    for (auto it = arrays.begin(); it != arrays.end(); ++it) {
+        remapArray(it->second, remap);
+    }
+}
+
+void Mesh::remapVertices(const std::vector<unsigned int>& remap) {
+    if (remap.size() != vertices_.size()) {
+        LOGE("Mesh::remapVertices(): %d entries for %d vertices",
+                (int) remap.size(), (int) vertices_.size());
+        return;
+    }
+    remapArray(vertices_, remap);
+    remapArray(normals_, remap);
+    remapArrays(float_vectors_, remap);
+    remapArrays(vec2_vectors_, remap);
+    remapArrays(vec3_vectors_, remap);
+    remapArrays(vec4_vectors_, remap);
+    for (auto it = indices_.begin(); it != indices_.end(); ++it) {
+        *it = remap[*it];
+    }
+    verticesChanged();
+    dirty();
+}
 
-    if (vertices_.size() == 0 && normals_.size() == 0) {
+/*
+ * Uploads the interleaved vertices and the indices once, whatever number
+ * of programs draw the mesh. Vertices not encoded ahead of time are
+ * written straight into the mapped buffer.
+ */
+void Mesh::uploadVertices() {
+    if (vertices_.size() == 0) {
         std::string error = "no vertex data yet, shouldn't call here. ";
         throw error;
     }
@@ -345,67 +402,143 @@ void Mesh::generateVAO(int programId) {
         LOGW("mesh: number of vertices and normals do not match! vertices %d, normals %d", vertices_.size(), normals_.size());
     }
 
-    GLuint vaoID_;
-    GLuint triangle_vboID_;
-    GLuint static_vboID_;
-    auto it = program_ids_.find(programId);
-    if (it != program_ids_.end())
-    {
+    GLStateCache* state_cache = GLStateCache::getInstance();
+    // keep the upload from changing the index buffer of a bound VAO
+    state_cache->bindVertexArray(0);
 
-        GLVaoVboId ids = it->second;
-        vaoID_ = ids.vaoID;
-        triangle_vboID_ = ids.triangle_vboID;
-        static_vboID_ = ids.static_vboID;
+    if (vboID_ == GVR_INVALID) {
+        glGenBuffers(1, &vboID_);
     }
-    else
-    {
-        glGenVertexArrays(1, &vaoID_);
-        glGenBuffers(1, &triangle_vboID_);
-        glGenBuffers(1, &static_vboID_);
+    state_cache->bindBuffer(GL_ARRAY_BUFFER, vboID_);
+    if (!vertex_blob_.empty()) {
+        glBufferData(GL_ARRAY_BUFFER, vertex_blob_.size(), vertex_blob_.data(), GL_STATIC_DRAW);
+        vbo_bytes_ = vertex_blob_.size();
+        std::vector<char> blob;
+        vertex_blob_.swap(blob);
+    } else {
+        std::vector<VertexSource> sources;
+        buildVertexFormat(sources);
+        GLsizeiptr size = vertexBufferSize();
+        glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STATIC_DRAW);
+        vbo_bytes_ = size;
+        void* mapped = size > 0 ? glMapBufferRange(GL_ARRAY_BUFFER, 0, size,
+                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT) : nullptr;
+        bool written = false;
+        if (nullptr != mapped) {
+            writeVertices(static_cast<char*>(mapped), sources);
+            written = GL_TRUE == glUnmapBuffer(GL_ARRAY_BUFFER);
+        }
+        if (!written && size > 0) {
+            std::vector<char> blob(size);
+            writeVertices(blob.data(), sources);
+            glBufferData(GL_ARRAY_BUFFER, size, blob.data(), GL_STATIC_DRAW);
+        }
     }
+    state_cache->bindBuffer(GL_ARRAY_BUFFER, 0);
 
-
-    glBindVertexArray(vaoID_);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, triangle_vboID_);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-            sizeof(unsigned short) * indices_.size(), &indices_[0],
-            GL_STATIC_DRAW);
+    if (iboID_ == GVR_INVALID) {
+        glGenBuffers(1, &iboID_);
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, iboID_);
+    if (GL_UNSIGNED_SHORT == index_type_) {
+        std::vector<unsigned short> short_indices(indices_.begin(), indices_.end());
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                sizeof(unsigned short) * short_indices.size(), short_indices.data(),
+                GL_STATIC_DRAW);
+        ibo_bytes_ = sizeof(unsigned short) * short_indices.size();
+    } else {
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                sizeof(unsigned int) * indices_.size(), indices_.data(),
+                GL_STATIC_DRAW);
+        ibo_bytes_ = sizeof(unsigned int) * indices_.size();
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     numTriangles_ = indices_.size() / 3;
 
-    attrMapping.clear();
-    int totalStride;
-    int attrLength;
-    createAttributeMapping(programId, totalStride, attrLength);
+    vertices_dirty_ = false;
+}
 
-    std::vector<GLfloat> buffer;
-    createBuffer(buffer, attrLength);
-    glBindBuffer(GL_ARRAY_BUFFER, static_vboID_);
+// maps the active attributes of the program onto vertex_format_
+void Mesh::setupVAO(int programId, GLVaoId& vao) {
+    GLStateCache* state_cache = GLStateCache::getInstance();
+    state_cache->bindVertexArray(vao.vaoID);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, iboID_);
+    state_cache->bindBuffer(GL_ARRAY_BUFFER, vboID_);
 
-    glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * buffer.size(),
-            &buffer[0], GL_STATIC_DRAW);
-    int localCnt = 0;
-    for ( std::vector<GLAttributeMapping>::iterator it = attrMapping.begin(); it != attrMapping.end(); ++it)
+    GLint numActiveAtributes = 0;
+    glGetProgramiv(programId, GL_ACTIVE_ATTRIBUTES, &numActiveAtributes);
+    GLchar attrName[512];
+    GLsizei stride = vertex_format_.stride();
+    for (int i = 0; i < numActiveAtributes; i++)
     {
-        GLAttributeMapping currData = *it;
-        glVertexAttribPointer(currData.index, currData.size, currData.type, 0, totalStride * sizeof(GLfloat), (GLvoid*) (currData.offset * sizeof(GLfloat)));
-        glEnableVertexAttribArray(currData.index);
+        GLsizei length;
+        GLint size;
+        GLenum type;
+        glGetActiveAttrib(programId, i, 512, &length, &size, &type, attrName);
+        if (std::find(dynamicAttribute_Names_.begin(), dynamicAttribute_Names_.end(), attrName) != dynamicAttribute_Names_.end())
+        {
+            // Skip dynamic attributes. Currently only bones are dynamic attributes which changes each frame.
+            // They are handled seperately.
+            continue;
+        }
+        const VertexAttribute* attribute = vertex_format_.find(attrName);
+        if (nullptr == attribute)
+        {
+            LOGE("Looking up %s failed ", attrName);
+            continue;
+        }
+        GLint loc = glGetAttribLocation(programId, attrName);
+        if (loc < 0)
+        {
+            continue;
+        }
+        glVertexAttribPointer(loc, attribute->components, attribute->type, attribute->normalized,
+                stride, (GLvoid*) (uintptr_t) attribute->offset);
+        glEnableVertexAttribArray(loc);
     }
 
+    state_cache->bindVertexArray(0);
+    state_cache->bindBuffer(GL_ARRAY_BUFFER, 0);
+    vao.format_version = format_version_;
+}
 
-    // done generation
-    glBindVertexArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+const GLuint Mesh::getVAOId(int programId) {
+    if (programId == -1)
+    {
+        LOGI("!! %p Prog Id -- %d ", this, programId);
+        return 0;
+    }
+    generateVAO(programId);
+    auto it = program_ids_.find(programId);
+    if (it != program_ids_.end())
+    {
+        return it->second.vaoID;
+    }
+    LOGI("!! %p Error in creating VAO  for Prog Id -- %d", this, programId);
+    return 0;
+}
+
+// generate vertex array object
+void Mesh::generateVAO(int programId) {
+    obtainDeleter();
+    if (vertices_dirty_) {
+        uploadVertices();
+    }
 
+    auto it = program_ids_.find(programId);
     if (it == program_ids_.end())
     {
-        GLVaoVboId id;
-        id.vaoID = vaoID_;
-        id.static_vboID = static_vboID_;
-        id.triangle_vboID = triangle_vboID_;
-        program_ids_[programId] = id;
+        GLVaoId vao;
+        glGenVertexArrays(1, &vao.vaoID);
+        vao.format_version = -1;
+        vao.bone_version = -1;
+        it = program_ids_.insert(std::make_pair(programId, vao)).first;
+    }
+    // the buffers keep their names across uploads, so a VAO only needs
+    // new pointers when the layout changed
+    if (it->second.format_version != format_version_) {
+        setupVAO(programId, it->second);
     }
-    vao_dirty_ = false;
 }
 
 void Mesh::getAttribNames(std::set<std::string> &attrib_names) {
@@ -436,17 +569,6 @@ void Mesh::getAttribNames(std::set<std::string> &attrib_names) {
     }
 
 void Mesh::generateBoneArrayBuffers(GLuint programId) {
-    if (!bone_data_dirty_) {
-        return;
-    }
-
-
-    // delete
-    if (boneVboID_ != GVR_INVALID) {
-        deleter_->queueBuffer(boneVboID_);
-        boneVboID_ = GVR_INVALID;
-    }
-
     int nVertices = vertices().size();
     if (!vertexBoneData_.getNumBones() || !nVertices) {
         LOGV("no bones or vertices");
@@ -459,16 +581,29 @@ void Mesh::generateBoneArrayBuffers(GLuint programId) {
         LOGV("Invalid program Id for bones");
         return;
     }
-    GLVaoVboId id = it->second;
-    glBindVertexArray(id.vaoID);
+
+    // one bone buffer, like the vertices, pointed to by every VAO
+    if (bone_data_dirty_) {
+        if (boneVboID_ == GVR_INVALID) {
+            glGenBuffers(1, &boneVboID_);
+        }
+        GLStateCache::getInstance()->bindBuffer(GL_ARRAY_BUFFER, boneVboID_);
+        glBufferData(GL_ARRAY_BUFFER,
+                sizeof(vertexBoneData_.boneData[0]) * vertexBoneData_.boneData.size(),
+                &vertexBoneData_.boneData[0], GL_STATIC_DRAW);
+        bone_vbo_bytes_ = sizeof(vertexBoneData_.boneData[0]) * vertexBoneData_.boneData.size();
+        ++bone_version_;
+        bone_data_dirty_ = false;
+    }
+
+    GLVaoId& vao = it->second;
+    if (vao.bone_version == bone_version_) {
+        return;
+    }
+    GLStateCache::getInstance()->bindVertexArray(vao.vaoID);
+    GLStateCache::getInstance()->bindBuffer(GL_ARRAY_BUFFER, boneVboID_);
 
     // BoneID
-    GLuint boneVboID;
-    glGenBuffers(1, &boneVboID);
-    glBindBuffer(GL_ARRAY_BUFFER, boneVboID);
-    glBufferData(GL_ARRAY_BUFFER,
-            sizeof(vertexBoneData_.boneData[0]) * vertexBoneData_.boneData.size(),
-            &vertexBoneData_.boneData[0], GL_STATIC_DRAW);
     glEnableVertexAttribArray(getBoneIndicesLoc());
     glVertexAttribIPointer(getBoneIndicesLoc(), 4, GL_INT, sizeof(VertexBoneData::BoneData), (const GLvoid*) 0);
 
@@ -476,11 +611,10 @@ void Mesh::generateBoneArrayBuffers(GLuint programId) {
     glEnableVertexAttribArray(getBoneWeightsLoc());
     glVertexAttribPointer(getBoneWeightsLoc(), 4, GL_FLOAT, GL_FALSE, sizeof(VertexBoneData::BoneData),
             (const GLvoid*) (sizeof(VertexBoneData::BoneData::ids)));
+    vao.bone_version = bone_version_;
 
-    boneVboID_ = boneVboID;
-
-    glBindVertexArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    GLStateCache::getInstance()->bindVertexArray(0);
+    GLStateCache::getInstance()->bindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 void Mesh::add_dirty_flag(const std::shared_ptr<bool>& dirty_flag) {
@@ -491,4 +625,22 @@ void Mesh::dirty() {
     dirtyImpl(dirty_flags_);
 }
 
+void Mesh::add_bounds_listener(const std::shared_ptr<RenderData*>& listener) {
+    bounds_listeners_.insert(listener);
+}
+
+void Mesh::boundsChanged() {
+    for (auto it = bounds_listeners_.begin(); it != bounds_listeners_.end();) {
+        RenderData* rdata = **it;
+        if (nullptr == rdata) {
+            it = bounds_listeners_.erase(it);
+            continue;
+        }
+        if (nullptr != rdata->owner_object()) {
+            rdata->owner_object()->dirtyHierarchicalBoundingVolume();
+        }
+        ++it;
+    }
+}
+
 }
@@ -20,7 +20,9 @@
 #ifndef MESH_H_
 #define MESH_H_
 
+#include <algorithm>
 #include <map>
+#include <cstring>
 #include <memory>
 #include <vector>
 #include <string>
@@ -38,24 +40,48 @@
 #include "objects/material.h"
 #include "objects/bounding_volume.h"
 #include "objects/vertex_bone_data.h"
+#include "objects/vertex_format.h"
 
 #include "engine/memory/gl_delete.h"
 
 namespace gvr {
+class RenderData;
+
 class Mesh: public HybridObject {
 public:
+    /*
+     * How an attribute is stored in the vertex buffer. The mesh keeps
+     * floats for the CPU side either way.
+     *
+     * HALF positions are stored relative to the bounding box, in
+     * [-1, 1]; positionDequant() maps them back and the renderer folds
+     * it into the model matrix. SNORM_2_10_10_10 packs a vec3 in a word,
+     * for normals and tangents. UNORM16 is for attributes in [0, 1],
+     * like most texture coordinates; others stay FLOAT.
+     */
+    enum VertexEncoding {
+        FLOAT, HALF, SNORM_2_10_10_10, UNORM16
+    };
+
     Mesh() :
             vertices_(),
             normals_(),
-            indices_(),
             float_vectors_(),
             vec2_vectors_(),
             vec3_vectors_(),
             vec4_vectors_(),
+            indices_(),
+            index_type_(GL_UNSIGNED_SHORT),
+            vertices_dirty_(true),
+            vertex_count_(0),
+            has_dequant_(false),
+            vboID_(GVR_INVALID),
+            iboID_(GVR_INVALID),
+            format_version_(0),
             have_bounding_volume_(false),
-            vao_dirty_(true),
-            boneVboID_(GVR_INVALID),
             vertexBoneData_(this),
+            boneVboID_(GVR_INVALID),
+            bone_version_(0),
             bone_data_dirty_(true)
     {
     }
@@ -69,7 +95,7 @@ public:
         vertices.swap(vertices_);
         std::vector<glm::vec3> normals;
         normals.swap(normals_);
-        std::vector<unsigned short> indices;
+        std::vector<unsigned int> indices;
         indices.swap(indices_);
 
         deleteVaos();
@@ -80,10 +106,7 @@ public:
         auto it = program_ids_.find(programId);
         if (it != program_ids_.end())
         {
-            GLVaoVboId ids = it->second;
-            deleter_->queueVertexArray(ids.vaoID);
-            deleter_->queueBuffer(ids.static_vboID);
-            deleter_->queueBuffer(ids.triangle_vboID);
+            deleter_->queueVertexArray(it->second.vaoID);
             program_ids_.erase(it);
         }
     }
@@ -91,14 +114,23 @@ public:
     void deleteVaos() {
         for (auto it : program_ids_ )
         {
-            GLVaoVboId ids = it.second;
-            deleter_->queueVertexArray(ids.vaoID);
-            deleter_->queueBuffer(ids.static_vboID);
-            deleter_->queueBuffer(ids.triangle_vboID);
+            deleter_->queueVertexArray(it.second.vaoID);
         }
         program_ids_.clear();
+        if (vboID_ != GVR_INVALID) {
+            deleter_->queueBuffer(vboID_, vbo_bytes_);
+            vboID_ = GVR_INVALID;
+        }
+        if (iboID_ != GVR_INVALID) {
+            deleter_->queueBuffer(iboID_, ibo_bytes_);
+            iboID_ = GVR_INVALID;
+        }
+        if (boneVboID_ != GVR_INVALID) {
+            deleter_->queueBuffer(boneVboID_, bone_vbo_bytes_);
+            boneVboID_ = GVR_INVALID;
+        }
         have_bounding_volume_ = false;
-        vao_dirty_ = true;
+        vertices_dirty_ = true;
         bone_data_dirty_ = true;
     }
 
@@ -110,16 +142,20 @@ public:
         vertices_ = vertices;
         have_bounding_volume_ = false;
         getBoundingVolume(); // calculate bounding volume
-        vao_dirty_ = true;
+        updateDequant();
+        verticesChanged();
         dirty();
+        boundsChanged();
     }
 
     void set_vertices(std::vector<glm::vec3>&& vertices) {
         vertices_ = std::move(vertices);
         have_bounding_volume_ = false;
         getBoundingVolume(); // calculate bounding volume
-        vao_dirty_ = true;
+        updateDequant();
+        verticesChanged();
         dirty();
+        boundsChanged();
     }
 
     const std::vector<glm::vec3>& normals() const {
@@ -128,48 +164,65 @@ public:
 
     void set_normals(const std::vector<glm::vec3>& normals) {
         normals_ = normals;
-        vao_dirty_ = true;
+        verticesChanged();
         dirty();
     }
 
     void set_normals(std::vector<glm::vec3>&& normals) {
         normals_ = std::move(normals);
-        vao_dirty_ = true;
+        verticesChanged();
         dirty();
     }
 
-    const std::vector<unsigned short>& triangles() const {
+    const std::vector<unsigned int>& triangles() const {
         return indices_;
     }
 
     void set_triangles(const std::vector<unsigned short>& triangles) {
-        indices_ = triangles;
-        vao_dirty_ = true;
-        dirty();
+        set_indices(triangles);
     }
 
-    void set_triangles(std::vector<unsigned short>&& triangles) {
-        indices_ = std::move(triangles);
-        vao_dirty_ = true;
-        dirty();
+    void set_triangles(const std::vector<unsigned int>& triangles) {
+        set_indices(triangles);
+    }
+
+    void set_triangles(std::vector<unsigned int>&& triangles) {
+        set_indices(std::move(triangles));
     }
 
-    const std::vector<unsigned short>& indices() const {
+    const std::vector<unsigned int>& indices() const {
         return indices_;
     }
 
     void set_indices(const std::vector<unsigned short>& indices) {
+        indices_.assign(indices.begin(), indices.end());
+        index_type_ = GL_UNSIGNED_SHORT;
+        verticesChanged();
+        dirty();
+    }
+
+    void set_indices(const std::vector<unsigned int>& indices) {
         indices_ = indices;
-        vao_dirty_ = true;
+        updateIndexType();
+        verticesChanged();
         dirty();
     }
 
-    void set_indices(std::vector<unsigned short>&& indices) {
+    void set_indices(std::vector<unsigned int>&& indices) {
         indices_ = std::move(indices);
-        vao_dirty_ = true;
+        updateIndexType();
+        verticesChanged();
         dirty();
     }
 
+    /*
+     * GL_UNSIGNED_SHORT when every index fits in 16 bits, else
+     * GL_UNSIGNED_INT; the type of the index buffer and of the draws.
+     */
+    GLenum indexType() const {
+        return index_type_;
+    }
+
     bool hasAttribute(std::string key) const {
         if (vec3_vectors_.find(key) != vec3_vectors_.end()) {
             return true;
@@ -199,7 +252,7 @@ public:
 
     void setFloatVector(std::string key, const std::vector<float>& vector) {
         float_vectors_[key] = vector;
-        vao_dirty_ = true;
+        verticesChanged();
     }
 
     const std::vector<glm::vec2>& getVec2Vector(std::string key) const {
@@ -228,7 +281,7 @@ public:
         if(strstr((key.c_str()),"a_texcoord")) {
             dirty();
         }
-        vao_dirty_ = true;
+        verticesChanged();
     }
 
     const std::vector<glm::vec3>& getVec3Vector(std::string key) const {
@@ -243,7 +296,7 @@ public:
 
     void setVec3Vector(std::string key, const std::vector<glm::vec3>& vector) {
         vec3_vectors_[key] = vector;
-        vao_dirty_ = true;
+        verticesChanged();
     }
 
     const std::vector<glm::vec4>& getVec4Vector(std::string key) const {
@@ -258,7 +311,7 @@ public:
 
     void setVec4Vector(std::string key, const std::vector<glm::vec4>& vector) {
         vec4_vectors_[key] = vector;
-        vao_dirty_ = true;
+        verticesChanged();
     }
 
     Mesh* createBoundingBox();
@@ -283,30 +336,81 @@ public:
 
     void setVertexAttribLocF(GLuint location, std::string key) {
         attribute_float_keys_[location] = key;
-        vao_dirty_ = true;
+        verticesChanged();
         LOGD("SHADER: setVertexAttrib %s\n", key.c_str());
     }
 
     void setVertexAttribLocV2(GLuint location, std::string key) {
         attribute_vec2_keys_[location] = key;
-        vao_dirty_ = true;
+        verticesChanged();
         LOGD("SHADER: setVertexAttrib %s\n", key.c_str());
     }
 
     void setVertexAttribLocV3(GLuint location, std::string key) {
         attribute_vec3_keys_[location] = key;
-        vao_dirty_ = true;
+        verticesChanged();
         LOGD("SHADER: setVertexAttrib %s\n", key.c_str());
     }
 
     void setVertexAttribLocV4(GLuint location, std::string key) {
         attribute_vec4_keys_[location] = key;
-        vao_dirty_ = true;
+        verticesChanged();
         LOGD("SHADER: setVertexAttrib %s\n", key.c_str());
     }
 
     const GLuint getVAOId(int programId);
 
+    // layout of the vertex buffer, as of the last encode
+    const VertexFormat& vertexFormat() const {
+        return vertex_format_;
+    }
+
+    /*
+     * The dequantization of encoded positions is folded into the model
+     * matrix, which skinning would apply after the bone transforms, so
+     * positions of a mesh with bones stay FLOAT.
+     */
+    void setAttributeEncoding(const std::string& key, VertexEncoding encoding) {
+        if (key == "a_position" && FLOAT != encoding && hasBones()) {
+            LOGW("Mesh: positions of a mesh with bones are not encoded");
+            return;
+        }
+        encodings_[key] = encoding;
+        if (key == "a_position") {
+            updateDequant();
+        }
+        verticesChanged();
+    }
+
+    /*
+     * Builds the vertex buffer contents now instead of on the GL thread
+     * at the first draw. For loader threads.
+     */
+    void encodeVertices();
+
+    /*
+     * Renumbers the vertices, remap[old index] = new index. Every
+     * per-vertex array and the indices follow, bone weights do not.
+     */
+    void remapVertices(const std::vector<unsigned int>& remap);
+
+    // bytes of vertex buffer, as of the last encode
+    size_t vertexBufferSize() const {
+        return vertex_count_ * vertex_format_.stride();
+    }
+
+    // bytes the vertex buffer would take with every attribute a float
+    size_t floatVertexSize() const;
+
+    bool hasPositionDequant() const {
+        return has_dequant_;
+    }
+
+    // model space from the encoded positions
+    const glm::mat4& positionDequant() const {
+        return dequant_;
+    }
+
     GLuint getNumTriangles() {
         return numTriangles_;
     }
@@ -320,6 +424,12 @@ public:
     void setBones(std::vector<Bone*>&& bones) {
         vertexBoneData_.setBones(std::move(bones));
         bone_data_dirty_ = true;
+        if (hasBones() && FLOAT != encodingOf("a_position")) {
+            LOGW("Mesh: bones added, positions are no longer encoded");
+            encodings_.erase("a_position");
+            updateDequant();
+            verticesChanged();
+        }
     }
 
     VertexBoneData &getVertexBoneData() {
@@ -338,15 +448,23 @@ public:
     void getAttribNames(std::set<std::string> &attrib_names);
 
     void forceShouldReset() { // one time, then false
-        vao_dirty_ = true;
+        verticesChanged();
         bone_data_dirty_ = true;
     }
 
+    // uploads changed vertex data, then sets up the VAO of the program
     void generateVAO(int programId);
 
     void add_dirty_flag(const std::shared_ptr<bool>& dirty_flag);
     void dirty();
 
+    /*
+     * The RenderData using the mesh, so new vertices move the BVH leaves
+     * of the objects drawing it. The RenderData clears the pointer when
+     * it goes away or takes another mesh, and is dropped here then.
+     */
+    void add_bounds_listener(const std::shared_ptr<RenderData*>& listener);
+
 private:
     Mesh(const Mesh& mesh);
     Mesh(Mesh&& mesh);
@@ -361,7 +479,8 @@ private:
     std::map<std::string, std::vector<glm::vec2>> vec2_vectors_;
     std::map<std::string, std::vector<glm::vec3>> vec3_vectors_;
     std::map<std::string, std::vector<glm::vec4>> vec4_vectors_;
-    std::vector<unsigned short> indices_;
+    std::vector<unsigned int> indices_;
+    GLenum index_type_;
 
     // add location slot map
     std::map<int, std::string> attribute_float_keys_;
@@ -369,31 +488,62 @@ private:
     std::map<int, std::string> attribute_vec3_keys_;
     std::map<int, std::string> attribute_vec4_keys_;
 
-    // add vertex array object and VBO
+    // one vertex and one index buffer, shared by a VAO per program
 
-    struct GLVaoVboId {
+    struct GLVaoId {
         GLuint vaoID;
-        GLuint static_vboID;
-        GLuint triangle_vboID;
+        int format_version;     // vertex_format_ the pointers were set for
+        int bone_version;
     };
 
-    std::map<GLuint, GLVaoVboId> program_ids_;
+    std::map<GLuint, GLVaoId> program_ids_;
 
-    struct GLAttributeMapping {
-        GLuint          index;
-        GLuint          size;
-        GLenum          type;
-        GLuint          offset;
-        const void*     data;
+    struct VertexSource {
+        const char* data;
+        GLint components;       // floats per vertex in data
+        GLuint offset;
+        VertexEncoding encoding;
     };
-    std::vector<GLAttributeMapping> attrMapping;
 
-    void createAttributeMapping(int programId, int& totalStride, int& attrLength);
-    void createBuffer(std::vector<GLfloat>& buffer, int attrLength);
+    void verticesChanged() {
+        vertices_dirty_ = true;
+        std::vector<char> blob;
+        vertex_blob_.swap(blob);
+    }
+
+    void updateIndexType() {
+        unsigned int max_index = 0;
+        for (auto it = indices_.begin(); it != indices_.end(); ++it) {
+            max_index = std::max(max_index, *it);
+        }
+        index_type_ = max_index > 0xffff ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
+    }
+
+    void updateDequant();
+    void boundsChanged();
+    VertexEncoding encodingOf(const std::string& key) const {
+        auto it = encodings_.find(key);
+        return it != encodings_.end() ? it->second : FLOAT;
+    }
+    void buildVertexFormat(std::vector<VertexSource>& sources);
+    void writeVertices(char* dest, const std::vector<VertexSource>& sources) const;
+    void uploadVertices();
+    void setupVAO(int programId, GLVaoId& vao);
 
     // triangle information
     GLuint numTriangles_;
-    bool vao_dirty_;
+    bool vertices_dirty_;
+    VertexFormat vertex_format_;
+    std::map<std::string, VertexEncoding> encodings_;
+    int vertex_count_;
+    std::vector<char> vertex_blob_;     // encoded ahead of the upload
+    bool has_dequant_;
+    glm::mat4 dequant_;
+    glm::vec3 quant_bias_;
+    float quant_scale_;
+    GLuint vboID_;
+    GLuint iboID_;
+    int format_version_;
     bool have_bounding_volume_;
     BoundingVolume bounding_volume;
 
@@ -403,11 +553,17 @@ private:
     GLuint boneWeightsLoc_;
 
     GLuint boneVboID_;
+    int bone_version_;
     bool bone_data_dirty_;
     GlDelete* deleter_ = nullptr;
+    // what the buffers take, for the deleter
+    size_t vbo_bytes_ = 0;
+    size_t ibo_bytes_ = 0;
+    size_t bone_vbo_bytes_ = 0;
     static std::vector<std::string> dynamicAttribute_Names_;
 
     std::unordered_set<std::shared_ptr<bool>> dirty_flags_;
+    std::unordered_set<std::shared_ptr<RenderData*>> bounds_listeners_;
 };
 }
 #endif
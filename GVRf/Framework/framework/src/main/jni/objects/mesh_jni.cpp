@@ -19,6 +19,7 @@
  ***************************************************************************/
 
 #include "mesh.h"
+#include "mesh_optimizer.h"
 
 #include "util/gvr_log.h"
 #include "util/gvr_jni.h"
@@ -59,6 +60,12 @@ extern "C" {
     JNIEXPORT void JNICALL
     Java_org_gearvrf_NativeMesh_setIndices(JNIEnv * env,
             jobject obj, jlong jmesh, jcharArray indices);
+    JNIEXPORT jintArray JNICALL
+    Java_org_gearvrf_NativeMesh_getIntIndices(JNIEnv * env,
+            jobject obj, jlong jmesh);
+    JNIEXPORT void JNICALL
+    Java_org_gearvrf_NativeMesh_setIntIndices(JNIEnv * env,
+            jobject obj, jlong jmesh, jintArray indices);
 
     JNIEXPORT void JNICALL
     Java_org_gearvrf_NativeMesh_setFloatVector(JNIEnv * env,
@@ -100,6 +107,10 @@ extern "C" {
     Java_org_gearvrf_NativeMesh_getAttribNames(JNIEnv * env,
             jobject obj, jlong jmesh);
 
+    JNIEXPORT void JNICALL
+    Java_org_gearvrf_NativeMesh_optimize(JNIEnv * env,
+            jobject obj, jlong jmesh, jboolean reduce_overdraw);
+
 };
 
 JNIEXPORT jobjectArray JNICALL
@@ -197,56 +208,77 @@ Java_org_gearvrf_NativeMesh_getTexCoords(JNIEnv * env,
     return NULL;
 }
 
+static jcharArray getCharIndices(JNIEnv * env, const char* caller, Mesh* mesh) {
+    if (GL_UNSIGNED_SHORT != mesh->indexType()) {
+        LOGE("%s: indices do not fit in 16 bits, use getIntIndices", caller);
+        return NULL;
+    }
+    const std::vector<unsigned int>& indices = mesh->indices();
+    std::vector<jchar> char_indices(indices.begin(), indices.end());
+    jcharArray jindices = env->NewCharArray(char_indices.size());
+    env->SetCharArrayRegion(jindices, 0, char_indices.size(), char_indices.data());
+    return jindices;
+}
+
+static void setCharIndices(JNIEnv * env, Mesh* mesh, jcharArray indices) {
+    jchar* jindices_pointer = env->GetCharArrayElements(indices, 0);
+    unsigned short* indices_pointer =
+            static_cast<unsigned short*>(jindices_pointer);
+    int indices_length = env->GetArrayLength(indices);
+    std::vector<unsigned short> native_indices(indices_pointer,
+            indices_pointer + indices_length);
+    mesh->set_indices(native_indices);
+    env->ReleaseCharArrayElements(indices, jindices_pointer, JNI_ABORT);
+}
+
 JNIEXPORT jcharArray JNICALL
 Java_org_gearvrf_NativeMesh_getTriangles(JNIEnv * env,
         jobject obj, jlong jmesh) {
     Mesh* mesh = reinterpret_cast<Mesh*>(jmesh);
-    const std::vector<unsigned short>& triangles = mesh->triangles();
-    jcharArray jtriangles = env->NewCharArray(triangles.size());
-    env->SetCharArrayRegion(jtriangles, 0, triangles.size(), triangles.data());
-    return jtriangles;
+    return getCharIndices(env, "getTriangles", mesh);
 }
 
 JNIEXPORT void JNICALL
 Java_org_gearvrf_NativeMesh_setTriangles(JNIEnv * env,
         jobject obj, jlong jmesh, jcharArray triangles) {
     Mesh* mesh = reinterpret_cast<Mesh*>(jmesh);
-    jchar* jtriangles_pointer = env->GetCharArrayElements(triangles, 0);
-    unsigned short* triangles_pointer =
-            static_cast<unsigned short*>(jtriangles_pointer);
-    int triangles_length = env->GetArrayLength(triangles);
-    std::vector<unsigned short> native_triangles;
-    for (int i = 0; i < triangles_length; ++i) {
-        native_triangles.push_back(triangles_pointer[i]);
-    }
-    mesh->set_triangles(native_triangles);
-    env->ReleaseCharArrayElements(triangles, jtriangles_pointer, 0);
+    setCharIndices(env, mesh, triangles);
 }
 
 JNIEXPORT jcharArray JNICALL
 Java_org_gearvrf_NativeMesh_getIndices(JNIEnv * env,
         jobject obj, jlong jmesh) {
     Mesh* mesh = reinterpret_cast<Mesh*>(jmesh);
-    const std::vector<unsigned short>& indices = mesh->indices();
-    jcharArray jindices = env->NewCharArray(indices.size());
-    env->SetCharArrayRegion(jindices, 0, indices.size(), indices.data());
-    return jindices;
+    return getCharIndices(env, "getIndices", mesh);
 }
 
 JNIEXPORT void JNICALL
 Java_org_gearvrf_NativeMesh_setIndices(JNIEnv * env,
         jobject obj, jlong jmesh, jcharArray indices) {
     Mesh* mesh = reinterpret_cast<Mesh*>(jmesh);
-    jchar* jindices_pointer = env->GetCharArrayElements(indices, 0);
-    unsigned short* indices_pointer =
-            static_cast<unsigned short*>(jindices_pointer);
+    setCharIndices(env, mesh, indices);
+}
+
+JNIEXPORT jintArray JNICALL
+Java_org_gearvrf_NativeMesh_getIntIndices(JNIEnv * env,
+        jobject obj, jlong jmesh) {
+    Mesh* mesh = reinterpret_cast<Mesh*>(jmesh);
+    const std::vector<unsigned int>& indices = mesh->indices();
+    jintArray jindices = env->NewIntArray(indices.size());
+    env->SetIntArrayRegion(jindices, 0, indices.size(),
+            reinterpret_cast<const jint*>(indices.data()));
+    return jindices;
+}
+
+JNIEXPORT void JNICALL
+Java_org_gearvrf_NativeMesh_setIntIndices(JNIEnv * env,
+        jobject obj, jlong jmesh, jintArray indices) {
+    Mesh* mesh = reinterpret_cast<Mesh*>(jmesh);
     int indices_length = env->GetArrayLength(indices);
-    std::vector<unsigned short> native_indices;
-    for (int i = 0; i < indices_length; ++i) {
-        native_indices.push_back(indices_pointer[i]);
-    }
-    mesh->set_indices(native_indices);
-    env->ReleaseCharArrayElements(indices, jindices_pointer, 0);
+    std::vector<unsigned int> native_indices(indices_length);
+    env->GetIntArrayRegion(indices, 0, indices_length,
+            reinterpret_cast<jint*>(native_indices.data()));
+    mesh->set_indices(std::move(native_indices));
 }
 
 JNIEXPORT jfloatArray JNICALL
@@ -429,4 +461,11 @@ Java_org_gearvrf_NativeMesh_getSphereBound(JNIEnv * env,
     sphere[3] = bvol.radius();
     env->SetFloatArrayRegion(jsphere, 0, 4, sphere);
 }
+
+JNIEXPORT void JNICALL
+Java_org_gearvrf_NativeMesh_optimize(JNIEnv * env,
+        jobject obj, jlong jmesh, jboolean reduce_overdraw) {
+    Mesh* mesh = reinterpret_cast<Mesh*>(jmesh);
+    MeshOptimizer::optimize(mesh, reduce_overdraw);
+}
 }
@@ -0,0 +1,333 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Reorders the triangles and vertices of a mesh for the GPU.
+ ***************************************************************************/
+
+#include "mesh_optimizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "objects/mesh.h"
+#include "util/gvr_log.h"
+
+namespace gvr {
+
+namespace {
+
+const float CACHE_DECAY_POWER = 1.5f;
+const float LAST_TRIANGLE_SCORE = 0.75f;
+const float VALENCE_BOOST_SCALE = 2.0f;
+const float VALENCE_BOOST_POWER = 0.5f;
+
+// a cluster ends at a triangle that misses the cache on every vertex
+const size_t MIN_CLUSTER_TRIANGLES = 32;
+
+float vertexScore(int cache_position, int valence) {
+    if (valence == 0) {
+        return -1.0f; // nothing left to draw with it
+    }
+    float score = 0.0f;
+    if (cache_position >= 0) {
+        if (cache_position < 3) {
+            // used by the last triangle, an immediate reuse gains nothing
+            score = LAST_TRIANGLE_SCORE;
+        } else {
+            float scaler = 1.0f / (MeshOptimizer::CACHE_SIZE - 3);
+            score = std::pow(1.0f - (cache_position - 3) * scaler, CACHE_DECAY_POWER);
+        }
+    }
+    // favour vertices with few triangles left so they leave the mesh early
+    score += VALENCE_BOOST_SCALE * std::pow((float) valence, -VALENCE_BOOST_POWER);
+    return score;
+}
+
+}
+
+float MeshOptimizer::acmr(const std::vector<unsigned int>& indices,
+        unsigned int vertex_count) {
+    size_t triangles = indices.size() / 3;
+    if (triangles == 0) {
+        return 0.0f;
+    }
+    std::vector<unsigned int> cache_time(vertex_count, 0);
+    unsigned int time = CACHE_SIZE + 1;
+    size_t misses = 0;
+    for (size_t i = 0; i < triangles * 3; ++i) {
+        unsigned int v = indices[i];
+        if (time - cache_time[v] > CACHE_SIZE) {
+            cache_time[v] = time++;
+            ++misses;
+        }
+    }
+    return (float) misses / triangles;
+}
+
+void MeshOptimizer::optimizeVertexCache(std::vector<unsigned int>& indices,
+        unsigned int vertex_count) {
+    size_t triangle_count = indices.size() / 3;
+    if (triangle_count == 0) {
+        return;
+    }
+
+    // triangles of each vertex
+    std::vector<unsigned int> offsets(vertex_count + 1, 0);
+    for (size_t i = 0; i < triangle_count * 3; ++i) {
+        ++offsets[indices[i] + 1];
+    }
+    for (unsigned int v = 0; v < vertex_count; ++v) {
+        offsets[v + 1] += offsets[v];
+    }
+    std::vector<unsigned int> adjacency(triangle_count * 3);
+    std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < triangle_count * 3; ++i) {
+        adjacency[fill[indices[i]]++] = i / 3;
+    }
+
+    std::vector<int> valence(vertex_count);
+    std::vector<int> cache_position(vertex_count, -1);
+    std::vector<float> vertex_scores(vertex_count);
+    for (unsigned int v = 0; v < vertex_count; ++v) {
+        valence[v] = offsets[v + 1] - offsets[v];
+        vertex_scores[v] = vertexScore(-1, valence[v]);
+    }
+
+    std::vector<float> triangle_scores(triangle_count);
+    std::vector<bool> emitted(triangle_count, false);
+    for (size_t t = 0; t < triangle_count; ++t) {
+        triangle_scores[t] = vertex_scores[indices[t * 3]]
+                + vertex_scores[indices[t * 3 + 1]]
+                + vertex_scores[indices[t * 3 + 2]];
+    }
+
+    std::vector<unsigned int> ordered;
+    ordered.reserve(triangle_count * 3);
+    // the LRU cache, three spare slots for the vertices pushed out
+    std::vector<unsigned int> cache;
+    std::vector<unsigned int> next_cache;
+    cache.reserve(CACHE_SIZE + 3);
+    next_cache.reserve(CACHE_SIZE + 3);
+
+    size_t scan = 0;
+    long best = std::max_element(triangle_scores.begin(), triangle_scores.end())
+            - triangle_scores.begin();
+
+    while (best >= 0) {
+        emitted[best] = true;
+        const unsigned int* tri = &indices[best * 3];
+
+        next_cache.clear();
+        for (int k = 0; k < 3; ++k) {
+            unsigned int v = tri[k];
+            ordered.push_back(v);
+            next_cache.push_back(v);
+
+            // drop the triangle from the vertex' list of remaining ones
+            unsigned int* begin = &adjacency[offsets[v]];
+            unsigned int* end = begin + valence[v];
+            unsigned int* found = std::find(begin, end, (unsigned int) best);
+            std::swap(*found, *(end - 1));
+            --valence[v];
+        }
+        for (auto it = cache.begin(); it != cache.end(); ++it) {
+            unsigned int v = *it;
+            if (v != tri[0] && v != tri[1] && v != tri[2]) {
+                next_cache.push_back(v);
+            }
+        }
+        cache.swap(next_cache);
+
+        // rescore what is in the cache and what just fell out of it
+        for (size_t i = 0; i < cache.size(); ++i) {
+            unsigned int v = cache[i];
+            int position = i < (size_t) CACHE_SIZE ? (int) i : -1;
+            cache_position[v] = position;
+            float score = vertexScore(position, valence[v]);
+            float delta = score - vertex_scores[v];
+            vertex_scores[v] = score;
+            for (int j = 0; j < valence[v]; ++j) {
+                triangle_scores[adjacency[offsets[v] + j]] += delta;
+            }
+        }
+        if (cache.size() > (size_t) CACHE_SIZE) {
+            cache.resize(CACHE_SIZE);
+        }
+
+        // best triangle touching the cache, or the next one left over
+        best = -1;
+        float best_score = -1.0f;
+        for (auto it = cache.begin(); it != cache.end(); ++it) {
+            unsigned int v = *it;
+            for (int j = 0; j < valence[v]; ++j) {
+                unsigned int t = adjacency[offsets[v] + j];
+                if (triangle_scores[t] > best_score) {
+                    best_score = triangle_scores[t];
+                    best = t;
+                }
+            }
+        }
+        if (best < 0) {
+            while (scan < triangle_count && emitted[scan]) {
+                ++scan;
+            }
+            if (scan < triangle_count) {
+                best = scan;
+            }
+        }
+    }
+    indices.swap(ordered);
+}
+
+void MeshOptimizer::reduceOverdraw(std::vector<unsigned int>& indices,
+        const Mesh* mesh) {
+    const std::vector<glm::vec3>& vertices = mesh->vertices();
+    size_t triangle_count = indices.size() / 3;
+    if (triangle_count < MIN_CLUSTER_TRIANGLES * 2) {
+        return;
+    }
+
+    // cut where the cache order starts over anyway, so the cache cost stays
+    std::vector<size_t> starts;
+    std::vector<unsigned int> cache_time(vertices.size(), 0);
+    unsigned int time = CACHE_SIZE + 1;
+    starts.push_back(0);
+    for (size_t t = 0; t < triangle_count; ++t) {
+        int misses = 0;
+        for (int k = 0; k < 3; ++k) {
+            unsigned int v = indices[t * 3 + k];
+            if (time - cache_time[v] > CACHE_SIZE) {
+                cache_time[v] = time++;
+                ++misses;
+            }
+        }
+        if (misses == 3 && t - starts.back() >= MIN_CLUSTER_TRIANGLES) {
+            starts.push_back(t);
+        }
+    }
+    starts.push_back(triangle_count);
+    size_t cluster_count = starts.size() - 1;
+    if (cluster_count < 2) {
+        return;
+    }
+
+    // clusters facing away from the middle of the mesh draw first
+    glm::vec3 mesh_centroid(0.0f);
+    float mesh_area = 0.0f;
+    std::vector<glm::vec3> centroids(cluster_count);
+    std::vector<glm::vec3> normals(cluster_count);
+    for (size_t c = 0; c < cluster_count; ++c) {
+        glm::vec3 centroid(0.0f);
+        glm::vec3 normal(0.0f);
+        float area = 0.0f;
+        for (size_t t = starts[c]; t < starts[c + 1]; ++t) {
+            const glm::vec3& p0 = vertices[indices[t * 3]];
+            const glm::vec3& p1 = vertices[indices[t * 3 + 1]];
+            const glm::vec3& p2 = vertices[indices[t * 3 + 2]];
+            glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+            float a = glm::length(n);
+            centroid += (p0 + p1 + p2) * (a / 3.0f);
+            normal += n;
+            area += a;
+        }
+        mesh_centroid += centroid;
+        mesh_area += area;
+        centroids[c] = area > 0.0f ? centroid / area : vertices[indices[starts[c] * 3]];
+        normals[c] = normal;
+    }
+    if (mesh_area <= 0.0f) {
+        return;
+    }
+    mesh_centroid /= mesh_area;
+
+    std::vector<std::pair<float, size_t>> keys(cluster_count);
+    for (size_t c = 0; c < cluster_count; ++c) {
+        float length = glm::length(normals[c]);
+        glm::vec3 n = length > 0.0f ? normals[c] / length : glm::vec3(0.0f);
+        keys[c] = std::make_pair(-glm::dot(centroids[c] - mesh_centroid, n), c);
+    }
+    std::stable_sort(keys.begin(), keys.end(),
+            [](const std::pair<float, size_t>& a, const std::pair<float, size_t>& b) {
+                return a.first < b.first;
+            });
+
+    std::vector<unsigned int> sorted;
+    sorted.reserve(indices.size());
+    for (auto it = keys.begin(); it != keys.end(); ++it) {
+        size_t c = it->second;
+        sorted.insert(sorted.end(), indices.begin() + starts[c] * 3,
+                indices.begin() + starts[c + 1] * 3);
+    }
+    sorted.insert(sorted.end(), indices.begin() + triangle_count * 3, indices.end());
+    indices.swap(sorted);
+}
+
+void MeshOptimizer::fetchOrder(const std::vector<unsigned int>& indices,
+        unsigned int vertex_count, std::vector<unsigned int>& remap) {
+    const unsigned int unused = ~0u;
+    remap.assign(vertex_count, unused);
+    unsigned int next = 0;
+    for (auto it = indices.begin(); it != indices.end(); ++it) {
+        if (remap[*it] == unused) {
+            remap[*it] = next++;
+        }
+    }
+    // vertices no triangle uses keep their relative order at the end
+    for (unsigned int v = 0; v < vertex_count; ++v) {
+        if (remap[v] == unused) {
+            remap[v] = next++;
+        }
+    }
+}
+
+bool MeshOptimizer::optimize(Mesh* mesh, bool reduce_overdraw) {
+    std::vector<unsigned int> indices = mesh->indices();
+    unsigned int vertex_count = mesh->vertices().size();
+    if (indices.size() < 3 || vertex_count == 0) {
+        return false;
+    }
+    for (auto it = indices.begin(); it != indices.end(); ++it) {
+        if (*it >= vertex_count) {
+            LOGE("MeshOptimizer: index %u out of range of %u vertices", *it, vertex_count);
+            return false;
+        }
+    }
+
+    float before = acmr(indices, vertex_count);
+    optimizeVertexCache(indices, vertex_count);
+    float reordered = acmr(indices, vertex_count);
+    if (reduce_overdraw) {
+        reduceOverdraw(indices, mesh);
+    }
+    float after = acmr(indices, vertex_count);
+    mesh->set_indices(std::move(indices));
+
+    if (!mesh->hasBones()) {
+        std::vector<unsigned int> remap;
+        fetchOrder(mesh->indices(), vertex_count, remap);
+        mesh->remapVertices(remap);
+    }
+    if (reduce_overdraw) {
+        LOGI("MeshOptimizer: %u triangles, ACMR %.3f -> %.3f (%.3f before overdraw sort)",
+                (unsigned int) mesh->indices().size() / 3, before, after, reordered);
+    } else {
+        LOGI("MeshOptimizer: %u triangles, ACMR %.3f -> %.3f",
+                (unsigned int) mesh->indices().size() / 3, before, after);
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,70 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Reorders the triangles and vertices of a mesh for the GPU.
+ ***************************************************************************/
+
+#ifndef MESH_OPTIMIZER_H_
+#define MESH_OPTIMIZER_H_
+
+#include <vector>
+
+namespace gvr {
+class Mesh;
+
+/*
+ * Import time optimization of indexed triangle lists:
+ *
+ * - triangles are reordered for the post-transform vertex cache with
+ *   Forsyth's linear-speed algorithm,
+ * - optionally, the reordered list is cut into clusters that are then
+ *   sorted outside in, so near-convex parts tend to draw their front
+ *   faces first and occlude the rest (after Sander et al., "Fast
+ *   triangle reordering for vertex locality and reduced overdraw"),
+ * - vertices are renumbered in first-use order so vertex fetch walks
+ *   the buffer forwards. Skinned meshes keep their vertex order, their
+ *   bone weights refer to it.
+ *
+ * Cache behaviour is modelled as a FIFO of CACHE_SIZE entries and
+ * reported as ACMR, the average number of vertices transformed per
+ * triangle (0.5 at best for a regular grid, 3 at worst).
+ */
+class MeshOptimizer {
+public:
+    static const int CACHE_SIZE = 16;
+
+    // returns false when the mesh has no indexed triangles to optimize
+    static bool optimize(Mesh* mesh, bool reduce_overdraw);
+
+    static float acmr(const std::vector<unsigned int>& indices,
+            unsigned int vertex_count);
+
+    static void optimizeVertexCache(std::vector<unsigned int>& indices,
+            unsigned int vertex_count);
+
+    static void reduceOverdraw(std::vector<unsigned int>& indices,
+            const Mesh* mesh);
+
+    // remap[old vertex] = new vertex, in first-use order
+    static void fetchOrder(const std::vector<unsigned int>& indices,
+            unsigned int vertex_count, std::vector<unsigned int>& remap);
+
+private:
+    MeshOptimizer();
+};
+
+}
+#endif
@@ -0,0 +1,48 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "render_data_state.h"
+
+namespace gvr {
+
+RenderDataStateTable* RenderDataStateTable::instance_ = new RenderDataStateTable();
+
+RenderDataStateTable* RenderDataStateTable::getInstance() {
+    return instance_;
+}
+
+// 64-bit FNV-1a over the packed bytes
+uint64_t RenderDataState::hash() const {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(this);
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < sizeof(*this); ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+int RenderDataStateTable::intern(const RenderDataState& state) {
+    std::lock_guard < std::mutex > lock(mutex_);
+    auto it = ids_.find(state);
+    if (it != ids_.end()) {
+        return it->second;
+    }
+    int id = ids_.size();
+    ids_.insert(std::make_pair(state, id));
+    return id;
+}
+
+}
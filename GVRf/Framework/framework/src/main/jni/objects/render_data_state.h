@@ -0,0 +1,101 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * The GL state a RenderData draws with, interned to a small integer id.
+ ***************************************************************************/
+
+#ifndef RENDER_DATA_STATE_H_
+#define RENDER_DATA_STATE_H_
+
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
+#include "gl/gl_headers.h"
+
+namespace gvr {
+class Light;
+
+/*
+ * Packed copy of the RenderData fields that decide GL state. Always
+ * built from a zeroed struct so the padding compares and hashes equal.
+ */
+struct RenderDataState {
+    Light*    light;
+    float     offset_factor;
+    float     offset_units;
+    float     sample_coverage;
+    GLenum    draw_mode;
+    int       render_mask;
+    bool      use_light;
+    bool      use_lightmap;
+    bool      offset;
+    bool      depth_test;
+    bool      alpha_blend;
+    bool      alpha_to_coverage;
+    GLboolean invert_coverage_mask;
+
+    RenderDataState() {
+        memset(this, 0, sizeof(*this));
+    }
+
+    uint64_t hash() const;
+
+    bool operator==(const RenderDataState& state) const {
+        return 0 == memcmp(this, &state, sizeof(*this));
+    }
+};
+
+/*
+ * Hands out one id per distinct RenderDataState, starting at 0, so two
+ * render data have the same state exactly when their ids are equal.
+ * Ids are never released; the number of distinct states in an app is
+ * small.
+ */
+class RenderDataStateTable {
+public:
+    static RenderDataStateTable* getInstance();
+
+    int intern(const RenderDataState& state);
+
+    int size() {
+        std::lock_guard < std::mutex > lock(mutex_);
+        return ids_.size();
+    }
+
+private:
+    RenderDataStateTable() {
+    }
+    RenderDataStateTable(const RenderDataStateTable& table);
+    RenderDataStateTable(RenderDataStateTable&& table);
+    RenderDataStateTable& operator=(const RenderDataStateTable& table);
+    RenderDataStateTable& operator=(RenderDataStateTable&& table);
+
+    struct Hasher {
+        size_t operator()(const RenderDataState& state) const {
+            return state.hash();
+        }
+    };
+
+private:
+    static RenderDataStateTable* instance_;
+    std::mutex mutex_;
+    std::unordered_map<RenderDataState, int, Hasher> ids_;
+};
+
+}
+#endif
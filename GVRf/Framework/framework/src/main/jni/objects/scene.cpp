@@ -33,12 +33,15 @@ Scene::Scene() :
         occlusion_flag_(false),
         pick_visible_(true),
         is_shadowmap_invalid(true) {
+    // everything added under the root joins the hierarchy from here on
+    bvh_.insert(&scene_root_);
     if (main_scene() == NULL) {
         set_main_scene(this);
     }
 }
 
 Scene::~Scene() {
+    bvh_.clear();
 }
 
 void Scene::addSceneObject(SceneObject* scene_object) {
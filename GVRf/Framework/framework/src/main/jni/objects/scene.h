@@ -25,6 +25,7 @@
 #include <vector>
 #include <mutex>
 
+#include "objects/bvh.h"
 #include "objects/hybrid_object.h"
 #include "components/camera_rig.h"
 #include "engine/renderer/renderer.h"
@@ -38,6 +39,7 @@ public:
     Scene();
     virtual ~Scene();
     SceneObject* getRoot() { return &scene_root_; }
+    BVH& bvh() { return bvh_; }
     void addSceneObject(SceneObject* scene_object);
     void removeSceneObject(SceneObject* scene_object);
     void removeAllSceneObjects();
@@ -80,6 +82,25 @@ public:
             return gRenderer->getNumberTriangles();
         }
     }
+    int getNumberInstances() {
+        if(nullptr!= gRenderer) {
+            return gRenderer->getNumberInstances();
+        }
+        return 0;
+    }
+
+    int getNumberStateChanges() {
+        if(nullptr!= gRenderer) {
+            return gRenderer->getNumberStateChanges();
+        }
+        return 0;
+    }
+    int getNumberSkippedStateChanges() {
+        if(nullptr!= gRenderer) {
+            return gRenderer->getNumberSkippedStateChanges();
+        }
+        return 0;
+    }
 
     void exportToFile(std::string filepath);
 
@@ -138,6 +159,16 @@ public:
      */
     void pick(SceneObject* sceneobj);
 
+    /*
+     * Appends colliders gathered during culling to the
+     * visible collider list. Does not lock the collider list.
+     */
+    void addVisibleColliders(const std::vector<Component*>& colliders) {
+        if (pick_visible_) {
+            visibleColliders.insert(visibleColliders.end(), colliders.begin(), colliders.end());
+        }
+    }
+
     /*
      * Get the current collider list and lock it.
      * If set_pick_visible is set the visible collider list
@@ -173,6 +204,7 @@ private:
 
 private:
     static Scene* main_scene_;
+    BVH bvh_;
     SceneObject scene_root_;
     CameraRig* main_camera_rig_;
     int dirtyFlag_;
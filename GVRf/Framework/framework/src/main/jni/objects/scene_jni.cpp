@@ -67,6 +67,18 @@ extern "C" {
     Java_org_gearvrf_NativeScene_getNumberTriangles(JNIEnv * env,
             jobject obj, jlong jscene);
 
+    JNIEXPORT int JNICALL
+    Java_org_gearvrf_NativeScene_getNumberInstances(JNIEnv * env,
+            jobject obj, jlong jscene);
+
+    JNIEXPORT int JNICALL
+    Java_org_gearvrf_NativeScene_getNumberStateChanges(JNIEnv * env,
+            jobject obj, jlong jscene);
+
+    JNIEXPORT int JNICALL
+    Java_org_gearvrf_NativeScene_getNumberSkippedStateChanges(JNIEnv * env,
+            jobject obj, jlong jscene);
+
     JNIEXPORT jboolean JNICALL
     Java_org_gearvrf_NativeScene_addLight(
             JNIEnv * env, jobject obj, jlong jscene, jlong light);
@@ -174,6 +186,27 @@ Java_org_gearvrf_NativeScene_getNumberTriangles(JNIEnv * env,
     return scene->getNumberTriangles();
 }
 
+JNIEXPORT int JNICALL
+Java_org_gearvrf_NativeScene_getNumberInstances(JNIEnv * env,
+        jobject obj, jlong jscene) {
+    Scene* scene = reinterpret_cast<Scene*>(jscene);
+    return scene->getNumberInstances();
+}
+
+JNIEXPORT int JNICALL
+Java_org_gearvrf_NativeScene_getNumberStateChanges(JNIEnv * env,
+        jobject obj, jlong jscene) {
+    Scene* scene = reinterpret_cast<Scene*>(jscene);
+    return scene->getNumberStateChanges();
+}
+
+JNIEXPORT int JNICALL
+Java_org_gearvrf_NativeScene_getNumberSkippedStateChanges(JNIEnv * env,
+        jobject obj, jlong jscene) {
+    Scene* scene = reinterpret_cast<Scene*>(jscene);
+    return scene->getNumberSkippedStateChanges();
+}
+
 JNIEXPORT void JNICALL
 Java_org_gearvrf_NativeScene_exportToFile(JNIEnv * env,
         jobject obj, jlong jscene, jstring filepath) {
@@ -19,6 +19,7 @@
 
 #include "scene_object.h"
 
+#include "objects/bvh.h"
 #include "objects/components/camera.h"
 #include "objects/components/camera_rig.h"
 #include "objects/components/collider_group.h"
@@ -31,17 +32,16 @@ bool SceneObject::using_lod_ = false;
 
 SceneObject::SceneObject() :
         HybridObject(), name_(""), children_(), visible_(true), transform_dirty_(false), in_frustum_(
-                false),  enabled_(true),query_currently_issued_(false), vis_count_(0), lod_min_range_(
+                false),  enabled_(true), lod_min_range_(
                 0), lod_max_range_(MAXFLOAT), cull_status_(false), bounding_volume_dirty_(
-                true) {
-
-    // Occlusion query setup
-    queries_ = new GLuint[1];
-    glGenQueries(1, queries_);
+                true), bvh_(nullptr), bvh_index_(-1), bvh_leaf_(-1), bvh_dirty_(false),
+                bvh_visible_frame_(0) {
 }
 
 SceneObject::~SceneObject() {
-    delete queries_;
+    if (nullptr != bvh_) {
+        bvh_->remove(this);
+    }
 }
 
 bool SceneObject::attachComponent(Component* component) {
@@ -120,7 +120,15 @@ void SceneObject::addChildObject(SceneObject* self, SceneObject* child) {
     child->parent_ = self;
     Transform* const t = child->transform();
     if (nullptr != t) {
-        t->invalidate(false);
+        t->set_parent(self->transform());
+    }
+    if (child->bvh_ != bvh_) {
+        if (nullptr != child->bvh_) {
+            child->bvh_->remove(child);
+        }
+        if (nullptr != bvh_) {
+            bvh_->insert(child);
+        }
     }
     dirtyHierarchicalBoundingVolume();
 }
@@ -132,11 +140,14 @@ void SceneObject::removeChildObject(SceneObject* child) {
             children_.erase(std::remove(children_.begin(), children_.end(), child), children_.end());
         }
         child->parent_ = NULL;
+        if (nullptr != child->bvh_) {
+            child->bvh_->remove(child);
+        }
     }
 
     Transform* const t = child->transform();
     if (nullptr != t) {
-        t->invalidate(false);
+        t->set_parent((nullptr != child->parent_) ? child->parent_->transform() : nullptr);
     }
     dirtyHierarchicalBoundingVolume();
 }
@@ -146,6 +157,13 @@ void SceneObject::clear() {
     for (auto it = children_.begin(); it != children_.end(); ++it) {
         SceneObject* child = *it;
         child->parent_ = NULL;
+        Transform* const t = child->transform();
+        if (nullptr != t) {
+            t->set_parent(nullptr);
+        }
+        if (nullptr != child->bvh_) {
+            child->bvh_->remove(child);
+        }
     }
     children_.clear();
 }
@@ -172,29 +190,6 @@ void SceneObject::getDescendants(std::vector<SceneObject*>& descendants) {
     }
 }
 
-void SceneObject::set_visible(bool visibility = true) {
-
-    //HACK
-    //If checked every frame, queries may return
-    //an inconsistent result when used with bounding boxes.
-
-    //We need to make sure that the object's visibility status is consistent before
-    //changing the status to avoid flickering artifacts.
-
-    if (visibility == true)
-        vis_count_++;
-    else
-        vis_count_--;
-
-    if (vis_count_ > check_frames_) {
-        visible_ = true;
-        vis_count_ = 0;
-    } else if (vis_count_ < (-1 * check_frames_)) {
-        visible_ = false;
-        vis_count_ = 0;
-    }
-}
-
 bool SceneObject::isColliding(SceneObject *scene_object) {
 
     //Get the transformed bounding boxes in world coordinates and check if they intersect
@@ -321,6 +316,14 @@ bool SceneObject::intersectsBoundingVolume(SceneObject *scene_object) {
 }
 
 void SceneObject::dirtyHierarchicalBoundingVolume() {
+    // only this object's own box moved, the ancestors just grow or shrink
+    if (nullptr != bvh_ && !bvh_dirty_) {
+        bvh_->markDirty(this);
+    }
+    dirtyBoundingVolumeChain();
+}
+
+void SceneObject::dirtyBoundingVolumeChain() {
     if (bounding_volume_dirty_) {
         return;
     }
@@ -328,7 +331,7 @@ void SceneObject::dirtyHierarchicalBoundingVolume() {
     bounding_volume_dirty_ = true;
 
     if (parent_ != NULL) {
-        parent_->dirtyHierarchicalBoundingVolume();
+        parent_->dirtyBoundingVolumeChain();
     }
 }
 
@@ -363,9 +366,9 @@ BoundingVolume& SceneObject::getBoundingVolume() {
     return transformed_bounding_volume_;
 }
 
+// the planes from Renderer::build_frustum are already normalized
 float planeDistanceToPoint(float plane[4], glm::vec3 &compare_point) {
     glm::vec3 normal = glm::vec3(plane[0], plane[1], plane[2]);
-    glm::normalize(normal);
     float distance_to_origin = plane[3];
     float distance = glm::dot(compare_point, normal) + distance_to_origin;
 
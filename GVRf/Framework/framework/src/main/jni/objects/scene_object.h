@@ -33,6 +33,7 @@
 #include "util/gvr_gl.h"
 
 namespace gvr {
+class BVH;
 class Camera;
 class CameraRig;
 
@@ -65,17 +66,12 @@ public:
         return in_frustum_;
     }
 
-    void set_visible(bool visibility);
-    bool visible() const {
-        return visible_;
-    }
-
-    void set_query_issued(bool issued = true) {
-        query_currently_issued_ = issued;
+    void set_visible(bool visibility = true) {
+        visible_ = visibility;
     }
 
-    bool is_query_issued() {
-        return query_currently_issued_;
+    bool visible() const {
+        return visible_;
     }
 
     bool attachComponent(Component* component);
@@ -135,9 +131,6 @@ public:
     void clear();
     int getChildrenCount() const;
     SceneObject* getChildByIndex(int index);
-    GLuint *get_occlusion_array() {
-        return queries_;
-    }
     bool isColliding(SceneObject* scene_object);
     bool intersectsBoundingVolume(float rox, float roy, float roz, float rdx,
             float rdy, float rdz);
@@ -157,6 +150,10 @@ public:
         return lod_max_range_;
     }
 
+    static bool using_lod() {
+        return using_lod_;
+    }
+
     bool inLODRange(float distance_from_camera) {
         if (!using_lod_) {
             return true;
@@ -173,6 +170,11 @@ public:
 
     int frustumCull(glm::vec3 camera_position, const float frustum[6][4], int& planeMask);
 
+private:
+    friend class BVH;
+
+    void dirtyBoundingVolumeChain();
+
 private:
     std::string name_;
     std::vector<Component*> components_;
@@ -187,15 +189,16 @@ private:
     bool bounding_volume_dirty_;
     BoundingVolume mesh_bounding_volume;
 
-    //Flags to check for visibility of a node and
-    //whether there are any pending occlusion queries on it
-    const int check_frames_ = 12;
-    int vis_count_;
+    // membership in the scene's BVH, maintained by BVH
+    BVH* bvh_;
+    int bvh_index_;
+    int bvh_leaf_;
+    bool bvh_dirty_;
+    unsigned int bvh_visible_frame_;    // last cull() that returned it
+
     bool visible_;
     bool enabled_;
     bool in_frustum_;
-    bool query_currently_issued_;
-    GLuint *queries_ = nullptr;
 
     SceneObject(const SceneObject& scene_object);
     SceneObject(SceneObject&& scene_object);
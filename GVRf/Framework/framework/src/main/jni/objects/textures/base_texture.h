@@ -23,6 +23,7 @@
 #include "objects/textures/texture.h"
 #include "util/gvr_log.h"
 #include "util/jni_utils.h"
+#include "gl/gl_state_cache.h"
 
 namespace gvr {
 
@@ -57,10 +58,12 @@ public:
     }
 
     bool update(int width, int height, void* data) {
-        glBindTexture(GL_TEXTURE_2D, gl_texture_->id());
+        GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, gl_texture_->id());
         glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, width, height, 0,
                 GL_LUMINANCE, GL_UNSIGNED_BYTE, data);
         glGenerateMipmap (GL_TEXTURE_2D);
+        // a third more for the mipmaps
+        gl_texture_->setByteSize(size_t(width) * height * 4 / 3);
         return (glGetError() == 0) ? 1 : 0;
     }
 
@@ -20,10 +20,14 @@
 #ifndef compressed_texture_H_
 #define compressed_texture_H_
 
+#include <memory>
+
+#include "objects/textures/ktx_file.h"
 #include "objects/textures/texture.h"
 #include "util/gvr_jni.h"
 #include "util/gvr_log.h"
 #include "util/jni_utils.h"
+#include "gl/gl_state_cache.h"
 
 namespace gvr {
 class CompressedTexture: public Texture {
@@ -41,33 +45,26 @@ public:
             GLsizei width, GLsizei height, GLsizei imageSize, jbyteArray bytes,
             int dataOffset, int* texture_parameters) :
             Texture(new GLTexture(target, texture_parameters)), target(target) {
-        pending_gl_task_ = GL_TASK_INIT_INTERNAL_FORMAT;
-        if (JNI_OK != env->GetJavaVM(&javaVm_)) {
-            FAIL("GetJavaVM failed");
-        }
-
-        internalFormat_ = internalFormat;
-        width_ = width;
-        height_ = height;
-        imageSize_ = imageSize;
-        bytesRef_ = static_cast<jbyteArray>(env->NewGlobalRef(bytes));
-        dataOffset_ = dataOffset;
-    }
-
-    virtual ~CompressedTexture() {
-        JNIEnv* env = getCurrentEnv(javaVm_);
+        pending_gl_task_ = GL_TASK_NONE;
 
-        // Release global refs. Race condition does not occur because if
-        // the runPendingGL is running, the object won't be destructed.
-        switch (pending_gl_task_) {
-        case GL_TASK_INIT_INTERNAL_FORMAT: {
-            env->DeleteGlobalRef(bytesRef_);
-            break;
-        }
+        // Copied here, on the loading thread, so the array is not pinned
+        // on the GL thread later
+        std::shared_ptr<TextureUpload> upload =
+                std::make_shared<TextureUpload>(target, texture_parameters);
+        void* data = upload->addImage(target, 0, internalFormat, width, height,
+                0, 0, imageSize);
+        env->GetByteArrayRegion(bytes, dataOffset, imageSize, static_cast<jbyte*>(data));
+        gl_texture_->setUpload(upload);
+    }
 
-        default:
-            break;
-        }
+    // The constructor to use with a mapped KTX file, streamed smallest levels first
+    explicit CompressedTexture(const std::shared_ptr<KtxFile>& file,
+            int* texture_parameters) :
+            Texture(new GLTexture(file->faces() == 6 ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D,
+                    texture_parameters)),
+            target(file->faces() == 6 ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D) {
+        pending_gl_task_ = GL_TASK_NONE;
+        gl_texture_->setUpload(KtxFile::createUpload(file, texture_parameters));
     }
 
     GLenum getTarget() const {
@@ -82,22 +79,9 @@ public:
             return;
 
         case GL_TASK_INIT_PLAIN:
-            glBindTexture(target, gl_texture_->id());
+            GLStateCache::getInstance()->bindTexture(target, gl_texture_->id());
             break;
 
-        case GL_TASK_INIT_INTERNAL_FORMAT: {
-            JNIEnv* env = getCurrentEnv(javaVm_);
-            jbyte* data = env->GetByteArrayElements(bytesRef_, 0);
-
-            glBindTexture(target, gl_texture_->id());
-            glCompressedTexImage2D(target, 0, internalFormat_, width_, height_, 0,
-                    imageSize_, data + dataOffset_);
-
-            env->ReleaseByteArrayElements(bytesRef_, data, 0);
-            env->DeleteGlobalRef(bytesRef_);
-            break;
-        }
-
         } // switch
 
         pending_gl_task_ = GL_TASK_NONE;
@@ -117,19 +101,8 @@ private:
     enum {
         GL_TASK_NONE = 0,
         GL_TASK_INIT_PLAIN,
-        GL_TASK_INIT_INTERNAL_FORMAT,
     };
     int pending_gl_task_;
-
-    JavaVM* javaVm_;
-
-    // For GL_TASK_INIT_INTERNAL_FORMAT
-    GLenum internalFormat_;
-    GLsizei width_;
-    GLsizei height_;
-    GLsizei imageSize_;
-    int dataOffset_;
-    jbyteArray bytesRef_;
 };
 
 }
@@ -31,6 +31,10 @@ Java_org_gearvrf_asynchronous_NativeCompressedTexture_normalConstructor(JNIEnv *
 JNIEXPORT jlong JNICALL
 Java_org_gearvrf_asynchronous_NativeCompressedTexture_mipmappedConstructor(JNIEnv * env,
         jobject obj, jint target);
+
+JNIEXPORT jlong JNICALL
+Java_org_gearvrf_asynchronous_NativeCompressedTexture_ktxConstructor(JNIEnv * env,
+        jobject obj, jlong jktx_file, jintArray jtexture_parameters);
 }
 
 
@@ -57,4 +61,17 @@ Java_org_gearvrf_asynchronous_NativeCompressedTexture_mipmappedConstructor(JNIEn
     return reinterpret_cast<jlong>(new CompressedTexture(target));
 }
 
+JNIEXPORT jlong JNICALL
+Java_org_gearvrf_asynchronous_NativeCompressedTexture_ktxConstructor(JNIEnv * env,
+    jobject obj, jlong jktx_file, jintArray jtexture_parameters) {
+    // takes over the file
+    std::shared_ptr<KtxFile> file(reinterpret_cast<KtxFile*>(jktx_file));
+
+    jint* texture_parameters = env->GetIntArrayElements(jtexture_parameters,0);
+    CompressedTexture* texture = new CompressedTexture(file, texture_parameters);
+    env->ReleaseIntArrayElements(jtexture_parameters, texture_parameters, 0);
+
+    return reinterpret_cast<jlong>(texture);
+}
+
 }
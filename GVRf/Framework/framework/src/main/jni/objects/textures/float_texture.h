@@ -22,6 +22,7 @@
 
 #include "objects/textures/texture.h"
 #include "util/gvr_log.h"
+#include "gl/gl_state_cache.h"
 
 namespace gvr {
 class FloatTexture: public Texture {
@@ -31,9 +32,10 @@ public:
     }
 
     bool update(int width, int height, float* data) {
-        glBindTexture(GL_TEXTURE_2D, gl_texture_->id());
+        GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, gl_texture_->id());
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, width, height, 0,
                 GL_RG, GL_FLOAT, data);
+        gl_texture_->setByteSize(size_t(width) * height * 2 * sizeof(float));
         return (glGetError() == 0) ? 1 : 0;
     }
 
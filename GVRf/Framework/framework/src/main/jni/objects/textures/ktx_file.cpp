@@ -0,0 +1,311 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * A KTX or KTX2 texture file, mapped into memory.
+ ***************************************************************************/
+
+#include "ktx_file.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "objects/textures/texture_loader.h"
+#include "util/gvr_log.h"
+
+namespace gvr {
+
+static const unsigned char KTX1_IDENTIFIER[12] = {
+        0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+static const unsigned char KTX2_IDENTIFIER[12] = {
+        0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+static const size_t KTX1_HEADER_SIZE = 64;     // identifier and 13 UInt32
+static const size_t KTX2_HEADER_SIZE = 80;     // identifier, 9 UInt32 and the index
+static const size_t KTX2_LEVEL_SIZE = 24;      // 3 UInt64 per level
+
+static uint32_t readU32(const char* p, bool swap) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    if (swap) {
+        value = (value >> 24) | ((value >> 8) & 0xFF00) | ((value << 8) & 0xFF0000)
+                | (value << 24);
+    }
+    return value;
+}
+
+static uint64_t readU64(const char* p) {
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static size_t align4(size_t size) {
+    return (size + 3) & ~size_t(3);
+}
+
+// the GL internal format of a KTX2 VkFormat, 0 for those without one
+static GLenum glFormatOf(uint32_t vk_format) {
+    // ETC2 and EAC, VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK on
+    static const GLenum ETC2[] = {
+            GL_COMPRESSED_RGB8_ETC2, GL_COMPRESSED_SRGB8_ETC2,
+            GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2,
+            GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2,
+            GL_COMPRESSED_RGBA8_ETC2_EAC, GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC,
+            GL_COMPRESSED_R11_EAC, GL_COMPRESSED_SIGNED_R11_EAC,
+            GL_COMPRESSED_RG11_EAC, GL_COMPRESSED_SIGNED_RG11_EAC };
+    static const uint32_t VK_FORMAT_R8G8B8A8_UNORM = 37;
+    static const uint32_t VK_FORMAT_R8G8B8A8_SRGB = 43;
+    static const uint32_t VK_FORMAT_ETC2_FIRST = 147;
+    static const uint32_t VK_FORMAT_ASTC_FIRST = 157;   // 4x4 UNORM, then SRGB
+    static const uint32_t ASTC_BLOCK_SIZES = 14;        // 4x4 to 12x12
+
+    if (VK_FORMAT_R8G8B8A8_UNORM == vk_format) {
+        return GL_RGBA8;
+    }
+    if (VK_FORMAT_R8G8B8A8_SRGB == vk_format) {
+        return GL_SRGB8_ALPHA8;
+    }
+    if (vk_format >= VK_FORMAT_ETC2_FIRST
+            && vk_format < VK_FORMAT_ETC2_FIRST + sizeof(ETC2) / sizeof(ETC2[0])) {
+        return ETC2[vk_format - VK_FORMAT_ETC2_FIRST];
+    }
+    if (vk_format >= VK_FORMAT_ASTC_FIRST
+            && vk_format < VK_FORMAT_ASTC_FIRST + 2 * ASTC_BLOCK_SIZES) {
+        uint32_t block = (vk_format - VK_FORMAT_ASTC_FIRST) / 2;
+        bool srgb = 0 != ((vk_format - VK_FORMAT_ASTC_FIRST) & 1);
+        // GL_COMPRESSED_RGBA_ASTC_4x4_KHR and GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR
+        return (srgb ? 0x93D0 : 0x93B0) + block;
+    }
+    return 0;
+}
+
+// glTexStorage2D only takes sized formats
+static bool isUnsized(GLenum internal_format) {
+    switch (internal_format) {
+    case GL_ALPHA:
+    case GL_LUMINANCE:
+    case GL_LUMINANCE_ALPHA:
+    case GL_RGB:
+    case GL_RGBA:
+        return true;
+    default:
+        return false;
+    }
+}
+
+KtxFile::KtxFile(int fd, off_t offset, size_t length) :
+        mapping_(MAP_FAILED), mapping_size_(0), data_(nullptr), size_(length),
+        internal_format_(0), format_(0), type_(0), width_(0), height_(0), faces_(1) {
+    // mmap wants a page aligned offset; assets sit anywhere in the apk
+    off_t page = sysconf(_SC_PAGESIZE);
+    off_t aligned = offset - offset % page;
+    mapping_size_ = length + (offset - aligned);
+    mapping_ = mmap(nullptr, mapping_size_, PROT_READ, MAP_PRIVATE, fd, aligned);
+    if (MAP_FAILED == mapping_) {
+        std::string error = "KtxFile: mmap failed";
+        LOGE("%s", error.c_str());
+        throw error;
+    }
+    data_ = static_cast<const char*>(mapping_) + (offset - aligned);
+
+    try {
+        if (length >= sizeof(KTX1_IDENTIFIER)
+                && 0 == memcmp(data_, KTX1_IDENTIFIER, sizeof(KTX1_IDENTIFIER))) {
+            parseKtx1();
+        } else if (length >= sizeof(KTX2_IDENTIFIER)
+                && 0 == memcmp(data_, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER))) {
+            parseKtx2();
+        } else {
+            std::string error = "KtxFile: not a KTX file";
+            throw error;
+        }
+    } catch (const std::string& error) {
+        LOGE("%s", error.c_str());
+        munmap(mapping_, mapping_size_);
+        throw;
+    }
+}
+
+KtxFile::~KtxFile() {
+    munmap(mapping_, mapping_size_);
+}
+
+const char* KtxFile::at(size_t offset, size_t size) const {
+    if (offset > size_ || size > size_ - offset) {
+        std::string error = "KtxFile: truncated file";
+        throw error;
+    }
+    return data_ + offset;
+}
+
+void KtxFile::parseKtx1() {
+    const char* header = at(0, KTX1_HEADER_SIZE);
+    uint32_t endianness = readU32(header + 12, false);
+    bool swap = 0x01020304 == endianness;
+    if (!swap && 0x04030201 != endianness) {
+        std::string error = "KtxFile: bad endianness";
+        throw error;
+    }
+
+    uint32_t gl_type = readU32(header + 16, swap);
+    uint32_t gl_type_size = readU32(header + 20, swap);
+    uint32_t gl_format = readU32(header + 24, swap);
+    uint32_t gl_internal_format = readU32(header + 28, swap);
+    uint32_t pixel_width = readU32(header + 36, swap);
+    uint32_t pixel_height = readU32(header + 40, swap);
+    uint32_t pixel_depth = readU32(header + 44, swap);
+    uint32_t array_elements = readU32(header + 48, swap);
+    uint32_t faces = readU32(header + 52, swap);
+    uint32_t levels = readU32(header + 56, swap);
+    uint32_t key_value_bytes = readU32(header + 60, swap);
+
+    if (0 != pixel_depth || 0 != array_elements) {
+        std::string error = "KtxFile: 3D and array textures are not supported";
+        throw error;
+    }
+    if (swap && 0 != gl_format && gl_type_size > 1) {
+        std::string error = "KtxFile: pixels in the other byte order";
+        throw error;
+    }
+    if (0 == pixel_width || 0 == pixel_height || (1 != faces && 6 != faces)) {
+        std::string error = "KtxFile: bad dimensions";
+        throw error;
+    }
+
+    internal_format_ = gl_internal_format;
+    format_ = gl_format;
+    type_ = (0 == gl_format) ? 0 : gl_type;
+    width_ = pixel_width;
+    height_ = pixel_height;
+    faces_ = faces;
+
+    // 0 levels asks for a generated chain; there is just the one then
+    size_t offset = KTX1_HEADER_SIZE + key_value_bytes;
+    for (uint32_t level = 0; level < (0 == levels ? 1 : levels); ++level) {
+        uint32_t image_size = readU32(at(offset, 4), swap);
+        offset += 4;
+
+        // a cube map face is image_size, padded to 4
+        Level l;
+        l.data = at(offset, 0);
+        l.face_size = image_size;
+        l.face_stride = (6 == faces) ? align4(image_size) : image_size;
+        at(offset, l.face_stride * (faces - 1) + image_size);
+        levels_.push_back(l);
+
+        offset = align4(offset + l.face_stride * faces);
+    }
+}
+
+void KtxFile::parseKtx2() {
+    const char* header = at(0, KTX2_HEADER_SIZE);
+    uint32_t vk_format = readU32(header + 12, false);
+    uint32_t pixel_width = readU32(header + 20, false);
+    uint32_t pixel_height = readU32(header + 24, false);
+    uint32_t pixel_depth = readU32(header + 28, false);
+    uint32_t layers = readU32(header + 32, false);
+    uint32_t faces = readU32(header + 36, false);
+    uint32_t levels = readU32(header + 40, false);
+    uint32_t supercompression = readU32(header + 44, false);
+
+    if (0 != supercompression) {
+        std::string error = "KtxFile: supercompressed KTX2 is not supported";
+        throw error;
+    }
+    if (0 != pixel_depth || 0 != layers) {
+        std::string error = "KtxFile: 3D and array textures are not supported";
+        throw error;
+    }
+    if (0 == pixel_width || 0 == pixel_height || (1 != faces && 6 != faces)) {
+        std::string error = "KtxFile: bad dimensions";
+        throw error;
+    }
+
+    internal_format_ = glFormatOf(vk_format);
+    if (0 == internal_format_) {
+        std::string error = "KtxFile: VkFormat without a GL format";
+        throw error;
+    }
+    if (GL_RGBA8 == internal_format_ || GL_SRGB8_ALPHA8 == internal_format_) {
+        format_ = GL_RGBA;
+        type_ = GL_UNSIGNED_BYTE;
+    }
+    width_ = pixel_width;
+    height_ = pixel_height;
+    faces_ = faces;
+
+    if (0 == levels) {
+        levels = 1;
+    }
+    const char* index = at(KTX2_HEADER_SIZE, KTX2_LEVEL_SIZE * levels);
+    for (uint32_t level = 0; level < levels; ++level) {
+        uint64_t byte_offset = readU64(index + KTX2_LEVEL_SIZE * level);
+        uint64_t byte_length = readU64(index + KTX2_LEVEL_SIZE * level + 8);
+
+        // the faces of a level are packed without padding
+        Level l;
+        l.data = at(byte_offset, byte_length);
+        l.face_size = byte_length / faces;
+        l.face_stride = l.face_size;
+        levels_.push_back(l);
+    }
+}
+
+std::shared_ptr<TextureUpload> KtxFile::createUpload(
+        const std::shared_ptr<KtxFile>& file, const int* texture_parameters) {
+    GLenum target = (6 == file->faces_) ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+    std::shared_ptr<TextureUpload> upload =
+            std::make_shared<TextureUpload>(target, texture_parameters);
+    int levels = file->levels();
+
+    // without storage the levels cannot land one at a time: a level
+    // defined on its own is incomplete
+    bool stream = !isUnsized(file->internal_format_);
+    if (stream) {
+        upload->setStorage(levels, file->internal_format_, file->width_, file->height_);
+    }
+
+    bool first_stage = true;
+    size_t staged = 0;
+    for (int level = levels - 1; level >= 0; --level) {
+        const Level& l = file->levels_[level];
+        size_t level_size = l.face_size * file->faces_;
+        if (stream && staged > 0
+                && (!first_stage || staged + level_size > FIRST_STAGE_BYTES)) {
+            upload->nextStage();
+            first_stage = false;
+        }
+        staged += level_size;
+
+        GLsizei width = std::max(1, file->width_ >> level);
+        GLsizei height = std::max(1, file->height_ >> level);
+        for (int face = 0; face < file->faces_; ++face) {
+            GLenum face_target = (6 == file->faces_) ?
+                    GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : GL_TEXTURE_2D;
+            upload->addSourceImage(face_target, level, file->internal_format_,
+                    width, height, file->format_, file->type_,
+                    l.data + l.face_stride * face, l.face_size);
+        }
+    }
+    upload->setSource(file);
+    return upload;
+}
+
+}
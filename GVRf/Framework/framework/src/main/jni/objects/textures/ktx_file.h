@@ -0,0 +1,121 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * A KTX or KTX2 texture file, mapped into memory.
+ ***************************************************************************/
+
+#ifndef KTX_FILE_H_
+#define KTX_FILE_H_
+
+#include <cstddef>
+#include <memory>
+#include <sys/types.h>
+#include <vector>
+
+#include "gl/gl_headers.h"
+
+namespace gvr {
+class TextureUpload;
+
+/*
+ * Maps a KTX 1.1 or KTX 2.0 file and finds its images in place, so the
+ * loader copies them from the page cache straight into its pixel buffers
+ * and nothing is read into Java memory first. The mapping lives as long
+ * as the last upload made from it.
+ *
+ * Takes 2D textures and cube maps with any number of levels, compressed
+ * or not. KTX2 files have to be without supercompression, in a format
+ * that has a GL equivalent: RGBA8, ETC2/EAC or ASTC.
+ */
+class KtxFile {
+public:
+    // the smallest levels that go up together, before each bigger one streams
+    static const size_t FIRST_STAGE_BYTES = 64 * 1024;
+
+    struct Level {
+        const char* data;       // face 0, the next face follows at face_stride
+        size_t face_size;
+        size_t face_stride;
+    };
+
+    // maps length bytes of fd from offset; throws a std::string when the
+    // file cannot be mapped or is not a texture this can upload
+    KtxFile(int fd, off_t offset, size_t length);
+    ~KtxFile();
+
+    GLenum internal_format() const {
+        return internal_format_;
+    }
+
+    // 0 for compressed formats
+    GLenum format() const {
+        return format_;
+    }
+
+    GLenum type() const {
+        return type_;
+    }
+
+    GLsizei width() const {
+        return width_;
+    }
+
+    GLsizei height() const {
+        return height_;
+    }
+
+    int levels() const {
+        return levels_.size();
+    }
+
+    int faces() const {
+        return faces_;
+    }
+
+    /*
+     * The upload of every image in file, set up to stream: the levels up
+     * to FIRST_STAGE_BYTES first, then one stage per bigger level.
+     */
+    static std::shared_ptr<TextureUpload> createUpload(
+            const std::shared_ptr<KtxFile>& file, const int* texture_parameters);
+
+private:
+    KtxFile(const KtxFile& file);
+    KtxFile(KtxFile&& file);
+    KtxFile& operator=(const KtxFile& file);
+    KtxFile& operator=(KtxFile&& file);
+
+    void parseKtx1();
+    void parseKtx2();
+    const char* at(size_t offset, size_t size) const;
+
+private:
+    void* mapping_;
+    size_t mapping_size_;
+    const char* data_;
+    size_t size_;
+
+    GLenum internal_format_;
+    GLenum format_;
+    GLenum type_;
+    GLsizei width_;
+    GLsizei height_;
+    int faces_;
+    std::vector<Level> levels_;
+};
+
+}
+#endif
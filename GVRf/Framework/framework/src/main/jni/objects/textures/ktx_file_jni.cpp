@@ -0,0 +1,59 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * JNI
+ ***************************************************************************/
+
+#include <string>
+
+#include "ktx_file.h"
+#include "util/gvr_jni.h"
+
+namespace gvr {
+extern "C" {
+JNIEXPORT jlong JNICALL
+Java_org_gearvrf_asynchronous_NativeKtxFile_open(JNIEnv * env, jobject obj,
+        jint fd, jlong offset, jlong length, jintArray jinfo);
+
+JNIEXPORT void JNICALL
+Java_org_gearvrf_asynchronous_NativeKtxFile_delete(JNIEnv * env, jobject obj,
+        jlong jktx_file);
+}
+
+JNIEXPORT jlong JNICALL
+Java_org_gearvrf_asynchronous_NativeKtxFile_open(JNIEnv * env, jobject obj,
+        jint fd, jlong offset, jlong length, jintArray jinfo) {
+    KtxFile* file;
+    try {
+        file = new KtxFile(fd, offset, length);
+    } catch (const std::string& err) {
+        // Java parses what cannot be mapped
+        return 0;
+    }
+
+    jint info[] = { static_cast<jint>(file->internal_format()), file->width(),
+            file->height(), file->levels(), file->faces() };
+    env->SetIntArrayRegion(jinfo, 0, sizeof(info) / sizeof(info[0]), info);
+    return reinterpret_cast<jlong>(file);
+}
+
+JNIEXPORT void JNICALL
+Java_org_gearvrf_asynchronous_NativeKtxFile_delete(JNIEnv * env, jobject obj,
+        jlong jktx_file) {
+    delete reinterpret_cast<KtxFile*>(jktx_file);
+}
+
+}
@@ -21,17 +21,42 @@
 #include "render_texture.h"
 #include "util/gvr_gl_ext.h"
 #include "eglextension/msaa/msaa.h"
+#include "gl/gl_readback.h"
+#include "gl/gl_state_cache.h"
 
 namespace gvr {
+
+// bytes per pixel, for the texture budget
+static size_t colorBytes(int jcolor_format) {
+    switch (jcolor_format) {
+    case ColorFormat::COLOR_565:
+    case ColorFormat::COLOR_5551:
+    case ColorFormat::COLOR_4444:
+        return 2;
+    default:
+        return 4;
+    }
+}
+
+static size_t depthBytes(int jdepth_format) {
+    switch (jdepth_format) {
+    case DepthFormat::DEPTH_0:
+        return 0;
+    case DepthFormat::DEPTH_16:
+        return 2;
+    default:
+        return 4;
+    }
+}
+
 RenderTexture::RenderTexture(int width, int height) :
         Texture(new GLTexture(TARGET)), width_(width), height_(height), sample_count_(
                 0), renderTexture_gl_render_buffer_(new GLRenderBuffer()), renderTexture_gl_frame_buffer_ (
                 new GLFrameBuffer()) {
-    initialize(width, height);
-    glBindTexture(TARGET, gl_texture_->id());
+    GLStateCache::getInstance()->bindTexture(TARGET, gl_texture_->id());
     glTexImage2D(TARGET, 0, GL_RGBA, width_, height_, 0, GL_RGBA,
             GL_UNSIGNED_BYTE, 0);
-    glBindTexture(TARGET, 0);
+    GLStateCache::getInstance()->bindTexture(TARGET, 0);
 
     glBindRenderbuffer(GL_RENDERBUFFER, renderTexture_gl_render_buffer_->id());
     glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16, width, height);
@@ -44,17 +69,19 @@ RenderTexture::RenderTexture(int width, int height) :
 
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
             GL_RENDERBUFFER, renderTexture_gl_render_buffer_->id());
+
+    gl_texture_->setByteSize(size_t(width) * height * (colorBytes(ColorFormat::COLOR_8888)
+            + depthBytes(DepthFormat::DEPTH_16)));
 }
 
 RenderTexture::RenderTexture(int width, int height, int sample_count) :
         Texture(new GLTexture(TARGET)), width_(width), height_(height), sample_count_(
                 sample_count), renderTexture_gl_render_buffer_(new GLRenderBuffer()), renderTexture_gl_frame_buffer_(
                 new GLFrameBuffer()) {
-    initialize(width, height);
-    glBindTexture(TARGET, gl_texture_->id());
+    GLStateCache::getInstance()->bindTexture(TARGET, gl_texture_->id());
     glTexImage2D(TARGET, 0, GL_RGBA, width_, height_, 0, GL_RGBA,
             GL_UNSIGNED_BYTE, 0);
-    glBindTexture(TARGET, 0);
+    GLStateCache::getInstance()->bindTexture(TARGET, 0);
 
     glBindRenderbuffer(GL_RENDERBUFFER, renderTexture_gl_render_buffer_->id());
     MSAA::glRenderbufferStorageMultisampleIMG(GL_RENDERBUFFER, sample_count,
@@ -68,6 +95,9 @@ RenderTexture::RenderTexture(int width, int height, int sample_count) :
 
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
             GL_RENDERBUFFER, renderTexture_gl_render_buffer_->id());
+
+    gl_texture_->setByteSize(size_t(width) * height * (colorBytes(ColorFormat::COLOR_8888)
+            + depthBytes(DepthFormat::DEPTH_16)));
 }
 
 RenderTexture::RenderTexture(int width, int height, int sample_count,
@@ -75,9 +105,8 @@ RenderTexture::RenderTexture(int width, int height, int sample_count,
         int* texture_parameters) :
         Texture(new GLTexture(TARGET, texture_parameters)), width_(width), height_(
                 height), sample_count_(sample_count), renderTexture_gl_frame_buffer_(new GLFrameBuffer()) {
-    initialize(width, height);
     GLenum depth_format;
-    glBindTexture(TARGET, gl_texture_->id());
+    GLStateCache::getInstance()->bindTexture(TARGET, gl_texture_->id());
     switch (jcolor_format) {
     case ColorFormat::COLOR_565:
         glTexImage2D(TARGET, 0, GL_RGB, width_, height_, 0, GL_RGB,
@@ -146,6 +175,16 @@ RenderTexture::RenderTexture(int width, int height, int sample_count,
         }
     }
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // with resolve_depth the samples live in renderbuffers of their own;
+    // rendering multisampled into the texture keeps one sample in memory
+    size_t pixels = size_t(width) * height;
+    size_t bytes = pixels * (colorBytes(jcolor_format) + depthBytes(jdepth_format));
+    if (resolve_depth && sample_count > 1) {
+        bytes = pixels * colorBytes(jcolor_format)
+                + pixels * sample_count * (colorBytes(jcolor_format) + depthBytes(jdepth_format));
+    }
+    gl_texture_->setByteSize(bytes);
 }
 
 void RenderTexture::generateRenderTextureNoMultiSampling(int jdepth_format,
@@ -218,9 +257,9 @@ void RenderTexture::beginRendering() {
     glBindFramebuffer(GL_FRAMEBUFFER, renderTexture_gl_frame_buffer_->id());
     glViewport(0, 0, width, height);
     glScissor(0, 0, width, height);
-    glDepthMask(GL_TRUE);
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LEQUAL);
+    GLStateCache::getInstance()->depthMask(GL_TRUE);
+    GLStateCache::getInstance()->enable(GL_DEPTH_TEST);
+    GLStateCache::getInstance()->depthFunc(GL_LEQUAL);
     invalidateFrameBuffer(GL_FRAMEBUFFER, true, true, true);
     glClear(GL_DEPTH_BUFFER_BIT);
 }
@@ -248,17 +287,42 @@ void RenderTexture::invalidateFrameBuffer(GLenum target, bool is_fbo, const bool
 
 void RenderTexture::startReadBack() {
     glBindFramebuffer(GL_READ_FRAMEBUFFER, renderTexture_gl_frame_buffer_->id());
-    glViewport(0, 0, width_, height_);
     glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, TARGET,
             gl_texture_->id(), 0);
     glReadBuffer(GL_COLOR_ATTACHMENT0);
-    glBindBuffer(GL_PIXEL_PACK_BUFFER, renderTexture_gl_pbo_);
-    glPixelStorei(GL_PACK_ALIGNMENT, 1);
-
-    glReadPixels(0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE, 0);
 
+    // a read still in flight keeps its own pixels
+    if (!readback_ || !readback_.unique()) {
+        readback_ = std::make_shared<ReadbackPixels>();
+    }
+    readback_->done = false;
+    std::shared_ptr<ReadbackPixels> pixels(readback_);
+    GLReadback::Callback done = [pixels](const GLubyte* data, int width, int height) {
+        if (nullptr != data) {
+            pixels->data.assign(data, data + width * height * 4);
+        } else {
+            pixels->data.clear();
+        }
+        pixels->done = true;
+    };
+
+    GLReadback* readback = GLReadback::getInstance();
+    if (!readback->read(0, 0, width_, height_, done)) {
+        // every buffer is in flight, make room
+        readback->finish();
+        readback->read(0, 0, width_, height_, done);
+    }
     readback_started_ = true;
-    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+bool RenderTexture::isReadBackDone() {
+    if (!readback_started_) {
+        return false;
+    }
+    if (!readback_->done) {
+        GLReadback::getInstance()->poll();
+    }
+    return readback_->done;
 }
 
 bool RenderTexture::readRenderResult(uint32_t *readback_buffer, long capacity) {
@@ -274,29 +338,19 @@ bool RenderTexture::readRenderResult(uint32_t *readback_buffer, long capacity) {
         return false;
     }
 
-    glBindFramebuffer(GL_READ_FRAMEBUFFER, renderTexture_gl_frame_buffer_->id());
-    glViewport(0, 0, width_, height_);
-    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, TARGET,
-            gl_texture_->id(), 0);
-    glReadBuffer(GL_COLOR_ATTACHMENT0);
-    glBindBuffer(GL_PIXEL_PACK_BUFFER, renderTexture_gl_pbo_);
-    glPixelStorei(GL_PACK_ALIGNMENT, 1);
-
     if (!readback_started_) {
-        glReadPixels(0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+        startReadBack();
     }
-
-    int *buf = (int *)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, neededCapacity * 4,
-             GL_MAP_READ_BIT);
-    if (buf) {
-        memcpy(readback_buffer, buf, neededCapacity * 4);
+    if (!isReadBackDone()) {
+        GLReadback::getInstance()->finish();
     }
-
     readback_started_ = false;
 
-    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
-    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
-
+    const std::vector<GLubyte>& pixels = readback_->data;
+    if (pixels.size() < size_t(neededCapacity) * 4) {
+        return false;
+    }
+    memcpy(readback_buffer, pixels.data(), neededCapacity * 4);
     return true;
 }
 
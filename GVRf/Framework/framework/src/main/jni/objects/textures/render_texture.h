@@ -26,6 +26,10 @@
 #include "util/gvr_parameters.h"
 #include "objects/textures/base_texture.h"
 #include "util/gvr_gl.h"
+#include "gl/gl_state_cache.h"
+
+#include <memory>
+#include <vector>
 
 namespace gvr {
 
@@ -42,19 +46,6 @@ public:
         delete renderTexture_gl_frame_buffer_;
         delete renderTexture_gl_color_buffer_;
         delete renderTexture_gl_resolve_buffer_;
-
-        if (0 != renderTexture_gl_pbo_) {
-            glDeleteBuffers(1, &renderTexture_gl_pbo_);
-        }
-    }
-
-    void initialize(int width, int height) {
-        glGenBuffers(1, &renderTexture_gl_pbo_);
-        glBindBuffer(GL_PIXEL_PACK_BUFFER, renderTexture_gl_pbo_);
-        glBufferData(GL_PIXEL_PACK_BUFFER, width_ * height_ * 4, 0, GL_DYNAMIC_READ);
-        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
-
-        readback_started_ = false;
     }
 
     GLenum getTarget() const {
@@ -81,11 +72,15 @@ public:
     void endRendering();
 
     // Start to read back texture in the background. It can be optionally called before
-    // readRenderResult() to read pixels asynchronously. This function returns immediately.
+    // readRenderResult() to read pixels asynchronously. This function returns immediately;
+    // the pixels are copied out once the GPU is done, a frame or two later.
     void startReadBack();
 
-    // Copy data in pixel buffer to client memory. This function is synchronous. When
-    // it returns, the pixels have been copied to PBO and then to the client memory.
+    // Whether the read started last has completed. GL thread.
+    bool isReadBackDone();
+
+    // Copy the pixels to client memory. This function is synchronous: without a read
+    // started, or with it still on the GPU, it waits for the GPU to finish it.
     bool readRenderResult(uint32_t *readback_buffer, long capacity);
 
 private:
@@ -109,7 +104,13 @@ private:
     GLFrameBuffer* renderTexture_gl_resolve_buffer_ = nullptr;
     GLRenderBuffer* renderTexture_gl_color_buffer_ = nullptr;// This is only for multisampling case
                                      // when resolveDepth is on.
-    GLuint renderTexture_gl_pbo_ = 0;
-    bool readback_started_;          // set by startReadBack()
+
+    // the pixels of a read, filled in by the GLReadback callback
+    struct ReadbackPixels {
+        std::vector<GLubyte> data;
+        bool done = false;
+    };
+    std::shared_ptr<ReadbackPixels> readback_;
+    bool readback_started_ = false;  // set by startReadBack()
 };}
 #endif
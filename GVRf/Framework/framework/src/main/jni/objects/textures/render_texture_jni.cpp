@@ -44,6 +44,9 @@ Java_org_gearvrf_NativeRenderTexture_endRendering(JNIEnv * env, jobject obj,
 JNIEXPORT bool JNICALL
 Java_org_gearvrf_NativeRenderTexture_readRenderResult(JNIEnv * env, jobject obj,
         jlong ptr, jintArray jreadback_buffer);
+JNIEXPORT jboolean JNICALL
+Java_org_gearvrf_NativeRenderTexture_isReadBackDone(JNIEnv * env, jobject obj,
+        jlong ptr);
 
 JNIEXPORT void JNICALL
 Java_org_gearvrf_NativeRenderTexture_bind(JNIEnv * env, jobject obj, jlong ptr);
@@ -105,6 +108,13 @@ Java_org_gearvrf_NativeRenderTexture_readRenderResult(JNIEnv * env, jobject obj,
     return rv;
 }
 
+JNIEXPORT jboolean JNICALL
+Java_org_gearvrf_NativeRenderTexture_isReadBackDone(JNIEnv * env, jobject obj,
+        jlong ptr) {
+    RenderTexture *render_texture = reinterpret_cast<RenderTexture*>(ptr);
+    return render_texture->isReadBackDone();
+}
+
 JNIEXPORT void JNICALL
 Java_org_gearvrf_NativeRenderTexture_bind(JNIEnv * env, jobject obj, jlong ptr) {
     RenderTexture *render_texture = reinterpret_cast<RenderTexture*>(ptr);
@@ -23,6 +23,7 @@
 #include "gl/gl_texture.h"
 #include "objects/hybrid_object.h"
 #include "objects/gl_pending_task.h"
+#include "gl/gl_state_cache.h"
 
 namespace gvr {
 
@@ -45,6 +46,20 @@ public:
         return gl_texture_->id();
     }
 
+    // called where the shaders bind the texture for drawing
+    void markUsed() {
+        if (gl_texture_) {
+            gl_texture_->markUsed();
+        }
+    }
+
+    // GL thread: for images defined outside the native code, see GLTexture::setByteSize
+    void setByteSize(size_t bytes) {
+        if (gl_texture_) {
+            gl_texture_->setByteSize(bytes);
+        }
+    }
+
     virtual void updateTextureParameters(int* texture_parameters) {
         // Sets the new MIN FILTER
         GLenum min_filter_type_ = texture_parameters[0];
@@ -58,7 +73,7 @@ public:
         // Sets the wrap parameter for texture coordinate S
         GLenum wrap_t_type_ = texture_parameters[4];
 
-        glBindTexture(target, getId());
+        GLStateCache::getInstance()->bindTexture(target, getId());
 
         // Sets the anisotropic filtering if the value provided is greater than 1 because 1 is the default value
         if (texture_parameters[2] > 1.0f) {
@@ -69,7 +84,7 @@ public:
         glTexParameteri(target, GL_TEXTURE_WRAP_T, wrap_t_type_);
         glTexParameteri(target, GL_TEXTURE_MIN_FILTER, min_filter_type_);
         glTexParameteri(target, GL_TEXTURE_MAG_FILTER, mag_filter_type_);
-        glBindTexture(target, 0);
+        GLStateCache::getInstance()->bindTexture(target, 0);
     }
 
     virtual GLenum getTarget() const = 0;
@@ -80,8 +95,16 @@ public:
         }
     }
 
+    // set by the material, and the images are on the GPU
     bool isReady() {
-        return ready;
+        return ready && (nullptr == gl_texture_ || gl_texture_->isLoaded());
+    }
+
+    // for callers that need the id even if that means waiting for the loader
+    void waitUntilLoaded() {
+        if (gl_texture_) {
+            gl_texture_->waitUntilLoaded();
+        }
     }
 
     void setReady(bool ready) {
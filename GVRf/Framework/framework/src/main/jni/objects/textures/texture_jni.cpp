@@ -30,6 +30,9 @@ Java_org_gearvrf_NativeTexture_getId(JNIEnv * env, jobject obj,
 JNIEXPORT void JNICALL
 Java_org_gearvrf_NativeTexture_updateTextureParameters(JNIEnv * env, jobject obj,
         jlong jtexture, jintArray jtexture_parameters);
+JNIEXPORT void JNICALL
+Java_org_gearvrf_NativeTexture_setByteSize(JNIEnv * env, jobject obj,
+        jlong jtexture, jlong bytes);
 }
 ;
 
@@ -37,6 +40,8 @@ JNIEXPORT jint JNICALL
 Java_org_gearvrf_NativeTexture_getId(JNIEnv * env, jobject obj,
         jlong jtexture) {
     Texture* texture = reinterpret_cast<Texture*>(jtexture);
+    // Java expects a usable id back
+    texture->waitUntilLoaded();
     return texture->getId();
 }
 
@@ -51,4 +56,11 @@ Java_org_gearvrf_NativeTexture_updateTextureParameters(JNIEnv * env, jobject obj
 
 }
 
+JNIEXPORT void JNICALL
+Java_org_gearvrf_NativeTexture_setByteSize(JNIEnv * env, jobject obj,
+        jlong jtexture, jlong bytes) {
+    Texture* texture = reinterpret_cast<Texture*>(jtexture);
+    texture->setByteSize(static_cast<size_t>(bytes));
+}
+
 }
@@ -0,0 +1,627 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Uploads texture images on a thread with its own GL context.
+ ***************************************************************************/
+
+#include "texture_loader.h"
+
+#include <algorithm>
+
+#include "engine/memory/gl_delete.h"
+#include "gl/gl_texture.h"
+#include "util/gvr_log.h"
+
+namespace gvr {
+
+// how long the idle worker waits on the oldest fence before looking at the queue
+static const GLuint64 FENCE_WAIT_NS = 1000000;
+
+static size_t align4(size_t size) {
+    return (size + 3) & ~size_t(3);
+}
+
+TextureUpload::TextureUpload(GLenum target, const int* texture_parameters) :
+        target_(target), has_parameters_(nullptr != texture_parameters),
+        storage_levels_(0), storage_format_(0), storage_width_(0), storage_height_(0),
+        stage_count_(1), state_(QUEUED), landed_stages_(0), id_(0), abandoned_(false),
+        loader_id_(0), next_stage_(0) {
+    if (has_parameters_) {
+        memcpy(texture_parameters_, texture_parameters, sizeof(texture_parameters_));
+    }
+}
+
+void* TextureUpload::addImage(GLenum target, GLint level, GLenum internal_format,
+        GLsizei width, GLsizei height, GLenum format, GLenum type, size_t size) {
+    Image image;
+    image.target = target;
+    image.level = level;
+    image.internal_format = internal_format;
+    image.width = width;
+    image.height = height;
+    image.format = format;
+    image.type = type;
+    image.source = nullptr;
+    // keep every image 4-byte aligned for GL_UNPACK_ALIGNMENT
+    image.offset = align4(data_.size());
+    image.size = size;
+    image.stage = stage_count_ - 1;
+    images_.push_back(image);
+    data_.resize(image.offset + size);
+    return &data_[image.offset];
+}
+
+void TextureUpload::addSourceImage(GLenum target, GLint level, GLenum internal_format,
+        GLsizei width, GLsizei height, GLenum format, GLenum type,
+        const void* pixels, size_t size) {
+    Image image;
+    image.target = target;
+    image.level = level;
+    image.internal_format = internal_format;
+    image.width = width;
+    image.height = height;
+    image.format = format;
+    image.type = type;
+    image.source = static_cast<const char*>(pixels);
+    image.offset = 0;
+    image.size = size;
+    image.stage = stage_count_ - 1;
+    images_.push_back(image);
+}
+
+void TextureUpload::setStorage(GLsizei levels, GLenum internal_format,
+        GLsizei width, GLsizei height) {
+    storage_levels_ = levels;
+    storage_format_ = internal_format;
+    storage_width_ = width;
+    storage_height_ = height;
+}
+
+GLint TextureUpload::stageBaseLevel(int stage) const {
+    GLint level = -1;
+    for (auto it = images_.begin(); it != images_.end(); ++it) {
+        if (it->stage == stage && (level < 0 || it->level < level)) {
+            level = it->level;
+        }
+    }
+    return level;
+}
+
+size_t TextureUpload::stageSize(int stage) const {
+    size_t size = 0;
+    for (auto it = images_.begin(); it != images_.end(); ++it) {
+        if (it->stage == stage) {
+            size = align4(size) + it->size;
+        }
+    }
+    return size;
+}
+
+void TextureUpload::allocate(GLint first_level) const {
+    if (storage_levels_ > 0) {
+        glTexStorage2D(target_, storage_levels_ - first_level, storage_format_,
+                std::max(1, storage_width_ >> first_level),
+                std::max(1, storage_height_ >> first_level));
+    }
+}
+
+GLint TextureUpload::levelCount() const {
+    GLint count = 0;
+    for (auto it = images_.begin(); it != images_.end(); ++it) {
+        count = std::max(count, it->level + 1);
+    }
+    return count;
+}
+
+size_t TextureUpload::levelSize(GLint level) const {
+    size_t size = 0;
+    for (auto it = images_.begin(); it != images_.end(); ++it) {
+        if (it->level == level) {
+            size += it->size;
+        }
+    }
+    return size;
+}
+
+size_t TextureUpload::byteSize() const {
+    size_t size = 0;
+    for (auto it = images_.begin(); it != images_.end(); ++it) {
+        size += it->size;
+    }
+    return size;
+}
+
+void TextureUpload::copyStage(int stage, char* dst) const {
+    size_t offset = 0;
+    for (auto it = images_.begin(); it != images_.end(); ++it) {
+        if (it->stage == stage) {
+            offset = align4(offset);
+            memcpy(dst + offset, pixels(*it), it->size);
+            offset += it->size;
+        }
+    }
+}
+
+void TextureUpload::issueStage(int stage, bool from_buffer) const {
+    size_t offset = 0;
+    for (auto it = images_.begin(); it != images_.end(); ++it) {
+        if (it->stage != stage) {
+            continue;
+        }
+        offset = align4(offset);
+        issueImage(*it, it->level,
+                from_buffer ? static_cast<const char*>(nullptr) + offset : pixels(*it));
+        offset += it->size;
+    }
+}
+
+void TextureUpload::issueLevels(GLint first_level, GLint end_level) const {
+    for (auto it = images_.begin(); it != images_.end(); ++it) {
+        if (it->level >= first_level && it->level < end_level) {
+            issueImage(*it, it->level, pixels(*it));
+        }
+    }
+}
+
+std::shared_ptr<TextureUpload> TextureUpload::fromLevel(GLint first_level,
+        const int* texture_parameters) const {
+    std::shared_ptr<TextureUpload> upload =
+            std::make_shared<TextureUpload>(target_, texture_parameters);
+    if (storage_levels_ > 0) {
+        upload->setStorage(storage_levels_ - first_level, storage_format_,
+                std::max(1, storage_width_ >> first_level),
+                std::max(1, storage_height_ >> first_level));
+    }
+    for (auto it = images_.begin(); it != images_.end(); ++it) {
+        if (it->level >= first_level) {
+            upload->addSourceImage(it->target, it->level - first_level, it->internal_format,
+                    it->width, it->height, it->format, it->type, pixels(*it), it->size);
+        }
+    }
+    upload->setSource(source_);
+    return upload;
+}
+
+void TextureUpload::releaseLevels(GLint first_level, GLint end_level) const {
+    for (auto it = images_.begin(); it != images_.end(); ++it) {
+        const Image& image = *it;
+        if (image.level < first_level || image.level >= end_level) {
+            continue;
+        }
+        if (0 == image.format) {
+            glCompressedTexImage2D(image.target, image.level, image.internal_format,
+                    0, 0, 0, 0, nullptr);
+        } else {
+            glTexImage2D(image.target, image.level, image.internal_format, 0, 0, 0,
+                    image.format, image.type, nullptr);
+        }
+    }
+}
+
+void TextureUpload::issueImage(const Image& image, GLint level, const char* data) const {
+    if (storage_levels_ > 0) {
+        if (0 == image.format) {
+            glCompressedTexSubImage2D(image.target, level, 0, 0,
+                    image.width, image.height, image.internal_format, image.size, data);
+        } else {
+            glTexSubImage2D(image.target, level, 0, 0,
+                    image.width, image.height, image.format, image.type, data);
+        }
+    } else if (0 == image.format) {
+        glCompressedTexImage2D(image.target, level, image.internal_format,
+                image.width, image.height, 0, image.size, data);
+    } else {
+        glTexImage2D(image.target, level, image.internal_format,
+                image.width, image.height, 0, image.format, image.type, data);
+    }
+}
+
+GLuint TextureUpload::takeId() {
+    std::lock_guard < std::mutex > lock(mutex_);
+    GLuint id = (DONE == state_) ? id_ : 0;
+    id_ = 0;
+    return id;
+}
+
+GLuint TextureUpload::abandon() {
+    std::lock_guard < std::mutex > lock(mutex_);
+    abandoned_ = true;
+    // a streaming texture still belongs to the loader
+    GLuint id = (DONE == state_) ? id_ : 0;
+    id_ = 0;
+    return id;
+}
+
+bool TextureUpload::abandoned() {
+    std::lock_guard < std::mutex > lock(mutex_);
+    return abandoned_;
+}
+
+GLuint TextureUpload::id() {
+    std::lock_guard < std::mutex > lock(mutex_);
+    return id_;
+}
+
+bool TextureUpload::finish(GLuint id, int state) {
+    std::lock_guard < std::mutex > lock(mutex_);
+    if (abandoned_) {
+        return false;
+    }
+    id_ = id;
+    if (DONE == state) {
+        landed_stages_.store(stage_count_, std::memory_order_release);
+    }
+    state_.store(state, std::memory_order_release);
+    return true;
+}
+
+bool TextureUpload::land(GLuint id) {
+    std::lock_guard < std::mutex > lock(mutex_);
+    if (abandoned_) {
+        return false;
+    }
+    id_ = id;
+    landed_stages_.store(next_stage_, std::memory_order_release);
+    state_.store(STREAMING, std::memory_order_release);
+    return true;
+}
+
+TextureLoader* TextureLoader::instance_ = new TextureLoader();
+
+TextureLoader* TextureLoader::getInstance() {
+    return instance_;
+}
+
+TextureLoader::TextureLoader() :
+        display_(EGL_NO_DISPLAY), context_(EGL_NO_CONTEXT), surface_(EGL_NO_SURFACE),
+        deleter_(nullptr), running_(false), stopping_(false),
+        uploaded_count_(0), uploaded_bytes_(0) {
+}
+
+bool TextureLoader::createContext() {
+    display_ = eglGetCurrentDisplay();
+    EGLContext shared = eglGetCurrentContext();
+    if (EGL_NO_DISPLAY == display_ || EGL_NO_CONTEXT == shared) {
+        LOGE("TextureLoader: no current context to share with");
+        return false;
+    }
+
+    // a context in the same share group needs a compatible config; the
+    // renderer's is the safest choice
+    EGLint config_id = 0;
+    EGLint config_count = 0;
+    EGLConfig config;
+    eglQueryContext(display_, shared, EGL_CONFIG_ID, &config_id);
+    const EGLint config_attributes[] = { EGL_CONFIG_ID, config_id, EGL_NONE };
+    if (!eglChooseConfig(display_, config_attributes, &config, 1, &config_count)
+            || config_count < 1) {
+        LOGE("TextureLoader: no config for id %d", config_id);
+        return false;
+    }
+
+    const EGLint context_attributes[] = { EGL_CONTEXT_CLIENT_VERSION, 3, EGL_NONE };
+    context_ = eglCreateContext(display_, config, shared, context_attributes);
+    if (EGL_NO_CONTEXT == context_) {
+        LOGE("TextureLoader: eglCreateContext failed 0x%x", eglGetError());
+        return false;
+    }
+
+    const char* extensions = eglQueryString(display_, EGL_EXTENSIONS);
+    if (nullptr == extensions || nullptr == strstr(extensions, "EGL_KHR_surfaceless_context")) {
+        const EGLint surface_attributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+        surface_ = eglCreatePbufferSurface(display_, config, surface_attributes);
+        if (EGL_NO_SURFACE == surface_) {
+            LOGE("TextureLoader: eglCreatePbufferSurface failed 0x%x", eglGetError());
+            destroyContext();
+            return false;
+        }
+    }
+    return true;
+}
+
+void TextureLoader::destroyContext() {
+    if (EGL_NO_SURFACE != surface_) {
+        eglDestroySurface(display_, surface_);
+        surface_ = EGL_NO_SURFACE;
+    }
+    if (EGL_NO_CONTEXT != context_) {
+        eglDestroyContext(display_, context_);
+        context_ = EGL_NO_CONTEXT;
+    }
+}
+
+bool TextureLoader::start() {
+    if (running()) {
+        return true;
+    }
+    if (thread_.joinable()) {
+        // gave up on its context
+        stop();
+    }
+    if (!createContext()) {
+        LOGI("TextureLoader: textures upload on the GL thread");
+        return false;
+    }
+    deleter_ = getDeleterForThisThread();
+    stopping_ = false;
+    running_.store(true, std::memory_order_release);
+    thread_ = std::thread(&TextureLoader::loop, this);
+    return true;
+}
+
+void TextureLoader::stop() {
+    if (!thread_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard < std::mutex > lock(mutex_);
+        running_.store(false, std::memory_order_release);
+        stopping_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+    destroyContext();
+}
+
+bool TextureLoader::submit(const std::shared_ptr<TextureUpload>& upload) {
+    {
+        std::lock_guard < std::mutex > lock(mutex_);
+        if (!running()) {
+            return false;
+        }
+        queue_.push_back(upload);
+    }
+    wake_.notify_one();
+    return true;
+}
+
+void TextureLoader::wait(const TextureUpload& upload) {
+    std::unique_lock < std::mutex > lock(mutex_);
+    finished_.wait(lock, [&upload]() {
+        return upload.state() >= TextureUpload::DONE;
+    });
+}
+
+void TextureLoader::loop() {
+    if (!eglMakeCurrent(display_, surface_, surface_, context_)) {
+        LOGE("TextureLoader: eglMakeCurrent failed 0x%x", eglGetError());
+        std::lock_guard < std::mutex > lock(mutex_);
+        running_.store(false, std::memory_order_release);
+        stopping_ = true;
+    }
+
+    for (;;) {
+        std::shared_ptr<TextureUpload> next;
+        {
+            std::unique_lock < std::mutex > lock(mutex_);
+            if (in_flight_.empty()) {
+                wake_.wait(lock, [this]() {
+                    return stopping_ || !queue_.empty();
+                });
+            }
+            if (stopping_) {
+                break;
+            }
+            if (!queue_.empty()) {
+                next = queue_.front();
+                queue_.pop_front();
+            }
+        }
+        if (next) {
+            upload(next);
+        }
+        // with nothing else to do, sleep on the oldest fence
+        retire(!next);
+    }
+
+    // what is still in flight finishes before the context goes
+    while (!in_flight_.empty()) {
+        retire(true);
+    }
+    // the rest falls back to the GL thread
+    std::deque<std::shared_ptr<TextureUpload> > left;
+    {
+        std::lock_guard < std::mutex > lock(mutex_);
+        left.swap(queue_);
+    }
+    for (auto it = left.begin(); it != left.end(); ++it) {
+        if (0 != (*it)->loader_id_) {
+            finishStages(*it);
+        } else {
+            complete(*it, 0, TextureUpload::FAILED);
+        }
+    }
+    for (auto it = free_buffers_.begin(); it != free_buffers_.end(); ++it) {
+        glDeleteBuffers(1, &it->buffer);
+    }
+    free_buffers_.clear();
+    eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglReleaseThread();
+}
+
+void TextureLoader::upload(const std::shared_ptr<TextureUpload>& upload) {
+    GLenum target = upload->target();
+    int stage = upload->next_stage_;
+    GLuint id = upload->loader_id_;
+    if (0 == stage) {
+        glGenTextures(1, &id);
+        glBindTexture(target, id);
+        GLTexture::setParameters(target, upload->texture_parameters());
+        upload->allocate();
+        upload->loader_id_ = id;
+    } else if (upload->abandoned()) {
+        glDeleteTextures(1, &id);
+        upload->loader_id_ = 0;
+        return;
+    } else {
+        glBindTexture(target, id);
+    }
+
+    size_t size = upload->stageSize(stage);
+    PixelBuffer pixels = acquireBuffer(size);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixels.buffer);
+    void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (nullptr != mapped) {
+        upload->copyStage(stage, static_cast<char*>(mapped));
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        upload->issueStage(stage, true);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    } else {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        upload->issueStage(stage, false);
+    }
+    if (upload->stage_count() > 1) {
+        // sample only what has landed
+        glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, upload->stageBaseLevel(stage));
+    }
+    glBindTexture(target, 0);
+
+    GLenum error = glGetError();
+    if (GL_NO_ERROR != error) {
+        LOGE("TextureLoader: upload of %zu bytes failed 0x%x", size, error);
+        glDeleteTextures(1, &id);
+        upload->loader_id_ = 0;
+        releaseBuffer(pixels);
+        complete(upload, 0, TextureUpload::FAILED);
+        return;
+    }
+
+    InFlight in_flight;
+    in_flight.upload = upload;
+    in_flight.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    in_flight.pixels = pixels;
+    // the fence has to reach the GPU to ever signal
+    glFlush();
+    in_flight_.push_back(in_flight);
+    uploaded_bytes_ += size;
+}
+
+void TextureLoader::retire(bool block) {
+    size_t kept = 0;
+    for (size_t i = 0; i < in_flight_.size(); ++i) {
+        InFlight& in_flight = in_flight_[i];
+        GLuint64 timeout = (block && 0 == i) ? FENCE_WAIT_NS : 0;
+        GLenum status = glClientWaitSync(in_flight.fence, 0, timeout);
+        if (GL_ALREADY_SIGNALED == status || GL_CONDITION_SATISFIED == status
+                || GL_WAIT_FAILED == status) {
+            glDeleteSync(in_flight.fence);
+            releaseBuffer(in_flight.pixels);
+            landed(in_flight.upload);
+        } else {
+            in_flight_[kept++] = in_flight;
+        }
+    }
+    in_flight_.resize(kept);
+}
+
+void TextureLoader::landed(const std::shared_ptr<TextureUpload>& upload) {
+    GLuint id = upload->loader_id_;
+    if (++upload->next_stage_ >= upload->stage_count()) {
+        upload->loader_id_ = 0;
+        upload->releaseData();
+        ++uploaded_count_;
+        complete(upload, id, TextureUpload::DONE);
+        return;
+    }
+    if (!upload->land(id)) {
+        // given up half way, the rest is not needed
+        glDeleteTextures(1, &id);
+        upload->loader_id_ = 0;
+        return;
+    }
+    {
+        std::lock_guard < std::mutex > lock(mutex_);
+        if (!stopping_) {
+            queue_.push_back(upload);
+            return;
+        }
+    }
+    // the loader is going away
+    finishStages(upload);
+}
+
+void TextureLoader::finishStages(const std::shared_ptr<TextureUpload>& upload) {
+    // the GL thread already samples this texture, it cannot start over
+    GLuint id = upload->loader_id_;
+    glBindTexture(upload->target(), id);
+    for (; upload->next_stage_ < upload->stage_count(); ++upload->next_stage_) {
+        upload->issueStage(upload->next_stage_, false);
+    }
+    glTexParameteri(upload->target(), GL_TEXTURE_BASE_LEVEL, 0);
+    glBindTexture(upload->target(), 0);
+    glFinish();
+    upload->loader_id_ = 0;
+    upload->releaseData();
+    ++uploaded_count_;
+    complete(upload, id, TextureUpload::DONE);
+}
+
+void TextureLoader::complete(const std::shared_ptr<TextureUpload>& upload,
+        GLuint id, int state) {
+    if (!upload->finish(id, state)) {
+        // the texture went away while it was loading
+        if (0 != id) {
+            glDeleteTextures(1, &id);
+        }
+    }
+    {
+        // wait() checks the state under the lock; taking it here keeps the
+        // notification from falling between that check and its sleep
+        std::lock_guard < std::mutex > lock(mutex_);
+    }
+    finished_.notify_all();
+}
+
+TextureLoader::PixelBuffer TextureLoader::acquireBuffer(size_t size) {
+    // the smallest free buffer that fits
+    int best = -1;
+    for (size_t i = 0; i < free_buffers_.size(); ++i) {
+        if (free_buffers_[i].size >= size
+                && (best < 0 || free_buffers_[i].size < free_buffers_[best].size)) {
+            best = i;
+        }
+    }
+    PixelBuffer pixels;
+    if (best >= 0) {
+        pixels = free_buffers_[best];
+        free_buffers_.erase(free_buffers_.begin() + best);
+        return pixels;
+    }
+    glGenBuffers(1, &pixels.buffer);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixels.buffer);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    pixels.size = size;
+    return pixels;
+}
+
+void TextureLoader::releaseBuffer(const PixelBuffer& pixels) {
+    free_buffers_.push_back(pixels);
+    if (free_buffers_.size() > MAX_FREE_BUFFERS) {
+        // let the smallest go, big textures are the ones worth a buffer
+        auto smallest = free_buffers_.begin();
+        for (auto it = free_buffers_.begin(); it != free_buffers_.end(); ++it) {
+            if (it->size < smallest->size) {
+                smallest = it;
+            }
+        }
+        glDeleteBuffers(1, &smallest->buffer);
+        free_buffers_.erase(smallest);
+    }
+}
+
+}
@@ -0,0 +1,348 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Uploads texture images on a thread with its own GL context.
+ ***************************************************************************/
+
+#ifndef TEXTURE_LOADER_H_
+#define TEXTURE_LOADER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "gl/gl_headers.h"
+
+namespace gvr {
+class GlDelete;
+
+/*
+ * The images of one texture, copied out of Java memory when the texture
+ * is constructed so nothing has to stay pinned until it is uploaded, or
+ * pointing into memory the upload keeps alive, such as a mapped file.
+ * Shared between the GLTexture and the TextureLoader; whichever side
+ * lets go last cleans up the GL name.
+ *
+ * Images can be split into stages that the loader uploads one at a time,
+ * each raising GL_TEXTURE_BASE_LEVEL to the finest level it brought, so
+ * a texture is usable from its small mips while the big ones stream in.
+ * Streaming needs immutable storage, see setStorage.
+ */
+class TextureUpload {
+public:
+    enum State {
+        QUEUED = 0,     // waiting for the loader, or for the GL thread
+        UPLOADING,      // nothing has landed yet
+        STREAMING,      // some stages landed, id() can be sampled
+        DONE,           // every stage landed, id() can be taken over
+        FAILED,
+    };
+
+    struct Image {
+        GLenum target;          // GL_TEXTURE_2D or a cube map face
+        GLint level;
+        GLenum internal_format;
+        GLsizei width;
+        GLsizei height;
+        GLenum format;          // 0 for compressed images
+        GLenum type;
+        const char* source;     // outside memory, or null for the copied data
+        size_t offset;          // into the copied data
+        size_t size;
+        int stage;
+    };
+
+    // texture_parameters as taken by GLTexture, or null for the defaults
+    TextureUpload(GLenum target, const int* texture_parameters);
+
+    // returns where to copy the image's size bytes to
+    void* addImage(GLenum target, GLint level, GLenum internal_format,
+            GLsizei width, GLsizei height, GLenum format, GLenum type, size_t size);
+
+    void addCompressedImage(GLenum target, GLint level, GLenum internal_format,
+            GLsizei width, GLsizei height, const void* data, size_t size) {
+        memcpy(addImage(target, level, internal_format, width, height, 0, 0, size),
+                data, size);
+    }
+
+    // an image read in place; keep the memory alive with setSource
+    void addSourceImage(GLenum target, GLint level, GLenum internal_format,
+            GLsizei width, GLsizei height, GLenum format, GLenum type,
+            const void* pixels, size_t size);
+
+    void setSource(const std::shared_ptr<const void>& source) {
+        source_ = source;
+    }
+
+    /*
+     * Allocates every level up front with glTexStorage2D and fills them
+     * with sub-image uploads, instead of defining each level by its image.
+     */
+    void setStorage(GLsizei levels, GLenum internal_format, GLsizei width, GLsizei height);
+
+    // images added from now on go into the next stage
+    void nextStage() {
+        ++stage_count_;
+    }
+
+    int stage_count() const {
+        return stage_count_;
+    }
+
+    // the finest level of the stage
+    GLint stageBaseLevel(int stage) const;
+
+    // bytes the stage takes packed into a buffer
+    size_t stageSize(int stage) const;
+
+    GLenum target() const {
+        return target_;
+    }
+
+    int state() const {
+        return state_.load(std::memory_order_acquire);
+    }
+
+    // stages that have landed, changes while STREAMING
+    int landed_stages() const {
+        return landed_stages_.load(std::memory_order_acquire);
+    }
+
+    // as passed in, or null
+    const int* texture_parameters() const {
+        return has_parameters_ ? texture_parameters_ : nullptr;
+    }
+
+    bool has_storage() const {
+        return storage_levels_ > 0;
+    }
+
+    // allocates the storage of the bound texture, if it has any, from
+    // first_level down
+    void allocate(GLint first_level = 0) const;
+
+    GLint levelCount() const;
+
+    // bytes of the level's images, all faces
+    size_t levelSize(GLint level) const;
+
+    // bytes of all the images
+    size_t byteSize() const;
+
+    // packs the stage's images into dst, stageSize bytes
+    void copyStage(int stage, char* dst) const;
+
+    /*
+     * Issues the stage's images into the bound texture, from memory or,
+     * packed as copyStage lays them out, from the bound
+     * GL_PIXEL_UNPACK_BUFFER.
+     */
+    void issueStage(int stage, bool from_buffer) const;
+
+    /*
+     * Issues the levels [first_level, end_level) from memory. Only an
+     * upload with a source still has its images after releaseData.
+     */
+    void issueLevels(GLint first_level, GLint end_level) const;
+
+    // redefines the levels [first_level, end_level) as empty images
+    void releaseLevels(GLint first_level, GLint end_level) const;
+
+    // true when the images are in outside memory, so they outlive releaseData
+    bool reloadable() const {
+        return nullptr != source_;
+    }
+
+    /*
+     * A single stage upload of the levels from first_level down, with
+     * first_level as its level 0, reading the same outside memory. For
+     * rebuilding a reloadable texture with fewer or more levels.
+     */
+    std::shared_ptr<TextureUpload> fromLevel(GLint first_level,
+            const int* texture_parameters) const;
+
+    /*
+     * Lets go of the copied images once they are on the GPU. Memory set
+     * with setSource stays, it costs no heap, so the texture can be
+     * reloaded from it.
+     */
+    void releaseData() {
+        std::vector<char>().swap(data_);
+    }
+
+    /*
+     * Hands over the finished texture, or 0 when it is not finished.
+     * A texture that is given up before that is deleted by whoever
+     * finishes it.
+     */
+    GLuint takeId();
+    GLuint abandon();
+    bool abandoned();
+
+    // the texture being streamed, owned by the loader until DONE
+    GLuint id();
+
+    // the side that finished it: publishes the name, false if abandoned
+    bool finish(GLuint id, int state);
+
+    // the loader, after a stage landed: false if abandoned
+    bool land(GLuint id);
+
+private:
+    TextureUpload(const TextureUpload& upload);
+    TextureUpload(TextureUpload&& upload);
+    TextureUpload& operator=(const TextureUpload& upload);
+    TextureUpload& operator=(TextureUpload&& upload);
+
+    void issueImage(const Image& image, GLint level, const char* data) const;
+
+    const char* pixels(const Image& image) const {
+        return nullptr != image.source ? image.source : data_.data() + image.offset;
+    }
+
+private:
+    friend class TextureLoader;
+
+    GLenum target_;
+    bool has_parameters_;
+    int texture_parameters_[5];
+    GLsizei storage_levels_;        // 0 without storage
+    GLenum storage_format_;
+    GLsizei storage_width_;
+    GLsizei storage_height_;
+    std::vector<Image> images_;
+    std::vector<char> data_;
+    std::shared_ptr<const void> source_;
+    int stage_count_;
+
+    std::mutex mutex_;              // guards id_ and abandoned_
+    std::atomic<int> state_;
+    std::atomic<int> landed_stages_;
+    GLuint id_;
+    bool abandoned_;
+
+    // the loader's own, between stages
+    GLuint loader_id_;
+    int next_stage_;
+};
+
+/*
+ * A worker thread that owns an EGL context in the share group of the
+ * renderer's. Textures are created and filled there: the images go
+ * through a pixel unpack buffer, then a fence is inserted and the upload
+ * only counts as done once the worker has seen the fence signal, so the
+ * GL thread never waits for the copy or the driver's conversion.
+ *
+ * A streamed texture goes back to the end of the queue after each stage,
+ * so the first stages of everything queued land before the big levels.
+ *
+ * start() must be called on the GL thread with its context current.
+ * Until then, or when no shared context can be created, submit() returns
+ * false and textures upload on the GL thread at first use as before.
+ */
+class TextureLoader {
+public:
+    static const size_t MAX_FREE_BUFFERS = 4;
+
+    static TextureLoader* getInstance();
+
+    bool start();
+    void stop();
+
+    bool running() const {
+        return running_.load(std::memory_order_acquire);
+    }
+
+    // any thread: queues the upload, false when the loader is not running
+    bool submit(const std::shared_ptr<TextureUpload>& upload);
+
+    // blocks until the upload is done or failed
+    void wait(const TextureUpload& upload);
+
+    // the GL thread's deleter, for the textures the loader created
+    GlDelete* deleter() const {
+        return deleter_;
+    }
+
+    int uploaded_count() const {
+        return uploaded_count_;
+    }
+
+    size_t uploaded_bytes() const {
+        return uploaded_bytes_;
+    }
+
+private:
+    TextureLoader();
+    TextureLoader(const TextureLoader& loader);
+    TextureLoader(TextureLoader&& loader);
+    TextureLoader& operator=(const TextureLoader& loader);
+    TextureLoader& operator=(TextureLoader&& loader);
+
+    struct PixelBuffer {
+        GLuint buffer;
+        size_t size;
+    };
+
+    struct InFlight {
+        std::shared_ptr<TextureUpload> upload;
+        GLsync fence;
+        PixelBuffer pixels;
+    };
+
+    bool createContext();
+    void destroyContext();
+    void loop();
+    void upload(const std::shared_ptr<TextureUpload>& upload);
+    void retire(bool block);
+    void landed(const std::shared_ptr<TextureUpload>& upload);
+    void finishStages(const std::shared_ptr<TextureUpload>& upload);
+    void complete(const std::shared_ptr<TextureUpload>& upload, GLuint id, int state);
+    PixelBuffer acquireBuffer(size_t size);
+    void releaseBuffer(const PixelBuffer& pixels);
+
+private:
+    static TextureLoader* instance_;
+
+    EGLDisplay display_;
+    EGLContext context_;
+    EGLSurface surface_;
+    GlDelete* deleter_;
+
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable finished_;
+    std::deque<std::shared_ptr<TextureUpload> > queue_;
+    std::atomic<bool> running_;
+    bool stopping_;
+
+    // worker only
+    std::vector<InFlight> in_flight_;
+    std::vector<PixelBuffer> free_buffers_;
+
+    std::atomic<int> uploaded_count_;
+    std::atomic<size_t> uploaded_bytes_;
+};
+
+}
+#endif
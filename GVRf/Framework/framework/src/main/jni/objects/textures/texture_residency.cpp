@@ -0,0 +1,291 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Keeps texture memory within a budget.
+ ***************************************************************************/
+
+#include "texture_residency.h"
+
+#include <algorithm>
+
+#include "gl/gl_state_cache.h"
+#include "gl/gl_texture.h"
+#include "objects/textures/texture_loader.h"
+#include "util/gvr_log.h"
+
+namespace gvr {
+
+TextureResidency* TextureResidency::instance_ = new TextureResidency();
+
+TextureResidency* TextureResidency::getInstance() {
+    return instance_;
+}
+
+TextureResidency::TextureResidency() :
+        budget_(0), frame_(1), resident_(0), dropped_(0),
+        resident_bytes_(0), dropped_bytes_(0), texture_count_(0) {
+}
+
+void TextureResidency::add(GLTexture* texture, const std::shared_ptr<TextureUpload>& upload) {
+    Entry entry;
+    entry.upload = upload;
+    entry.first_level = 0;
+    entry.rebuild_from = 0;
+    for (GLint level = 0; level < upload->levelCount(); ++level) {
+        entry.level_bytes.push_back(upload->levelSize(level));
+    }
+    texture->last_used_frame_ = frame_;
+
+    std::lock_guard < std::mutex > lock(mutex_);
+    for (auto it = entry.level_bytes.begin(); it != entry.level_bytes.end(); ++it) {
+        resident_ += *it;
+    }
+    entries_[texture] = entry;
+    updateStats();
+}
+
+void TextureResidency::addFixed(GLTexture* texture, size_t bytes) {
+    std::lock_guard < std::mutex > lock(mutex_);
+    Entry& entry = entries_[texture];
+    if (entry.level_bytes.empty()) {
+        entry.first_level = 0;
+        entry.rebuild_from = 0;
+        entry.level_bytes.push_back(0);
+    }
+    resident_ = resident_ - entry.level_bytes[0] + bytes;
+    entry.level_bytes[0] = bytes;
+    updateStats();
+}
+
+void TextureResidency::remove(GLTexture* texture) {
+    std::lock_guard < std::mutex > lock(mutex_);
+    auto it = entries_.find(texture);
+    if (entries_.end() == it) {
+        return;
+    }
+    const Entry& entry = it->second;
+    if (entry.rebuild) {
+        // deleted by the loader if it is still working on it
+        GLuint id = entry.rebuild->abandon();
+        if (0 != id && texture->deleter_) {
+            texture->deleter_->queueTexture(id, entry.rebuild->byteSize());
+        }
+    }
+    for (size_t level = 0; level < entry.level_bytes.size(); ++level) {
+        if (GLint(level) < entry.first_level) {
+            dropped_ -= entry.level_bytes[level];
+        } else {
+            resident_ -= entry.level_bytes[level];
+        }
+    }
+    entries_.erase(it);
+    updateStats();
+}
+
+void TextureResidency::beginFrame() {
+    ++frame_;
+    size_t budget = budget_.load(std::memory_order_relaxed);
+
+    std::lock_guard < std::mutex > lock(mutex_);
+    if (entries_.empty()) {
+        return;
+    }
+
+    // rebuilds the loader is done with
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+        if (it->second.rebuild && it->second.rebuild->state() >= TextureUpload::DONE) {
+            finishRebuild(it->first, it->second);
+        }
+    }
+
+    // levels of the textures in use again, one per texture and frame
+    size_t uploaded = 0;
+    size_t needed = 0;
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+        Entry& entry = it->second;
+        if (!entry.upload || 0 == entry.first_level || entry.rebuild
+                || frame_ - it->first->last_used_frame_ > 1) {
+            continue;
+        }
+        size_t bytes = entry.level_bytes[entry.first_level - 1];
+        if (0 != budget && resident_ + bytes > budget) {
+            // room for it has to come from the cold ones
+            needed = std::max(needed, bytes);
+            continue;
+        }
+        size_t upload_bytes = uploadBytes(entry, entry.first_level - 1);
+        if (uploaded > 0 && uploaded + upload_bytes > UPLOAD_BYTES_PER_FRAME) {
+            break;
+        }
+        setFirstLevel(it->first, entry, entry.first_level - 1);
+        uploaded += upload_bytes;
+    }
+
+    if (0 != budget && resident_ + needed > budget) {
+        std::vector<std::pair<GLTexture*, Entry*> > cold;
+        for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+            Entry& entry = it->second;
+            if (entry.upload && frame_ - it->first->last_used_frame_ >= IDLE_FRAMES
+                    && entry.first_level + 1 < GLint(entry.level_bytes.size())) {
+                cold.push_back(std::make_pair(it->first, &entry));
+            }
+        }
+        std::sort(cold.begin(), cold.end(),
+                [](const std::pair<GLTexture*, Entry*>& a,
+                        const std::pair<GLTexture*, Entry*>& b) {
+                    return a.first->last_used_frame_ < b.first->last_used_frame_;
+                });
+
+        // the top level of each, coldest first, then round again
+        int drops = 0;
+        bool dropped = true;
+        while (dropped && resident_ + needed > budget) {
+            dropped = false;
+            for (auto it = cold.begin(); it != cold.end(); ++it) {
+                Entry& entry = *it->second;
+                if (entry.rebuild || entry.first_level + 1 >= GLint(entry.level_bytes.size())) {
+                    continue;
+                }
+                size_t upload_bytes = uploadBytes(entry, entry.first_level + 1);
+                if (drops >= MAX_DROPS_PER_FRAME
+                        || (uploaded > 0 && uploaded + upload_bytes > UPLOAD_BYTES_PER_FRAME)) {
+                    // the rest next frame
+                    dropped = false;
+                    break;
+                }
+                setFirstLevel(it->first, entry, entry.first_level + 1);
+                uploaded += upload_bytes;
+                ++drops;
+                dropped = true;
+                if (resident_ + needed <= budget) {
+                    break;
+                }
+            }
+        }
+    }
+    updateStats();
+}
+
+size_t TextureResidency::uploadBytes(const Entry& entry, GLint first_level) const {
+    size_t bytes = 0;
+    if (entry.upload->has_storage()) {
+        // rebuilt with every level it keeps
+        for (size_t level = first_level; level < entry.level_bytes.size(); ++level) {
+            bytes += entry.level_bytes[level];
+        }
+    } else {
+        // dropped levels are only redefined empty
+        for (GLint level = first_level; level < entry.first_level; ++level) {
+            bytes += entry.level_bytes[level];
+        }
+    }
+    return bytes;
+}
+
+void TextureResidency::setFirstLevel(GLTexture* texture, Entry& entry, GLint first_level) {
+    GLenum target = texture->target();
+    GLStateCache* cache = GLStateCache::getInstance();
+    const TextureUpload& upload = *entry.upload;
+
+    if (upload.has_storage()) {
+        // keep the parameters the texture was given since
+        int parameters[5] = { GL_LINEAR, GL_LINEAR, 1, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE };
+        GLfloat anisotropy = 1.0f;
+        cache->bindTexture(target, texture->id_);
+        glGetTexParameteriv(target, GL_TEXTURE_MIN_FILTER, &parameters[0]);
+        glGetTexParameteriv(target, GL_TEXTURE_MAG_FILTER, &parameters[1]);
+        glGetTexParameterfv(target, GL_TEXTURE_MAX_ANISOTROPY_EXT, &anisotropy);
+        glGetTexParameteriv(target, GL_TEXTURE_WRAP_S, &parameters[3]);
+        glGetTexParameteriv(target, GL_TEXTURE_WRAP_T, &parameters[4]);
+        parameters[2] = static_cast<int>(anisotropy);
+        cache->bindTexture(target, 0);
+
+        std::shared_ptr<TextureUpload> rebuild = upload.fromLevel(first_level, parameters);
+        entry.rebuild_from = entry.first_level;
+        account(entry, first_level);
+        if (TextureLoader::getInstance()->submit(rebuild)) {
+            // the old name is sampled until the new one has landed
+            entry.rebuild = rebuild;
+            return;
+        }
+
+        GLuint id;
+        glGenTextures(1, &id);
+        cache->bindTexture(target, id);
+        GLTexture::setParameters(target, rebuild->texture_parameters());
+        rebuild->allocate();
+        rebuild->issueStage(0, false);
+        cache->bindTexture(target, 0);
+        replaceId(texture, id);
+        return;
+    }
+
+    cache->bindTexture(target, texture->id_);
+    if (first_level > entry.first_level) {
+        glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, first_level);
+        upload.releaseLevels(entry.first_level, first_level);
+    } else {
+        upload.issueLevels(first_level, entry.first_level);
+        glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, first_level);
+    }
+    cache->bindTexture(target, 0);
+    account(entry, first_level);
+}
+
+void TextureResidency::finishRebuild(GLTexture* texture, Entry& entry) {
+    GLuint id = entry.rebuild->takeId();
+    entry.rebuild.reset();
+    if (0 == id) {
+        LOGW("TextureResidency: rebuild failed, keeping level %d", entry.rebuild_from);
+        account(entry, entry.rebuild_from);
+        return;
+    }
+    // filled in another context, bind it again to see it
+    GLStateCache::getInstance()->forgetTexture(id);
+    replaceId(texture, id);
+}
+
+void TextureResidency::replaceId(GLTexture* texture, GLuint id) {
+    // the name may come back for another texture
+    GLuint old_id = texture->id_;
+    GLStateCache::getInstance()->forgetTexture(old_id);
+    glDeleteTextures(1, &old_id);
+    texture->id_ = id;
+}
+
+// moves the bytes of the levels between resident and dropped
+void TextureResidency::account(Entry& entry, GLint first_level) {
+    for (GLint level = std::min(first_level, entry.first_level);
+            level < std::max(first_level, entry.first_level); ++level) {
+        size_t bytes = entry.level_bytes[level];
+        if (first_level > entry.first_level) {
+            resident_ -= bytes;
+            dropped_ += bytes;
+        } else {
+            resident_ += bytes;
+            dropped_ -= bytes;
+        }
+    }
+    entry.first_level = first_level;
+}
+
+void TextureResidency::updateStats() {
+    resident_bytes_.store(resident_, std::memory_order_relaxed);
+    dropped_bytes_.store(dropped_, std::memory_order_relaxed);
+    texture_count_.store(entries_.size(), std::memory_order_relaxed);
+}
+
+}
@@ -0,0 +1,144 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Keeps texture memory within a budget.
+ ***************************************************************************/
+
+#ifndef TEXTURE_RESIDENCY_H_
+#define TEXTURE_RESIDENCY_H_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "gl/gl_headers.h"
+
+namespace gvr {
+class GLTexture;
+class TextureUpload;
+
+/*
+ * Counts the bytes every texture takes on the GPU against a budget. The
+ * textures whose images can be issued again, those read from a mapped
+ * file, are tracked by level and can be evicted; the others, bitmaps,
+ * copied images, render targets, only count. The shaders stamp a texture
+ * with the frame whenever they bind it.
+ *
+ * While the resident bytes are over the budget, the top levels of the
+ * textures unused for IDLE_FRAMES go, one level of each, coldest first,
+ * until the rest fits. A texture that is used again gets its levels
+ * back, coarse to fine, once they fit.
+ *
+ * Levels of a mutable texture are redefined empty behind a raised
+ * GL_TEXTURE_BASE_LEVEL, so its name stays, and issued again on the GL
+ * thread. Immutable storage cannot give levels back: those textures are
+ * rebuilt with the other levels under a new name by the TextureLoader,
+ * and the new name replaces the old once the loader's fence signalled.
+ * A texture has one rebuild at a time.
+ *
+ * The bytes issued for restores and rebuilds are bounded per frame, as
+ * is the number of levels dropped.
+ */
+class TextureResidency {
+public:
+    static const unsigned int IDLE_FRAMES = 30;
+    static const size_t UPLOAD_BYTES_PER_FRAME = 4 * 1024 * 1024;
+    static const int MAX_DROPS_PER_FRAME = 16;
+
+    static TextureResidency* getInstance();
+
+    // any thread; 0, the default, for no budget
+    void setBudget(size_t bytes) {
+        budget_.store(bytes, std::memory_order_relaxed);
+    }
+
+    size_t budget() const {
+        return budget_.load(std::memory_order_relaxed);
+    }
+
+    // the frame the GL thread is in
+    unsigned int frame() const {
+        return frame_;
+    }
+
+    // GL thread: the texture's images are on the GPU and upload can issue them again
+    void add(GLTexture* texture, const std::shared_ptr<TextureUpload>& upload);
+
+    // GL thread: the texture takes bytes that cannot be evicted; again when they change
+    void addFixed(GLTexture* texture, size_t bytes);
+
+    // any thread, before the texture goes
+    void remove(GLTexture* texture);
+
+    // GL thread, once per frame
+    void beginFrame();
+
+    size_t resident_bytes() const {
+        return resident_bytes_.load(std::memory_order_relaxed);
+    }
+
+    // bytes of the levels that are dropped at the moment
+    size_t dropped_bytes() const {
+        return dropped_bytes_.load(std::memory_order_relaxed);
+    }
+
+    int texture_count() const {
+        return texture_count_.load(std::memory_order_relaxed);
+    }
+
+private:
+    TextureResidency();
+    TextureResidency(const TextureResidency& residency);
+    TextureResidency(TextureResidency&& residency);
+    TextureResidency& operator=(const TextureResidency& residency);
+    TextureResidency& operator=(TextureResidency&& residency);
+
+    struct Entry {
+        std::shared_ptr<TextureUpload> upload;     // null when it cannot be evicted
+        std::vector<size_t> level_bytes;
+        GLint first_level;      // the finest level on the GPU, or once rebuilt
+        std::shared_ptr<TextureUpload> rebuild;     // with the loader
+        GLint rebuild_from;     // first_level before the rebuild
+    };
+
+    // bytes issued to move the texture's first level
+    size_t uploadBytes(const Entry& entry, GLint first_level) const;
+    void setFirstLevel(GLTexture* texture, Entry& entry, GLint first_level);
+    void finishRebuild(GLTexture* texture, Entry& entry);
+    void replaceId(GLTexture* texture, GLuint id);
+    void account(Entry& entry, GLint first_level);
+    void updateStats();
+
+private:
+    static TextureResidency* instance_;
+
+    std::mutex mutex_;      // guards entries_
+    std::unordered_map<GLTexture*, Entry> entries_;
+    std::atomic<size_t> budget_;
+    unsigned int frame_;
+    size_t resident_;
+    size_t dropped_;
+
+    std::atomic<size_t> resident_bytes_;
+    std::atomic<size_t> dropped_bytes_;
+    std::atomic<int> texture_count_;
+};
+
+}
+#endif
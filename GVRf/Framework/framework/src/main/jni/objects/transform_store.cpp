@@ -0,0 +1,293 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Structure-of-arrays storage for the local and world state of every
+ * Transform.
+ ***************************************************************************/
+
+#include "transform_store.h"
+
+#include "objects/scene_object.h"
+#include "objects/components/transform.h"
+#include "util/gvr_log.h"
+
+namespace gvr {
+
+TransformStore* TransformStore::instance_ = new TransformStore();
+
+TransformStore::TransformStore() :
+        block_count_(0), slot_count_(0), order_dirty_(false) {
+}
+
+int TransformStore::allocate(Transform* owner) {
+    std::lock_guard < std::mutex > lock(mutex_);
+    int slot;
+    if (!free_slots_.empty()) {
+        slot = free_slots_.back();
+        free_slots_.pop_back();
+    } else {
+        if (slot_count_ == block_count_ * BLOCK_SIZE) {
+            if (MAX_BLOCKS == block_count_) {
+                std::string error = "TransformStore::allocate() : out of transform slots.";
+                LOGE("%s", error.c_str());
+                throw error;
+            }
+            blocks_[block_count_++] = new Block();
+        }
+        slot = slot_count_++;
+    }
+
+    Block* b = block(slot);
+    int i = index(slot);
+    b->position[i] = glm::vec3(0.0f, 0.0f, 0.0f);
+    b->rotation[i] = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+    b->scale[i] = glm::vec3(1.0f, 1.0f, 1.0f);
+    b->world[i] = glm::mat4();
+    b->parent[i] = NO_SLOT;
+    b->first_child[i] = NO_SLOT;
+    b->next_sibling[i] = NO_SLOT;
+    b->prev_sibling[i] = NO_SLOT;
+    b->flags[i] = FLAG_ALLOCATED | FLAG_DIRTY;
+    b->owner[i] = owner;
+    order_dirty_ = true;
+    return slot;
+}
+
+void TransformStore::release(int slot) {
+    std::lock_guard < std::mutex > lock(mutex_);
+    Block* b = block(slot);
+    int i = index(slot);
+    while (NO_SLOT != b->first_child[i]) {
+        int child = b->first_child[i];
+        unlink(child);
+        block(child)->flags[index(child)] |= FLAG_DIRTY;
+        touchOwner(child);
+        markDescendants(child);
+    }
+    unlink(slot);
+    b->flags[i] = 0;
+    b->owner[i] = nullptr;
+    free_slots_.push_back(slot);
+    order_dirty_ = true;
+}
+
+void TransformStore::link(int slot, int parent_slot) {
+    Block* b = block(slot);
+    int i = index(slot);
+    b->parent[i] = parent_slot;
+    if (NO_SLOT == parent_slot) {
+        return;
+    }
+    Block* pb = block(parent_slot);
+    int pi = index(parent_slot);
+    int first = pb->first_child[pi];
+    b->prev_sibling[i] = NO_SLOT;
+    b->next_sibling[i] = first;
+    if (NO_SLOT != first) {
+        block(first)->prev_sibling[index(first)] = slot;
+    }
+    pb->first_child[pi] = slot;
+}
+
+void TransformStore::unlink(int slot) {
+    Block* b = block(slot);
+    int i = index(slot);
+    int parent_slot = b->parent[i];
+    if (NO_SLOT == parent_slot) {
+        return;
+    }
+    int prev = b->prev_sibling[i];
+    int next = b->next_sibling[i];
+    if (NO_SLOT != prev) {
+        block(prev)->next_sibling[index(prev)] = next;
+    } else {
+        block(parent_slot)->first_child[index(parent_slot)] = next;
+    }
+    if (NO_SLOT != next) {
+        block(next)->prev_sibling[index(next)] = prev;
+    }
+    b->parent[i] = NO_SLOT;
+    b->prev_sibling[i] = NO_SLOT;
+    b->next_sibling[i] = NO_SLOT;
+}
+
+void TransformStore::setParent(int slot, int parent_slot) {
+    {
+        std::lock_guard < std::mutex > lock(mutex_);
+        if (block(slot)->parent[index(slot)] != parent_slot) {
+            unlink(slot);
+            link(slot, parent_slot);
+            order_dirty_ = true;
+        }
+    }
+    invalidate(slot);
+}
+
+void TransformStore::detachChildren(int slot) {
+    std::lock_guard < std::mutex > lock(mutex_);
+    Block* b = block(slot);
+    int i = index(slot);
+    if (NO_SLOT == b->first_child[i]) {
+        return;
+    }
+    while (NO_SLOT != b->first_child[i]) {
+        int child = b->first_child[i];
+        unlink(child);
+        block(child)->flags[index(child)] |= FLAG_DIRTY;
+        touchOwner(child);
+        markDescendants(child);
+    }
+    order_dirty_ = true;
+}
+
+void TransformStore::touchOwner(int slot) {
+    Transform* t = block(slot)->owner[index(slot)];
+    SceneObject* owner_object = (nullptr != t) ? t->owner_object() : nullptr;
+    if (nullptr != owner_object) {
+        owner_object->setTransformDirty();
+        owner_object->dirtyHierarchicalBoundingVolume();
+    }
+}
+
+/*
+ * Walks the subtree below the slot through the sibling links, skipping
+ * subtrees that are already dirty. Must be called with mutex_ held.
+ */
+void TransformStore::markDescendants(int slot) {
+    int node = block(slot)->first_child[index(slot)];
+    while (NO_SLOT != node) {
+        Block* b = block(node);
+        int i = index(node);
+        bool descend = (0 == (b->flags[i] & FLAG_DIRTY))
+                && (NO_SLOT != b->first_child[i]);
+        b->flags[i] |= FLAG_DIRTY;
+        touchOwner(node);
+        if (descend) {
+            node = b->first_child[i];
+            continue;
+        }
+        // next sibling, or climb until an ancestor below slot has one
+        while (node != slot) {
+            int next = block(node)->next_sibling[index(node)];
+            if (NO_SLOT != next) {
+                node = next;
+                break;
+            }
+            node = block(node)->parent[index(node)];
+        }
+        if (node == slot) {
+            break;
+        }
+    }
+}
+
+void TransformStore::invalidate(int slot) {
+    Block* b = block(slot);
+    int i = index(slot);
+    bool was_valid = (0 == (b->flags[i] & FLAG_DIRTY));
+    b->flags[i] |= FLAG_DIRTY;
+    touchOwner(slot);
+    if (was_valid && NO_SLOT != b->first_child[i]) {
+        std::lock_guard < std::mutex > lock(mutex_);
+        markDescendants(slot);
+    }
+}
+
+glm::mat4 TransformStore::localMatrix(int slot) const {
+    Block* b = block(slot);
+    int i = index(slot);
+    // translation * rotation * scale, without the two full matrix products
+    glm::mat4 local = glm::mat4_cast(b->rotation[i]);
+    local[0] *= b->scale[i].x;
+    local[1] *= b->scale[i].y;
+    local[2] *= b->scale[i].z;
+    local[3] = glm::vec4(b->position[i], 1.0f);
+    return local;
+}
+
+void TransformStore::resolve(int slot) {
+    Block* b = block(slot);
+    int i = index(slot);
+    int parent_slot = b->parent[i];
+    if (NO_SLOT != parent_slot) {
+        b->world[i] = block(parent_slot)->world[index(parent_slot)] * localMatrix(slot);
+    } else {
+        b->world[i] = localMatrix(slot);
+    }
+    b->flags[i] &= ~FLAG_DIRTY;
+}
+
+const glm::mat4& TransformStore::worldMatrix(int slot) {
+    while (!isWorldMatrixValid(slot)) {
+        // the topmost dirty ancestor has a clean parent, resolve downwards from it
+        int top = slot;
+        for (int p = parent(top); NO_SLOT != p && !isWorldMatrixValid(p); p = parent(p)) {
+            top = p;
+        }
+        resolve(top);
+    }
+    return block(slot)->world[index(slot)];
+}
+
+/*
+ * Lays out every allocated slot in depth-first order from the roots so
+ * parents always come before their children. Must be called with mutex_
+ * held.
+ */
+void TransformStore::buildOrder() {
+    order_.clear();
+    order_.reserve(slot_count_);
+    for (int root = 0; root < slot_count_; ++root) {
+        Block* rb = block(root);
+        int ri = index(root);
+        if (0 == (rb->flags[ri] & FLAG_ALLOCATED) || NO_SLOT != rb->parent[ri]) {
+            continue;
+        }
+        int node = root;
+        while (true) {
+            order_.push_back(node);
+            int child = block(node)->first_child[index(node)];
+            if (NO_SLOT != child) {
+                node = child;
+                continue;
+            }
+            while (node != root && NO_SLOT == block(node)->next_sibling[index(node)]) {
+                node = block(node)->parent[index(node)];
+            }
+            if (node == root) {
+                break;
+            }
+            node = block(node)->next_sibling[index(node)];
+        }
+    }
+    order_dirty_ = false;
+}
+
+void TransformStore::updateWorldMatrices() {
+    std::lock_guard < std::mutex > lock(mutex_);
+    if (order_dirty_) {
+        buildOrder();
+    }
+    const int* order = order_.data();
+    for (size_t n = 0, count = order_.size(); n < count; ++n) {
+        int slot = order[n];
+        if (0 != (block(slot)->flags[index(slot)] & FLAG_DIRTY)) {
+            resolve(slot);
+        }
+    }
+}
+
+}
@@ -0,0 +1,167 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Structure-of-arrays storage for the local and world state of every
+ * Transform.
+ ***************************************************************************/
+
+#ifndef TRANSFORM_STORE_H_
+#define TRANSFORM_STORE_H_
+
+#include <mutex>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "glm/gtx/quaternion.hpp"
+
+namespace gvr {
+class Transform;
+
+/*
+ * Every Transform owns one slot in the store. Slots live in fixed-size
+ * blocks which are never moved or freed, so references into a slot stay
+ * valid for the lifetime of its Transform even while other threads
+ * allocate.
+ *
+ * The hierarchy is mirrored as parent / first child / sibling links
+ * between slots. A dirty world matrix implies dirty world matrices for
+ * the whole subtree below it, so invalidation stops at the first dirty
+ * slot, and updateWorldMatrices() resolves everything dirty in a single
+ * parent-before-child pass over the slots without recursion.
+ */
+class TransformStore {
+public:
+    static const int NO_SLOT = -1;
+
+    static TransformStore* getInstance() {
+        return instance_;
+    }
+
+    int allocate(Transform* owner);
+    void release(int slot);
+
+    glm::vec3& position(int slot) {
+        return block(slot)->position[index(slot)];
+    }
+
+    glm::quat& rotation(int slot) {
+        return block(slot)->rotation[index(slot)];
+    }
+
+    glm::vec3& scale(int slot) {
+        return block(slot)->scale[index(slot)];
+    }
+
+    int parent(int slot) const {
+        return block(slot)->parent[index(slot)];
+    }
+
+    bool isWorldMatrixValid(int slot) const {
+        return 0 == (block(slot)->flags[index(slot)] & FLAG_DIRTY);
+    }
+
+    /*
+     * Re-parents a slot (NO_SLOT makes it a root) and invalidates it.
+     */
+    void setParent(int slot, int parent_slot);
+
+    /*
+     * Makes every child of the slot a root, as when its owner goes away.
+     */
+    void detachChildren(int slot);
+
+    /*
+     * Marks the world matrix of the slot and all its descendants dirty
+     * and flags their scene objects for batch and bounding volume updates.
+     */
+    void invalidate(int slot);
+
+    glm::mat4 localMatrix(int slot) const;
+
+    /*
+     * Returns the world matrix of one slot, resolving only the dirty part
+     * of the path to its root.
+     */
+    const glm::mat4& worldMatrix(int slot);
+
+    /*
+     * Resolves every dirty world matrix. Called once per frame before
+     * culling, so later getModelMatrix() calls are plain loads.
+     */
+    void updateWorldMatrices();
+
+    int size() const {
+        return slot_count_ - free_slots_.size();
+    }
+
+private:
+    static const int BLOCK_SHIFT = 8;
+    static const int BLOCK_SIZE = 1 << BLOCK_SHIFT;
+    static const int MAX_BLOCKS = 4096;
+
+    enum {
+        FLAG_ALLOCATED = 1,
+        FLAG_DIRTY = 2,
+    };
+
+    struct Block {
+        glm::vec3     position[BLOCK_SIZE];
+        glm::quat     rotation[BLOCK_SIZE];
+        glm::vec3     scale[BLOCK_SIZE];
+        glm::mat4     world[BLOCK_SIZE];
+        int           parent[BLOCK_SIZE];
+        int           first_child[BLOCK_SIZE];
+        int           next_sibling[BLOCK_SIZE];
+        int           prev_sibling[BLOCK_SIZE];
+        unsigned char flags[BLOCK_SIZE];
+        Transform*    owner[BLOCK_SIZE];
+    };
+
+    TransformStore();
+    TransformStore(const TransformStore& store);
+    TransformStore(TransformStore&& store);
+    TransformStore& operator=(const TransformStore& store);
+    TransformStore& operator=(TransformStore&& store);
+
+    Block* block(int slot) const {
+        return blocks_[slot >> BLOCK_SHIFT];
+    }
+
+    static int index(int slot) {
+        return slot & (BLOCK_SIZE - 1);
+    }
+
+    void link(int slot, int parent_slot);
+    void unlink(int slot);
+    void markDescendants(int slot);
+    void touchOwner(int slot);
+    void resolve(int slot);
+    void buildOrder();
+
+private:
+    static TransformStore* instance_;
+
+    std::mutex       mutex_;
+    Block*           blocks_[MAX_BLOCKS];
+    int              block_count_;
+    int              slot_count_;
+    std::vector<int> free_slots_;
+    std::vector<int> order_;
+    bool             order_dirty_;
+};
+
+}
+#endif
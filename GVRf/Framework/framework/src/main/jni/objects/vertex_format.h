@@ -0,0 +1,136 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Layout of an interleaved vertex.
+ ***************************************************************************/
+
+#ifndef VERTEX_FORMAT_H_
+#define VERTEX_FORMAT_H_
+
+#include <string>
+#include <vector>
+
+#include "gl/gl_headers.h"
+
+namespace gvr {
+
+struct VertexAttribute {
+    std::string name;
+    GLint       components;
+    GLenum      type;
+    GLboolean   normalized;
+    GLuint      offset;     // bytes from the start of the vertex
+    GLuint      size;       // bytes
+};
+
+/*
+ * The attributes of one vertex in the order they are stored, each
+ * starting on a 4 byte boundary, so a vertex blob built to this format
+ * can go to glBufferData as is and every attribute maps to one
+ * glVertexAttribPointer call.
+ */
+class VertexFormat {
+public:
+    VertexFormat() : stride_(0) {
+    }
+
+    void clear() {
+        attributes_.clear();
+        stride_ = 0;
+    }
+
+    void add(const std::string& name, GLint components, GLenum type = GL_FLOAT,
+            GLboolean normalized = GL_FALSE) {
+        VertexAttribute attribute;
+        attribute.name = name;
+        attribute.components = components;
+        attribute.type = type;
+        attribute.normalized = normalized;
+        attribute.offset = stride_;
+        attribute.size = attributeSize(type, components);
+        attributes_.push_back(attribute);
+        stride_ += (attribute.size + 3) & ~3;
+    }
+
+    const VertexAttribute* find(const char* name) const {
+        for (auto it = attributes_.begin(); it != attributes_.end(); ++it) {
+            if (it->name == name) {
+                return &*it;
+            }
+        }
+        return nullptr;
+    }
+
+    const std::vector<VertexAttribute>& attributes() const {
+        return attributes_;
+    }
+
+    // bytes per vertex
+    GLsizei stride() const {
+        return stride_;
+    }
+
+    bool operator==(const VertexFormat& format) const {
+        if (stride_ != format.stride_ || attributes_.size() != format.attributes_.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < attributes_.size(); ++i) {
+            const VertexAttribute& a = attributes_[i];
+            const VertexAttribute& b = format.attributes_[i];
+            if (a.name != b.name || a.components != b.components || a.type != b.type
+                    || a.normalized != b.normalized || a.offset != b.offset) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool operator!=(const VertexFormat& format) const {
+        return !(*this == format);
+    }
+
+    static GLuint attributeSize(GLenum type, GLint components) {
+        switch (type) {
+        case GL_INT_2_10_10_10_REV:
+        case GL_UNSIGNED_INT_2_10_10_10_REV:
+            // all four components in one word
+            return 4;
+        default:
+            return componentSize(type) * components;
+        }
+    }
+
+    static GLuint componentSize(GLenum type) {
+        switch (type) {
+        case GL_BYTE:
+        case GL_UNSIGNED_BYTE:
+            return 1;
+        case GL_SHORT:
+        case GL_UNSIGNED_SHORT:
+        case GL_HALF_FLOAT:
+            return 2;
+        default:
+            return 4;
+        }
+    }
+
+private:
+    std::vector<VertexAttribute> attributes_;
+    GLsizei stride_;
+};
+
+}
+#endif
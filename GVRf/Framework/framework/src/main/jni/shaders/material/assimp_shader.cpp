@@ -27,6 +27,7 @@
 #include "util/gvr_gl.h"
 
 #include "util/gvr_log.h"
+#include "gl/gl_state_cache.h"
 
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
 
@@ -200,7 +201,7 @@ AssimpShader::~AssimpShader() {
 
 void AssimpShader::render(RenderState* rstate,
         RenderData* render_data, Material* material) {
-    Texture* texture;
+    Texture* texture = nullptr;
     int feature_set = material->get_shader_feature_set();
 
     /* Get the texture only diffuse texture is set */
@@ -224,19 +225,22 @@ void AssimpShader::render(RenderState* rstate,
     u_opacity_ = glGetUniformLocation(program_->id(), "u_opacity");
 
     /* Get common attributes and uniforms from material */
-    glm::vec3 color = material->getVec3("color");
-    float opacity = material->getFloat("opacity");
+    glm::vec3 color = material->getVec3(Material::colorSlot());
+    float opacity = material->getFloat(Material::opacitySlot());
 
-    glUseProgram(program_->id());
+    GLStateCache::getInstance()->useProgram(program_->id());
     glUniformMatrix4fv(u_mvp_, 1, GL_FALSE, glm::value_ptr(rstate->uniforms.u_mvp));
 
     if (ISSET(feature_set, AS_DIFFUSE_TEXTURE)) {
-        glActiveTexture (GL_TEXTURE0);
-        glBindTexture(texture->getTarget(), texture->getId());
+        GLStateCache::getInstance()->activeTexture(GL_TEXTURE0);
+        texture->markUsed();
+        GLStateCache::getInstance()->bindTexture(texture->getTarget(), texture->getId());
         glUniform1i(u_texture_, 0);
     } else {
-        glm::vec4 diffuse_color = material->getVec4("diffuse_color");
-        glm::vec4 ambient_color = material->getVec4("ambient_color");
+        static const int diffuse_color_slot = Material::declare("diffuse_color", MaterialLayout::VEC4);
+        static const int ambient_color_slot = Material::declare("ambient_color", MaterialLayout::VEC4);
+        glm::vec4 diffuse_color = material->getVec4(diffuse_color_slot);
+        glm::vec4 ambient_color = material->getVec4(ambient_color_slot);
         glUniform4f(u_diffuse_color_, diffuse_color.r, diffuse_color.g,
                 diffuse_color.b, diffuse_color.a);
         glUniform4f(u_ambient_color_, ambient_color.r, ambient_color.g,
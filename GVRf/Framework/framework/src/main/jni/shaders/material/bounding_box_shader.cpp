@@ -25,6 +25,7 @@
 #include "objects/components/render_data.h"
 #include "objects/textures/texture.h"
 #include "util/gvr_gl.h"
+#include "gl/gl_state_cache.h"
 
 namespace gvr {
 static const char VERTEX_SHADER[] = //
@@ -53,7 +54,7 @@ BoundingBoxShader::~BoundingBoxShader() {
 
 void BoundingBoxShader::render(const glm::mat4& mvp_matrix,
         RenderData* render_data, Material* material) {
-    glUseProgram(program_->id());
+    GLStateCache::getInstance()->useProgram(program_->id());
     glUniformMatrix4fv(u_mvp_, 1, GL_FALSE, glm::value_ptr(mvp_matrix));
     checkGlError("BoundingBoxShader::render");
 }
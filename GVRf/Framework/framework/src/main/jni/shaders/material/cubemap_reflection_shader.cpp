@@ -26,6 +26,7 @@
 #include "objects/textures/texture.h"
 #include "util/gvr_gl.h"
 #include "engine/renderer/renderer.h"
+#include "gl/gl_state_cache.h"
 
 // OpenGL Cube map texture uses coordinate system different to other OpenGL functions:
 // Positive x pointing right, positive y pointing up, positive z pointing inward.
@@ -115,8 +116,8 @@ CubemapReflectionShader::~CubemapReflectionShader() {
 
 void CubemapReflectionShader::render(RenderState* rstate, RenderData* render_data, Material* material) {
     Texture* texture = material->getTexture("main_texture");
-    glm::vec3 color = material->getVec3("color");
-    float opacity = material->getFloat("opacity");
+    glm::vec3 color = material->getVec3(Material::colorSlot());
+    float opacity = material->getFloat(Material::opacitySlot());
 
     if (texture->getTarget() != GL_TEXTURE_CUBE_MAP) {
         std::string error =
@@ -124,14 +125,15 @@ void CubemapReflectionShader::render(RenderState* rstate, RenderData* render_dat
         throw error;
     }
 
-    glUseProgram(program_->id());
+    GLStateCache::getInstance()->useProgram(program_->id());
     glUniformMatrix4fv(u_mv_, 1, GL_FALSE, glm::value_ptr(rstate->uniforms.u_mv));
     glUniformMatrix4fv(u_mv_it_, 1, GL_FALSE, glm::value_ptr(rstate->uniforms.u_mv_it));
     glUniformMatrix4fv(u_mvp_, 1, GL_FALSE, glm::value_ptr(rstate->uniforms.u_mvp));
     glUniformMatrix4fv(u_view_i_, 1, GL_FALSE,
             glm::value_ptr(rstate->uniforms.u_view_inv));
-    glActiveTexture (GL_TEXTURE0);
-    glBindTexture(texture->getTarget(), texture->getId());
+    GLStateCache::getInstance()->activeTexture(GL_TEXTURE0);
+    texture->markUsed();
+    GLStateCache::getInstance()->bindTexture(texture->getTarget(), texture->getId());
     glUniform1i(u_texture_, 0);
     glUniform3f(u_color_, color.r, color.g, color.b);
     glUniform1f(u_opacity_, opacity);
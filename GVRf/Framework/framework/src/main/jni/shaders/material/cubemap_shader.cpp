@@ -26,6 +26,7 @@
 #include "objects/textures/texture.h"
 #include "util/gvr_gl.h"
 #include "engine/renderer/renderer.h"
+#include "gl/gl_state_cache.h"
 
 // OpenGL Cube map texture uses coordinate system different to other OpenGL functions:
 // Positive x pointing right, positive y pointing up, positive z pointing inward.
@@ -103,18 +104,19 @@ CubemapShader::~CubemapShader() {
 
 void CubemapShader::render(RenderState* rstate, RenderData* render_data, Material* material) {
     Texture* texture = material->getTexture("main_texture");
-    glm::vec3 color = material->getVec3("color");
-    float opacity = material->getFloat("opacity");
+    glm::vec3 color = material->getVec3(Material::colorSlot());
+    float opacity = material->getFloat(Material::opacitySlot());
 
     if (texture->getTarget() != GL_TEXTURE_CUBE_MAP) {
         std::string error = "CubemapShader::render : texture with wrong target";
         throw error;
     }
-    glUseProgram(program_->id());
+    GLStateCache::getInstance()->useProgram(program_->id());
     glUniformMatrix4fv(u_model_, 1, GL_FALSE, glm::value_ptr(rstate->uniforms.u_model));
     glUniformMatrix4fv(u_mvp_, 1, GL_FALSE, glm::value_ptr(rstate->uniforms.u_mvp));
-    glActiveTexture (GL_TEXTURE0);
-    glBindTexture(texture->getTarget(), texture->getId());
+    GLStateCache::getInstance()->activeTexture(GL_TEXTURE0);
+    texture->markUsed();
+    GLStateCache::getInstance()->bindTexture(texture->getTarget(), texture->getId());
     glUniform1i(u_texture_, 0);
     glUniform3f(u_color_, color.r, color.g, color.b);
     glUniform1f(u_opacity_, opacity);
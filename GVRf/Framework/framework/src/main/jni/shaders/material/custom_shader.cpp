@@ -19,6 +19,7 @@
 
 #include "custom_shader.h"
 #include "engine/renderer/renderer.h"
+#include "engine/renderer/uniform_blocks.h"
 #include "gl/gl_program.h"
 #include "objects/material.h"
 #include "objects/scene.h"
@@ -27,11 +28,13 @@
 #include "objects/components/render_data.h"
 #include "util/gvr_gl.h"
 
-#include <sys/time.h>
+#include "gl/gl_state_cache.h"
 
 namespace gvr {
 CustomShader::CustomShader(const std::string& vertex_shader, const std::string& fragment_shader)
-    : vertexShader_(vertex_shader), fragmentShader_(fragment_shader) {
+    : u_mvp_(-1), u_mv_(-1), u_view_(-1), u_mv_it_(-1), u_right_(-1), u_model_(-1),
+      a_instance_matrix_(-1), variablesDirty_(false),
+      vertexShader_(vertex_shader), fragmentShader_(fragment_shader) {
 }
 void CustomShader::initializeOnDemand(RenderState* rstate) {
     if (nullptr == program_)
@@ -59,45 +62,69 @@ void CustomShader::initializeOnDemand(RenderState* rstate) {
         }
         u_right_ = glGetUniformLocation(program_->id(), "u_right");
         u_model_ = glGetUniformLocation(program_->id(), "u_model");
+        a_instance_matrix_ = glGetAttribLocation(program_->id(), "a_instance_matrix");
+        bindings_.a_bone_indices = glGetAttribLocation(program_->id(), "a_bone_indices");
+        bindings_.a_bone_weights = glGetAttribLocation(program_->id(), "a_bone_weights");
+        bindings_.u_bone_matrices = glGetUniformLocation(program_->id(), "u_bone_matrix[0]");
+        bindings_.u_shadow_maps = glGetUniformLocation(program_->id(), "u_shadow_maps");
+        // matrices declared in the blocks come from the renderer's buffers
+        UniformBlocks::bindProgram(program_->id());
         vertexShader_.clear();
         fragmentShader_.clear();
         LOGE("Custom shader added program %d", program_->id());
     }
-   if (textureVariablesDirty_) {
-        std::lock_guard<std::mutex> lock(textureVariablesLock_);
-        for (auto it = textureVariables_.begin(); it != textureVariables_.end(); ++it) {
-            if (-1 == it->location) {
-                it->location = it->variableType.f_getLocation(program_->id());
-                LOGV("CustomShader::texture:location: variable: %s location: %d", it->variable.c_str(),
-                        it->location);
-            }
-        }
-        textureVariablesDirty_ = false;
+    if (variablesDirty_.load(std::memory_order_acquire)) {
+        buildBindings();
     }
+}
 
-    if (uniformVariablesDirty_) {
-        std::lock_guard<std::mutex> lock(uniformVariablesLock_);
-        for (auto it = uniformVariables_.begin(); it != uniformVariables_.end(); ++it) {
-            LOGV("CustomShader::uniform:location: variable: %s", it->variable.c_str());
-            if (-1 == it->location) {
-                it->location = it->variableType.f_getLocation(program_->id());
-                LOGV("CustomShader::uniform:location: location: %d", it->location);
-            }
-        }
-        uniformVariablesDirty_ = false;
+/*
+ * Resolves the variables added so far against the program. Runs once
+ * after linking and after each batch of add*Key calls.
+ */
+void CustomShader::buildBindings() {
+    std::vector<Variable> variables;
+    {
+        std::lock_guard<std::mutex> lock(variablesLock_);
+        variablesDirty_.store(false, std::memory_order_relaxed);
+        variables = variables_;
     }
 
-    if (attributeVariablesDirty_) {
-        std::lock_guard <std::mutex> lock(attributeVariablesLock_);
-        for (auto it = attributeVariables_.begin(); it != attributeVariables_.end(); ++it) {
-            if (-1 == it->location) {
-                it->location = it->variableType.f_getLocation(program_->id());
-                LOGV("CustomShader::attribute:location: variable: %s location: %d", it->variable.c_str(),
-                        it->location);
-            }
+    bindings_.textures.clear();
+    bindings_.attributes.clear();
+    bindings_.uniforms.clear();
+    for (auto it = variables.begin(); it != variables.end(); ++it) {
+        Binding binding;
+        binding.type = it->type;
+        binding.key = it->key;
+        binding.slot = -1;
+        switch (it->type) {
+        case TEXTURE:
+            binding.location = glGetUniformLocation(program_->id(), it->variable.c_str());
+            LOGV("CustomShader::texture:location: variable: %s location: %d", it->variable.c_str(),
+                    binding.location);
+            bindings_.textures.push_back(binding);
+            break;
+        case ATTRIBUTE_FLOAT:
+        case ATTRIBUTE_VEC2:
+        case ATTRIBUTE_VEC3:
+        case ATTRIBUTE_VEC4:
+            binding.location = glGetAttribLocation(program_->id(), it->variable.c_str());
+            LOGV("CustomShader::attribute:location: variable: %s location: %d", it->variable.c_str(),
+                    binding.location);
+            bindings_.attributes.push_back(binding);
+            break;
+        default:
+            binding.location = glGetUniformLocation(program_->id(), it->variable.c_str());
+            binding.slot = Material::declare(it->key, static_cast<MaterialLayout::ParamType>(
+                    MaterialLayout::FLOAT + it->type - UNIFORM_FLOAT));
+            LOGV("CustomShader::uniform:location: variable: %s location: %d", it->variable.c_str(),
+                    binding.location);
+            bindings_.uniforms.push_back(binding);
+            break;
         }
-        attributeVariablesDirty_ = false;
     }
+    textures_.reserve(bindings_.textures.size());
 }
 
 CustomShader::~CustomShader() {
@@ -106,171 +133,166 @@ CustomShader::~CustomShader() {
 GLuint CustomShader::getProgramId(){
 	return program_->id();
 }
-void CustomShader::addTextureKey(const std::string& variable_name, const std::string& key) {
-    LOGV("CustomShader::texture:add variable: %s key: %s", variable_name.c_str(), key.c_str());
-    Descriptor<TextureVariable> d(variable_name, key);
-
-    d.variableType.f_getLocation = [variable_name] (GLuint programId) {
-        return glGetUniformLocation(programId, variable_name.c_str());
-    };
-
-    d.variableType.f_bind = [key] (int& textureIndex, const Material& material, GLuint location) {
-        glActiveTexture(GL_TEXTURE0 + textureIndex);
-        Texture* texture = material.getTextureNoError(key);
-        if (nullptr != texture) {
-            glBindTexture(texture->getTarget(), texture->getId());
-            glUniform1i(location, textureIndex++);
+void CustomShader::addVariable(const std::string& variable_name, const std::string& key,
+        VariableType type) {
+    LOGV("CustomShader::add variable: %s key: %s", variable_name.c_str(), key.c_str());
+    std::lock_guard<std::mutex> lock(variablesLock_);
+    for (auto it = variables_.begin(); it != variables_.end(); ++it) {
+        if (it->variable == variable_name && it->key == key) {
+            return;
         }
-    };
-
-    std::lock_guard<std::mutex> lock(textureVariablesLock_);
-    textureVariables_.insert(d);
-    textureVariablesDirty_ = true;
+    }
+    variables_.push_back(Variable(variable_name, key, type));
+    variablesDirty_.store(true, std::memory_order_release);
 }
 
+void CustomShader::addTextureKey(const std::string& variable_name, const std::string& key) {
+    addVariable(variable_name, key, TEXTURE);
+}
 
 void CustomShader::addAttributeFloatKey(const std::string& variable_name,
         const std::string& key) {
-    AttributeVariableBind f =
-            [key] (Mesh& mesh, GLuint location) {
-                mesh.setVertexAttribLocF(location, key);
-            };
-    addAttributeKey(variable_name, key, f);
+    addVariable(variable_name, key, ATTRIBUTE_FLOAT);
 }
 
-
 void CustomShader::addAttributeVec2Key(const std::string& variable_name,
         const std::string& key) {
-    AttributeVariableBind f =
-            [key] (Mesh& mesh, GLuint location) {
-                mesh.setVertexAttribLocV2(location, key);
-            };
-    addAttributeKey(variable_name, key, f);
+    addVariable(variable_name, key, ATTRIBUTE_VEC2);
 }
-void CustomShader::addAttributeKey(const std::string& variable_name,
-        const std::string& key, AttributeVariableBind f) {
-    Descriptor<AttributeVariable> d(variable_name, key);
-
-    d.variableType.f_getLocation = [variable_name] (GLuint programId) {
-        return glGetAttribLocation(programId, variable_name.c_str());
-    };
-    d.variableType.f_bind = f;
-
-    std::lock_guard <std::mutex> lock(attributeVariablesLock_);
-    attributeVariables_.insert(d);
-    attributeVariablesDirty_ = true;
-}
-
 
 void CustomShader::addAttributeVec3Key(const std::string& variable_name,
         const std::string& key) {
-    AttributeVariableBind f =
-            [key] (Mesh& mesh, GLuint location) {
-                mesh.setVertexAttribLocV3(location, key);
-            };
-    addAttributeKey(variable_name, key, f);
+    addVariable(variable_name, key, ATTRIBUTE_VEC3);
 }
 
-
 void CustomShader::addAttributeVec4Key(const std::string& variable_name,
         const std::string& key) {
-    AttributeVariableBind f =
-            [key] (Mesh& mesh, GLuint location) {
-                mesh.setVertexAttribLocV4(location, key);
-            };
-    addAttributeKey(variable_name, key, f);
+    addVariable(variable_name, key, ATTRIBUTE_VEC4);
 }
-void CustomShader::addUniformKey(const std::string& variable_name,
-        const std::string& key, UniformVariableBind f) {
-    LOGV("CustomShader::uniform:add variable: %s key: %s", variable_name.c_str(), key.c_str());
-    Descriptor<UniformVariable> d(variable_name, key);
-
-    d.variableType.f_getLocation = [variable_name] (GLuint programId) {
-        return glGetUniformLocation(programId, variable_name.c_str());
-    };
-    d.variableType.f_bind = f;
-
-    std::lock_guard <std::mutex> lock(uniformVariablesLock_);
-    uniformVariables_.insert(d);
-    uniformVariablesDirty_ = true;
-}
-
 
 void CustomShader::addUniformFloatKey(const std::string& variable_name,
         const std::string& key) {
-    UniformVariableBind f =
-            [key] (Material& material, GLuint location) {
-                glUniform1f(location, material.getFloat(key));
-            };
-    addUniformKey(variable_name, key, f);
+    addVariable(variable_name, key, UNIFORM_FLOAT);
 }
 
-
 void CustomShader::addUniformVec2Key(const std::string& variable_name,
         const std::string& key) {
-    UniformVariableBind f =
-            [key] (Material& material, GLuint location) {
-                glm::vec2 v = material.getVec2(key);
-                glUniform2f(location, v.x, v.y);
-            };
-    addUniformKey(variable_name, key, f);
+    addVariable(variable_name, key, UNIFORM_VEC2);
 }
 
-
 void CustomShader::addUniformVec3Key(const std::string& variable_name,
         const std::string& key) {
-    UniformVariableBind f =
-            [key] (Material& material, GLuint location) {
-                glm::vec3 v = material.getVec3(key);
-                glUniform3f(location, v.x, v.y, v.z);
-            };
-    addUniformKey(variable_name, key, f);
+    addVariable(variable_name, key, UNIFORM_VEC3);
 }
 
-
 void CustomShader::addUniformVec4Key(const std::string& variable_name,
         const std::string& key) {
-    UniformVariableBind f =
-            [key] (Material& material, GLuint location) {
-                glm::vec4 v = material.getVec4(key);
-                glUniform4f(location, v.x, v.y, v.z, v.w);
-            };
-    addUniformKey(variable_name, key, f);
+    addVariable(variable_name, key, UNIFORM_VEC4);
 }
 
 void CustomShader::addUniformMat4Key(const std::string& variable_name,
         const std::string& key) {
-    UniformVariableBind f =
-            [key] (Material& material, GLuint location) {
-                glm::mat4 m = material.getMat4(key);
-                glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(m));
-            };
-    addUniformKey(variable_name, key, f);
+    addVariable(variable_name, key, UNIFORM_MAT4);
 }
 
+/*
+ * Keys the material does not have are skipped: the keys defined for this
+ * shader might not have been used by the material yet.
+ */
+void CustomShader::bindUniform(const Binding& binding, const Material& material) {
+    switch (binding.type) {
+    case UNIFORM_FLOAT: {
+        const float* v = material.getFloatNoError(binding.slot);
+        if (nullptr != v) {
+            glUniform1f(binding.location, *v);
+        }
+        break;
+    }
+    case UNIFORM_VEC2: {
+        const glm::vec2* v = material.getVec2NoError(binding.slot);
+        if (nullptr != v) {
+            glUniform2f(binding.location, v->x, v->y);
+        }
+        break;
+    }
+    case UNIFORM_VEC3: {
+        const glm::vec3* v = material.getVec3NoError(binding.slot);
+        if (nullptr != v) {
+            glUniform3f(binding.location, v->x, v->y, v->z);
+        }
+        break;
+    }
+    case UNIFORM_VEC4: {
+        const glm::vec4* v = material.getVec4NoError(binding.slot);
+        if (nullptr != v) {
+            glUniform4f(binding.location, v->x, v->y, v->z, v->w);
+        }
+        break;
+    }
+    case UNIFORM_MAT4: {
+        const glm::mat4* m = material.getMat4NoError(binding.slot);
+        if (nullptr != m) {
+            glUniformMatrix4fv(binding.location, 1, GL_FALSE, glm::value_ptr(*m));
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void CustomShader::prewarm() {
+    RenderState rstate = RenderState();
+    rstate.shadow_map = false;
+    initializeOnDemand(&rstate);
+}
 
 void CustomShader::render(RenderState* rstate, RenderData* render_data, Material* material) {
+    renderProgram(rstate, render_data, material, false);
+}
+
+/*
+ * Shaders opt in to instancing by declaring "in mat4 a_instance_matrix"
+ * and applying it after u_model; u_model, u_mv and u_mvp then leave out
+ * the model matrix of the instance.
+ */
+bool CustomShader::renderInstanced(RenderState* rstate, RenderData* render_data, Material* material) {
+    initializeOnDemand(rstate);
+    if (a_instance_matrix_ < 0) {
+        return false;
+    }
+    renderProgram(rstate, render_data, material, true);
+    return true;
+}
+
+void CustomShader::renderProgram(RenderState* rstate, RenderData* render_data, Material* material,
+        bool instanced) {
 	//LOGE(" start of render %s", render_data->owner_object()->name().c_str());
 	initializeOnDemand(rstate);
-    {
-        std::lock_guard<std::mutex> lock(textureVariablesLock_);
-        for (auto it = textureVariables_.begin(); it != textureVariables_.end(); ++it) {
-            Texture* texture = material->getTextureNoError(it->key);
-            if ((texture == NULL) || !texture->isReady()) {
-                return;
-            }
+    textures_.clear();
+    for (auto it = bindings_.textures.begin(); it != bindings_.textures.end(); ++it) {
+        Texture* texture = material->getTextureNoError(it->key);
+        if ((texture == NULL) || !texture->isReady()) {
+            return;
         }
+        textures_.push_back(texture);
     }
    // LOGE("rendering %s with program %d", render_data->owner_object()->name().c_str(), program_->id());
 
     Mesh* mesh = render_data->mesh();
-    glUseProgram(program_->id());
+    GLStateCache::getInstance()->useProgram(program_->id());
+    if (!instanced && a_instance_matrix_ >= 0) {
+        // a single draw sees the identity as its instance matrix
+        for (int i = 0; i < 4; ++i) {
+            glVertexAttrib4f(a_instance_matrix_ + i, i == 0, i == 1, i == 2, i == 3);
+        }
+    }
     /*
      * Update the bone matrices
      */
-    int a_bone_indices = glGetAttribLocation(program_->id(), "a_bone_indices");
-    int a_bone_weights = glGetAttribLocation(program_->id(), "a_bone_weights");
-    int u_bone_matrices = glGetUniformLocation(program_->id(), "u_bone_matrix[0]");
+    int a_bone_indices = bindings_.a_bone_indices;
+    int a_bone_weights = bindings_.a_bone_weights;
+    int u_bone_matrices = bindings_.u_bone_matrices;
     if ((a_bone_indices >= 0) ||
         (a_bone_weights >= 0) ||
         (u_bone_matrices >= 0)) {
@@ -289,15 +311,9 @@ void CustomShader::render(RenderState* rstate, RenderData* render_data, Material
     /*
      * Update values of uniform variables
      */
-    {
-        std::lock_guard<std::mutex> lock(uniformVariablesLock_);
-        for (auto it = uniformVariables_.begin(); it != uniformVariables_.end(); ++it) {
-            auto d = *it;
-            try {
-                d.variableType.f_bind(*material, d.location);
-            } catch(const std::string& exc) {
-                //the keys defined for this shader might not have been used by the material yet
-            }
+    for (auto it = bindings_.uniforms.begin(); it != bindings_.uniforms.end(); ++it) {
+        if (it->location >= 0) {
+            bindUniform(*it, *material);
         }
     }
 
@@ -328,20 +344,22 @@ void CustomShader::render(RenderState* rstate, RenderData* render_data, Material
         else
             glUniformMatrix4fv(u_mv_it_, 1, GL_FALSE, glm::value_ptr(rstate->uniforms.u_mv_it));
     }
-    if (u_right_ != 0) {
+    if (u_right_ != -1) {
         glUniform1i(u_right_, rstate->uniforms.u_right ? 1 : 0);
     }
     /*
      * Bind textures
      */
+    GLStateCache* gl_state = GLStateCache::getInstance();
     int texture_index = 0;
-    {
-        std::lock_guard<std::mutex> lock(textureVariablesLock_);
-        for (auto it = textureVariables_.begin(); it != textureVariables_.end(); ++it) {
-            auto d = *it;
-            d.variableType.f_bind(texture_index, *material, d.location);
-            texture_index++;
+    for (size_t i = 0; i < bindings_.textures.size(); ++i) {
+        if (bindings_.textures[i].location < 0) {
+            continue;
         }
+        gl_state->activeTexture(GL_TEXTURE0 + texture_index);
+        textures_[i]->markUsed();
+        gl_state->bindTexture(textures_[i]->getTarget(), textures_[i]->getId());
+        glUniform1i(bindings_.textures[i].location, texture_index++);
     }
     /*
      * Update the uniforms for the lights
@@ -359,7 +377,7 @@ void CustomShader::render(RenderState* rstate, RenderData* render_data, Material
          }
     }
     if (castShadow){
-    	Light::bindShadowMap(program_->id(), texture_index);
+    	Light::bindShadowMap(bindings_.u_shadow_maps, texture_index);
     }
     checkGlError("CustomShader::render");
 }
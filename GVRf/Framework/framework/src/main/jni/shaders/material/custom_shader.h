@@ -21,8 +21,7 @@
 #ifndef CUSTOM_SHADER_H_
 #define CUSTOM_SHADER_H_
 
-#include <map>
-#include <set>
+#include <atomic>
 #include <memory>
 #include <string>
 #include <mutex>
@@ -38,10 +37,7 @@
 
 namespace gvr {
 
-struct ShaderUniformsPerObject;
-
-typedef std::function<void(Mesh&, GLuint)> AttributeVariableBind;
-typedef std::function<void(Material&, GLuint)> UniformVariableBind;
+class Texture;
 
 class CustomShader: public ShaderBase {
 public:
@@ -61,6 +57,9 @@ public:
     void addUniformVec4Key(const std::string& variable_name, const std::string& key);
     void addUniformMat4Key(const std::string& variable_name, const std::string& key);
     virtual void render(RenderState* rstate, RenderData* render_data, Material* material);
+    virtual bool renderInstanced(RenderState* rstate, RenderData* render_data, Material* material);
+    // links the program and resolves the bindings ahead of the first draw
+    void prewarm();
     static int getGLTexture(int n);
     GLuint getProgramId();
 private:
@@ -69,62 +68,79 @@ private:
     CustomShader& operator=(const CustomShader& custom_shader);
     CustomShader& operator=(CustomShader&& custom_shader);
 
-    void addAttributeKey(const std::string& variable_name, const std::string& key, AttributeVariableBind f);
-    void addUniformKey(const std::string& variable_name, const std::string& key, UniformVariableBind f);
-
-    void initializeOnDemand(RenderState* rstate);
+    enum VariableType {
+        TEXTURE,
+        ATTRIBUTE_FLOAT,
+        ATTRIBUTE_VEC2,
+        ATTRIBUTE_VEC3,
+        ATTRIBUTE_VEC4,
+        // in MaterialLayout::ParamType order
+        UNIFORM_FLOAT,
+        UNIFORM_VEC2,
+        UNIFORM_VEC3,
+        UNIFORM_VEC4,
+        UNIFORM_MAT4
+    };
 
-    template <class T> struct Descriptor {
-        Descriptor(const std::string& v, const std::string& k) : variable(v), key(k) {
+    // a shader variable fed from a material or mesh key
+    struct Variable {
+        Variable(const std::string& v, const std::string& k, VariableType t) :
+                variable(v), key(k), type(t) {
         }
 
-        const std::string variable;
-        const std::string key;
-        mutable int location = -1;
-        T variableType;
+        std::string variable;
+        std::string key;
+        VariableType type;
     };
 
-    template <class T> struct DescriptorComparator {
-        bool operator() (const Descriptor<T>& lhs, const Descriptor<T>& rhs) const {
-            const std::string lhsKey = lhs.variable + lhs.key;
-            const std::string rhsKey = rhs.variable + rhs.key;
-            return lhsKey < rhsKey;
-        }
+    // a variable resolved against the linked program and the material layout
+    struct Binding {
+        GLint location;
+        VariableType type;
+        std::string key;
+        int slot;       // uniforms only
     };
 
-    struct TextureVariable {
-        std::function<int(GLuint)> f_getLocation;
-        std::function<void(int&, const Material&, GLuint)> f_bind;
+    /*
+     * Everything a draw needs to know about the program. Built on the GL
+     * thread after linking and again only when keys were added; render()
+     * reads it without locking.
+     */
+    struct BindingTable {
+        std::vector<Binding> textures;
+        std::vector<Binding> attributes;
+        std::vector<Binding> uniforms;
+        GLint a_bone_indices = -1;
+        GLint a_bone_weights = -1;
+        GLint u_bone_matrices = -1;
+        GLint u_shadow_maps = -1;
     };
 
-    struct AttributeVariable {
-        std::function<int(GLuint)> f_getLocation;
-        AttributeVariableBind f_bind;
-    };
+    void addVariable(const std::string& variable_name, const std::string& key, VariableType type);
 
-    struct UniformVariable {
-        std::function<int(GLuint)> f_getLocation;
-        UniformVariableBind f_bind;
-    };
+    void initializeOnDemand(RenderState* rstate);
+    void buildBindings();
+    void bindUniform(const Binding& binding, const Material& material);
+    void renderProgram(RenderState* rstate, RenderData* render_data, Material* material,
+            bool instanced);
 
 private:
-    GLuint u_mvp_;
-    GLuint u_mv_;
-    GLuint u_view_;
-    GLuint u_mv_it_;
-    GLuint u_right_;
-    GLuint u_model_;
-    bool textureVariablesDirty_ = false;
-    std::mutex textureVariablesLock_;
-    std::set<Descriptor<TextureVariable>, DescriptorComparator<TextureVariable>> textureVariables_;
-
-    bool attributeVariablesDirty_ = false;
-    std::mutex attributeVariablesLock_;
-    std::set<Descriptor<AttributeVariable>, DescriptorComparator<AttributeVariable>> attributeVariables_;
-
-    bool uniformVariablesDirty_ = false;
-    std::mutex uniformVariablesLock_;
-    std::set<Descriptor<UniformVariable>, DescriptorComparator<UniformVariable>> uniformVariables_;
+    GLint u_mvp_;
+    GLint u_mv_;
+    GLint u_view_;
+    GLint u_mv_it_;
+    GLint u_right_;
+    GLint u_model_;
+    GLint a_instance_matrix_;
+
+    // the add*Key calls come from the application threads
+    std::mutex variablesLock_;
+    std::vector<Variable> variables_;
+    std::atomic<bool> variablesDirty_;
+
+    // GL thread only
+    BindingTable bindings_;
+    std::vector<Texture*> textures_;
 
     std::string vertexShader_;
     std::string fragmentShader_;
@@ -25,6 +25,7 @@
 #include "objects/components/render_data.h"
 #include "util/gvr_gl.h"
 #include "engine/renderer/renderer.h"
+#include "gl/gl_state_cache.h"
 
 namespace gvr {
 static const char VERTEX_SHADER[] = "attribute vec4 a_position;\n"
@@ -56,7 +57,7 @@ void ErrorShader::render(RenderState* rstate, RenderData* render_data, Material*
     float b = 0.0f;
     float a = 1.0f;
 
-    glUseProgram(program_->id());
+    GLStateCache::getInstance()->useProgram(program_->id());
     glUniformMatrix4fv(u_mvp_, 1, GL_FALSE, glm::value_ptr(rstate->uniforms.u_mvp));
     glUniform4f(u_color_, r, g, b, a);
     checkGlError("ErrorShader::render");
@@ -14,6 +14,7 @@
 #include "util/gvr_gl.h"
 #include "util/gvr_log.h"
 #include "engine/renderer/renderer.h"
+#include "gl/gl_state_cache.h"
 
 static GVRF_ExternalRenderer externalRenderer = NULL;
 
@@ -66,7 +67,7 @@ void ExternalRendererShader::render(RenderState* rstate, RenderData* render_data
     //state invariants for surface flinger
     //Oculus leaves buffers bound before calling us; SurfaceFlinger is ES 2.0
     //so the following two lines ensure that SF doesn't end up using incorrect
-    //buffers
+    //buffers; they are set directly, the cache may not know what Oculus left
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
@@ -79,7 +80,7 @@ void ExternalRendererShader::render(RenderState* rstate, RenderData* render_data
                          scratchBuffer, 6,
                          glm::value_ptr(rstate->uniforms.u_mvp), 16,
                          glm::value_ptr(*mesh->getVec2Vector("a_texcoord").data()), mesh->getVec2Vector("a_texcoord").size() * 2,
-                         material->getFloat("opacity"));
+                         material->getFloat(Material::opacitySlot()));
     } else {
         // Capture texture in RenderTexture
         capturer->beginCapture();
@@ -106,6 +107,8 @@ void ExternalRendererShader::render(RenderState* rstate, RenderData* render_data
         // Callback
         capturer->callback(TCCB_NEW_CAPTURE, 0);
     }
+    // the external renderer changes GL state behind the cache
+    GLStateCache::getInstance()->invalidate();
 
     checkGlError("ExternalRendererShader::render");
 }
@@ -26,6 +26,7 @@
 #include "objects/textures/texture.h"
 #include "util/gvr_gl.h"
 #include "engine/renderer/renderer.h"
+#include "gl/gl_state_cache.h"
 
 namespace gvr {
 static const char VERTEX_SHADER[] = "attribute vec4 a_position;\n"
@@ -76,19 +77,23 @@ void LightMapShader::render(RenderState* rstate,
 
     Texture* texture = material->getTexture("main_texture");
     Texture* lightmap_texture = material->getTexture("lightmap_texture");
-    glm::vec2 lightmap_offset = material->getVec2("lightmap_offset");
-    glm::vec2 lightmap_scale = material->getVec2("lightmap_scale");
+    static const int lightmap_offset_slot = Material::declare("lightmap_offset", MaterialLayout::VEC2);
+    static const int lightmap_scale_slot = Material::declare("lightmap_scale", MaterialLayout::VEC2);
+    glm::vec2 lightmap_offset = material->getVec2(lightmap_offset_slot);
+    glm::vec2 lightmap_scale = material->getVec2(lightmap_scale_slot);
 
-    glUseProgram(program_->id());
+    GLStateCache::getInstance()->useProgram(program_->id());
 
     glUniformMatrix4fv(u_mvp_, 1, GL_FALSE, glm::value_ptr(rstate->uniforms.u_mvp));
 
-    glActiveTexture (GL_TEXTURE0);
-    glBindTexture(texture->getTarget(), texture->getId());
+    GLStateCache::getInstance()->activeTexture(GL_TEXTURE0);
+    texture->markUsed();
+    GLStateCache::getInstance()->bindTexture(texture->getTarget(), texture->getId());
     glUniform1i(u_texture_, 0);
 
-    glActiveTexture (GL_TEXTURE1);
-    glBindTexture(lightmap_texture->getTarget(), lightmap_texture->getId());
+    GLStateCache::getInstance()->activeTexture(GL_TEXTURE1);
+    lightmap_texture->markUsed();
+    GLStateCache::getInstance()->bindTexture(lightmap_texture->getTarget(), lightmap_texture->getId());
     glUniform1i(u_lightmap_texture_, 1);
 
     glUniform2f(u_lightmap_offset_, lightmap_offset.x, lightmap_offset.y);
@@ -25,6 +25,7 @@
 #include "objects/components/render_data.h"
 #include "util/gvr_gl.h"
 #include "engine/renderer/renderer.h"
+#include "gl/gl_state_cache.h"
 
 static const char USE_MULTIVIEW[] = "#define MULTIVIEW\n";
 static const char NOT_USE_MULTIVIEW[] = "#undef MULTIVIEW\n";
@@ -143,23 +144,24 @@ OESShader::~OESShader() {
 
 void OESShader::render(RenderState* rstate, RenderData* render_data, Material* material) {
     Texture* texture = material->getTexture("main_texture");
-    glm::vec3 color = material->getVec3("color");
-    float opacity = material->getFloat("opacity");
+    glm::vec3 color = material->getVec3(Material::colorSlot());
+    float opacity = material->getFloat(Material::opacitySlot());
 
     if (texture->getTarget() != GL_TEXTURE_EXTERNAL_OES) {
         std::string error = "OESShader::render : texture with wrong target";
         throw error;
     }
 
-    glUseProgram(program_->id());
+    GLStateCache::getInstance()->useProgram(program_->id());
     if (use_multiview) {
         glUniformMatrix4fv(u_mvp_, 2, GL_FALSE, glm::value_ptr(rstate->uniforms.u_mvp_[0]));
     } else {
         glUniformMatrix4fv(u_mvp_, 1, GL_FALSE, glm::value_ptr(rstate->uniforms.u_mvp));
     }
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(texture->getTarget(), texture->getId());
+    GLStateCache::getInstance()->activeTexture(GL_TEXTURE0);
+    texture->markUsed();
+    GLStateCache::getInstance()->bindTexture(texture->getTarget(), texture->getId());
     glUniform1i(u_texture_, 0);
     glUniform3f(u_color_, color.r, color.g, color.b);
     glUniform1f(u_opacity_, opacity);
@@ -39,6 +39,14 @@ public:
     ShaderBase() : program_(nullptr) {
     };
     virtual void render(RenderState* rstate, RenderData* render_data, Material* material)=0;
+    /*
+     * Sets up the program for an instanced draw, with per instance model
+     * matrices in the mat4 attribute a_instance_matrix. Returns false if
+     * the shader can not draw instanced.
+     */
+    virtual bool renderInstanced(RenderState* rstate, RenderData* render_data, Material* material) {
+        return false;
+    }
     GLuint getProgramId()
     {
         if (program_)
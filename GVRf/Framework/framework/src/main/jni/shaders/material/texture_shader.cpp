@@ -28,12 +28,17 @@
 #include "util/gvr_gl.h"
 #include "util/gvr_log.h"
 #include "engine/renderer/renderer.h"
+#include "engine/renderer/batch.h"
+#include "engine/renderer/uniform_blocks.h"
+#include "gl/gl_state_cache.h"
 #define LIGHT           1
 #define NO_LIGHT        2
 #define MULTIVIEW       4
 #define NO_MULTIVIEW    8
 #define BATCHING        16
 #define NO_BATCHING     32
+#define INSTANCING      64
+#define NO_INSTANCING   128
 
 namespace gvr {
 static const char USE_MULTIVIEW[] = "#define MULTIVIEW\n";
@@ -43,25 +48,22 @@ static const char USE_LIGHT[] = "#define USE_LIGHT\n";
 static const char NOT_USE_LIGHT[] = "#undef USE_LIGHT\n";
 static const char USE_BATCHING[] = "#define USE_BATCHING\n";
 static const char NOT_USE_BATCHING[] ="#undef USE_BATCHING\n";
+static const char USE_INSTANCING[] = "#define USE_INSTANCING\n";
+static const char NOT_USE_INSTANCING[] ="#undef USE_INSTANCING\n";
 
-static const char VERTEX_SHADER[] =
+static const char VERTEX_EXTENSIONS[] =
         "#ifdef MULTIVIEW\n"
         "#extension GL_OVR_multiview2 : enable\n"
         "layout(num_views = 2) in;\n"
-        "#endif\n"
+        "#endif\n";
 
-        "uniform mat4 u_proj;\n"
+// follows the FrameUniforms and ObjectUniforms blocks
+static const char VERTEX_SHADER[] =
         "in vec3 a_position;\n"
         "in vec2 a_texcoord;\n"
 
-        "#ifdef MULTIVIEW\n"
-        "uniform mat4 u_view_[2];\n"
-        "#else\n"
-        "uniform mat4 u_view;\n"
-        "#endif\n"
-
-        "#ifndef USE_BATCHING\n"
-        "uniform mat4 u_model;\n"
+        "#ifdef USE_INSTANCING\n"
+        "in mat4 a_instance_matrix;\n"
         "#endif\n"
 
         "out vec2 v_tex_coord;\n"
@@ -75,7 +77,9 @@ static const char VERTEX_SHADER[] =
 
         "#ifdef USE_BATCHING\n"
         "in float a_matrix_index;\n"
-        "uniform vec4 u_matrices[240];\n"
+        "layout(std140) uniform BatchMatrices {\n"
+        "    mat4 u_matrices[256];\n"
+        "};\n"
         "#endif\n"
 
         "void main() {\n"
@@ -83,28 +87,40 @@ static const char VERTEX_SHADER[] =
             "mat4 mv_it;\n"
             "mat4 mvp;\n"
 
+            // batched models are not in the object block
             "#ifdef USE_BATCHING\n"
-            "int index =int(a_matrix_index);\n"
-            "mat4 model_matrix = mat4(u_matrices[index*4],u_matrices[index*4+1],u_matrices[index*4+2],u_matrices[index*4+3]);\n"
-            "#else\n"
-            "mat4 model_matrix = u_model;\n"
-            "#endif\n"
-
-            "#ifdef MULTIVIEW\n"
-            "mvp = u_proj * u_view_[gl_ViewID_OVR] * model_matrix; \n"
+                "int index =int(a_matrix_index);\n"
+                "#ifdef MULTIVIEW\n"
+                "mv = u_view_[gl_ViewID_OVR] * u_matrices[index];\n"
+                "#else\n"
+                "mv = u_view * u_matrices[index];\n"
+                "#endif\n"
+                "mvp = u_proj * mv;\n"
+                "#ifdef USE_LIGHT\n"
+                "mv_it = transpose(inverse(mv));\n"
+                "#endif\n"
             "#else\n"
-            "mvp = u_proj * u_view * model_matrix; \n"
-            "#endif\n"
-
-            // use light
-            "#ifdef USE_LIGHT\n"
                 "#ifdef MULTIVIEW\n"
-                "mv = u_view_[gl_ViewID_OVR] * model_matrix; \n"
+                "mv = u_mv_[gl_ViewID_OVR];\n"
+                "mvp = u_mvp_[gl_ViewID_OVR];\n"
+                "mv_it = u_mv_it_[gl_ViewID_OVR];\n"
                 "#else\n"
-                "mv = u_view * model_matrix;\n"
+                "mv = u_mv;\n"
+                "mvp = u_mvp;\n"
+                "mv_it = u_mv_it;\n"
                 "#endif\n"
-
+                // the object block holds the identity model
+                "#ifdef USE_INSTANCING\n"
+                "mv = mv * a_instance_matrix;\n"
+                "mvp = mvp * a_instance_matrix;\n"
+                "#ifdef USE_LIGHT\n"
                 "mv_it = transpose(inverse(mv));\n"
+                "#endif\n"
+                "#endif\n"
+            "#endif\n"
+
+            // use light
+            "#ifdef USE_LIGHT\n"
                 "vec4 v_viewspace_position_vec4 = mv * vec4(a_position,1.0);\n"
                 "vec3 v_viewspace_position = v_viewspace_position_vec4.xyz / v_viewspace_position_vec4.w;\n"
                 "v_viewspace_light_direction = u_light_pos - v_viewspace_position;\n"
@@ -176,7 +192,7 @@ void TextureShader::initUniforms(int feature_set, GLuint program_id,uniforms& lo
     locations.u_texture = glGetUniformLocation(program_id, "u_texture");
     locations.u_color = glGetUniformLocation(program_id, "u_color");
     locations.u_opacity = glGetUniformLocation(program_id, "u_opacity");
-    locations.u_proj = glGetUniformLocation(program_id, "u_proj");
+    UniformBlocks::bindProgram(program_id);
 
     if(feature_set & LIGHT){
         locations.u_light_pos = glGetUniformLocation(program_id, "u_light_pos");
@@ -195,78 +211,58 @@ void TextureShader::initUniforms(int feature_set, GLuint program_id,uniforms& lo
         locations.u_light_specular_intensity_ = glGetUniformLocation(program_id,
                 "lightSpecularIntensity");
     }
-    if(feature_set & MULTIVIEW)
-        locations.u_view = glGetUniformLocation(program_id, "u_view_[0]");
-    else
-        locations.u_view = glGetUniformLocation(program_id, "u_view");
-
-    if(feature_set & BATCHING)
-        locations.u_model = glGetUniformLocation(program_id, "u_matrices[0]");
-    else
-        locations.u_model = glGetUniformLocation(program_id, "u_model");
-}
-
-void TextureShader::programInit(RenderState* rstate, RenderData* render_data, Material* material,
-        const std::vector<glm::mat4>& model_matrix,int drawcount, bool batching){
-
-    if(!material->isMainTextureReady())
-        return;
-
-    Texture* texture = material->getTexture("main_texture");
-    glm::vec3 color = material->getVec3("color");
-    float opacity = material->getFloat("opacity");
-    glm::vec4 material_ambient_color = material->getVec4("ambient_color");
-    glm::vec4 material_diffuse_color = material->getVec4("diffuse_color");
-    glm::vec4 material_specular_color = material->getVec4("specular_color");
-    float material_specular_exponent = material->getFloat("specular_exponent");
-
-    if (texture->getTarget() != GL_TEXTURE_2D) {
-        std::string error = "TextureShader::render : texture with wrong target.";
-        throw error;
-    }
-
-    bool use_light = false;
-    Light* light;
-    if (render_data->light_enabled()) {
-        light = render_data->light();
-        if (light->enabled()) {
-            use_light = true;
-        }
+    if(feature_set & BATCHING) {
+        GLuint block_index = glGetUniformBlockIndex(program_id, "BatchMatrices");
+        glUniformBlockBinding(program_id, block_index, Batch::MATRIX_BINDING);
     }
+}
 
-    bool batching_enabled = batching;
+/*
+ * The program of a feature set, built the first time it is asked for.
+ */
+GLProgram* TextureShader::getProgram(bool use_light, bool batching_enabled, bool instanced,
+        uniforms& uniform_locations) {
     int feature_set =0;
     feature_set |= (use_light) ? LIGHT : NO_LIGHT;
     feature_set |= (use_multiview) ? MULTIVIEW : NO_MULTIVIEW;
     feature_set |= (batching_enabled) ? BATCHING : NO_BATCHING;
+    feature_set |= (instanced) ? INSTANCING : NO_INSTANCING;
 
-    bool properties [] = {use_light, use_multiview, batching_enabled};
-    const char* feature_strings[2][3]={{NOT_USE_LIGHT, NOT_USE_MULTIVIEW, NOT_USE_BATCHING},
-            {USE_LIGHT, USE_MULTIVIEW, USE_BATCHING}};
+    bool properties [] = {use_light, use_multiview, batching_enabled, instanced};
+    const char* feature_strings[2][4]={{NOT_USE_LIGHT, NOT_USE_MULTIVIEW, NOT_USE_BATCHING, NOT_USE_INSTANCING},
+            {USE_LIGHT, USE_MULTIVIEW, USE_BATCHING, USE_INSTANCING}};
 
-    int feature_string_lengths[2][3]={{strlen(NOT_USE_LIGHT), strlen(NOT_USE_MULTIVIEW), strlen(NOT_USE_BATCHING)},
-            {strlen(USE_LIGHT),strlen(USE_MULTIVIEW), strlen(USE_BATCHING)}};
+    int feature_string_lengths[2][4]={{strlen(NOT_USE_LIGHT), strlen(NOT_USE_MULTIVIEW), strlen(NOT_USE_BATCHING), strlen(NOT_USE_INSTANCING)},
+            {strlen(USE_LIGHT),strlen(USE_MULTIVIEW), strlen(USE_BATCHING), strlen(USE_INSTANCING)}};
 
-    uniforms uniform_locations;
     GLProgram* prgram = nullptr;
     if(program_object_map_.find(feature_set)==program_object_map_.end()){
 
-        const char* vertex_shader_strings[5];
-        GLint vertex_shader_string_lengths[5];
+        const char* vertex_shader_strings[9];
+        GLint vertex_shader_string_lengths[9];
         vertex_shader_strings[0]=version;
-        vertex_shader_strings[4]=VERTEX_SHADER;
+        vertex_shader_strings[5]=VERTEX_EXTENSIONS;
+        vertex_shader_strings[6]=UniformBlocks::FRAME_BLOCK;
+        vertex_shader_strings[7]=UniformBlocks::OBJECT_BLOCK;
+        vertex_shader_strings[8]=VERTEX_SHADER;
         vertex_shader_string_lengths[0]= (GLint) strlen(version);
-        vertex_shader_string_lengths[4]= (GLint) strlen(VERTEX_SHADER);
+        for(int i=5;i<9;i++)
+            vertex_shader_string_lengths[i]= (GLint) strlen(vertex_shader_strings[i]);
 
-        const char* frag_shader_strings[5];
-        GLint frag_shader_string_lengths[5];
+        // the fragment shader needs no blocks, same count with empty strings
+        const char* frag_shader_strings[9];
+        GLint frag_shader_string_lengths[9];
         frag_shader_strings[0]=version;
-        frag_shader_strings[4]=FRAGMENT_SHADER;
+        frag_shader_strings[8]=FRAGMENT_SHADER;
         frag_shader_string_lengths [0] = vertex_shader_string_lengths[0];
-        frag_shader_string_lengths [4] = (GLint) strlen(FRAGMENT_SHADER);
+        frag_shader_string_lengths [8] = (GLint) strlen(FRAGMENT_SHADER);
+        for(int i=5;i<8;i++){
+            frag_shader_strings[i]="";
+            frag_shader_string_lengths[i]=0;
+        }
 
         int index = 1;
-        for(int i=0;i<3; i++){
+        for(int i=0;i<4; i++){
             vertex_shader_strings[index]= feature_strings[properties[i]][i];
             vertex_shader_string_lengths [index]= feature_string_lengths[properties[i]][i];
             frag_shader_strings[index]=vertex_shader_strings[index];
@@ -275,7 +271,7 @@ void TextureShader::programInit(RenderState* rstate, RenderData* render_data, Ma
         }
         prgram = new GLProgram(vertex_shader_strings,
                 vertex_shader_string_lengths, frag_shader_strings,
-                frag_shader_string_lengths, 5);
+                frag_shader_string_lengths, 9);
         program_object_map_[feature_set] = prgram;
 
         if(use_multiview)
@@ -288,21 +284,63 @@ void TextureShader::programInit(RenderState* rstate, RenderData* render_data, Ma
         uniform_locations = uniform_loc[feature_set];
     }
 
+    return prgram;
+}
+
+void TextureShader::prewarm(bool use_light, bool batching_enabled, bool instanced) {
+    uniforms uniform_locations;
+    getProgram(use_light, batching_enabled, instanced, uniform_locations);
+}
+
+void TextureShader::programInit(RenderState* rstate, RenderData* render_data, Material* material,
+        Batch* batch, bool instanced){
+
+    if(!material->isMainTextureReady())
+        return;
+
+    Texture* texture = material->getMainTexture();
+    glm::vec3 color = material->getVec3(Material::colorSlot());
+    float opacity = material->getFloat(Material::opacitySlot());
+    static const int ambient_color_slot = Material::declare("ambient_color", MaterialLayout::VEC4);
+    static const int diffuse_color_slot = Material::declare("diffuse_color", MaterialLayout::VEC4);
+    static const int specular_color_slot = Material::declare("specular_color", MaterialLayout::VEC4);
+    static const int specular_exponent_slot =
+            Material::declare("specular_exponent", MaterialLayout::FLOAT);
+    glm::vec4 material_ambient_color = material->getVec4(ambient_color_slot);
+    glm::vec4 material_diffuse_color = material->getVec4(diffuse_color_slot);
+    glm::vec4 material_specular_color = material->getVec4(specular_color_slot);
+    float material_specular_exponent = material->getFloat(specular_exponent_slot);
+
+    if (texture->getTarget() != GL_TEXTURE_2D) {
+        std::string error = "TextureShader::render : texture with wrong target.";
+        throw error;
+    }
+
+    bool use_light = false;
+    Light* light;
+    if (render_data->light_enabled()) {
+        light = render_data->light();
+        if (light->enabled()) {
+            use_light = true;
+        }
+    }
+
+    bool batching_enabled = (nullptr != batch);
+    uniforms uniform_locations;
+    GLProgram* prgram = getProgram(use_light, batching_enabled, instanced, uniform_locations);
+
     program_ = prgram;
     GLuint programId = prgram->id();
     //render_data->mesh()->generateVAO(programId);
-    GL(glUseProgram(programId));
-    GL(glActiveTexture (GL_TEXTURE0));
-    GL(glBindTexture(texture->getTarget(), texture->getId()));
+    GL(GLStateCache::getInstance()->useProgram(programId));
+    GL(GLStateCache::getInstance()->activeTexture(GL_TEXTURE0));
+    texture->markUsed();
+    GL(GLStateCache::getInstance()->bindTexture(texture->getTarget(), texture->getId()));
 
     glUniform1i(uniform_locations.u_texture, 0);
     glUniform3f(uniform_locations.u_color, color.r, color.g, color.b);
     glUniform1f(uniform_locations.u_opacity, opacity);
 
-    if(!batching_enabled)
-        glUniformMatrix4fv(uniform_locations.u_model, 1, GL_FALSE, glm::value_ptr(rstate->uniforms.u_model));
-
-    glUniformMatrix4fv(uniform_locations.u_proj, 1, GL_FALSE, glm::value_ptr(rstate->uniforms.u_proj));
     if (use_light) {
         glm::vec3 light_position = light->getVec3("world_position");
         glm::vec4 light_ambient_intensity = light->getVec4("ambient_intensity");
@@ -335,15 +373,9 @@ void TextureShader::programInit(RenderState* rstate, RenderData* render_data, Ma
 
     }
 
-    if(use_multiview)
-        glUniformMatrix4fv(uniform_locations.u_view, 2, GL_FALSE, glm::value_ptr(rstate->uniforms.u_view_[0]));
-    else
-        glUniformMatrix4fv(uniform_locations.u_view, 1, GL_FALSE, glm::value_ptr(rstate->uniforms.u_view));
-
-
-    if(batching){
-        glUniform4fv(uniform_locations.u_model, drawcount*4, &model_matrix[0][0][0]);
-        glBindVertexArray(render_data->mesh()->getVAOId(programId));
+    if(batching_enabled){
+        GLStateCache::getInstance()->bindBufferBase(GL_UNIFORM_BUFFER, Batch::MATRIX_BINDING, batch->matrix_buffer());
+        GLStateCache::getInstance()->bindVertexArray(batch->getVAOId(programId));
     }
 
 
@@ -351,18 +383,20 @@ void TextureShader::programInit(RenderState* rstate, RenderData* render_data, Ma
 void TextureShader::render(RenderState* rstate,
         RenderData* render_data, Material* material) {
 
-   std::vector<glm::mat4> model_matrix;
-   model_matrix.push_back(rstate->uniforms.u_model);
-   programInit(rstate,render_data,material,model_matrix,1,false);
+   programInit(rstate,render_data,material,nullptr,false);
    checkGlError("TextureShader::render");
 }
-void TextureShader::render_batch(const std::vector<glm::mat4>& model_matrix,
-        RenderData* render_data,  RenderState& rstate, unsigned int indexCount, int drawcount)
+bool TextureShader::renderInstanced(RenderState* rstate,
+        RenderData* render_data, Material* material) {
+   programInit(rstate,render_data,material,nullptr,true);
+   checkGlError("TextureShader::renderInstanced");
+   return true;
+}
+void TextureShader::render_batch(Batch* batch, RenderData* render_data, RenderState& rstate)
 {
-    uniforms uniform_locations;
-    programInit(&rstate,render_data,rstate.material_override,model_matrix,drawcount,true);
-    GL(glDrawElements(render_data->draw_mode(), indexCount, GL_UNSIGNED_SHORT, 0));
-    GL(glBindVertexArray(0));
+    programInit(&rstate,render_data,rstate.material_override,batch,false);
+    GL(glDrawElements(render_data->draw_mode(), batch->getIndexCount(), GL_UNSIGNED_INT, 0));
+    GL(GLStateCache::getInstance()->bindVertexArray(0));
     checkGlError(" TextureShader::render_batch");
 }
 }
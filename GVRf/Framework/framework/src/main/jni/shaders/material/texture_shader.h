@@ -25,6 +25,7 @@
 #include <unordered_map>
 namespace gvr {
 class GLProgram;
+class Batch;
 
 class TextureShader: public ShaderBase {
 public:
@@ -32,8 +33,11 @@ public:
     virtual ~TextureShader();
 
     virtual void render(RenderState* rstate, RenderData* render_data, Material* material);
-    void render_batch(const std::vector<glm::mat4>& model_matrix,
-              RenderData* render_data,  RenderState& rstate, unsigned int, int);
+    virtual bool renderInstanced(RenderState* rstate, RenderData* render_data, Material* material);
+    void render_batch(Batch* batch, RenderData* render_data, RenderState& rstate);
+
+    // builds the program of a feature set ahead of its first draw
+    void prewarm(bool use_light, bool batching_enabled, bool instanced);
 
 private:
     TextureShader(const TextureShader& texture_shader);
@@ -45,12 +49,9 @@ private:
 
     std::unordered_map<int, GLProgram*>program_object_map_;
     struct uniforms{
-        GLuint u_model;
         GLuint u_texture;
         GLuint u_color;
         GLuint u_opacity;
-        GLuint u_view;
-        GLuint u_proj;
         GLuint u_light_pos;
         GLuint u_material_ambient_color_;
         GLuint u_material_diffuse_color_;
@@ -63,10 +64,14 @@ private:
     std::unordered_map<int,uniforms> uniform_loc;
 
 
+    GLProgram* getProgram(bool use_light, bool batching_enabled, bool instanced,
+            uniforms& uniform_locations);
+
 public:
     void initUniforms(int, GLuint ,uniforms& );
-    void programInit(RenderState* rstate, RenderData* rdata, Material* material, const std::vector<glm::mat4>& model_matrix
-            ,int drawcount, bool batching);
+    // batch is null when rendering a single render data
+    void programInit(RenderState* rstate, RenderData* rdata, Material* material, Batch* batch,
+            bool instanced);
 };
 
 }
@@ -26,6 +26,7 @@
 #include "objects/textures/texture.h"
 #include "util/gvr_gl.h"
 #include "engine/renderer/renderer.h"
+#include "gl/gl_state_cache.h"
 
 namespace gvr {
 static const char VERTEX_SHADER[] = "attribute vec3 a_position;\n"
@@ -69,8 +70,8 @@ UnlitVerticalStereoShader::~UnlitVerticalStereoShader() {
 void UnlitVerticalStereoShader::render(RenderState* rstate,
         RenderData* render_data, Material* material) {
     Texture* texture = material->getTexture("main_texture");
-    glm::vec3 color = material->getVec3("color");
-    float opacity = material->getFloat("opacity");
+    glm::vec3 color = material->getVec3(Material::colorSlot());
+    float opacity = material->getFloat(Material::opacitySlot());
     bool mono_rendering;
 
     if (texture->getTarget() != GL_TEXTURE_2D) {
@@ -79,17 +80,17 @@ void UnlitVerticalStereoShader::render(RenderState* rstate,
         throw error;
     }
 
-    try {
-        mono_rendering = material->getFloat("mono_rendering") == 1;
-    } catch (std::string& error) {
-        mono_rendering = false;
-    }
+    static const int mono_rendering_slot =
+            Material::declare("mono_rendering", MaterialLayout::FLOAT);
+    const float* mono = material->getFloatNoError(mono_rendering_slot);
+    mono_rendering = (NULL != mono) && (*mono == 1);
 
-   glUseProgram(program_->id());
+   GLStateCache::getInstance()->useProgram(program_->id());
 
     glUniformMatrix4fv(u_mvp_, 1, GL_FALSE, glm::value_ptr(rstate->uniforms.u_mvp));
-    glActiveTexture (GL_TEXTURE0);
-    glBindTexture(texture->getTarget(), texture->getId());
+    GLStateCache::getInstance()->activeTexture(GL_TEXTURE0);
+    texture->markUsed();
+    GLStateCache::getInstance()->bindTexture(texture->getTarget(), texture->getId());
     glUniform1i(u_texture_, 0);
     glUniform3f(u_color_, color.r, color.g, color.b);
     glUniform1f(u_opacity_, opacity);
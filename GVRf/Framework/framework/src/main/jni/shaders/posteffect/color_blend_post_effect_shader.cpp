@@ -24,6 +24,7 @@
 #include "objects/post_effect_data.h"
 #include "objects/textures/render_texture.h"
 #include "util/gvr_gl.h"
+#include "gl/gl_state_cache.h"
 
 namespace gvr {
 static const char VERTEX_SHADER[] = "attribute vec3 a_position;\n"
@@ -77,23 +78,23 @@ void ColorBlendPostEffectShader::render(
     float b = post_effect_data->getFloat("b");
     float factor = post_effect_data->getFloat("factor");
 
-    glUseProgram(program_->id());
+    GLStateCache::getInstance()->useProgram(program_->id());
 
     GLuint tmpID;
 
     if(vaoID_ == 0)
     {
         glGenVertexArrays(1, &vaoID_);
-        glBindVertexArray(vaoID_);
+        GLStateCache::getInstance()->bindVertexArray(vaoID_);
 
         glGenBuffers(1, &tmpID);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, tmpID);
+        GLStateCache::getInstance()->bindBuffer(GL_ELEMENT_ARRAY_BUFFER, tmpID);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned short)*triangles.size(), &triangles[0], GL_STATIC_DRAW);
 
         if (vertices.size())
         {
             glGenBuffers(1, &tmpID);
-            glBindBuffer(GL_ARRAY_BUFFER, tmpID);
+            GLStateCache::getInstance()->bindBuffer(GL_ARRAY_BUFFER, tmpID);
             glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3)*vertices.size(), &vertices[0], GL_STATIC_DRAW);
             glEnableVertexAttribArray(a_position_);
             glVertexAttribPointer(a_position_, 3, GL_FLOAT, 0, 0, 0);
@@ -102,23 +103,23 @@ void ColorBlendPostEffectShader::render(
         if (tex_coords.size())
         {
             glGenBuffers(1, &tmpID);
-            glBindBuffer(GL_ARRAY_BUFFER, tmpID);
+            GLStateCache::getInstance()->bindBuffer(GL_ARRAY_BUFFER, tmpID);
             glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec2)*tex_coords.size(), &tex_coords[0], GL_STATIC_DRAW);
             glEnableVertexAttribArray(a_tex_coord_);
             glVertexAttribPointer(a_tex_coord_, 2, GL_FLOAT, 0, 0, 0);
         }
     }
 
-    glActiveTexture (GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, render_texture->getId());
+    GLStateCache::getInstance()->activeTexture(GL_TEXTURE0);
+    GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, render_texture->getId());
     glUniform1i(u_texture_, 0);
 
     glUniform3f(u_color_, r, g, b);
     glUniform1f(u_factor_, factor);
 
-    glBindVertexArray(vaoID_);
+    GLStateCache::getInstance()->bindVertexArray(vaoID_);
     glDrawElements(GL_TRIANGLES, triangles.size(), GL_UNSIGNED_SHORT, 0);
-    glBindVertexArray(0);
+    GLStateCache::getInstance()->bindVertexArray(0);
 
     checkGlError("ColorBlendPostEffectShader::render");
 }
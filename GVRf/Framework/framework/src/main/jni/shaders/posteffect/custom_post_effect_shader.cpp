@@ -24,6 +24,7 @@
 #include "objects/post_effect_data.h"
 #include "objects/components/render_data.h"
 #include "objects/textures/render_texture.h"
+#include "gl/gl_state_cache.h"
 
 
 namespace gvr {
@@ -104,23 +105,23 @@ void CustomPostEffectShader::render(Camera* camera,
         return;
     }
 
-    glUseProgram(program_->id());
+    GLStateCache::getInstance()->useProgram(program_->id());
 
     if(vaoID_ == 0)
     {
         GLuint tmpID;
 
         glGenVertexArrays(1, &vaoID_);
-        glBindVertexArray(vaoID_);
+        GLStateCache::getInstance()->bindVertexArray(vaoID_);
 
         glGenBuffers(1, &tmpID);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, tmpID);
+        GLStateCache::getInstance()->bindBuffer(GL_ELEMENT_ARRAY_BUFFER, tmpID);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned short)*triangles.size(), &triangles[0], GL_STATIC_DRAW);
 
         if (vertices.size())
         {
             glGenBuffers(1, &tmpID);
-            glBindBuffer(GL_ARRAY_BUFFER, tmpID);
+            GLStateCache::getInstance()->bindBuffer(GL_ARRAY_BUFFER, tmpID);
             glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3)*vertices.size(), &vertices[0], GL_STATIC_DRAW);
             glEnableVertexAttribArray(a_position_);
             glVertexAttribPointer(a_position_, 3, GL_FLOAT, 0, 0, 0);
@@ -129,7 +130,7 @@ void CustomPostEffectShader::render(Camera* camera,
         if (tex_coords.size())
         {
             glGenBuffers(1, &tmpID);
-            glBindBuffer(GL_ARRAY_BUFFER, tmpID);
+            GLStateCache::getInstance()->bindBuffer(GL_ARRAY_BUFFER, tmpID);
             glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec2)*tex_coords.size(), &tex_coords[0], GL_STATIC_DRAW);
             glEnableVertexAttribArray(a_tex_coord_);
             glVertexAttribPointer(a_tex_coord_, 2, GL_FLOAT, 0, 0, 0);
@@ -138,8 +139,8 @@ void CustomPostEffectShader::render(Camera* camera,
 
     int texture_index = 0;
     if (u_texture_ != -1) {
-        glActiveTexture(getGLTexture(texture_index));
-        glBindTexture(GL_TEXTURE_2D, render_texture->getId());
+        GLStateCache::getInstance()->activeTexture(getGLTexture(texture_index));
+        GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, render_texture->getId());
         glUniform1i(u_texture_, texture_index++);
     }
 
@@ -155,12 +156,13 @@ void CustomPostEffectShader::render(Camera* camera,
 
     lock_.lock();
     for (auto it = texture_keys_.begin(); it != texture_keys_.end(); ++it) {
-        glActiveTexture(getGLTexture(texture_index));
+        GLStateCache::getInstance()->activeTexture(getGLTexture(texture_index));
 
         const std::string& variable = it->first.first;
         const std::string& key = it->first.second;
         Texture* texture = post_effect_data->getTexture(key);
-        glBindTexture(texture->getTarget(), texture->getId());
+        texture->markUsed();
+        GLStateCache::getInstance()->bindTexture(texture->getTarget(), texture->getId());
 
         if (0 == it->second) {
             it->second = glGetUniformLocation(program_->id(), variable.c_str());
@@ -227,9 +229,9 @@ void CustomPostEffectShader::render(Camera* camera,
     }
     lock_.unlock();
 
-    glBindVertexArray(vaoID_);
+    GLStateCache::getInstance()->bindVertexArray(vaoID_);
     glDrawElements(GL_TRIANGLES, triangles.size(), GL_UNSIGNED_SHORT, 0);
-    glBindVertexArray(0);
+    GLStateCache::getInstance()->bindVertexArray(0);
 }
 
 int CustomPostEffectShader::getGLTexture(int n) {
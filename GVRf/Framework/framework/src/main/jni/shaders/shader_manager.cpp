@@ -0,0 +1,162 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Manages instances of shaders.
+ ***************************************************************************/
+
+#include "shader_manager.h"
+
+#include "objects/light.h"
+#include "objects/material.h"
+#include "objects/scene.h"
+#include "objects/scene_object.h"
+#include "objects/components/render_data.h"
+
+extern bool do_batching;
+
+namespace gvr {
+
+void ShaderManager::prewarm(Scene* scene) {
+    // gathered now, the scene may be gone by the time the GL thread looks
+    std::vector<PrewarmEntry> entries;
+    collectPrewarm(scene, entries);
+    std::lock_guard < std::mutex > lock(prewarm_lock_);
+    prewarm_pending_.insert(prewarm_pending_.end(), entries.begin(), entries.end());
+}
+
+int ShaderManager::prewarmStep(int budget) {
+    std::vector<PrewarmEntry> entries;
+    {
+        std::lock_guard < std::mutex > lock(prewarm_lock_);
+        entries.swap(prewarm_pending_);
+    }
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        queuePrewarmEntry(*it);
+    }
+
+    for (int i = 0; i < budget && !prewarm_queue_.empty(); ++i) {
+        PrewarmEntry entry = prewarm_queue_.front();
+        prewarm_queue_.pop_front();
+        try {
+            prewarmShader(entry);
+        } catch (const std::string& error) {
+            LOGE("ShaderManager::prewarm: shader %d: %s", entry.shader_type, error.c_str());
+        }
+    }
+    return prewarm_queue_.size();
+}
+
+/*
+ * One entry per shader and feature set; the feature sets are the ones
+ * TextureShader picks from the render data, the other shaders have one
+ * program each. Batched render data sharing a mesh may be drawn
+ * instanced instead, so they also get the instanced TextureShader.
+ */
+void ShaderManager::collectPrewarm(Scene* scene, std::vector<PrewarmEntry>& entries) {
+    std::vector<SceneObject*> scene_objects = scene->getWholeSceneObjects();
+    for (auto it = scene_objects.begin(); it != scene_objects.end(); ++it) {
+        RenderData* render_data = (*it)->render_data();
+        if (nullptr == render_data) {
+            continue;
+        }
+        Light* light = render_data->light();
+        bool use_light = render_data->light_enabled() && nullptr != light && light->enabled();
+        bool batching = do_batching && render_data->batching();
+        for (int pass = 0; pass < render_data->pass_count(); ++pass) {
+            Material* material = render_data->material(pass);
+            if (nullptr == material) {
+                continue;
+            }
+            PrewarmEntry entry;
+            entry.shader_type = material->shader_type();
+            entry.use_light = false;
+            entry.batching = false;
+            entry.instanced = false;
+            if (Material::TEXTURE_SHADER == entry.shader_type) {
+                entry.use_light = use_light;
+                entry.batching = batching;
+            }
+            entries.push_back(entry);
+            if (entry.batching) {
+                entry.batching = false;
+                entry.instanced = true;
+                entries.push_back(entry);
+            }
+        }
+    }
+}
+
+void ShaderManager::queuePrewarmEntry(const PrewarmEntry& entry) {
+    // a shader still being generated has no program to build yet
+    if (entry.shader_type < 0) {
+        return;
+    }
+    int id = (entry.shader_type << 3) | (entry.use_light << 2) | (entry.batching << 1)
+            | entry.instanced;
+    if (prewarm_seen_.insert(id).second) {
+        prewarm_queue_.push_back(entry);
+    }
+}
+
+void ShaderManager::prewarmShader(const PrewarmEntry& entry) {
+    switch (entry.shader_type) {
+    case Material::UNLIT_HORIZONTAL_STEREO_SHADER:
+        getUnlitHorizontalStereoShader();
+        break;
+    case Material::UNLIT_VERTICAL_STEREO_SHADER:
+        getUnlitVerticalStereoShader();
+        break;
+    case Material::OES_SHADER:
+        getOESShader();
+        break;
+    case Material::OES_HORIZONTAL_STEREO_SHADER:
+        getOESHorizontalStereoShader();
+        break;
+    case Material::OES_VERTICAL_STEREO_SHADER:
+        getOESVerticalStereoShader();
+        break;
+    case Material::CUBEMAP_SHADER:
+        getCubemapShader();
+        break;
+    case Material::CUBEMAP_REFLECTION_SHADER:
+        getCubemapReflectionShader();
+        break;
+    case Material::TEXTURE_SHADER:
+        getTextureShader()->prewarm(entry.use_light, entry.batching, entry.instanced);
+        break;
+    case Material::EXTERNAL_RENDERER_SHADER:
+        getExternalRendererShader();
+        break;
+    case Material::ASSIMP_SHADER:
+        getAssimpShader();
+        break;
+    case Material::LIGHTMAP_SHADER:
+        getLightMapShader();
+        break;
+    case Material::UNLIT_FBO_SHADER:
+        getUnlitFboShader();
+        break;
+    default: {
+        auto it = custom_shaders_.find(entry.shader_type);
+        if (it != custom_shaders_.end()) {
+            it->second->prewarm();
+        }
+        break;
+    }
+    }
+}
+
+}
@@ -20,6 +20,11 @@
 #ifndef SHADER_MANAGER_H_
 #define SHADER_MANAGER_H_
 
+#include <deque>
+#include <mutex>
+#include <set>
+#include <vector>
+
 #include "objects/hybrid_object.h"
 #include "shaders/material/bounding_box_shader.h"
 #include "shaders/material/custom_shader.h"
@@ -41,6 +46,8 @@
 #include "util/gvr_log.h"
 
 namespace gvr {
+class Scene;
+
 class ShaderManager: public HybridObject {
 public:
     ShaderManager() :
@@ -161,6 +168,17 @@ public:
         custom_shaders_[id] = custom_shader;
         return id;
     }
+    /*
+     * Queues the programs the materials of the scene draw with, read from
+     * the scene before returning. The GL thread builds a few of them per
+     * frame in prewarmStep, ahead of their first draw; with the program
+     * cache most load from binaries.
+     */
+    void prewarm(Scene* scene);
+
+    // GL thread: builds up to budget queued programs, returns the number left
+    int prewarmStep(int budget);
+
     CustomShader* getCustomShader(int id) {
         auto it = custom_shaders_.find(id);
         if (it != custom_shaders_.end()) {
@@ -177,6 +195,18 @@ private:
     ShaderManager& operator=(const ShaderManager& shader_manager);
     ShaderManager& operator=(ShaderManager&& shader_manager);
 
+private:
+    struct PrewarmEntry {
+        int shader_type;
+        bool use_light;
+        bool batching;
+        bool instanced;
+    };
+
+    void collectPrewarm(Scene* scene, std::vector<PrewarmEntry>& entries);
+    void queuePrewarmEntry(const PrewarmEntry& entry);
+    void prewarmShader(const PrewarmEntry& entry);
+
 private:
     static const int INITIAL_CUSTOM_SHADER_INDEX = 1000;
     BoundingBoxShader* bounding_box_shader_;
@@ -199,6 +229,13 @@ private:
     ErrorShader* error_shader_;
     int latest_custom_shader_id_;
     std::map<int, CustomShader*> custom_shaders_;
+
+    // programs prewarm found, queued on the GL thread
+    std::mutex prewarm_lock_;
+    std::vector<PrewarmEntry> prewarm_pending_;
+    // GL thread only
+    std::deque<PrewarmEntry> prewarm_queue_;
+    std::set<int> prewarm_seen_;
 };
 
 }
@@ -19,6 +19,8 @@
 
 #include "shader_manager.h"
 
+#include "gl/gl_program_cache.h"
+#include "objects/scene.h"
 #include "util/gvr_jni.h"
 
 namespace gvr {
@@ -33,6 +35,12 @@ Java_org_gearvrf_NativeShaderManager_addCustomShader(
 JNIEXPORT jlong JNICALL
 Java_org_gearvrf_NativeShaderManager_getCustomShader(
         JNIEnv * env, jobject obj, jlong jshader_manager, jint id);
+JNIEXPORT void JNICALL
+Java_org_gearvrf_NativeShaderManager_setProgramCacheDir(
+        JNIEnv * env, jobject obj, jstring directory);
+JNIEXPORT void JNICALL
+Java_org_gearvrf_NativeShaderManager_prewarm(
+        JNIEnv * env, jobject obj, jlong jshader_manager, jlong jscene);
 }
 
 JNIEXPORT jlong JNICALL
@@ -71,4 +79,21 @@ Java_org_gearvrf_NativeShaderManager_getCustomShader(
 }
 }
 
+JNIEXPORT void JNICALL
+Java_org_gearvrf_NativeShaderManager_setProgramCacheDir(
+    JNIEnv * env, jobject obj, jstring directory) {
+    const char* directory_str = env->GetStringUTFChars(directory, 0);
+    ProgramCache::getInstance()->setDirectory(std::string(directory_str));
+    env->ReleaseStringUTFChars(directory, directory_str);
+}
+
+JNIEXPORT void JNICALL
+Java_org_gearvrf_NativeShaderManager_prewarm(
+    JNIEnv * env, jobject obj, jlong jshader_manager, jlong jscene) {
+    ShaderManager* shader_manager =
+    reinterpret_cast<ShaderManager*>(jshader_manager);
+    Scene* scene = reinterpret_cast<Scene*>(jscene);
+    shader_manager->prewarm(scene);
+}
+
 }
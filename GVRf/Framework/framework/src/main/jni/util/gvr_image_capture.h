@@ -22,40 +22,31 @@
 #include "gl/gl_headers.h"
 #include <vector>
 #include <string>
+#include "util/gvr_image_encoder.h"
 
 
 /* Saves a buffer with RGBA values as a tga file */
 
-int write_truecolor_tga( int width, int height, GLubyte* valRGBA, char* fileName );
+int write_truecolor_tga(uint width, uint height, const GLubyte* valRGBA, const char* fileName);
 
-// Reads back in RGBA format.
-// Images are saved to /sdcard/image-xx.tga
+// Reads back in RGBA format, through the GL thread's readback ring.
+// Images are saved to /sdcard/image-xx.tga, or .png or .raw, on the
+// encoder's thread as soon as their read completes.
 
 class GVRImageCapture {
 public:
-    GVRImageCapture(uint width = 0, uint height = 0); // Default width and height for PBOs.
+    GVRImageCapture(uint width = 0, uint height = 0, // Default width and height for reads.
+            gvr::ImageEncoder::Format format = gvr::ImageEncoder::TGA);
     ~GVRImageCapture();
     void captureImage(int startX, int startY, uint width, uint height, char* msg = NULL);
     void captureImage(int startX, int startY, char* msg = NULL);
+    // waits until every captured image is saved
     void saveAllImages();
 private:
-    struct PBOINFO
-    {
-        GLuint id;
-        uint width;
-        uint height;
-        int startX;
-        int startY;
-        std::string msg;
-    };
-
     uint mDefaultWidth;
     uint mDefaultHeight;
-    std::vector<PBOINFO> mPBOData;
-    uint mMaxWidth;
-    uint mMaxHeight;
-
-
+    gvr::ImageEncoder::Format mFormat;
+    int mFileIndex;
 };
 
 #endif // GVR_CPP_STACK_TRACE_H_
@@ -0,0 +1,228 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Encodes and saves read back images on a worker thread.
+ ***************************************************************************/
+
+#include "gvr_image_encoder.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <zlib.h>
+
+#include "util/gvr_log.h"
+
+namespace gvr {
+
+ImageEncoder* ImageEncoder::instance_ = new ImageEncoder();
+
+ImageEncoder* ImageEncoder::getInstance() {
+    return instance_;
+}
+
+ImageEncoder::ImageEncoder() :
+        started_(false), busy_(false) {
+}
+
+void ImageEncoder::save(Format format, int width, int height,
+        std::vector<GLubyte>& pixels, const std::string& path, const Callback& done) {
+    Job* job = new Job();
+    job->format = format;
+    job->width = width;
+    job->height = height;
+    job->pixels.swap(pixels);
+    job->path = path;
+    job->done = done;
+
+    std::lock_guard < std::mutex > lock(mutex_);
+    if (!started_) {
+        // lives as long as the process, like the encoder
+        std::thread(&ImageEncoder::workerLoop, this).detach();
+        started_ = true;
+    }
+    jobs_.push_back(job);
+    wake_.notify_one();
+}
+
+void ImageEncoder::wait() {
+    std::unique_lock < std::mutex > lock(mutex_);
+    while (busy_ || !jobs_.empty()) {
+        idle_.wait(lock);
+    }
+}
+
+void ImageEncoder::workerLoop() {
+    std::vector<char> file;
+    for (;;) {
+        Job* job;
+        {
+            std::unique_lock < std::mutex > lock(mutex_);
+            busy_ = false;
+            if (jobs_.empty()) {
+                idle_.notify_all();
+            }
+            while (jobs_.empty()) {
+                wake_.wait(lock);
+            }
+            job = jobs_.front();
+            jobs_.pop_front();
+            busy_ = true;
+        }
+
+        bool written = false;
+        file.clear();
+        if (encode(job->format, job->width, job->height, job->pixels.data(), file)) {
+            FILE* fp = fopen(job->path.c_str(), "wb");
+            if (nullptr != fp) {
+                written = file.size() == fwrite(file.data(), 1, file.size(), fp);
+                written = 0 == fclose(fp) && written;
+            }
+        }
+        if (!written) {
+            LOGE("ImageEncoder: cannot write %s", job->path.c_str());
+        }
+        if (job->done) {
+            job->done(written);
+        }
+        delete job;
+    }
+}
+
+const char* ImageEncoder::extension(Format format) {
+    switch (format) {
+    case TGA:
+        return "tga";
+    case PNG:
+        return "png";
+    default:
+        return "raw";
+    }
+}
+
+bool ImageEncoder::encode(Format format, int width, int height, const GLubyte* pixels,
+        std::vector<char>& file) {
+    switch (format) {
+    case RAW:
+        file.assign(reinterpret_cast<const char*>(pixels),
+                reinterpret_cast<const char*>(pixels) + size_t(width) * height * 4);
+        return true;
+    case TGA:
+        encodeTga(width, height, pixels, file);
+        return true;
+    case PNG:
+        encodePng(width, height, pixels, file);
+        return true;
+    default:
+        return false;
+    }
+}
+
+void ImageEncoder::encodeTga(int width, int height, const GLubyte* pixels,
+        std::vector<char>& file) {
+    static const char footer[26] =
+            "\0\0\0\0"              // no extension area
+            "\0\0\0\0"              // no developer directory
+            "TRUEVISION-XFILE"      // yep, this is a TGA file
+            ".";
+    size_t size = size_t(width) * height * 3;
+    file.resize(18 + size + sizeof(footer));
+
+    char* header = file.data();
+    std::fill(header, header + 18, 0);
+    header[2] = 2;      // truecolor
+    header[12] = width & 0xFF;
+    header[13] = (width >> 8) & 0xFF;
+    header[14] = height & 0xFF;
+    header[15] = (height >> 8) & 0xFF;
+    header[16] = 24;    // bits per pixel
+
+    // bottom to top like GL, blue green red
+    char* out = file.data() + 18;
+    for (size_t i = 0, count = size_t(width) * height; i < count; ++i) {
+        const GLubyte* pixel = pixels + i * 4;
+        out[0] = pixel[2];
+        out[1] = pixel[1];
+        out[2] = pixel[0];
+        out += 3;
+    }
+    std::copy(footer, footer + sizeof(footer), out);
+}
+
+static void appendWord(std::vector<char>& file, uLong word) {
+    file.push_back((word >> 24) & 0xFF);
+    file.push_back((word >> 16) & 0xFF);
+    file.push_back((word >> 8) & 0xFF);
+    file.push_back(word & 0xFF);
+}
+
+static void appendChunk(std::vector<char>& file, const char* type,
+        const char* data, size_t size) {
+    appendWord(file, size);
+    size_t start = file.size();
+    file.insert(file.end(), type, type + 4);
+    file.insert(file.end(), data, data + size);
+    uLong crc = crc32(0, reinterpret_cast<const Bytef*>(file.data() + start), size + 4);
+    appendWord(file, crc);
+}
+
+void ImageEncoder::encodePng(int width, int height, const GLubyte* pixels,
+        std::vector<char>& file) {
+    // top to bottom, each row with the Up filter: the difference to the row above
+    size_t stride = size_t(width) * 4;
+    std::vector<Bytef> rows((stride + 1) * height);
+    Bytef* out = rows.data();
+    for (int y = 0; y < height; ++y) {
+        const GLubyte* row = pixels + (height - 1 - y) * stride;
+        *out++ = 0 == y ? 0 : 2;
+        if (0 == y) {
+            std::copy(row, row + stride, out);
+        } else {
+            const GLubyte* above = row + stride;
+            for (size_t i = 0; i < stride; ++i) {
+                out[i] = row[i] - above[i];
+            }
+        }
+        out += stride;
+    }
+
+    uLongf deflated_size = compressBound(rows.size());
+    std::vector<char> deflated(deflated_size);
+    compress2(reinterpret_cast<Bytef*>(deflated.data()), &deflated_size,
+            rows.data(), rows.size(), Z_BEST_SPEED);
+
+    static const char signature[8] = { '\x89', 'P', 'N', 'G', '\r', '\n', '\x1a', '\n' };
+    char header[13];
+    header[0] = (width >> 24) & 0xFF;
+    header[1] = (width >> 16) & 0xFF;
+    header[2] = (width >> 8) & 0xFF;
+    header[3] = width & 0xFF;
+    header[4] = (height >> 24) & 0xFF;
+    header[5] = (height >> 16) & 0xFF;
+    header[6] = (height >> 8) & 0xFF;
+    header[7] = height & 0xFF;
+    header[8] = 8;      // bits per channel
+    header[9] = 6;      // RGBA
+    header[10] = 0;     // deflate
+    header[11] = 0;     // adaptive filters
+    header[12] = 0;     // not interlaced
+
+    file.assign(signature, signature + sizeof(signature));
+    appendChunk(file, "IHDR", header, sizeof(header));
+    appendChunk(file, "IDAT", deflated.data(), deflated_size);
+    appendChunk(file, "IEND", nullptr, 0);
+}
+
+}
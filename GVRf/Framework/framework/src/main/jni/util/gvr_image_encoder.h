@@ -0,0 +1,104 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Encodes and saves read back images on a worker thread.
+ ***************************************************************************/
+
+#ifndef GVR_IMAGE_ENCODER_H_
+#define GVR_IMAGE_ENCODER_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gl/gl_headers.h"
+
+namespace gvr {
+
+/*
+ * Writes RGBA8 images as they come out of glReadPixels, bottom row
+ * first, to files: raw, as they are; TGA, 24 bits, which stores its rows
+ * bottom first too; or PNG, turned top first and deflated with zlib.
+ *
+ * The work is done on one thread of its own, started with the first
+ * image, so the GL thread only copies the pixels out of the mapped
+ * buffer. Images are written in the order they were handed over.
+ */
+class ImageEncoder {
+public:
+    enum Format {
+        RAW = 0,
+        TGA,
+        PNG,
+    };
+
+    // worker thread, whether the file was written
+    typedef std::function<void(bool written)> Callback;
+
+    static ImageEncoder* getInstance();
+
+    // any thread; takes the pixels
+    void save(Format format, int width, int height, std::vector<GLubyte>& pixels,
+            const std::string& path, const Callback& done = nullptr);
+
+    // blocks until the images handed over so far are written
+    void wait();
+
+    // the file contents of the image, on any thread; false if format is unknown
+    static bool encode(Format format, int width, int height, const GLubyte* pixels,
+            std::vector<char>& file);
+
+    static const char* extension(Format format);
+
+private:
+    ImageEncoder();
+    ImageEncoder(const ImageEncoder& encoder);
+    ImageEncoder(ImageEncoder&& encoder);
+    ImageEncoder& operator=(const ImageEncoder& encoder);
+    ImageEncoder& operator=(ImageEncoder&& encoder);
+
+    struct Job {
+        Format format;
+        int width;
+        int height;
+        std::vector<GLubyte> pixels;
+        std::string path;
+        Callback done;
+    };
+
+    void workerLoop();
+    static void encodeTga(int width, int height, const GLubyte* pixels,
+            std::vector<char>& file);
+    static void encodePng(int width, int height, const GLubyte* pixels,
+            std::vector<char>& file);
+
+private:
+    static ImageEncoder* instance_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable idle_;
+    std::deque<Job*> jobs_;
+    bool started_;
+    bool busy_;         // the worker is on a job it took
+};
+
+}
+#endif
@@ -0,0 +1,212 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gvr_job_system.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <unistd.h>
+
+#include "gvr_log.h"
+#include "gvr_thread.h"
+
+namespace gvr {
+
+JobSystem* JobSystem::instance_ = nullptr;
+
+JobSystem* JobSystem::getInstance() {
+    if (nullptr == instance_) {
+        instance_ = new JobSystem();
+    }
+    return instance_;
+}
+
+JobSystem::JobSystem() :
+        queued_(0), stopping_(false) {
+    start(-1);
+}
+
+JobSystem::~JobSystem() {
+    stop();
+}
+
+/*
+ * The cores with the highest maximum frequency; all online cores when
+ * cpufreq is not readable or the SoC is not big.LITTLE.
+ */
+void JobSystem::bigCores(std::vector<int>& cpus) {
+    cpus.clear();
+    int cpu_count = sysconf(_SC_NPROCESSORS_CONF);
+    long best = -1;
+    for (int cpu = 0; cpu < cpu_count; ++cpu) {
+        char path[128];
+        snprintf(path, sizeof(path),
+                "/sys/devices/system/cpu/cpu%d/cpufreq/cpuinfo_max_freq", cpu);
+        FILE* file = fopen(path, "r");
+        long frequency = 0;
+        if (nullptr != file) {
+            if (1 != fscanf(file, "%ld", &frequency)) {
+                frequency = 0;
+            }
+            fclose(file);
+        }
+        if (frequency > best) {
+            best = frequency;
+            cpus.clear();
+        }
+        if (frequency == best) {
+            cpus.push_back(cpu);
+        }
+    }
+}
+
+void JobSystem::resize(int worker_count) {
+    stop();
+    start(worker_count);
+}
+
+void JobSystem::start(int worker_count) {
+    std::vector<int> cpus;
+    bigCores(cpus);
+    if (worker_count < 0) {
+        worker_count = cpus.size() > 1 ? cpus.size() - 1 : 0;
+    }
+
+    stopping_ = false;
+    queued_ = 0;
+    for (int i = 0; i <= worker_count; ++i) {
+        queues_.push_back(new Queue());
+    }
+    for (int i = 0; i < worker_count; ++i) {
+        // leave the first big core to the calling thread
+        int cpu = cpus.empty() ? -1 : cpus[(i + 1) % cpus.size()];
+        threads_.push_back(std::thread(&JobSystem::workerLoop, this, i, cpu));
+    }
+    LOGD("JobSystem: %d workers, %d big cores", worker_count, (int) cpus.size());
+}
+
+void JobSystem::stop() {
+    {
+        std::lock_guard < std::mutex > lock(wake_mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto it = threads_.begin(); it != threads_.end(); ++it) {
+        it->join();
+    }
+    threads_.clear();
+    for (auto it = queues_.begin(); it != queues_.end(); ++it) {
+        delete *it;
+    }
+    queues_.clear();
+}
+
+bool JobSystem::takeJob(int index, Job& job) {
+    int queue_count = queues_.size();
+    {
+        Queue* own = queues_[index];
+        std::lock_guard < std::mutex > lock(own->mutex);
+        if (!own->jobs.empty()) {
+            job = own->jobs.back();
+            own->jobs.pop_back();
+            --queued_;
+            return true;
+        }
+    }
+    for (int i = 1; i < queue_count; ++i) {
+        Queue* victim = queues_[(index + i) % queue_count];
+        std::lock_guard < std::mutex > lock(victim->mutex);
+        if (!victim->jobs.empty()) {
+            job = victim->jobs.front();
+            victim->jobs.pop_front();
+            --queued_;
+            return true;
+        }
+    }
+    return false;
+}
+
+void JobSystem::runJob(const Job& job) {
+    (*job.fn)(job.begin, job.end);
+    job.remaining->fetch_sub(1, std::memory_order_release);
+}
+
+void JobSystem::workerLoop(int index, int cpu) {
+    if (cpu >= 0) {
+        setCurrentThreadAffinityMask(cpu, 0, 0);
+    }
+    Job job;
+    for (;;) {
+        if (takeJob(index, job)) {
+            runJob(job);
+            continue;
+        }
+        std::unique_lock < std::mutex > lock(wake_mutex_);
+        wake_.wait(lock, [this] { return stopping_ || queued_ > 0; });
+        if (stopping_) {
+            return;
+        }
+    }
+}
+
+void JobSystem::parallelFor(int count, int grain,
+        const std::function<void(int begin, int end)>& fn) {
+    if (count <= 0) {
+        return;
+    }
+    if (grain < 1) {
+        grain = 1;
+    }
+    if (threads_.empty() || count <= grain) {
+        fn(0, count);
+        return;
+    }
+
+    std::lock_guard < std::mutex > submit_lock(submit_mutex_);
+    int chunk_count = (count + grain - 1) / grain;
+    int queue_count = queues_.size();
+    std::atomic<int> remaining(chunk_count);
+
+    // deal the chunks out round robin so every queue starts with work
+    for (int q = 0; q < queue_count; ++q) {
+        Queue* queue = queues_[q];
+        std::lock_guard < std::mutex > lock(queue->mutex);
+        for (int chunk = q; chunk < chunk_count; chunk += queue_count) {
+            Job job;
+            job.fn = &fn;
+            job.begin = chunk * grain;
+            job.end = std::min(count, job.begin + grain);
+            job.remaining = &remaining;
+            queue->jobs.push_back(job);
+            ++queued_;
+        }
+    }
+    {
+        std::lock_guard < std::mutex > lock(wake_mutex_);
+    }
+    wake_.notify_all();
+
+    Job job;
+    int caller = queue_count - 1;
+    while (remaining.load(std::memory_order_acquire) > 0) {
+        if (takeJob(caller, job)) {
+            runJob(job);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+}
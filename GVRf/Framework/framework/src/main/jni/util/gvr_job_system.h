@@ -0,0 +1,109 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/***************************************************************************
+ * Work-stealing thread pool for the CPU side of the frame.
+ ***************************************************************************/
+
+#ifndef GVR_JOB_SYSTEM_H_
+#define GVR_JOB_SYSTEM_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gvr {
+
+/*
+ * One worker per big core, minus the one the calling (GL) thread runs
+ * on, each pinned with setCurrentThreadAffinityMask. Every worker owns a
+ * queue: it takes its own work from the back and steals from the front
+ * of the others when it runs dry. The calling thread executes chunks
+ * too while it waits, so with no workers everything runs inline.
+ *
+ * Work is handed out as index ranges. Callers that need a stable result
+ * write per chunk output and merge it in chunk order afterwards, which
+ * keeps the result independent of which thread ran what.
+ */
+class JobSystem {
+public:
+    static JobSystem* getInstance();
+
+    /*
+     * Restarts the pool with the given number of workers; a negative
+     * count picks the default for the device. Must not be called while
+     * parallelFor is running.
+     */
+    void resize(int worker_count);
+
+    int worker_count() const {
+        return threads_.size();
+    }
+
+    /*
+     * Calls fn(begin, end) over [0, count) in chunks of at most grain
+     * indices and returns once every chunk has run. Chunks may run on any
+     * thread and in any order.
+     */
+    void parallelFor(int count, int grain,
+            const std::function<void(int begin, int end)>& fn);
+
+private:
+    JobSystem();
+    ~JobSystem();
+    JobSystem(const JobSystem& job_system);
+    JobSystem(JobSystem&& job_system);
+    JobSystem& operator=(const JobSystem& job_system);
+    JobSystem& operator=(JobSystem&& job_system);
+
+    struct Job {
+        const std::function<void(int, int)>* fn;
+        int begin;
+        int end;
+        std::atomic<int>* remaining;
+    };
+
+    struct Queue {
+        std::mutex      mutex;
+        std::deque<Job> jobs;
+    };
+
+    static void bigCores(std::vector<int>& cpus);
+    void start(int worker_count);
+    void stop();
+    void workerLoop(int index, int cpu);
+    bool takeJob(int index, Job& job);
+    void runJob(const Job& job);
+
+private:
+    static JobSystem* instance_;
+
+    std::vector<std::thread> threads_;
+    // one queue per worker, the last one belongs to the calling thread
+    std::vector<Queue*>      queues_;
+    std::mutex               submit_mutex_;
+    std::mutex               wake_mutex_;
+    std::condition_variable  wake_;
+    std::atomic<int>         queued_;
+    bool                     stopping_;
+};
+
+}
+#endif
@@ -15,6 +15,7 @@
 
 #include <sys/syscall.h>
 #include<stdlib.h>
+#include<string.h>
 #include<unistd.h>
 #include "gvr_log.h"
 #include "gvr_thread.h"